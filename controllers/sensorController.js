@@ -1,8 +1,15 @@
 const SensorData = require('../models/SensorData');
+const SensorRegistry = require('../models/SensorRegistry');
+const SensorRollup = require('../models/SensorRollup');
 const DeviceControl = require('../models/DeviceControl');
-const User = require('../models/User');
-const Greenhouse = require('../models/Greenhouse');
 const moment = require('moment');
+const IngestPipeline = require('../services/ingestPipeline');
+const SensorDataBuffer = require('../services/sensorDataBuffer');
+
+// Cached lookups and batched bookkeeping for receiveSensorData
+const ingestPipeline = new IngestPipeline();
+// Batched inserts of the readings themselves
+const sensorDataBuffer = new SensorDataBuffer();
 
 // @desc    Receive sensor data from ESP32/Arduino (Enhanced)
 // @route   POST /api/sensors/data
@@ -24,7 +31,7 @@ const receiveSensorData = async (req, res) => {
 
     // Support both old and new data formats
     let sensorDataInput;
-    
+  
     if (sensors && sensors.outsideTemp !== undefined) {
       // New format from enhanced ESP32
       sensorDataInput = {
@@ -51,7 +58,7 @@ const receiveSensorData = async (req, res) => {
         ph,
         waterTankLevel
       } = req.body;
-      
+    
       sensorDataInput = {
         temp1,
         temp2,
@@ -80,136 +87,82 @@ const receiveSensorData = async (req, res) => {
     // const greenhouse = await Greenhouse.findById(greenhouseId);
     // if (!greenhouse) { ... }
 
-    // Instead, you can fetch the first user/greenhouse if IDs are default:
-    let user, greenhouse;
-    if (userId === 'defaultUserId') {
-      user = await User.findOne();
-    } else {
-      user = await User.findById(userId);
-    }
+    // Instead, you can fetch the first user/greenhouse if IDs are default (cached, see IngestPipeline)
+    const { user, greenhouse } = await ingestPipeline.resolve(userId, greenhouseId);
     if (!user) {
-      return res.status(404).json({
-        success: false,
-        message: 'User not found'
-      });
-    }
-    if (greenhouseId === 'defaultGreenhouseId') {
-      greenhouse = await Greenhouse.findOne();
-    } else {
-      greenhouse = await Greenhouse.findById(greenhouseId);
+      throw notFound('User not found');
     }
     if (!greenhouse) {
-      return res.status(404).json({
-        success: false,
-        message: 'Greenhouse not found'
-      });
+      throw notFound('Greenhouse not found');
     }
 
+    // What the channels of this payload format are, kept once per device in SensorRegistry
+    const channels = {
+      ...SensorRegistry.defaultChannels,
+      temp1: { ...SensorRegistry.defaultChannels.temp1, location: sensors && sensors.outsideTemp !== undefined ? 'Outside' : 'Zone 1' },
+      temp2: { ...SensorRegistry.defaultChannels.temp2, location: sensors && sensors.greenhouseTemp !== undefined ? 'Greenhouse' : 'Zone 2' },
+      hum1: { ...SensorRegistry.defaultChannels.hum1, location: sensors && sensors.outsideHumidity !== undefined ? 'Outside' : 'Zone 1' },
+      hum2: { ...SensorRegistry.defaultChannels.hum2, location: sensors && sensors.greenhouseHumidity !== undefined ? 'Greenhouse' : 'Zone 2' }
+    };
+
     // Create sensor data document
     const sensorData = new SensorData({
       deviceId,
-      userId,
-      greenhouseId,
-      temperature: {
-        temp1: {
-          value: parseFloat(sensorDataInput.temp1) || 0,
-          unit: 'C',
-          sensorType: 'DHT11',
-          location: sensors && sensors.outsideTemp !== undefined ? 'Outside' : 'Zone 1'
-        },
-        temp2: {
-          value: parseFloat(sensorDataInput.temp2) || 0,
-          unit: 'C',
-          sensorType: 'DHT11',
-          location: sensors && sensors.greenhouseTemp !== undefined ? 'Greenhouse' : 'Zone 2'
-        }
-      },
-      humidity: {
-        hum1: {
-          value: parseFloat(sensorDataInput.hum1) || 0,
-          unit: '%',
-          sensorType: 'DHT11',
-          location: sensors && sensors.outsideHumidity !== undefined ? 'Outside' : 'Zone 1'
-        },
-        hum2: {
-          value: parseFloat(sensorDataInput.hum2) || 0,
-          unit: '%',
-          sensorType: 'DHT11',
-          location: sensors && sensors.greenhouseHumidity !== undefined ? 'Greenhouse' : 'Zone 2'
-        }
-      },
-      soilMoisture: {
-        value: parseFloat(sensorDataInput.soilMoisture) || 0,
-        unit: '%',
-        sensorType: 'Capacitive',
-        location: 'Soil bed'
-      },
-      lightIntensity: {
-        value: parseFloat(sensorDataInput.lightIntensity) || 0,
-        unit: '%',
-        sensorType: 'LDR',
-        location: 'Canopy level'
-      },
-      ph: {
-        value: parseFloat(sensorDataInput.ph) || 7.0,
-        unit: 'pH',
-        sensorType: 'pH4502C',
-        location: 'Nutrient solution'
-      },
-      waterTankLevel: {
-        value: parseFloat(sensorDataInput.waterTankLevel) || 0,
-        unit: '%',
-        sensorType: 'Ultrasonic',
-        location: 'Main water tank'
+      userId: user._id,
+      greenhouseId: greenhouse._id,
+      readings: {
+        temp1: parseFloat(sensorDataInput.temp1) || 0,
+        temp2: parseFloat(sensorDataInput.temp2) || 0,
+        hum1: parseFloat(sensorDataInput.hum1) || 0,
+        hum2: parseFloat(sensorDataInput.hum2) || 0,
+        soilMoisture: parseFloat(sensorDataInput.soilMoisture) || 0,
+        lightIntensity: parseFloat(sensorDataInput.lightIntensity) || 0,
+        ph: parseFloat(sensorDataInput.ph) || 7.0,
+        waterTankLevel: parseFloat(sensorDataInput.waterTankLevel) || 0
       },
-      // Store actuator states if provided
-      actuatorStates: sensorDataInput.actuatorStates || {},
-      rfidData: sensorDataInput.rfidData || 'NoCard',
-      deviceStatus: deviceStatus || {},
-      rawData: rawData || req.body,
-      dataQuality: 'good'
+      // Store actuator states, RFID and device status if provided
+      actuatorStates: sensorDataInput.actuatorStates || undefined,
+      rfidData: sensorDataInput.rfidData && sensorDataInput.rfidData !== 'NoCard' ? sensorDataInput.rfidData : undefined,
+      deviceStatus: deviceStatus || undefined,
+      // only what the device sent for debugging, not a copy of the whole payload
+      rawData
     });
 
     // Check for alerts based on user preferences
     const userPreferences = user.preferences.alertThresholds;
     const alerts = sensorData.checkAlerts(userPreferences);
 
-    // Save sensor data
-    await sensorData.save();
-
-    // Update greenhouse stats
-    greenhouse.stats.totalSensorReadings += 1;
-    greenhouse.stats.lastDataReceived = new Date();
-    if (alerts.length > 0) {
-      greenhouse.stats.totalAlerts += alerts.length;
-    }
-    await greenhouse.save();
-
-    // Update device status in greenhouse
-    await greenhouse.updateDeviceStatus(deviceId, 'active');
+    // Save sensor data, the only write the device waits for (grouped with other devices' readings)
+    await sensorDataBuffer.insert(sensorData);
 
-    // Update device control with latest actuator states if provided
-    if (sensorDataInput.actuatorStates) {
-      await updateDeviceControlStates(deviceId, sensorDataInput.actuatorStates);
-    }
+    // Greenhouse stats, device status and actuator feedback are written in batches
+    ingestPipeline.defer({
+      greenhouseId: greenhouse._id,
+      deviceId,
+      alerts: alerts.length,
+      actuatorStates: sensorDataInput.actuatorStates,
+      channels,
+      receivedAt: sensorData.createdAt
+    });
 
-    // Trigger automation if needed
+    // Trigger automation if needed, without holding up the response
     if (alerts.length > 0) {
-      await handleAutomationTriggers(deviceId, sensorData, alerts);
+      handleAutomationTriggers(deviceId, sensorData, alerts);
     }
 
     // Emit real-time data via Socket.IO
+    const apiData = SensorData.toApi(sensorData, channels);
     req.io.emit(`greenhouse_${greenhouseId}`, {
       type: 'sensor_data',
       deviceId,
       data: {
         sensors: {
-          temperature: sensorData.temperature,
-          humidity: sensorData.humidity,
-          soilMoisture: sensorData.soilMoisture,
-          lightIntensity: sensorData.lightIntensity,
-          ph: sensorData.ph,
-          waterTankLevel: sensorData.waterTankLevel
+          temperature: apiData.temperature,
+          humidity: apiData.humidity,
+          soilMoisture: apiData.soilMoisture,
+          lightIntensity: apiData.lightIntensity,
+          ph: apiData.ph,
+          waterTankLevel: apiData.waterTankLevel
         },
         actuators: sensorDataInput.actuatorStates,
         rfid: sensorDataInput.rfidData,
@@ -225,8 +178,8 @@ const receiveSensorData = async (req, res) => {
         id: sensorData._id,
         timestamp: sensorData.createdAt,
         alerts: alerts,
-        averageTemperature: sensorData.temperature.average,
-        averageHumidity: sensorData.humidity.average,
+        averageTemperature: sensorData.readings.tempAverage,
+        averageHumidity: sensorData.readings.humAverage,
         actuatorStates: sensorDataInput.actuatorStates,
         rfidData: sensorDataInput.rfidData
       }
@@ -234,6 +187,16 @@ const receiveSensorData = async (req, res) => {
 
   } catch (error) {
     console.error('Sensor data reception error:', error);
+
+    if (error.statusCode) {
+      if (error.retryAfter) {
+        res.set('Retry-After', String(error.retryAfter));
+      }
+      return res.status(error.statusCode).json({
+        success: false,
+        message: error.message
+      });
+    }
     
     if (error.name === 'ValidationError') {
       const messages = Object.values(error.errors).map(err => err.message);
@@ -259,15 +222,18 @@ const getLatestSensorData = async (req, res) => {
     const { deviceId } = req.params;
     const limit = parseInt(req.query.limit) || 1;
 
-    const sensorData = await SensorData.getLatestByDevice(deviceId, limit);
+    const latest = await SensorData.getLatestByDevice(deviceId, limit);
 
-    if (!sensorData || sensorData.length === 0) {
+    if (!latest || latest.length === 0) {
       return res.status(404).json({
         success: false,
         message: 'No sensor data found for this device'
       });
     }
 
+    const channels = await SensorRegistry.channelsFor([deviceId]);
+    const sensorData = latest.map(reading => SensorData.toApi(reading, channels.get(deviceId)));
+
     res.json({
       success: true,
       data: sensorData,
@@ -303,15 +269,20 @@ const getSensorHistory = async (req, res) => {
 
     const skip = (page - 1) * limit;
 
-    const sensorData = await SensorData.find({
-      deviceId,
-      createdAt: { $gte: start, $lte: end }
-    })
-    .sort({ createdAt: -1 })
-    .limit(parseInt(limit))
-    .skip(skip)
-    .populate('userId', 'username firstName lastName')
-    .populate('greenhouseId', 'name location');
+    const [history, channels] = await Promise.all([
+      SensorData.find({
+        deviceId,
+        createdAt: { $gte: start, $lte: end }
+      })
+      .sort({ createdAt: -1 })
+      .limit(parseInt(limit))
+      .skip(skip)
+      .populate('userId', 'username firstName lastName')
+      .populate('greenhouseId', 'name location')
+      .lean(),
+      SensorRegistry.channelsFor([deviceId])
+    ]);
+    const sensorData = history.map(reading => SensorData.toApi(reading, channels.get(deviceId)));
 
     const total = await SensorData.countDocuments({
       deviceId,
@@ -351,7 +322,7 @@ const getAggregatedData = async (req, res) => {
     const {
       startDate,
       endDate,
-      groupBy = 'hour', // hour, day, week, month
+      groupBy = 'hour', // minute, hour, day, week, month
       metrics = 'temperature,humidity,soilMoisture'
     } = req.query;
 
@@ -360,51 +331,33 @@ const getAggregatedData = async (req, res) => {
 
     const requestedMetrics = metrics.split(',');
     
-    // Aggregation pipeline
-    const pipeline = [
-      {
-        $match: {
-          deviceId,
-          createdAt: { $gte: start, $lte: end }
-        }
-      },
-      {
-        $group: {
-          _id: {
-            $dateToString: {
-              format: getDateFormat(groupBy),
-              date: '$createdAt'
-            }
-          },
-          avgTemp: { $avg: '$temperature.average' },
-          minTemp: { $min: '$temperature.average' },
-          maxTemp: { $max: '$temperature.average' },
-          avgHumidity: { $avg: '$humidity.average' },
-          minHumidity: { $min: '$humidity.average' },
-          maxHumidity: { $max: '$humidity.average' },
-          avgSoilMoisture: { $avg: '$soilMoisture.value' },
-          minSoilMoisture: { $min: '$soilMoisture.value' },
-          maxSoilMoisture: { $max: '$soilMoisture.value' },
-          avgLightIntensity: { $avg: '$lightIntensity.value' },
-          avgPh: { $avg: '$ph.value' },
-          avgWaterTank: { $avg: '$waterTankLevel.value' },
-          count: { $sum: 1 },
-          alertCount: { $sum: { $size: '$alerts' } }
-        }
-      },
-      {
-        $sort: { _id: 1 }
-      }
-    ];
-
-    const aggregatedData = await SensorData.aggregate(pipeline);
+    // Charts come from the coarsest rollup that can be grouped by `groupBy`, for the whole groups inside
+    // the range. Groups rollups don't cover are grouped from readings: the partial groups at either end
+    // of the range, before the first rollup (readings from before rollups, expired minute rollups) and
+    // where a rollup is stale
+    const resolution = getRollupResolution(groupBy);
+    const [rollupFrom, rollupTo] = getRollupRange(start, end, groupBy);
+    const rollupGroups = rollupFrom < rollupTo
+      ? await SensorRollup.aggregate(getRollupPipeline(deviceId, resolution, rollupFrom, rollupTo, groupBy))
+      : [];
+    const { kept, windows } = splitRollupGroups(rollupGroups, start, rollupFrom, rollupTo, groupBy);
+    let aggregatedData = kept;
+    if (windows.length > 0) {
+      const readingGroups = await SensorData.aggregate(getReadingsPipeline(deviceId, windows, start, end, groupBy));
+      aggregatedData = kept.concat(readingGroups).sort((a, b) => (a._id < b._id ? -1 : a._id > b._id ? 1 : 0));
+    }
+    let source = `rollup:${resolution}`;
+    if (windows.length > 0) {
+      source = kept.length > 0 ? `${source}+readings` : 'readings';
+    }
 
     res.json({
       success: true,
       data: aggregatedData,
       dateRange: { start, end },
       groupBy,
-      metrics: requestedMetrics
+      metrics: requestedMetrics,
+      source
     });
 
   } catch (error) {
@@ -426,7 +379,8 @@ const getDeviceStatus = async (req, res) => {
     // Get latest sensor data for device status
     const latestData = await SensorData.findOne({ deviceId })
       .sort({ createdAt: -1 })
-      .select('deviceStatus createdAt dataQuality');
+      .select('deviceStatus createdAt dataQuality')
+      .lean();
 
     if (!latestData) {
       return res.status(404).json({
@@ -444,8 +398,8 @@ const getDeviceStatus = async (req, res) => {
         deviceId,
         isOnline,
         lastSeen: latestData.createdAt,
-        status: latestData.deviceStatus,
-        dataQuality: latestData.dataQuality
+        status: latestData.deviceStatus || { lastHeartbeat: latestData.createdAt },
+        dataQuality: latestData.dataQuality || 'good'
       }
     });
 
@@ -471,7 +425,7 @@ const handleAutomationTriggers = async (deviceId, sensorData, alerts) => {
     // Check irrigation automation
     if (rules.irrigation.enabled) {
       const soilMoistureAlert = alerts.find(alert => alert.type === 'soil_moisture_low');
-      if (soilMoistureAlert && sensorData.soilMoisture.value < rules.irrigation.soilMoistureThreshold) {
+      if (soilMoistureAlert && sensorData.readings.soilMoisture < rules.irrigation.soilMoistureThreshold) {
         // Check cooldown period
         const lastTriggered = rules.irrigation.lastTriggered;
         if (!lastTriggered || moment().diff(moment(lastTriggered), 'seconds') > rules.irrigation.cooldownPeriod) {
@@ -510,50 +464,209 @@ const handleAutomationTriggers = async (deviceId, sensorData, alerts) => {
   }
 };
 
-// Helper function to update device control states with actuator feedback
-const updateDeviceControlStates = async (deviceId, actuatorStates) => {
-  try {
-    const DeviceControl = require('../models/DeviceControl');
-    const deviceControl = await DeviceControl.findOne({ deviceId });
-    
-    if (!deviceControl) {
-      console.log(`Device control not found for ${deviceId}, creating new one`);
-      return;
-    }
+// Helper function to build an error the HTTP endpoint answers with 404
+const notFound = (message) => {
+  const error = new Error(message);
+  error.statusCode = 404;
+  return error;
+};
 
-    // Update relay states based on ESP32 feedback
-    if (actuatorStates.waterPump) {
-      if (deviceControl.relays.waterPump) {
-        deviceControl.relays.waterPump.state = actuatorStates.waterPump.status === 'ON';
-        deviceControl.relays.waterPump.mode = actuatorStates.waterPump.mode || 'AUTO';
-        deviceControl.relays.waterPump.lastHeartbeat = new Date();
-      }
-    }
+// Helper function to get the coarsest rollup a `groupBy` can be built from
+const getRollupResolution = (groupBy) => {
+  switch (groupBy) {
+    case 'minute':
+      return 'minute';
+    case 'day':
+    case 'week':
+    case 'month':
+      return 'day';
+    default:
+      return 'hour';
+  }
+};
 
-    if (actuatorStates.ventilationFan) {
-      if (deviceControl.relays.ventilationFan) {
-        deviceControl.relays.ventilationFan.state = actuatorStates.ventilationFan.status === 'ON';
-        deviceControl.relays.ventilationFan.mode = actuatorStates.ventilationFan.mode || 'AUTO';
-        deviceControl.relays.ventilationFan.lastHeartbeat = new Date();
-      }
-    }
+// Helper function to average a metric's rolled up sums, null like $avg when it had no values
+const rollupAverage = (prefix) => ({
+  $cond: [{ $gt: [`$${prefix}Count`, 0] }, { $divide: [`$${prefix}Sum`, `$${prefix}Count`] }, null]
+});
 
-    if (actuatorStates.fertilizerPump) {
-      if (deviceControl.relays.fertilizerPump) {
-        deviceControl.relays.fertilizerPump.state = actuatorStates.fertilizerPump.status === 'ON';
-        deviceControl.relays.fertilizerPump.lastHeartbeat = new Date();
-      }
+// Helper function to build the getAggregatedData groups from readings, in [from, to) windows of
+// [start, end] (to null for the rest of the range)
+const getReadingsPipeline = (deviceId, windows, start, end, groupBy) => [
+  {
+    $match: {
+      deviceId,
+      $or: windows.map(([from, to]) => ({
+        createdAt: to ? { $gte: from < start ? start : from, $lt: to, $lte: end } : { $gte: from, $lte: end }
+      }))
+    }
+  },
+  {
+    // readings in either storage shape, until scripts/migrateSensorData.js has run
+    $project: {
+      createdAt: 1,
+      temperature: { $ifNull: ['$readings.tempAverage', '$temperature.average'] },
+      humidity: { $ifNull: ['$readings.humAverage', '$humidity.average'] },
+      soilMoisture: { $ifNull: ['$readings.soilMoisture', '$soilMoisture.value'] },
+      lightIntensity: { $ifNull: ['$readings.lightIntensity', '$lightIntensity.value'] },
+      ph: { $ifNull: ['$readings.ph', '$ph.value'] },
+      waterTankLevel: { $ifNull: ['$readings.waterTankLevel', '$waterTankLevel.value'] },
+      alertCount: { $size: { $ifNull: ['$alerts', []] } }
     }
+  },
+  {
+    $group: {
+      _id: {
+        $dateToString: {
+          format: getDateFormat(groupBy),
+          date: '$createdAt'
+        }
+      },
+      avgTemp: { $avg: '$temperature' },
+      minTemp: { $min: '$temperature' },
+      maxTemp: { $max: '$temperature' },
+      avgHumidity: { $avg: '$humidity' },
+      minHumidity: { $min: '$humidity' },
+      maxHumidity: { $max: '$humidity' },
+      avgSoilMoisture: { $avg: '$soilMoisture' },
+      minSoilMoisture: { $min: '$soilMoisture' },
+      maxSoilMoisture: { $max: '$soilMoisture' },
+      avgLightIntensity: { $avg: '$lightIntensity' },
+      avgPh: { $avg: '$ph' },
+      avgWaterTank: { $avg: '$waterTankLevel' },
+      count: { $sum: 1 },
+      alertCount: { $sum: '$alertCount' }
+    }
+  },
+  {
+    $sort: { _id: 1 }
+  }
+];
+
+// Helper function to split rollup groups into the ones charts can use and the windows that have to
+// be grouped from readings instead, aligned with the groups so no group is built from both. Rollups
+// were matched in [from, to), see getRollupRange
+const splitRollupGroups = (groups, start, from, to, groupBy) => {
+  if (groups.length === 0) {
+    return { kept: [], windows: [[start, null]] };
+  }
+  const firstBucket = new Date(Math.min(...groups.map(group => group.firstBucket.getTime())));
+  let coveredFrom = from;
+  if (firstBucket > coveredFrom) {
+    // readings before the first rollup, up to the end of the group it is in
+    const [groupFrom, groupTo] = getGroupWindow(firstBucket, groupBy);
+    coveredFrom = groupFrom.getTime() === firstBucket.getTime() ? groupFrom : groupTo;
+  }
+  const windows = coveredFrom > start ? [[start, coveredFrom]] : [];
+  const kept = [];
+  groups.forEach(({ firstBucket: groupBucket, stale, ...group }) => {
+    if (groupBucket < coveredFrom) {
+      return;
+    }
+    if (stale) {
+      windows.push(getGroupWindow(groupBucket, groupBy));
+      return;
+    }
+    kept.push(group);
+  });
+  // the group the range ends in
+  windows.push([to, null]);
+  return { kept, windows };
+};
 
-    await deviceControl.save();
-  } catch (error) {
-    console.error('Error updating device control states:', error);
+// Helper function to get the [from, to) rollups are used for: the whole groups in [start, end]. A
+// rollup in a group the range only partly covers also holds readings from outside the range
+const getRollupRange = (start, end, groupBy) => {
+  const [startFrom, startTo] = getGroupWindow(start, groupBy);
+  const [endFrom] = getGroupWindow(end, groupBy);
+  return [startFrom < start ? startTo : startFrom, endFrom];
+};
+
+// Helper function to get the [from, to) of the group a date falls in, as getDateFormat groups
+const getGroupWindow = (date, groupBy) => {
+  const unit = ['minute', 'day', 'week', 'month'].includes(groupBy) ? groupBy : 'hour';
+  const from = moment.utc(date).startOf(unit);
+  const to = from.clone().add(1, unit);
+  if (unit === 'week') {
+    // %U weeks start on Sunday and are cut at the turn of the year
+    const year = moment.utc(date).startOf('year');
+    return [moment.max(from, year).toDate(), moment.min(to, year.clone().add(1, 'year')).toDate()];
   }
+  return [from.toDate(), to.toDate()];
 };
 
+// Helper function to build the getAggregatedData groups from rollups in [from, to), same fields as from
+// readings. `from` and `to` are group boundaries, so are bucket boundaries of the rollup `groupBy` uses
+const getRollupPipeline = (deviceId, resolution, from, to, groupBy) => [
+  {
+    $match: {
+      deviceId,
+      resolution,
+      bucket: { $gte: from, $lt: to }
+    }
+  },
+  {
+    $group: {
+      _id: {
+        $dateToString: {
+          format: getDateFormat(groupBy),
+          date: '$bucket'
+        }
+      },
+      tempSum: { $sum: '$metrics.temperature.sum' },
+      tempCount: { $sum: '$metrics.temperature.count' },
+      minTemp: { $min: '$metrics.temperature.min' },
+      maxTemp: { $max: '$metrics.temperature.max' },
+      humiditySum: { $sum: '$metrics.humidity.sum' },
+      humidityCount: { $sum: '$metrics.humidity.count' },
+      minHumidity: { $min: '$metrics.humidity.min' },
+      maxHumidity: { $max: '$metrics.humidity.max' },
+      soilMoistureSum: { $sum: '$metrics.soilMoisture.sum' },
+      soilMoistureCount: { $sum: '$metrics.soilMoisture.count' },
+      minSoilMoisture: { $min: '$metrics.soilMoisture.min' },
+      maxSoilMoisture: { $max: '$metrics.soilMoisture.max' },
+      lightIntensitySum: { $sum: '$metrics.lightIntensity.sum' },
+      lightIntensityCount: { $sum: '$metrics.lightIntensity.count' },
+      phSum: { $sum: '$metrics.ph.sum' },
+      phCount: { $sum: '$metrics.ph.count' },
+      waterTankSum: { $sum: '$metrics.waterTankLevel.sum' },
+      waterTankCount: { $sum: '$metrics.waterTankLevel.count' },
+      count: { $sum: '$count' },
+      alertCount: { $sum: '$alertCount' },
+      firstBucket: { $min: '$bucket' },
+      stale: { $max: { $ifNull: ['$stale', false] } }
+    }
+  },
+  {
+    $project: {
+      avgTemp: rollupAverage('temp'),
+      minTemp: 1,
+      maxTemp: 1,
+      avgHumidity: rollupAverage('humidity'),
+      minHumidity: 1,
+      maxHumidity: 1,
+      avgSoilMoisture: rollupAverage('soilMoisture'),
+      minSoilMoisture: 1,
+      maxSoilMoisture: 1,
+      avgLightIntensity: rollupAverage('lightIntensity'),
+      avgPh: rollupAverage('ph'),
+      avgWaterTank: rollupAverage('waterTank'),
+      count: 1,
+      alertCount: 1,
+      firstBucket: 1,
+      stale: 1
+    }
+  },
+  {
+    $sort: { _id: 1 }
+  }
+];
+
 // Helper function to get date format for aggregation
 const getDateFormat = (groupBy) => {
   switch (groupBy) {
+    case 'minute':
+      return '%Y-%m-%d %H:%M:00';
     case 'hour':
       return '%Y-%m-%d %H:00:00';
     case 'day':
@@ -568,6 +681,8 @@ const getDateFormat = (groupBy) => {
 };
 
 module.exports = {
+  ingestPipeline,
+  sensorDataBuffer,
   receiveSensorData,
   getLatestSensorData,
   getSensorHistory,
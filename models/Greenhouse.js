@@ -242,4 +242,15 @@ greenhouseSchema.statics.getStatistics = function(greenhouseId) {
     .lean();
 };
 
+// Tell in-process caches (the ingest pipeline's) which document changed, null when a query
+// changed documents it can't name
+greenhouseSchema.post('save', function(doc) {
+  doc.constructor.emit('changed', doc._id);
+});
+
+greenhouseSchema.post(['updateOne', 'updateMany', 'findOneAndUpdate', 'deleteOne', 'deleteMany', 'findOneAndDelete'], function() {
+  const filter = this.getFilter();
+  this.model.emit('changed', filter && filter._id ? filter._id : null);
+});
+
 module.exports = mongoose.model('Greenhouse', greenhouseSchema);
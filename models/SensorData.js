@@ -1,4 +1,63 @@
 const mongoose = require('mongoose');
+const SensorRegistry = require('./SensorRegistry');
+
+const alertSchema = new mongoose.Schema({
+  type: {
+    type: String,
+    enum: ['temperature_high', 'temperature_low', 'humidity_high', 'humidity_low', 
+           'soil_moisture_low', 'ph_high', 'ph_low', 'water_tank_low', 'sensor_error']
+  },
+  message: String,
+  severity: {
+    type: String,
+    enum: ['low', 'medium', 'high', 'critical'],
+    default: 'medium'
+  },
+  acknowledged: { type: Boolean, default: false }
+});
+
+const actuatorStatesSchema = new mongoose.Schema({
+  waterPump: {
+    status: { type: String, enum: ['ON', 'OFF'], default: 'OFF' },
+    mode: { type: String, enum: ['AUTO', 'MANUAL'], default: 'AUTO' }
+  },
+  ventilationFan: {
+    status: { type: String, enum: ['ON', 'OFF'], default: 'OFF' },
+    mode: { type: String, enum: ['AUTO', 'MANUAL'], default: 'AUTO' }
+  },
+  fertilizerPump: {
+    status: { type: String, enum: ['ON', 'OFF'], default: 'OFF' }
+  }
+}, { _id: false });
+
+const deviceStatusSchema = new mongoose.Schema({
+  batteryLevel: Number,
+  wifiSignal: Number,
+  uptime: Number,
+  lastHeartbeat: Date
+}, { _id: false });
+
+// Where readings are kept. SENSOR_STORAGE=timeseries uses a MongoDB time-series collection
+// (MongoDB 6.3+) instead of a plain one, a separate collection that
+// scripts/migrateSensorTimeSeries.js copies readings into. The device is the series, its greenhouse
+// and user are the same for all of its readings and cost next to nothing in a bucket. Buckets span
+// SENSOR_TIMESERIES_BUCKET seconds (2700 by default, about 900 readings at our 3 s cadence and under
+// the 1000 readings a bucket holds), or one of MongoDB's granularities ('seconds', 'minutes').
+const storage = process.env.SENSOR_STORAGE === 'timeseries' ? 'timeseries' : 'collection';
+const collectionNames = { collection: 'sensordatas', timeseries: 'sensorreadings' };
+const bucket = process.env.SENSOR_TIMESERIES_BUCKET || '2700';
+const timeseriesOptions = isNaN(parseInt(bucket))
+  ? { timeField: 'createdAt', metaField: 'deviceId', granularity: bucket }
+  : { timeField: 'createdAt', metaField: 'deviceId', bucketMaxSpanSeconds: parseInt(bucket), bucketRoundingSeconds: parseInt(bucket) };
+
+const schemaOptions = {
+  collection: collectionNames[storage],
+  // readings are never updated, createdAt is also when they were processed
+  timestamps: { createdAt: true, updatedAt: false }
+};
+if (storage === 'timeseries') {
+  schemaOptions.timeseries = timeseriesOptions;
+}
 
 const sensorDataSchema = new mongoose.Schema({
   deviceId: {
@@ -20,136 +79,53 @@ const sensorDataSchema = new mongoose.Schema({
     index: true
   },
   
-  // Temperature sensors (2 DHT11 sensors)
-  temperature: {
-    temp1: {
-      value: { type: Number, required: true },
-      unit: { type: String, default: 'C' },
-      sensorType: { type: String, default: 'DHT11' },
-      location: { type: String, default: 'Zone 1' }
-    },
-    temp2: {
-      value: { type: Number, required: true },
-      unit: { type: String, default: 'C' },
-      sensorType: { type: String, default: 'DHT11' },
-      location: { type: String, default: 'Zone 2' }
-    },
-    average: { type: Number }
+  // One number per channel, what the channels are (unit, sensor type, location) is kept once per
+  // device in SensorRegistry, see toApi() for the shape the API returns
+  readings: {
+    temp1: { type: Number, required: true },
+    temp2: { type: Number, required: true },
+    tempAverage: { type: Number },
+    hum1: { type: Number, required: true },
+    hum2: { type: Number, required: true },
+    humAverage: { type: Number },
+    soilMoisture: { type: Number, required: true },
+    lightIntensity: { type: Number, required: true },
+    ph: { type: Number, required: true },
+    waterTankLevel: { type: Number, required: true }
   },
   
-  // Humidity sensors (2 DHT11 sensors)
-  humidity: {
-    hum1: {
-      value: { type: Number, required: true },
-      unit: { type: String, default: '%' },
-      sensorType: { type: String, default: 'DHT11' },
-      location: { type: String, default: 'Zone 1' }
-    },
-    hum2: {
-      value: { type: Number, required: true },
-      unit: { type: String, default: '%' },
-      sensorType: { type: String, default: 'DHT11' },
-      location: { type: String, default: 'Zone 2' }
-    },
-    average: { type: Number }
-  },
-  
-  // Soil moisture sensor
-  soilMoisture: {
-    value: { type: Number, required: true },
-    unit: { type: String, default: '%' },
-    sensorType: { type: String, default: 'Capacitive' },
-    location: { type: String, default: 'Soil bed' }
-  },
-  
-  // Light intensity sensor
-  lightIntensity: {
-    value: { type: Number, required: true },
-    unit: { type: String, default: '%' },
-    sensorType: { type: String, default: 'LDR' },
-    location: { type: String, default: 'Canopy level' }
-  },
-  
-  // pH sensor
-  ph: {
-    value: { type: Number, required: true },
-    unit: { type: String, default: 'pH' },
-    sensorType: { type: String, default: 'pH probe' },
-    location: { type: String, default: 'Nutrient solution' }
-  },
-  
-  // Water tank level
-  waterTankLevel: {
-    value: { type: Number, required: true },
-    unit: { type: String, default: '%' },
-    sensorType: { type: String, default: 'Ultrasonic' },
-    location: { type: String, default: 'Main water tank' }
-  },
-  
-  // Data quality and status
+  // Data quality and status, not stored when 'good'
   dataQuality: {
     type: String,
-    enum: ['good', 'warning', 'error'],
-    default: 'good'
+    enum: ['good', 'warning', 'error']
   },
   
-  alerts: [{
-    type: {
-      type: String,
-      enum: ['temperature_high', 'temperature_low', 'humidity_high', 'humidity_low', 
-             'soil_moisture_low', 'ph_high', 'ph_low', 'water_tank_low', 'sensor_error']
-    },
-    message: String,
-    severity: {
-      type: String,
-      enum: ['low', 'medium', 'high', 'critical'],
-      default: 'medium'
-    },
-    acknowledged: { type: Boolean, default: false }
-  }],
+  // Only stored when there are any
+  alerts: {
+    type: [alertSchema],
+    default: undefined
+  },
   
-  // Actuator states (from ESP32 feedback)
+  // Actuator states (from ESP32 feedback), only stored when the device reports them
   actuatorStates: {
-    waterPump: {
-      status: { type: String, enum: ['ON', 'OFF'], default: 'OFF' },
-      mode: { type: String, enum: ['AUTO', 'MANUAL'], default: 'AUTO' }
-    },
-    ventilationFan: {
-      status: { type: String, enum: ['ON', 'OFF'], default: 'OFF' },
-      mode: { type: String, enum: ['AUTO', 'MANUAL'], default: 'AUTO' }
-    },
-    fertilizerPump: {
-      status: { type: String, enum: ['ON', 'OFF'], default: 'OFF' }
-    }
+    type: actuatorStatesSchema,
+    default: undefined
   },
   
-  // RFID data
-  rfidData: {
-    type: String,
-    default: 'NoCard'
-  },
+  // RFID data, not stored when 'NoCard'
+  rfidData: String,
   
-  // ESP32/Arduino status
+  // ESP32/Arduino status, only stored when the device reports it
   deviceStatus: {
-    batteryLevel: Number,
-    wifiSignal: Number,
-    uptime: Number,
-    lastHeartbeat: { type: Date, default: Date.now }
+    type: deviceStatusSchema,
+    default: undefined
   },
   
-  // Raw sensor readings for debugging
+  // Raw sensor readings for debugging, only stored when the device sends them
   rawData: {
     type: mongoose.Schema.Types.Mixed
-  },
-  
-  // Processing timestamp
-  processedAt: {
-    type: Date,
-    default: Date.now
   }
-}, {
-  timestamps: true
-});
+}, schemaOptions);
 
 // Indexes for performance
 sensorDataSchema.index({ createdAt: -1 });
@@ -157,100 +133,229 @@ sensorDataSchema.index({ deviceId: 1, createdAt: -1 });
 sensorDataSchema.index({ userId: 1, createdAt: -1 });
 sensorDataSchema.index({ greenhouseId: 1, createdAt: -1 });
 
+sensorDataSchema.statics.storage = storage;
+sensorDataSchema.statics.collectionNames = collectionNames;
+sensorDataSchema.statics.timeseriesOptions = timeseriesOptions;
+
 // Pre-save middleware to calculate averages and detect alerts
 sensorDataSchema.pre('save', function(next) {
-  // Calculate temperature average
-  if (this.temperature.temp1.value && this.temperature.temp2.value) {
-    this.temperature.average = (this.temperature.temp1.value + this.temperature.temp2.value) / 2;
-  }
-  
-  // Calculate humidity average
-  if (this.humidity.hum1.value && this.humidity.hum2.value) {
-    this.humidity.average = (this.humidity.hum1.value + this.humidity.hum2.value) / 2;
-  }
-  
+  this.calculateAverages();
   next();
 });
 
-// Static method to get latest data for a device
+// Static method to get latest data for a device, as plain objects in either storage shape (see toApi)
 sensorDataSchema.statics.getLatestByDevice = function(deviceId, limit = 1) {
   return this.find({ deviceId })
     .sort({ createdAt: -1 })
     .limit(limit)
     .populate('userId', 'username firstName lastName')
-    .populate('greenhouseId', 'name location');
+    .populate('greenhouseId', 'name location')
+    .lean();
 };
 
-// Static method to get data within time range
+// Static method to get data within time range, as plain objects in either storage shape (see toApi)
 sensorDataSchema.statics.getDataInRange = function(deviceId, startDate, endDate) {
   return this.find({
     deviceId,
     createdAt: { $gte: startDate, $lte: endDate }
-  }).sort({ createdAt: 1 });
+  }).sort({ createdAt: 1 }).lean();
+};
+
+// Static method to find which of these readings are stored already, time-series collections have
+// no unique _id index to reject them. Looks only within the readings' devices and time range.
+sensorDataSchema.statics.storedIds = async function(readings) {
+  if (readings.length === 0) {
+    return new Set();
+  }
+  const times = readings.map(reading => new Date(reading.createdAt).getTime());
+  const stored = await this.collection.find({
+    deviceId: { $in: [...new Set(readings.map(reading => reading.deviceId))] },
+    createdAt: { $gte: new Date(Math.min(...times)), $lte: new Date(Math.max(...times)) },
+    _id: { $in: readings.map(reading => reading._id) }
+  }, { projection: { _id: 1 } }).toArray();
+  return new Set(stored.map(reading => String(reading._id)));
+};
+
+// Static method to turn a reading into the shape the API has always returned, one object per
+// channel with its unit, sensor type and location. `channels` are the device's from SensorRegistry.
+// Readings stored before the slim schema (see scripts/migrateSensorData.js) already have that shape.
+sensorDataSchema.statics.toApi = function(sensorData, channels = SensorRegistry.defaultChannels) {
+  const data = typeof sensorData.toObject === 'function' ? sensorData.toObject() : sensorData;
+  if (!data.readings) {
+    return data;
+  }
+
+  const { readings, ...rest } = data;
+  const channel = (name) => ({ value: readings[name], ...channels[name] });
+  return {
+    ...rest,
+    temperature: {
+      temp1: channel('temp1'),
+      temp2: channel('temp2'),
+      average: readings.tempAverage
+    },
+    humidity: {
+      hum1: channel('hum1'),
+      hum2: channel('hum2'),
+      average: readings.humAverage
+    },
+    soilMoisture: channel('soilMoisture'),
+    lightIntensity: channel('lightIntensity'),
+    ph: channel('ph'),
+    waterTankLevel: channel('waterTankLevel'),
+    dataQuality: data.dataQuality || 'good',
+    alerts: data.alerts || [],
+    actuatorStates: data.actuatorStates || {},
+    rfidData: data.rfidData || 'NoCard',
+    deviceStatus: { lastHeartbeat: data.createdAt, ...data.deviceStatus },
+    processedAt: data.createdAt,
+    updatedAt: data.createdAt
+  };
+};
+
+// Static method to convert a reading stored before the slim schema, returns the slim document
+// and the channels its metadata describes
+sensorDataSchema.statics.fromLegacy = function(legacy) {
+  const temperature = legacy.temperature || {};
+  const humidity = legacy.humidity || {};
+  const legacyChannels = {
+    temp1: temperature.temp1,
+    temp2: temperature.temp2,
+    hum1: humidity.hum1,
+    hum2: humidity.hum2,
+    soilMoisture: legacy.soilMoisture,
+    lightIntensity: legacy.lightIntensity,
+    ph: legacy.ph,
+    waterTankLevel: legacy.waterTankLevel
+  };
+
+  const readings = {};
+  const channels = {};
+  Object.entries(legacyChannels).forEach(([name, legacyChannel]) => {
+    readings[name] = legacyChannel && legacyChannel.value !== undefined ? legacyChannel.value : 0;
+    channels[name] = {
+      unit: (legacyChannel && legacyChannel.unit) || SensorRegistry.defaultChannels[name].unit,
+      sensorType: (legacyChannel && legacyChannel.sensorType) || SensorRegistry.defaultChannels[name].sensorType,
+      location: (legacyChannel && legacyChannel.location) || SensorRegistry.defaultChannels[name].location
+    };
+  });
+  if (temperature.average !== undefined) {
+    readings.tempAverage = temperature.average;
+  }
+  if (humidity.average !== undefined) {
+    readings.humAverage = humidity.average;
+  }
+
+  const slim = {
+    _id: legacy._id,
+    deviceId: legacy.deviceId,
+    greenhouseId: legacy.greenhouseId,
+    userId: legacy.userId,
+    readings,
+    createdAt: legacy.createdAt || legacy.processedAt
+  };
+  if (legacy.dataQuality && legacy.dataQuality !== 'good') {
+    slim.dataQuality = legacy.dataQuality;
+  }
+  if (legacy.alerts && legacy.alerts.length > 0) {
+    slim.alerts = legacy.alerts;
+  }
+  if (legacy.actuatorStates && Object.keys(legacy.actuatorStates).length > 0) {
+    slim.actuatorStates = legacy.actuatorStates;
+  }
+  if (legacy.rfidData && legacy.rfidData !== 'NoCard') {
+    slim.rfidData = legacy.rfidData;
+  }
+  if (legacy.deviceStatus && Object.keys(legacy.deviceStatus).some(key => key !== 'lastHeartbeat')) {
+    slim.deviceStatus = legacy.deviceStatus;
+  }
+  // rawData was a copy of the whole request unless the device sent its own, only keep the latter
+  const rawData = legacy.rawData;
+  const isRequestCopy = rawData && typeof rawData === 'object' &&
+    (rawData.sensors !== undefined || rawData.deviceId !== undefined || rawData.temp1 !== undefined);
+  if (rawData !== undefined && rawData !== null && !isRequestCopy) {
+    slim.rawData = rawData;
+  }
+  return { slim, channels };
+};
+
+// Instance method to calculate the temperature and humidity averages, done on save and by the
+// write-behind buffer, which inserts without save middleware
+sensorDataSchema.methods.calculateAverages = function() {
+  // Calculate temperature average
+  if (this.readings.temp1 && this.readings.temp2) {
+    this.readings.tempAverage = (this.readings.temp1 + this.readings.temp2) / 2;
+  }
+  
+  // Calculate humidity average
+  if (this.readings.hum1 && this.readings.hum2) {
+    this.readings.humAverage = (this.readings.hum1 + this.readings.hum2) / 2;
+  }
 };
 
 // Instance method to check if data is within normal ranges
 sensorDataSchema.methods.checkAlerts = function(thresholds) {
   const alerts = [];
+  const readings = this.readings;
   
   // Temperature alerts
-  if (this.temperature.average > thresholds.tempMax) {
+  if (readings.tempAverage > thresholds.tempMax) {
     alerts.push({
       type: 'temperature_high',
-      message: `Temperature is too high: ${this.temperature.average}°C`,
+      message: `Temperature is too high: ${readings.tempAverage}°C`,
       severity: 'high'
     });
-  } else if (this.temperature.average < thresholds.tempMin) {
+  } else if (readings.tempAverage < thresholds.tempMin) {
     alerts.push({
       type: 'temperature_low',
-      message: `Temperature is too low: ${this.temperature.average}°C`,
+      message: `Temperature is too low: ${readings.tempAverage}°C`,
       severity: 'high'
     });
   }
   
   // Humidity alerts
-  if (this.humidity.average > thresholds.humidityMax) {
+  if (readings.humAverage > thresholds.humidityMax) {
     alerts.push({
       type: 'humidity_high',
-      message: `Humidity is too high: ${this.humidity.average}%`,
+      message: `Humidity is too high: ${readings.humAverage}%`,
       severity: 'medium'
     });
-  } else if (this.humidity.average < thresholds.humidityMin) {
+  } else if (readings.humAverage < thresholds.humidityMin) {
     alerts.push({
       type: 'humidity_low',
-      message: `Humidity is too low: ${this.humidity.average}%`,
+      message: `Humidity is too low: ${readings.humAverage}%`,
       severity: 'medium'
     });
   }
   
   // Soil moisture alert
-  if (this.soilMoisture.value < thresholds.soilMoistureMin) {
+  if (readings.soilMoisture < thresholds.soilMoistureMin) {
     alerts.push({
       type: 'soil_moisture_low',
-      message: `Soil moisture is low: ${this.soilMoisture.value}%`,
+      message: `Soil moisture is low: ${readings.soilMoisture}%`,
       severity: 'high'
     });
   }
   
   // pH alerts
-  if (this.ph.value > thresholds.phMax || this.ph.value < thresholds.phMin) {
+  if (readings.ph > thresholds.phMax || readings.ph < thresholds.phMin) {
     alerts.push({
-      type: this.ph.value > thresholds.phMax ? 'ph_high' : 'ph_low',
-      message: `pH level is abnormal: ${this.ph.value}`,
+      type: readings.ph > thresholds.phMax ? 'ph_high' : 'ph_low',
+      message: `pH level is abnormal: ${readings.ph}`,
       severity: 'medium'
     });
   }
   
   // Water tank alert
-  if (this.waterTankLevel.value < thresholds.waterTankMin) {
+  if (readings.waterTankLevel < thresholds.waterTankMin) {
     alerts.push({
       type: 'water_tank_low',
-      message: `Water tank level is low: ${this.waterTankLevel.value}%`,
+      message: `Water tank level is low: ${readings.waterTankLevel}%`,
       severity: 'critical'
     });
   }
   
-  this.alerts = alerts;
+  this.alerts = alerts.length > 0 ? alerts : undefined;
   return alerts;
 };
 
@@ -0,0 +1,52 @@
+const mongoose = require('mongoose');
+
+// What a device's channels measure, kept once per device instead of on every reading. The keys
+// are the ones SensorData stores its readings under.
+const channelSchema = new mongoose.Schema({
+  unit: { type: String, required: true },
+  sensorType: { type: String, required: true },
+  location: { type: String, required: true }
+}, { _id: false });
+
+const sensorRegistrySchema = new mongoose.Schema({
+  deviceId: {
+    type: String,
+    required: [true, 'Device ID is required'],
+    trim: true,
+    unique: true
+  },
+  channels: {
+    type: Map,
+    of: channelSchema
+  }
+}, {
+  timestamps: true
+});
+
+// Channels of the Arduino node, readings of devices that aren't registered are described with these
+const defaultChannels = {
+  temp1: { unit: 'C', sensorType: 'DHT11', location: 'Zone 1' },
+  temp2: { unit: 'C', sensorType: 'DHT11', location: 'Zone 2' },
+  hum1: { unit: '%', sensorType: 'DHT11', location: 'Zone 1' },
+  hum2: { unit: '%', sensorType: 'DHT11', location: 'Zone 2' },
+  soilMoisture: { unit: '%', sensorType: 'Capacitive', location: 'Soil bed' },
+  lightIntensity: { unit: '%', sensorType: 'LDR', location: 'Canopy level' },
+  ph: { unit: 'pH', sensorType: 'pH4502C', location: 'Nutrient solution' },
+  waterTankLevel: { unit: '%', sensorType: 'Ultrasonic', location: 'Main water tank' }
+};
+
+sensorRegistrySchema.statics.defaultChannels = defaultChannels;
+
+// Static method to get the channels of several devices as deviceId -> channels, devices that
+// aren't registered get the default channels
+sensorRegistrySchema.statics.channelsFor = async function(deviceIds) {
+  const unique = [...new Set(deviceIds)];
+  const entries = await this.find({ deviceId: { $in: unique } }).lean();
+  const channels = new Map(unique.map(deviceId => [deviceId, defaultChannels]));
+  entries.forEach(entry => {
+    channels.set(entry.deviceId, { ...defaultChannels, ...entry.channels });
+  });
+  return channels;
+};
+
+module.exports = mongoose.model('SensorRegistry', sensorRegistrySchema);
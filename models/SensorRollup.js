@@ -0,0 +1,168 @@
+const mongoose = require('mongoose');
+
+// Per-metric totals of one device's readings in one minute, hour or day, kept up to date as readings
+// are stored (see SensorDataBuffer) so charts don't have to group raw readings. Averages are
+// sum / count, count only counts readings that had the metric.
+const metricSchema = new mongoose.Schema({
+  sum: Number,
+  count: Number,
+  min: Number,
+  max: Number
+}, { _id: false });
+
+const sensorRollupSchema = new mongoose.Schema({
+  deviceId: {
+    type: String,
+    required: [true, 'Device ID is required'],
+    trim: true
+  },
+  greenhouseId: {
+    type: mongoose.Schema.Types.ObjectId,
+    ref: 'Greenhouse'
+  },
+  resolution: {
+    type: String,
+    enum: ['minute', 'hour', 'day'],
+    required: true
+  },
+  // Start of the period, UTC
+  bucket: {
+    type: Date,
+    required: true
+  },
+  // no defaults, upserts $inc these
+  count: Number,
+  alertCount: Number,
+  metrics: {
+    temperature: metricSchema,
+    humidity: metricSchema,
+    soilMoisture: metricSchema,
+    lightIntensity: metricSchema,
+    ph: metricSchema,
+    waterTankLevel: metricSchema
+  },
+  // Set when an update failed, charts group the period's readings instead until
+  // scripts/rebuildSensorRollups.js replaces the rollup
+  stale: Boolean
+});
+
+// Indexes for performance
+sensorRollupSchema.index({ deviceId: 1, resolution: 1, bucket: 1 }, { unique: true });
+// Minute rollups are only kept for 30 days, hours and days are enough for longer charts
+sensorRollupSchema.index({ bucket: 1 }, {
+  expireAfterSeconds: 30 * 24 * 60 * 60,
+  partialFilterExpression: { resolution: 'minute' }
+});
+
+// Period length of each resolution
+const periods = {
+  minute: 60 * 1000,
+  hour: 60 * 60 * 1000,
+  day: 24 * 60 * 60 * 1000
+};
+
+// Rolled up metric -> field under SensorData's `readings`
+const metricFields = {
+  temperature: 'tempAverage',
+  humidity: 'humAverage',
+  soilMoisture: 'soilMoisture',
+  lightIntensity: 'lightIntensity',
+  ph: 'ph',
+  waterTankLevel: 'waterTankLevel'
+};
+
+sensorRollupSchema.statics.periods = periods;
+sensorRollupSchema.statics.metricFields = metricFields;
+
+// The minute, hour and day a reading is rolled up into
+const bucketsOf = (reading) => {
+  const time = new Date(reading.createdAt).getTime();
+  return Object.entries(periods).map(([resolution, period]) => ({
+    resolution,
+    bucket: new Date(Math.floor(time / period) * period)
+  }));
+};
+
+// Static method to add stored readings to their rollups, in one upsert per device and period
+sensorRollupSchema.statics.applyReadings = async function(readings) {
+  const totals = new Map();
+  readings.forEach(reading => {
+    bucketsOf(reading).forEach(({ resolution, bucket }) => {
+      const key = `${reading.deviceId}|${resolution}|${bucket.getTime()}`;
+      let total = totals.get(key);
+      if (!total) {
+        total = { deviceId: reading.deviceId, greenhouseId: reading.greenhouseId, resolution, bucket, count: 0, alertCount: 0, metrics: {} };
+        totals.set(key, total);
+      }
+      total.count += 1;
+      total.alertCount += reading.alerts ? reading.alerts.length : 0;
+      Object.entries(metricFields).forEach(([metric, field]) => {
+        const value = reading.readings ? reading.readings[field] : undefined;
+        if (typeof value !== 'number' || isNaN(value)) {
+          return;
+        }
+        const metricTotal = total.metrics[metric];
+        if (metricTotal) {
+          metricTotal.sum += value;
+          metricTotal.count += 1;
+          metricTotal.min = Math.min(metricTotal.min, value);
+          metricTotal.max = Math.max(metricTotal.max, value);
+        } else {
+          total.metrics[metric] = { sum: value, count: 1, min: value, max: value };
+        }
+      });
+    });
+  });
+  if (totals.size === 0) {
+    return;
+  }
+
+  const ops = [...totals.values()].map(total => {
+    const update = {
+      $setOnInsert: { greenhouseId: total.greenhouseId },
+      $inc: { count: total.count, alertCount: total.alertCount }
+    };
+    const metrics = Object.entries(total.metrics);
+    if (metrics.length > 0) {
+      update.$min = {};
+      update.$max = {};
+      metrics.forEach(([metric, metricTotal]) => {
+        update.$inc[`metrics.${metric}.sum`] = metricTotal.sum;
+        update.$inc[`metrics.${metric}.count`] = metricTotal.count;
+        update.$min[`metrics.${metric}.min`] = metricTotal.min;
+        update.$max[`metrics.${metric}.max`] = metricTotal.max;
+      });
+    }
+    return {
+      updateOne: {
+        filter: { deviceId: total.deviceId, resolution: total.resolution, bucket: total.bucket },
+        update,
+        upsert: true
+      }
+    };
+  });
+  await this.bulkWrite(ops, { ordered: false });
+};
+
+// Static method to mark the rollups of readings whose update failed, creating missing ones
+sensorRollupSchema.statics.markStale = async function(readings) {
+  const keys = new Map();
+  readings.forEach(reading => {
+    bucketsOf(reading).forEach(({ resolution, bucket }) => {
+      keys.set(`${reading.deviceId}|${resolution}|${bucket.getTime()}`, { deviceId: reading.deviceId, greenhouseId: reading.greenhouseId, resolution, bucket });
+    });
+  });
+  if (keys.size === 0) {
+    return;
+  }
+  const ops = [...keys.values()].map(key => ({
+    updateOne: {
+      filter: { deviceId: key.deviceId, resolution: key.resolution, bucket: key.bucket },
+      update: { $set: { stale: true }, $setOnInsert: { greenhouseId: key.greenhouseId } },
+      upsert: true
+    }
+  }));
+  await this.bulkWrite(ops, { ordered: false });
+};
+
+module.exports = mongoose.model('SensorRollup', sensorRollupSchema);
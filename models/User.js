@@ -107,4 +107,15 @@ userSchema.methods.toJSON = function() {
   return user;
 };
 
+// Tell in-process caches (the ingest pipeline's) which document changed, null when a query
+// changed documents it can't name
+userSchema.post('save', function(doc) {
+  doc.constructor.emit('changed', doc._id);
+});
+
+userSchema.post(['updateOne', 'updateMany', 'findOneAndUpdate', 'deleteOne', 'deleteMany', 'findOneAndDelete'], function() {
+  const filter = this.getFilter();
+  this.model.emit('changed', filter && filter._id ? filter._id : null);
+});
+
 module.exports = mongoose.model('User', userSchema);
@@ -5,7 +5,8 @@
   'targets': [{
     'target_name': 'bindings',
     'sources': [
-      'src/serialport.cpp'
+      'src/serialport.cpp',
+      'src/worker_pool.cpp'
     ],
     'include_dirs': ["<!(node -p \"require('node-addon-api').include_dir\")"],
     'cflags!': [ '-fno-exceptions' ],
@@ -54,7 +55,19 @@
           'sources': [
             'src/serialport_unix.cpp',
             'src/poller.cpp',
-            'src/serialport_linux.cpp'
+            'src/serialport_linux.cpp',
+            'src/linux_list.cpp',
+            'src/linux_hotplug.cpp',
+            'src/linux_coalescer.cpp',
+            'src/linux_uring.cpp',
+            'src/linux_capture.cpp',
+            'src/linux_pty.cpp',
+            'src/linux_bridge.cpp',
+            'src/linux_shared.cpp',
+            'src/linux_transaction.cpp',
+            'src/linux_detect.cpp',
+            'src/linux_mock.cpp',
+            'src/linux_modem.cpp'
           ]
         }
       ],
@@ -63,7 +76,19 @@
           'sources': [
             'src/serialport_unix.cpp',
             'src/poller.cpp',
-            'src/serialport_linux.cpp'
+            'src/serialport_linux.cpp',
+            'src/linux_list.cpp',
+            'src/linux_hotplug.cpp',
+            'src/linux_coalescer.cpp',
+            'src/linux_uring.cpp',
+            'src/linux_capture.cpp',
+            'src/linux_pty.cpp',
+            'src/linux_bridge.cpp',
+            'src/linux_shared.cpp',
+            'src/linux_transaction.cpp',
+            'src/linux_detect.cpp',
+            'src/linux_mock.cpp',
+            'src/linux_modem.cpp'
           ]
         }
       ],
@@ -8,6 +8,16 @@ export interface DarwinOpenOptions extends OpenOptions {
     vmin?: number;
     /** see [`man termios`](http://linux.die.net/man/3/termios) defaults to 0 */
     vtime?: number;
+    /**
+     * Let the tty assemble lines (ICANON). Each read returns at most one complete line, partial lines
+     * stay in the kernel until their newline arrives. vmin and vtime are ignored. Meant for text protocols,
+     * lines longer than the kernel's line buffer (4095 bytes on linux) are truncated. Defaults to false
+     */
+    icanon?: boolean;
+    /** Translate CR to NL on input (ICRNL), for devices that end lines with a bare CR. Defaults to false */
+    icrnl?: boolean;
+    /** Discard CR on input (IGNCR), for CRLF terminated lines. Defaults to false */
+    igncr?: boolean;
 }
 export type DarwinBindingInterface = BindingInterface<DarwinPortBinding, DarwinOpenOptions>;
 export declare const DarwinBinding: DarwinBindingInterface;
@@ -33,6 +43,17 @@ export declare class DarwinPortBinding implements BindingPortInterface {
     getBaudRate(): Promise<{
         baudRate: number;
     }>;
+    /**
+     * Same as `set()` but runs on the calling thread, changing the control lines is a single non blocking ioctl
+     */
+    setSync(options: SetOptions): void;
+    /**
+     * Same as `get()` but runs on the calling thread, cheap enough to poll the control lines at high frequency
+     */
+    getSync(): PortStatus;
+    getBaudRateSync(): {
+        baudRate: number;
+    };
     flush(): Promise<void>;
     drain(): Promise<void>;
 }
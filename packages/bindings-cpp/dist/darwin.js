@@ -26,7 +26,7 @@ exports.DarwinBinding = {
             throw new TypeError('"baudRate" is not a valid baudRate');
         }
         debug('open');
-        const openOptions = Object.assign({ vmin: 1, vtime: 0, dataBits: 8, lock: true, stopBits: 1, parity: 'none', rtscts: false, xon: false, xoff: false, xany: false, hupcl: true }, options);
+        const openOptions = Object.assign({ vmin: 1, vtime: 0, icanon: false, icrnl: false, igncr: false, dataBits: 8, lock: true, stopBits: 1, parity: 'none', rtscts: false, xon: false, xoff: false, xany: false, hupcl: true }, options);
         const fd = await (0, load_bindings_1.asyncOpen)(openOptions.path, openOptions);
         return new DarwinPortBinding(fd, openOptions);
     },
@@ -129,6 +129,36 @@ class DarwinPortBinding {
         }
         throw new Error('getBaudRate is not implemented on darwin');
     }
+    /**
+     * Same as `set()` but runs on the calling thread, changing the control lines is a single non blocking ioctl
+     */
+    setSync(options) {
+        if (!options || typeof options !== 'object' || Array.isArray(options)) {
+            throw new TypeError('"options" is not an object');
+        }
+        debug('setSync', options);
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        (0, load_bindings_1.syncSet)(this.fd, options);
+    }
+    /**
+     * Same as `get()` but runs on the calling thread, cheap enough to poll the control lines at high frequency
+     */
+    getSync() {
+        debug('getSync');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        return (0, load_bindings_1.syncGet)(this.fd);
+    }
+    getBaudRateSync() {
+        debug('getBaudRateSync');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        throw new Error('getBaudRate is not implemented on darwin');
+    }
     async flush() {
         debug('flush');
         if (!this.isOpen) {
@@ -4,6 +4,19 @@ import { WindowsBindingInterface } from './win32';
 export * from '@serialport/bindings-interface';
 export * from './darwin';
 export * from './linux';
+export * from './linux-hotplug';
+export * from './linux-reconnect';
+export * from './linux-coalesce';
+export * from './linux-uring';
+export * from './linux-capture';
+export * from './linux-replay';
+export * from './linux-bridge';
+export * from './linux-shared';
+export * from './linux-transaction';
+export * from './linux-mock';
+export * from './linux-modem';
+export * from './thread-pool';
+export { setPollBatching, getPollBatchStats, hasPollBatching, PollBatchStats } from './poller';
 export * from './win32';
 export * from './errors';
 export type AutoDetectTypes = DarwinBindingInterface | WindowsBindingInterface | LinuxBindingInterface;
@@ -17,6 +17,7 @@ var __importDefault = (this && this.__importDefault) || function (mod) {
     return (mod && mod.__esModule) ? mod : { "default": mod };
 };
 Object.defineProperty(exports, "__esModule", { value: true });
+exports.hasPollBatching = exports.getPollBatchStats = exports.setPollBatching = void 0;
 exports.autoDetect = autoDetect;
 /* eslint-disable @typescript-eslint/no-var-requires */
 const debug_1 = __importDefault(require("debug"));
@@ -27,6 +28,22 @@ const debug = (0, debug_1.default)('serialport/bindings-cpp');
 __exportStar(require("@serialport/bindings-interface"), exports);
 __exportStar(require("./darwin"), exports);
 __exportStar(require("./linux"), exports);
+__exportStar(require("./linux-hotplug"), exports);
+__exportStar(require("./linux-reconnect"), exports);
+__exportStar(require("./linux-coalesce"), exports);
+__exportStar(require("./linux-uring"), exports);
+__exportStar(require("./linux-capture"), exports);
+__exportStar(require("./linux-replay"), exports);
+__exportStar(require("./linux-bridge"), exports);
+__exportStar(require("./linux-shared"), exports);
+__exportStar(require("./linux-transaction"), exports);
+__exportStar(require("./linux-mock"), exports);
+__exportStar(require("./linux-modem"), exports);
+__exportStar(require("./thread-pool"), exports);
+var poller_1 = require("./poller");
+Object.defineProperty(exports, "setPollBatching", { enumerable: true, get: function () { return poller_1.setPollBatching; } });
+Object.defineProperty(exports, "getPollBatchStats", { enumerable: true, get: function () { return poller_1.getPollBatchStats; } });
+Object.defineProperty(exports, "hasPollBatching", { enumerable: true, get: function () { return poller_1.hasPollBatching; } });
 __exportStar(require("./win32"), exports);
 __exportStar(require("./errors"), exports);
 /**
@@ -0,0 +1,86 @@
+/// <reference types="node" />
+import { EventEmitter } from 'events';
+export declare const hasSerialBridge: boolean;
+export interface SerialBridgeOptions {
+    /** Address to listen on, an IPv4 or IPv6 literal. Defaults to 127.0.0.1 */
+    host?: string;
+    /** TCP port, 0 picks a free one. Defaults to 0 */
+    port?: number;
+    /** Connections beyond this are closed as soon as they are accepted. Defaults to 8 */
+    maxClients?: number;
+    /** Only pass whole frames ending with this on, in both directions */
+    delimiter?: number | string | Buffer | number[];
+    /** Longer frames are passed on without waiting for their delimiter. Defaults to 65536 */
+    maxFrame?: number;
+    /** Unsent bytes on a connection (or to the port) before reading stops. Defaults to 65536 */
+    highWaterMark?: number;
+}
+export interface SerialBridgeClientStats {
+    id: number;
+    /** remote address and port */
+    address: string;
+    /** received from the connection */
+    bytesIn: number;
+    /** sent to the connection */
+    bytesOut: number;
+    framesIn: number;
+    framesOut: number;
+    /** waiting to be sent to the connection */
+    queued: number;
+}
+export interface SerialBridgeStats {
+    bytesFromPort: number;
+    bytesToPort: number;
+    framesFromPort: number;
+    framesToPort: number;
+    /** read from the port while nobody was connected */
+    dropped: number;
+    /** times reading the port paused for a slow connection */
+    stalls: number;
+    /** connections closed because of `maxClients` */
+    rejected: number;
+    /** connections accepted since the bridge started */
+    connections: number;
+    /** waiting to be written to the port */
+    queuedToPort: number;
+    clients: SerialBridgeClientStats[];
+}
+/**
+ * Serves an open port on a TCP socket, like ser2net, so a node on another box's serial port can be
+ * reached over the network. Bytes are moved between the port and the connections natively.
+ *
+ * Everything read from the port goes to every connection (up to `maxClients`), what a connection sends
+ * is written to the port. With a `delimiter` only whole frames are passed on in either direction, so a
+ * new connection starts at a frame boundary and two connections' commands never interleave.
+ *
+ * A connection with more than `highWaterMark` bytes unsent pauses reading the port until it is down to
+ * half, the data waits in the kernel. Without connections the port's data is dropped.
+ *
+ * Don't read or write the port while it is bridged. Emits 'connection' ({ id, address }),
+ * 'disconnect' ({ id, error }) and 'error' when the port fails, after which the bridge is closed.
+ */
+export declare class SerialBridge extends EventEmitter {
+    private native;
+    private closed;
+    constructor(port: number | {
+        fd: number | null;
+    }, options?: SerialBridgeOptions);
+    /**
+     * Where the bridge listens, `port` is the one picked by the system when 0 was asked for
+     */
+    get address(): {
+        address: string;
+        family: string;
+        port: number;
+    } | null;
+    get stats(): SerialBridgeStats;
+    private onEvent;
+    /**
+     * Closes one connection
+     */
+    drop(id: number): void;
+    /**
+     * Stops listening and closes every connection. The port stays open.
+     */
+    close(): void;
+}
@@ -0,0 +1,87 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.SerialBridge = exports.hasSerialBridge = void 0;
+const events_1 = require("events");
+const debug_1 = __importDefault(require("debug"));
+const linux_coalesce_1 = require("./linux-coalesce");
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/bridge');
+exports.hasSerialBridge = typeof serialport_bindings_1.binding.SerialBridge === 'function';
+/**
+ * Serves an open port on a TCP socket, like ser2net, so a node on another box's serial port can be
+ * reached over the network. Bytes are moved between the port and the connections natively.
+ *
+ * Everything read from the port goes to every connection (up to `maxClients`), what a connection sends
+ * is written to the port. With a `delimiter` only whole frames are passed on in either direction, so a
+ * new connection starts at a frame boundary and two connections' commands never interleave.
+ *
+ * A connection with more than `highWaterMark` bytes unsent pauses reading the port until it is down to
+ * half, the data waits in the kernel. Without connections the port's data is dropped.
+ *
+ * Don't read or write the port while it is bridged. Emits 'connection' ({ id, address }),
+ * 'disconnect' ({ id, error }) and 'error' when the port fails, after which the bridge is closed.
+ */
+class SerialBridge extends events_1.EventEmitter {
+    constructor(port, options = {}) {
+        super();
+        const fd = typeof port === 'number' ? port : port.fd;
+        if (typeof fd !== 'number') {
+            throw new TypeError('"port" is not open');
+        }
+        const { host = '127.0.0.1', port: tcpPort = 0, maxClients = 8, highWaterMark = 65536, maxFrame = 65536 } = options;
+        this.native = new serialport_bindings_1.binding.SerialBridge(fd, { host, port: tcpPort, maxClients, highWaterMark, maxFrame, delimiter: (0, linux_coalesce_1.toDelimiter)(options.delimiter) }, (event, id, detail) => this.onEvent(event, id, detail));
+        this.closed = false;
+    }
+    /**
+     * Where the bridge listens, `port` is the one picked by the system when 0 was asked for
+     */
+    get address() {
+        return this.native.address;
+    }
+    get stats() {
+        return this.native.stats;
+    }
+    onEvent(event, id, detail) {
+        switch (event) {
+            case 'connection':
+                logger('connection', id, detail);
+                this.emit('connection', { id, address: detail });
+                break;
+            case 'disconnect':
+                logger('disconnect', id, detail);
+                this.emit('disconnect', { id, error: detail });
+                break;
+            case 'error':
+                logger('port error', detail);
+                if (detail.code === 'EBADF' || detail.code === 'ENXIO' || detail.code === 'EIO' || detail.code === 'EOF') {
+                    detail.disconnect = true;
+                }
+                this.close();
+                if (this.listenerCount('error') > 0) {
+                    this.emit('error', detail);
+                }
+                break;
+        }
+    }
+    /**
+     * Closes one connection
+     */
+    drop(id) {
+        this.native.drop(id);
+    }
+    /**
+     * Stops listening and closes every connection. The port stays open.
+     */
+    close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.native.close();
+        this.emit('close');
+    }
+}
+exports.SerialBridge = SerialBridge;
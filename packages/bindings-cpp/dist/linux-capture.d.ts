@@ -0,0 +1,69 @@
+/// <reference types="node" />
+import { Poller } from './poller';
+import { TimedReadResult } from './linux-coalesce';
+export declare const hasCapture: boolean;
+export interface CaptureOptions {
+    /** File to record to, `path.idx` holds the index */
+    path: string;
+    /** Rotate once the file reaches this size. Defaults to 64MiB */
+    maxBytes?: number;
+    /** Files kept including the current one, `path.1` is the newest rotated file. Defaults to 2 */
+    maxFiles?: number;
+}
+export interface CaptureStats {
+    /** bytes read from the port */
+    bytes: number;
+    /** reads from the port, one index record each while recording */
+    chunks: number;
+    /** bytes that went through user space because the tty can't splice */
+    copied: number;
+    rotations: number;
+    /** size of the current capture file */
+    fileBytes: number;
+    /** bytes waiting for room in the application's pipe */
+    pending: number;
+    recording: boolean;
+}
+export interface CaptureIndexEntry {
+    /** where the chunk starts in the capture file */
+    offset: number;
+    length: number;
+    /** when it was read, milliseconds since the epoch */
+    timestamp: number;
+}
+/**
+ * Records every byte read from a port to `path` while the application keeps reading it. The data
+ * goes from the tty to the file and the application's pipe with splice() and tee(), without being
+ * copied through JS.
+ *
+ * Each chunk read from the port gets a record in `path.idx`, see `readCaptureIndex()`. Once the file
+ * reaches `maxBytes` it is rotated to `path.1`, `path.2`... keeping `maxFiles` files, so a capture can
+ * run permanently in a bounded amount of disk.
+ */
+export declare class SerialCapture {
+    /** Set when recording stopped, for example because the disk is full. The port keeps working. */
+    error: Error | null;
+    private portError;
+    private native;
+    /** The application's side of the capture, a non blocking pipe */
+    readonly readFd: number;
+    private poller;
+    constructor(fd: number, options: CaptureOptions);
+    get stats(): CaptureStats;
+    /**
+     * Reads from the application's side of the capture, like `unixRead` does from the port
+     */
+    read(buffer: Buffer, offset: number, length: number): Promise<TimedReadResult>;
+    /**
+     * Drops what the application hasn't read yet, used by flush(). It stays in the capture file.
+     */
+    discard(): void;
+    close(): void;
+}
+/**
+ * Reads a capture's `.idx` sidecar. Each entry is a chunk read from the port: where it starts in the
+ * capture file, its length and when it was read in milliseconds since the epoch (with microseconds).
+ * Records are 16 bytes, the little endian file offset and read time in nanoseconds as 64 bit integers.
+ * While a capture is running its index is written about once a second, the newest chunks may be missing.
+ */
+export declare const readCaptureIndex: (path: string) => Promise<CaptureIndexEntry[]>;
@@ -0,0 +1,117 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.readCaptureIndex = exports.SerialCapture = exports.hasCapture = void 0;
+const fs_1 = require("fs");
+const util_1 = require("util");
+const debug_1 = __importDefault(require("debug"));
+const errors_1 = require("./errors");
+const poller_1 = require("./poller");
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/capture');
+const readAsync = (0, util_1.promisify)(fs_1.read);
+exports.hasCapture = typeof serialport_bindings_1.binding.PortCapture === 'function';
+const INDEX_RECORD_SIZE = 16;
+/**
+ * Records every byte read from a port to `path` while the application keeps reading it. The data
+ * goes from the tty to the file and the application's pipe with splice() and tee(), without being
+ * copied through JS.
+ *
+ * Each chunk read from the port gets a record in `path.idx`, see `readCaptureIndex()`. Once the file
+ * reaches `maxBytes` it is rotated to `path.1`, `path.2`... keeping `maxFiles` files, so a capture can
+ * run permanently in a bounded amount of disk.
+ */
+class SerialCapture {
+    constructor(fd, options) {
+        /** Set when recording stopped, for example because the disk is full. The port keeps working. */
+        this.error = null;
+        this.portError = null;
+        this.native = new serialport_bindings_1.binding.PortCapture(fd, options, (err, fatal) => {
+            if (fatal) {
+                logger('port error', err);
+                if (err.code === 'EBADF' || err.code === 'ENXIO' || err.code === 'EIO' || err.code === 'EOF') {
+                    err.disconnect = true;
+                }
+                this.portError = err;
+                return;
+            }
+            logger('recording stopped', err);
+            this.error = err;
+        });
+        this.readFd = this.native.readFd;
+        this.poller = new poller_1.Poller(this.readFd);
+    }
+    get stats() {
+        return this.native.stats;
+    }
+    /**
+     * Reads from the application's side of the capture, like `unixRead` does from the port
+     */
+    async read(buffer, offset, length) {
+        let wakeAt = Number(process.hrtime.bigint());
+        for (;;) {
+            if (!this.poller) {
+                throw new errors_1.BindingsError('Port is not open', { canceled: true });
+            }
+            try {
+                const { bytesRead } = await readAsync(this.readFd, buffer, offset, length, null);
+                if (bytesRead > 0) {
+                    return { bytesRead, buffer, readAt: Number(process.hrtime.bigint()), wakeAt };
+                }
+                // the capture closed the pipe after the port failed
+                throw this.portError || new errors_1.BindingsError('Port is not open', { canceled: true });
+            }
+            catch (err) {
+                if (err.code !== 'EAGAIN' && err.code !== 'EWOULDBLOCK' && err.code !== 'EINTR') {
+                    throw err;
+                }
+                if (!this.poller) {
+                    throw new errors_1.BindingsError('Port is not open', { canceled: true });
+                }
+                await new Promise((resolve, reject) => {
+                    this.poller.once('readable', err => (err ? reject(err) : resolve()));
+                });
+                wakeAt = Number(process.hrtime.bigint());
+            }
+        }
+    }
+    /**
+     * Drops what the application hasn't read yet, used by flush(). It stays in the capture file.
+     */
+    discard() {
+        this.native.discard();
+    }
+    close() {
+        if (!this.poller) {
+            return;
+        }
+        const poller = this.poller;
+        this.poller = null;
+        // cancels a pending read
+        poller.stop();
+        poller.destroy();
+        this.native.close();
+    }
+}
+exports.SerialCapture = SerialCapture;
+/**
+ * Reads a capture's `.idx` sidecar. Each entry is a chunk read from the port: where it starts in the
+ * capture file, its length and when it was read in milliseconds since the epoch (with microseconds).
+ * Records are 16 bytes, the little endian file offset and read time in nanoseconds as 64 bit integers.
+ * While a capture is running its index is written about once a second, the newest chunks may be missing.
+ */
+const readCaptureIndex = async (path) => {
+    const [index, { size }] = await Promise.all([fs_1.promises.readFile(`${path}.idx`), fs_1.promises.stat(path)]);
+    const count = Math.floor(index.length / INDEX_RECORD_SIZE);
+    const entries = [];
+    for (let i = 0; i < count; i++) {
+        const offset = Number(index.readBigUInt64LE(i * INDEX_RECORD_SIZE));
+        const nanos = index.readBigUInt64LE(i * INDEX_RECORD_SIZE + 8);
+        const end = i + 1 < count ? Number(index.readBigUInt64LE((i + 1) * INDEX_RECORD_SIZE)) : size;
+        entries.push({ offset, length: end - offset, timestamp: Number(nanos / 1000n) / 1000 });
+    }
+    return entries;
+};
+exports.readCaptureIndex = readCaptureIndex;
@@ -0,0 +1,83 @@
+/// <reference types="node" />
+export declare const hasReadCoalescer: boolean;
+/**
+ * A delimiter option as a Buffer, undefined when not set
+ */
+export declare function toDelimiter(delimiter: number | string | Buffer | number[] | undefined | null): Buffer | undefined;
+export interface CoalesceOptions {
+    /** Deliver once this many bytes have accumulated. Defaults to 4096 */
+    maxBytes?: number;
+    /** Deliver up to and including the last delimiter as soon as one is seen */
+    delimiter?: number | string | Buffer | number[];
+    /** Deliver this long after the first buffered byte at the latest, 0 delivers every read. Defaults to 1000 */
+    maxDelayMicros?: number;
+    /** Stop reading while this many bytes are waiting for `read()`. Defaults to 65536 */
+    highWaterMark?: number;
+}
+export interface CoalesceStats {
+    /** read() system calls */
+    reads: number;
+    /** batches handed to JS */
+    deliveries: number;
+    bytes: number;
+    /** batches delivered because `maxDelayMicros` passed */
+    timeouts: number;
+    /** bytes waiting in the native buffer */
+    buffered: number;
+    /** bytes waiting for `read()` */
+    queued: number;
+}
+/**
+ * When data was read, in nanoseconds of CLOCK_MONOTONIC, the clock `process.hrtime.bigint()` reads.
+ * The time from `wakeAt` to `readAt` is spent in the loop and the reader, from `readAt` to now in the
+ * queue and the application.
+ */
+export interface ReadTiming {
+    /** the read() that returned the first byte */
+    readAt: number;
+    /** the poll wake up that read() followed */
+    wakeAt: number;
+}
+/**
+ * What `read()` resolves with on linux, each result carries the timing of its own data. The stream
+ * layer drops the timing, read the binding directly to get it.
+ */
+export interface TimedReadResult extends ReadTiming {
+    buffer: Buffer;
+    bytesRead: number;
+}
+/**
+ * Reads the port natively and hands data to JS in batches instead of on every poll wake up.
+ * A batch is delivered when `maxBytes` have accumulated, `delimiter` has been seen (the batch ends
+ * with the last delimiter) or `maxDelayMicros` have passed since its first byte, whichever is first.
+ *
+ * Batches are queued until `read()` picks them up. Past `highWaterMark` queued bytes reading stops
+ * and the data waits in the kernel. `read()` also resolves with when the oldest byte it returns was
+ * read, see `ReadTiming`.
+ */
+export declare class CoalescingReader {
+    private highWaterMark;
+    private chunks;
+    private chunkTimes;
+    private queuedBytes;
+    private waiters;
+    private error;
+    private paused;
+    private closed;
+    private native;
+    /**
+     * `createNative` makes the native side, anything with start/stop/discard/close/stats that calls
+     * `callback` with each batch. Defaults to the binding's ReadCoalescer
+     */
+    constructor(fd: number, options?: CoalesceOptions, createNative?: (fd: number, options: object, callback: (err: Error | null, data?: Buffer, readAt?: number, wakeAt?: number) => void) => any);
+    get stats(): CoalesceStats;
+    private onData;
+    private settle;
+    private take;
+    read(buffer: Buffer, offset: number, length: number): Promise<TimedReadResult>;
+    /**
+     * Drops everything buffered natively and queued, used by flush()
+     */
+    discard(): void;
+    close(): void;
+}
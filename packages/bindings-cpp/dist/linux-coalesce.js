@@ -0,0 +1,157 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.CoalescingReader = exports.toDelimiter = exports.hasReadCoalescer = void 0;
+const debug_1 = __importDefault(require("debug"));
+const errors_1 = require("./errors");
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/coalesce');
+exports.hasReadCoalescer = typeof serialport_bindings_1.binding.ReadCoalescer === 'function';
+const defaultCoalesceOptions = {
+    maxBytes: 4096,
+    maxDelayMicros: 1000,
+    highWaterMark: 65536,
+};
+/**
+ * A delimiter option as a Buffer, undefined when not set
+ */
+function toDelimiter(delimiter) {
+    if (delimiter === undefined || delimiter === null) {
+        return undefined;
+    }
+    if (typeof delimiter === 'number') {
+        return Buffer.from([delimiter]);
+    }
+    const buffer = Buffer.from(delimiter);
+    if (buffer.length === 0) {
+        throw new TypeError('"delimiter" must not be empty');
+    }
+    return buffer;
+}
+exports.toDelimiter = toDelimiter;
+const createReadCoalescer = (fd, options, callback) => new serialport_bindings_1.binding.ReadCoalescer(fd, options, callback);
+/**
+ * Reads the port natively and hands data to JS in batches instead of on every poll wake up.
+ * A batch is delivered when `maxBytes` have accumulated, `delimiter` has been seen (the batch ends
+ * with the last delimiter) or `maxDelayMicros` have passed since its first byte, whichever is first.
+ *
+ * Batches are queued until `read()` picks them up. Past `highWaterMark` queued bytes reading stops
+ * and the data waits in the kernel. `read()` also resolves with when the oldest byte it returns was
+ * read, see `ReadTiming`.
+ */
+class CoalescingReader {
+    constructor(fd, options = {}, createNative = createReadCoalescer) {
+        const { maxBytes, maxDelayMicros, highWaterMark } = Object.assign({}, defaultCoalesceOptions, options);
+        this.highWaterMark = highWaterMark;
+        this.chunks = [];
+        // [readAt, wakeAt] of each chunk
+        this.chunkTimes = [];
+        this.queuedBytes = 0;
+        this.waiters = [];
+        this.error = null;
+        this.paused = false;
+        this.closed = false;
+        this.native = createNative(fd, { maxBytes, maxDelayMicros, delimiter: toDelimiter(options.delimiter) }, (err, data, readAt, wakeAt) => this.onData(err, data, readAt, wakeAt));
+        this.native.start();
+    }
+    get stats() {
+        return Object.assign({}, this.native.stats, { queued: this.queuedBytes });
+    }
+    onData(err, data, readAt, wakeAt) {
+        if (err) {
+            logger('read error', err);
+            if (err.code === 'EBADF' || err.code === 'ENXIO' || err.code === 'EIO' || err.code === 'EOF') {
+                err.disconnect = true;
+            }
+            this.error = err;
+            this.settle();
+            return;
+        }
+        this.chunks.push(data);
+        this.chunkTimes.push([readAt, wakeAt]);
+        this.queuedBytes += data.length;
+        if (this.queuedBytes >= this.highWaterMark && !this.paused) {
+            logger('pausing, queued', this.queuedBytes);
+            this.paused = true;
+            this.native.stop();
+        }
+        this.settle();
+    }
+    settle() {
+        while (this.waiters.length > 0 && (this.chunks.length > 0 || this.error)) {
+            const { buffer, offset, length, resolve, reject } = this.waiters.shift();
+            if (this.chunks.length > 0) {
+                resolve(this.take(buffer, offset, length));
+            }
+            else {
+                reject(this.error);
+            }
+        }
+    }
+    take(buffer, offset, length) {
+        // the oldest byte handed out decides the latency
+        const [readAt, wakeAt] = this.chunkTimes[0];
+        let bytesRead = 0;
+        while (this.chunks.length > 0 && bytesRead < length) {
+            const chunk = this.chunks[0];
+            const count = Math.min(chunk.length, length - bytesRead);
+            chunk.copy(buffer, offset + bytesRead, 0, count);
+            bytesRead += count;
+            if (count === chunk.length) {
+                this.chunks.shift();
+                this.chunkTimes.shift();
+            }
+            else {
+                this.chunks[0] = chunk.subarray(count);
+            }
+        }
+        this.queuedBytes -= bytesRead;
+        if (this.paused && this.queuedBytes < this.highWaterMark && !this.closed) {
+            this.paused = false;
+            this.native.start();
+        }
+        return { bytesRead, buffer, readAt, wakeAt };
+    }
+    read(buffer, offset, length) {
+        if (this.closed) {
+            return Promise.reject(new errors_1.BindingsError('Port is not open', { canceled: true }));
+        }
+        if (this.chunks.length > 0) {
+            return Promise.resolve(this.take(buffer, offset, length));
+        }
+        if (this.error) {
+            return Promise.reject(this.error);
+        }
+        return new Promise((resolve, reject) => this.waiters.push({ buffer, offset, length, resolve, reject }));
+    }
+    /**
+     * Drops everything buffered natively and queued, used by flush()
+     */
+    discard() {
+        this.native.discard();
+        this.chunks = [];
+        this.chunkTimes = [];
+        this.queuedBytes = 0;
+        if (this.paused && !this.closed) {
+            this.paused = false;
+            this.native.start();
+        }
+    }
+    close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.native.close();
+        this.chunks = [];
+        this.chunkTimes = [];
+        this.queuedBytes = 0;
+        const waiters = this.waiters;
+        this.waiters = [];
+        const canceled = new errors_1.BindingsError('Port is not open', { canceled: true });
+        waiters.forEach(({ reject }) => reject(canceled));
+    }
+}
+exports.CoalescingReader = CoalescingReader;
@@ -0,0 +1,39 @@
+import { EventEmitter } from 'events';
+import { PortInfo } from '@serialport/bindings-interface';
+export interface HotplugEvent extends PortInfo {
+    action: 'add' | 'remove';
+    /** sysfs path of the tty, e.g. /devices/pci0000:00/.../ttyUSB0/tty/ttyUSB0 */
+    devpath: string;
+}
+export interface HotplugMonitorOptions {
+    /** Defaults to 'udev' when udevd is running, otherwise 'kernel' */
+    source?: 'kernel' | 'udev';
+}
+interface HotplugMonitorClass {
+    new (cb: (err: Error | null, event: HotplugEvent) => void, options?: HotplugMonitorOptions): HotplugMonitorInstance;
+}
+interface HotplugMonitorInstance {
+    readonly source: 'kernel' | 'udev';
+    start(): void;
+    stop(): void;
+}
+/**
+ * Watches the kernel (or udev) uevent netlink socket for serial ports being plugged in or removed. Linux only.
+ */
+export declare class HotplugMonitor extends EventEmitter {
+    monitor: HotplugMonitorInstance;
+    isRunning: boolean;
+    constructor(options?: HotplugMonitorOptions, MonitorBindings?: HotplugMonitorClass);
+    /**
+     * Which netlink group is being listened to ('kernel'|'udev')
+     */
+    get source(): 'kernel' | 'udev';
+    /**
+     * Start emitting 'add' and 'remove' events, keeps the event loop alive until stopped
+     */
+    start(): this;
+    stop(): this;
+    on(event: 'add' | 'remove', listener: (event: HotplugEvent) => void): this;
+    on(event: 'error', listener: (err: Error) => void): this;
+}
+export {};
@@ -0,0 +1,56 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.HotplugMonitor = void 0;
+const debug_1 = __importDefault(require("debug"));
+const events_1 = require("events");
+const serialport_bindings_1 = require("./serialport-bindings");
+const { HotplugMonitor: HotplugMonitorBindings } = serialport_bindings_1.binding;
+const logger = (0, debug_1.default)('serialport/bindings-cpp/hotplug');
+function handleEvent(error, event) {
+    if (error) {
+        logger('error', error);
+        this.emit('error', error);
+        return;
+    }
+    logger(`received "${event.action}"`, event.path);
+    this.emit(event.action, event);
+}
+/**
+ * Watches the kernel (or udev) uevent netlink socket for serial ports being plugged in or removed. Linux only.
+ */
+class HotplugMonitor extends events_1.EventEmitter {
+    constructor(options = {}, MonitorBindings = HotplugMonitorBindings) {
+        logger('Creating hotplug monitor');
+        super();
+        if (!MonitorBindings) {
+            throw new Error('Hotplug monitoring is not supported on this platform');
+        }
+        this.monitor = new MonitorBindings(handleEvent.bind(this), options);
+        this.isRunning = false;
+    }
+    /**
+     * Which netlink group is being listened to ('kernel'|'udev')
+     */
+    get source() {
+        return this.monitor.source;
+    }
+    /**
+     * Start emitting 'add' and 'remove' events, keeps the event loop alive until stopped
+     */
+    start() {
+        logger('Starting hotplug monitor on the', this.source, 'group');
+        this.monitor.start();
+        this.isRunning = true;
+        return this;
+    }
+    stop() {
+        logger('Stopping hotplug monitor');
+        this.monitor.stop();
+        this.isRunning = false;
+        return this;
+    }
+}
+exports.HotplugMonitor = HotplugMonitor;
@@ -0,0 +1,119 @@
+/// <reference types="node" />
+import { EventEmitter } from 'events';
+export declare const hasMockDevice: boolean;
+export interface MockDeviceOptions {
+    /** Virtual milliseconds between telemetry lines, the sketch's loop delay. Defaults to 3000 */
+    interval?: number;
+    /** Each loop is up to this many virtual milliseconds early or late. Defaults to 0 */
+    jitter?: number;
+    /** Virtual milliseconds from a command arriving to it being handled. Defaults to the next loop, one command per loop like the sketch */
+    ackDelay?: number;
+    /** Probability of a line being lost. Defaults to 0 */
+    loss?: number;
+    /** Probability of a line having a bit flipped. Defaults to 0 */
+    corruption?: number;
+    /** Virtual milliseconds per real millisecond, 0 to only move with `advance()`. Defaults to 1 */
+    speed?: number;
+    /** Talk like the USB port (banner, `Sent: ` echoes, card text) rather than the espSerial link, which takes the commands. Defaults to true */
+    usb?: boolean;
+    /** Let the readings wander and respond to the relays between loops. Defaults to true */
+    drift?: boolean;
+    /** Seeds jitter, loss, corruption and drift. Defaults to 1 */
+    seed?: number;
+    /** Bytes queued for an application that isn't reading before lines are dropped. Defaults to 65536 */
+    maxQueued?: number;
+}
+export interface MockSensorValues {
+    temp1?: number;
+    hum1?: number;
+    temp2?: number;
+    hum2?: number;
+    soil?: number;
+    light?: number;
+    tank?: number;
+    ph?: number;
+    rfid?: string;
+}
+export interface MockRelayState {
+    on: boolean;
+    mode: 'AUTO' | 'MANUAL';
+}
+export interface MockDeviceState {
+    temp1: number;
+    hum1: number;
+    temp2: number;
+    hum2: number;
+    soil: number;
+    light: number;
+    tank: number;
+    ph: number;
+    waterPump: MockRelayState;
+    fan: MockRelayState;
+    fertilizer: boolean;
+}
+export interface MockDeviceStats {
+    loops: number;
+    /** lines sent, including lost ones */
+    lines: number;
+    commands: number;
+    /** commands handled, espSerial link only */
+    handled: number;
+    lost: number;
+    corrupted: number;
+    /** lines dropped because the application wasn't reading */
+    overruns: number;
+    queued: number;
+    bytesWritten: number;
+    bytesRead: number;
+}
+/**
+ * A greenhouse Arduino node behind a pseudo terminal, a stand-in for the hardware in tests and
+ * benchmarks. Applications open `path` like the board's port. Every `interval` the node sends its
+ * telemetry line (`T1:25.00,H1:60.00,...,RFID:NoCard`). Like the sketch, it reads `WATER:`, `FAN:` and
+ * `FERTILIZER:` commands only on the espSerial link (`usb: false`), one per loop, switching its relays
+ * without a reply. On the USB port (`usb: true`) the telemetry is echoed as `Sent: ...` and a line the
+ * application writes is text for the next RFID card: shown a card with `set({ rfid })`, the node
+ * reports that text padded to 16 characters.
+ *
+ * The device runs on a virtual clock. `speed` scales it against real time, `speed: 0` stops it so
+ * `advance(ms)` plays the traffic of `ms` at once. `jitter`, `loss` and `corruption` disturb the
+ * lines, seeded by `seed` so a failing run can be repeated.
+ *
+ * Emits 'command' (string) for each command the application writes on the espSerial link and 'error'. Closing the device
+ * hangs the port up like unplugging the board.
+ */
+export declare class MockDevice extends EventEmitter {
+    private native;
+    closed: boolean;
+    started: boolean;
+    constructor(options?: MockDeviceOptions);
+    /**
+     * The pty the application opens
+     */
+    get path(): string;
+    /**
+     * Boots the node, the banner and the first telemetry line go out at once. Opening a port discards
+     * pending input, so have the application open `path` first.
+     */
+    start(): string;
+    /**
+     * Moves the virtual clock forward by `ms`, sending everything due meanwhile. Returns the lines sent.
+     */
+    advance(ms: number): number;
+    /**
+     * Sets sensor readings (temp1, hum1, temp2, hum2, soil, light, tank, ph) for the next loops to report,
+     * `rfid` is a card shown to the reader once
+     */
+    set(values: MockSensorValues): void;
+    /**
+     * Virtual milliseconds since `start()`
+     */
+    get now(): number;
+    /**
+     * The sensor readings and relays, as the next telemetry line would report them
+     */
+    get state(): MockDeviceState;
+    get stats(): MockDeviceStats;
+    private onEvent;
+    close(): void;
+}
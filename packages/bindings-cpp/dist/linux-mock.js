@@ -0,0 +1,120 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.MockDevice = exports.hasMockDevice = void 0;
+const events_1 = require("events");
+const debug_1 = __importDefault(require("debug"));
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/mock');
+exports.hasMockDevice = typeof serialport_bindings_1.binding.MockDevice === 'function';
+const probability = (value, name) => {
+    if (typeof value !== 'number' || !(value >= 0 && value <= 1)) {
+        throw new TypeError(`"${name}" must be between 0 and 1`);
+    }
+    return value;
+};
+/**
+ * A greenhouse Arduino node behind a pseudo terminal, a stand-in for the hardware in tests and
+ * benchmarks. Applications open `path` like the board's port. Every `interval` the node sends its
+ * telemetry line (`T1:25.00,H1:60.00,...,RFID:NoCard`). Like the sketch, it reads `WATER:`, `FAN:` and
+ * `FERTILIZER:` commands only on the espSerial link (`usb: false`), one per loop, switching its relays
+ * without a reply. On the USB port (`usb: true`) the telemetry is echoed as `Sent: ...` and a line the
+ * application writes is text for the next RFID card: shown a card with `set({ rfid })`, the node
+ * reports that text padded to 16 characters.
+ *
+ * The device runs on a virtual clock. `speed` scales it against real time, `speed: 0` stops it so
+ * `advance(ms)` plays the traffic of `ms` at once. `jitter`, `loss` and `corruption` disturb the
+ * lines, seeded by `seed` so a failing run can be repeated.
+ *
+ * Emits 'command' (string) for each command the application writes on the espSerial link and 'error'. Closing the device
+ * hangs the port up like unplugging the board.
+ */
+class MockDevice extends events_1.EventEmitter {
+    constructor({ interval = 3000, jitter = 0, ackDelay, loss = 0, corruption = 0, speed = 1, usb = true, drift = true, seed = 1, maxQueued = 65536, } = {}) {
+        super();
+        if (typeof speed !== 'number' || !(speed >= 0)) {
+            throw new TypeError('"speed" must be a number, 0 or more');
+        }
+        const options = {
+            interval,
+            jitter,
+            loss: probability(loss, 'loss'),
+            corruption: probability(corruption, 'corruption'),
+            speed,
+            usb,
+            drift,
+            seed,
+            maxQueued,
+        };
+        if (typeof ackDelay === 'number') {
+            options.ackDelay = Math.max(0, ackDelay);
+        }
+        this.native = new serialport_bindings_1.binding.MockDevice(options, (err, command) => this.onEvent(err, command));
+        this.closed = false;
+        this.started = false;
+    }
+    /**
+     * The pty the application opens
+     */
+    get path() {
+        return this.native.path;
+    }
+    /**
+     * Boots the node, the banner and the first telemetry line go out at once. Opening a port discards
+     * pending input, so have the application open `path` first.
+     */
+    start() {
+        this.native.start();
+        this.started = true;
+        return this.path;
+    }
+    /**
+     * Moves the virtual clock forward by `ms`, sending everything due meanwhile. Returns the lines sent.
+     */
+    advance(ms) {
+        return this.native.advance(ms);
+    }
+    /**
+     * Sets sensor readings (temp1, hum1, temp2, hum2, soil, light, tank, ph) for the next loops to report,
+     * `rfid` is a card shown to the reader once
+     */
+    set(values) {
+        this.native.set(values);
+    }
+    /**
+     * Virtual milliseconds since `start()`
+     */
+    get now() {
+        return this.native.now;
+    }
+    /**
+     * The sensor readings and relays, as the next telemetry line would report them
+     */
+    get state() {
+        return this.native.state;
+    }
+    get stats() {
+        return this.native.stats;
+    }
+    onEvent(err, command) {
+        if (err) {
+            logger('device error', err);
+            if (this.listenerCount('error') > 0) {
+                this.emit('error', err);
+            }
+            return;
+        }
+        this.emit('command', command);
+    }
+    close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.native.close();
+        this.emit('close');
+    }
+}
+exports.MockDevice = MockDevice;
@@ -0,0 +1,57 @@
+/// <reference types="node" />
+import { EventEmitter } from 'events';
+export declare const hasModemWatcher: boolean;
+export type ModemLine = 'cts' | 'dsr' | 'dcd' | 'ri';
+export interface ModemWatcherOptions {
+    /** Lines to watch. Defaults to all four */
+    lines?: ModemLine[];
+    /** Milliseconds between checks on drivers that can't wait for changes, 0 to fail instead. Defaults to 100 */
+    pollInterval?: number;
+}
+export interface ModemLines {
+    cts: boolean;
+    dsr: boolean;
+    dcd: boolean;
+    ri: boolean;
+}
+export interface ModemChange extends ModemLines {
+    changed: ModemLine[];
+    /** edges counted by the driver since the previous change, 0 where it doesn't count them */
+    transitions: Record<ModemLine, number>;
+    /** milliseconds since the epoch */
+    timestamp: number;
+}
+export interface ModemWatcherStats {
+    /** 'wait' while sleeping in TIOCMIWAIT, 'poll' on drivers without it */
+    mode: 'wait' | 'poll';
+    wakeups: number;
+    changes: number;
+}
+/**
+ * Reports changes of the modem status lines (CTS, DSR, DCD and RI) of an open port as they happen,
+ * instead of polling `get()`. A helper thread sleeps in TIOCMIWAIT until a watched line changes, so a
+ * quiet port costs nothing. Drivers that can't wait for changes are polled every `pollInterval`
+ * milliseconds, `stats.mode` tells which is used.
+ *
+ * Emits 'change' with the lines' new state, the ones that `changed`, the edges the driver counted
+ * since the previous change (a pulse too short to see in the state, e.g. a node resetting, still
+ * shows there) and a `timestamp` in milliseconds since the epoch. Emits 'error' when the port fails,
+ * after which the watcher is closed.
+ */
+export declare class ModemWatcher extends EventEmitter {
+    private native;
+    closed: boolean;
+    constructor(port: number | {
+        fd: number | null;
+    }, options?: ModemWatcherOptions);
+    /**
+     * The lines as of the last change
+     */
+    get state(): ModemLines;
+    get stats(): ModemWatcherStats;
+    private onChange;
+    /**
+     * Stops watching, the port stays open
+     */
+    close(): void;
+}
@@ -0,0 +1,71 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.ModemWatcher = exports.hasModemWatcher = void 0;
+const events_1 = require("events");
+const debug_1 = __importDefault(require("debug"));
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/modem');
+exports.hasModemWatcher = typeof serialport_bindings_1.binding.ModemWatcher === 'function';
+/**
+ * Reports changes of the modem status lines (CTS, DSR, DCD and RI) of an open port as they happen,
+ * instead of polling `get()`. A helper thread sleeps in TIOCMIWAIT until a watched line changes, so a
+ * quiet port costs nothing. Drivers that can't wait for changes are polled every `pollInterval`
+ * milliseconds, `stats.mode` tells which is used.
+ *
+ * Emits 'change' with the lines' new state, the ones that `changed`, the edges the driver counted
+ * since the previous change (a pulse too short to see in the state, e.g. a node resetting, still
+ * shows there) and a `timestamp` in milliseconds since the epoch. Emits 'error' when the port fails,
+ * after which the watcher is closed.
+ */
+class ModemWatcher extends events_1.EventEmitter {
+    constructor(port, { lines = ['cts', 'dsr', 'dcd', 'ri'], pollInterval = 100 } = {}) {
+        super();
+        const fd = typeof port === 'number' ? port : port.fd;
+        if (typeof fd !== 'number') {
+            throw new TypeError('"port" is not open');
+        }
+        this.native = new serialport_bindings_1.binding.ModemWatcher(fd, { lines, pollInterval }, (err, change) => this.onChange(err, change));
+        this.closed = false;
+    }
+    /**
+     * The lines as of the last change
+     */
+    get state() {
+        return this.native.state;
+    }
+    get stats() {
+        return this.native.stats;
+    }
+    onChange(err, change) {
+        if (this.closed) {
+            return;
+        }
+        if (err) {
+            logger('port error', err);
+            if (err.code === 'EBADF' || err.code === 'ENXIO' || err.code === 'EIO') {
+                err.disconnect = true;
+            }
+            this.close();
+            if (this.listenerCount('error') > 0) {
+                this.emit('error', err);
+            }
+            return;
+        }
+        this.emit('change', change);
+    }
+    /**
+     * Stops watching, the port stays open
+     */
+    close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.native.close();
+        this.emit('close');
+    }
+}
+exports.ModemWatcher = ModemWatcher;
@@ -0,0 +1,94 @@
+/// <reference types="node" />
+import { EventEmitter } from 'events';
+import { PortInfo, UpdateOptions } from '@serialport/bindings-interface';
+import { BindingPortInterface } from '.';
+import { BaudSample, DetectBaudOptions, LinuxOpenOptions, LinuxPortBinding, LinuxPortStatus, LinuxSetOptions } from './linux';
+import { HotplugMonitor } from './linux-hotplug';
+import { Poller } from './poller';
+import { TimedReadResult } from './linux-coalesce';
+export interface ReconnectOptions {
+    /** How often to re-list ports while waiting for the device, in ms. Defaults to 1000 */
+    interval?: number;
+    /** Give up and fail pending operations after this many ms, 0 waits forever. Defaults to 0 */
+    timeout?: number;
+    /** Writes queued while disconnected are rejected beyond this many bytes. Defaults to 65536 */
+    maxQueuedBytes?: number;
+}
+export interface PortIdentity {
+    path: string;
+    pnpId?: string;
+    serialNumber?: string;
+    vendorId?: string;
+    productId?: string;
+}
+export interface ReconnectStats {
+    disconnects: number;
+    reconnects: number;
+    /** Milliseconds from the disconnect being noticed to the port being usable again */
+    lastLatency: number;
+    minLatency: number;
+    maxLatency: number;
+    totalLatency: number;
+    replayedWrites: number;
+    replayedBytes: number;
+    droppedBytes: number;
+}
+/**
+ * Errors that mean the device went away rather than the operation failing
+ */
+export declare function isDisconnectError(err: any): boolean;
+/**
+ * Work out a stable identity for a port so it can be found again after it re-enumerates
+ * under a different /dev/tty* name. A /dev/serial/by-id path is used as is, otherwise the
+ * usb serial number (plus vendor and product ids) reported by list() is used.
+ */
+export declare function resolvePortIdentity(path: string, list: () => Promise<PortInfo[]>): Promise<PortIdentity>;
+/**
+ * A port binding that survives the device re-enumerating. When the underlying port reports a
+ * disconnect it waits for the same device (by identity) to come back, reopens it with the original
+ * open options, restores the last `set()` and `update()` and replays writes queued in the meantime.
+ * Reads and other operations issued during the gap wait for the reconnect.
+ *
+ * Emits 'disconnect' (error) and 'reconnect' ({ path, latency }).
+ */
+export declare class ReconnectingPortBinding extends EventEmitter implements BindingPortInterface {
+    openOptions: Required<LinuxOpenOptions>;
+    readonly identity: PortIdentity;
+    readonly reconnectStats: ReconnectStats;
+    constructor(options: {
+        port: LinuxPortBinding;
+        identity: PortIdentity;
+        openOptions: Required<LinuxOpenOptions>;
+        openPort: (openOptions: Required<LinuxOpenOptions>) => Promise<LinuxPortBinding>;
+        list: () => Promise<PortInfo[]>;
+        reconnect: boolean | ReconnectOptions;
+        HotplugMonitorClass?: typeof HotplugMonitor | null;
+    });
+    get isOpen(): boolean;
+    get isConnected(): boolean;
+    get fd(): number | null;
+    get poller(): Poller | null;
+    close(): Promise<void>;
+    read(buffer: Buffer, offset: number, length: number): Promise<TimedReadResult>;
+    write(buffer: Buffer): Promise<void>;
+    update(options: UpdateOptions): Promise<void>;
+    detectBaud(options?: DetectBaudOptions): Promise<{
+        baudRate: number | null;
+        samples: BaudSample[];
+    }>;
+    set(options: LinuxSetOptions): Promise<void>;
+    get(): Promise<LinuxPortStatus>;
+    getBaudRate(): Promise<{
+        baudRate: number;
+    }>;
+    setSync(options: LinuxSetOptions): void;
+    /**
+     * Synchronous calls can't wait for a reconnect, they throw while the device is away
+     */
+    getSync(): LinuxPortStatus;
+    getBaudRateSync(): {
+        baudRate: number;
+    };
+    flush(): Promise<void>;
+    drain(): Promise<void>;
+}
@@ -0,0 +1,382 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.ReconnectingPortBinding = void 0;
+exports.resolvePortIdentity = resolvePortIdentity;
+exports.isDisconnectError = isDisconnectError;
+const path_1 = require("path");
+const events_1 = require("events");
+const debug_1 = __importDefault(require("debug"));
+const errors_1 = require("./errors");
+const linux_hotplug_1 = require("./linux-hotplug");
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/reconnect');
+const BY_ID_DIR = '/dev/serial/by-id/';
+const defaultReconnectOptions = {
+    interval: 1000,
+    timeout: 0,
+    maxQueuedBytes: 65536,
+};
+/**
+ * Errors that mean the device went away rather than the operation failing
+ */
+function isDisconnectError(err) {
+    return Boolean(err && (err.disconnect || err.code === 'EIO' || err.code === 'ENODEV' || err.code === 'ENXIO'));
+}
+/**
+ * Work out a stable identity for a port so it can be found again after it re-enumerates
+ * under a different /dev/tty* name. A /dev/serial/by-id path is used as is, otherwise the
+ * usb serial number (plus vendor and product ids) reported by list() is used.
+ */
+async function resolvePortIdentity(path, list) {
+    if (path.startsWith(BY_ID_DIR)) {
+        return { path, pnpId: (0, path_1.basename)(path) };
+    }
+    const ports = await list().catch(() => []);
+    const port = ports.find(info => info.path === path);
+    if (!port) {
+        return { path };
+    }
+    return {
+        path,
+        pnpId: port.pnpId,
+        serialNumber: port.serialNumber,
+        vendorId: port.vendorId,
+        productId: port.productId,
+    };
+}
+function matchesIdentity(identity, port) {
+    if (identity.pnpId && port.pnpId) {
+        return identity.pnpId === port.pnpId;
+    }
+    if (identity.serialNumber) {
+        return (port.serialNumber === identity.serialNumber &&
+            (!identity.vendorId || port.vendorId === identity.vendorId) &&
+            (!identity.productId || port.productId === identity.productId));
+    }
+    return port.path === identity.path;
+}
+/**
+ * A port binding that survives the device re-enumerating. When the underlying port reports a
+ * disconnect it waits for the same device (by identity) to come back, reopens it with the original
+ * open options, restores the last `set()` and `update()` and replays writes queued in the meantime.
+ * Reads and other operations issued during the gap wait for the reconnect.
+ *
+ * Emits 'disconnect' (error) and 'reconnect' ({ path, latency }).
+ */
+class ReconnectingPortBinding extends events_1.EventEmitter {
+    constructor({ port, identity, openOptions, openPort, list, reconnect, HotplugMonitorClass = serialport_bindings_1.binding.HotplugMonitor ? linux_hotplug_1.HotplugMonitor : null, }) {
+        super();
+        this.port = port;
+        this.identity = identity;
+        this.openOptions = openOptions;
+        this.openPort = openPort;
+        this.list = list;
+        this.reconnectOptions = Object.assign({}, defaultReconnectOptions, typeof reconnect === 'object' ? reconnect : {});
+        this.HotplugMonitorClass = HotplugMonitorClass;
+        this.closed = false;
+        this.reopening = false;
+        this.lastSetOptions = null;
+        this.writeQueue = [];
+        this.queuedBytes = 0;
+        this.reconnectWaiters = [];
+        this.disconnectedAt = null;
+        this.monitor = null;
+        this.retryTimer = null;
+        this.timeoutTimer = null;
+        this.reconnectStats = {
+            disconnects: 0,
+            reconnects: 0,
+            lastLatency: 0,
+            minLatency: 0,
+            maxLatency: 0,
+            totalLatency: 0,
+            replayedWrites: 0,
+            replayedBytes: 0,
+            droppedBytes: 0,
+        };
+    }
+    get isOpen() {
+        return !this.closed;
+    }
+    get isConnected() {
+        return this.port !== null;
+    }
+    get fd() {
+        return this.port ? this.port.fd : null;
+    }
+    get poller() {
+        return this.port ? this.port.poller : null;
+    }
+    async close() {
+        logger('close');
+        if (this.closed) {
+            throw new Error('Port is not open');
+        }
+        this.closed = true;
+        this.stopWatching();
+        const canceled = new errors_1.BindingsError('Port is not open', { canceled: true });
+        this.settleWaiters(canceled);
+        this.failQueuedWrites(canceled);
+        const port = this.port;
+        this.port = null;
+        if (port) {
+            await port.close();
+        }
+    }
+    async read(buffer, offset, length) {
+        const port = await this.connected();
+        try {
+            return await port.read(buffer, offset, length);
+        }
+        catch (err) {
+            if (!this.handleError(port, err)) {
+                throw err;
+            }
+            return this.read(buffer, offset, length);
+        }
+    }
+    async write(buffer) {
+        if (this.closed) {
+            throw new Error('Port is not open');
+        }
+        if (!this.port) {
+            return this.queueWrite(buffer);
+        }
+        const port = this.port;
+        try {
+            await port.write(buffer);
+        }
+        catch (err) {
+            if (!this.handleError(port, err)) {
+                throw err;
+            }
+            // the write may have been partially sent, it is replayed whole once the device is back
+            return this.queueWrite(buffer);
+        }
+    }
+    async update(options) {
+        if (this.closed) {
+            throw new Error('Port is not open');
+        }
+        this.openOptions = Object.assign({}, this.openOptions, { baudRate: options.baudRate });
+        if (this.port) {
+            await this.port.update(options);
+        }
+    }
+    async detectBaud(options) {
+        const result = await (await this.connected()).detectBaud(options);
+        if (result.baudRate !== null) {
+            // reopened at the detected rate
+            this.openOptions = Object.assign({}, this.openOptions, { baudRate: result.baudRate });
+        }
+        return result;
+    }
+    async set(options) {
+        if (this.closed) {
+            throw new Error('Port is not open');
+        }
+        this.lastSetOptions = options;
+        if (this.port) {
+            await this.port.set(options);
+        }
+    }
+    setSync(options) {
+        if (this.closed) {
+            throw new Error('Port is not open');
+        }
+        this.lastSetOptions = options;
+        if (this.port) {
+            this.port.setSync(options);
+        }
+    }
+    async get() {
+        return (await this.connected()).get();
+    }
+    /**
+     * Synchronous calls can't wait for a reconnect, they throw while the device is away
+     */
+    getSync() {
+        return this.connectedSync().getSync();
+    }
+    getBaudRateSync() {
+        return this.connectedSync().getBaudRateSync();
+    }
+    async getBaudRate() {
+        return (await this.connected()).getBaudRate();
+    }
+    async flush() {
+        if (!this.port) {
+            this.failQueuedWrites(new errors_1.BindingsError('Write flushed', { canceled: true }));
+        }
+        return (await this.connected()).flush();
+    }
+    async drain() {
+        return (await this.connected()).drain();
+    }
+    connectedSync() {
+        if (this.closed) {
+            throw new errors_1.BindingsError('Port is not open', { canceled: true });
+        }
+        if (!this.port) {
+            throw new errors_1.BindingsError('Port is reconnecting');
+        }
+        return this.port;
+    }
+    connected() {
+        if (this.closed) {
+            return Promise.reject(new errors_1.BindingsError('Port is not open', { canceled: true }));
+        }
+        if (this.port) {
+            return Promise.resolve(this.port);
+        }
+        return new Promise((resolve, reject) => this.reconnectWaiters.push({ resolve, reject }));
+    }
+    /**
+     * Returns true when the error was a disconnect and a reconnect is now under way
+     */
+    handleError(port, err) {
+        if (this.closed || !isDisconnectError(err)) {
+            return false;
+        }
+        if (this.port === port) {
+            this.disconnected(err);
+        }
+        return true;
+    }
+    disconnected(err) {
+        logger('disconnected, waiting for', this.identity);
+        const port = this.port;
+        this.port = null;
+        this.disconnectedAt = process.hrtime.bigint();
+        this.reconnectStats.disconnects++;
+        port.close().catch(() => { });
+        this.emit('disconnect', err);
+        this.watch(err);
+    }
+    watch(err) {
+        const { interval, timeout } = this.reconnectOptions;
+        if (this.HotplugMonitorClass) {
+            try {
+                this.monitor = new this.HotplugMonitorClass();
+                this.monitor.on('add', event => {
+                    if (matchesIdentity(this.identity, event)) {
+                        this.tryReopen(event.path);
+                    }
+                });
+                this.monitor.on('error', error => logger('hotplug error', error));
+                this.monitor.start();
+            }
+            catch (error) {
+                // no netlink (containers, seccomp), the list() fallback below still works
+                logger('hotplug unavailable', error);
+                this.monitor = null;
+            }
+        }
+        // Also re-list periodically in case the uevent was missed or udev had not finished the by-id links yet
+        this.retryTimer = setInterval(() => this.scan(), interval);
+        if (timeout > 0) {
+            this.timeoutTimer = setTimeout(() => {
+                logger('reconnect timed out');
+                this.closed = true;
+                this.stopWatching();
+                this.settleWaiters(err);
+                this.failQueuedWrites(err);
+            }, timeout);
+        }
+    }
+    stopWatching() {
+        if (this.monitor) {
+            this.monitor.stop();
+            this.monitor = null;
+        }
+        clearInterval(this.retryTimer);
+        clearTimeout(this.timeoutTimer);
+        this.retryTimer = null;
+        this.timeoutTimer = null;
+    }
+    async scan() {
+        const ports = await this.list().catch(() => []);
+        const port = ports.find(info => matchesIdentity(this.identity, info));
+        if (port) {
+            await this.tryReopen(port.path);
+        }
+    }
+    async tryReopen(path) {
+        if (this.closed || this.port || this.reopening) {
+            return;
+        }
+        this.reopening = true;
+        try {
+            const port = await this.openPort(Object.assign({}, this.openOptions, { path }));
+            if (this.closed) {
+                await port.close();
+                return;
+            }
+            if (this.lastSetOptions) {
+                await port.set(this.lastSetOptions);
+            }
+            this.reconnected(port, path);
+        }
+        catch (err) {
+            // udev may not have fixed the permissions yet, the next scan or uevent tries again
+            logger('reopen failed', path, err);
+        }
+        finally {
+            this.reopening = false;
+        }
+    }
+    reconnected(port, path) {
+        this.stopWatching();
+        this.port = port;
+        const latency = Number(process.hrtime.bigint() - this.disconnectedAt) / 1e6;
+        const stats = this.reconnectStats;
+        stats.reconnects++;
+        stats.lastLatency = latency;
+        stats.totalLatency += latency;
+        stats.minLatency = stats.reconnects === 1 ? latency : Math.min(stats.minLatency, latency);
+        stats.maxLatency = Math.max(stats.maxLatency, latency);
+        logger('reconnected to', path, 'after', latency, 'ms');
+        this.emit('reconnect', { path, latency });
+        this.replayWrites();
+        this.settleWaiters(null, port);
+    }
+    queueWrite(buffer) {
+        const { maxQueuedBytes } = this.reconnectOptions;
+        if (this.queuedBytes + buffer.length > maxQueuedBytes) {
+            this.reconnectStats.droppedBytes += buffer.length;
+            return Promise.reject(new Error(`Port is reconnecting and more than ${maxQueuedBytes} bytes are queued`));
+        }
+        this.queuedBytes += buffer.length;
+        return new Promise((resolve, reject) => this.writeQueue.push({ buffer, resolve, reject }));
+    }
+    async replayWrites() {
+        while (this.writeQueue.length > 0 && this.port) {
+            const { buffer, resolve, reject } = this.writeQueue.shift();
+            this.queuedBytes -= buffer.length;
+            try {
+                await this.write(buffer);
+                this.reconnectStats.replayedWrites++;
+                this.reconnectStats.replayedBytes += buffer.length;
+                resolve();
+            }
+            catch (err) {
+                reject(err);
+            }
+        }
+    }
+    failQueuedWrites(err) {
+        const queue = this.writeQueue;
+        this.writeQueue = [];
+        this.queuedBytes = 0;
+        queue.forEach(({ reject }) => reject(err));
+    }
+    settleWaiters(err, port) {
+        const waiters = this.reconnectWaiters;
+        this.reconnectWaiters = [];
+        waiters.forEach(({ resolve, reject }) => (err ? reject(err) : resolve(port)));
+    }
+}
+exports.ReconnectingPortBinding = ReconnectingPortBinding;
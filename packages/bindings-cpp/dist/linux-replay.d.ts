@@ -0,0 +1,112 @@
+/// <reference types="node" />
+import { EventEmitter } from 'events';
+export interface PtyPair {
+    /** the path the application opens */
+    path: string;
+    /** the device's side, non blocking */
+    masterFd: number;
+    slaveFd: number;
+}
+/**
+ * Opens a raw pseudo terminal. Applications open `path` like a serial port, `masterFd` is the device's
+ * side. `slaveFd` keeps the pty up while the application has the port closed, close both when done.
+ */
+export declare const openPty: () => PtyPair;
+export interface CaptureChunk {
+    data: Buffer;
+    /** when it was read, milliseconds since the epoch */
+    timestamp: number;
+}
+/**
+ * Reads captures recorded with the `capture` open option into chunks as they were read from the port.
+ * Pass rotated files oldest first, e.g. `['port.raw.1', 'port.raw']`.
+ */
+export declare const loadCapture: (paths: string | string[]) => Promise<CaptureChunk[]>;
+export interface ReplayOptions {
+    /** Simulated devices, each gets its own pty. Defaults to 1 */
+    ports?: number;
+    /** Multiplier of the recorded pace or 'max' to send as fast as the application reads. Defaults to 1 */
+    speed?: number | 'max';
+    /** Replay line by line with a sequence number field, `true` names it SEQ. Defaults to false */
+    sequence?: boolean | string;
+    /** Start over at the end of the capture instead of emitting 'end'. Defaults to false */
+    loop?: boolean;
+}
+export interface ReplayStats {
+    ports: number;
+    /** chunks, or lines with `sequence`, written */
+    records: number;
+    bytes: number;
+    /** writes that found the pty full because the application wasn't reading */
+    stalls: number;
+    /** `observe()` calls for unknown or already observed sequence numbers */
+    missed: number;
+    recordsPerSecond: number;
+    /** milliseconds from writing a line to its `observe()` */
+    latency: {
+        count: number;
+        mean: number;
+        p50: number;
+        p99: number;
+        max: number;
+    };
+}
+/**
+ * Plays captures back into pseudo terminals, one per simulated device, so an application reading serial
+ * ports can be load tested with recorded field traffic.
+ *
+ * Every port replays the whole capture, at the original pace (`speed: 1`), scaled (`speed: 10` is ten
+ * times faster) or as fast as the application reads (`speed: 'max'`). Ports are staggered over the
+ * capture's average interval so a large fleet doesn't send in lockstep.
+ *
+ * With `sequence` each line gets a `,SEQ:<n>` field (numbered per port) and the application reports what
+ * it has handled with `observe(path, n)`, which records the latency from the moment the line was written.
+ *
+ * Emits 'data' (path, Buffer) with what the application writes to a port and 'end' once every port has
+ * replayed the capture, unless `loop` is set.
+ */
+export declare class CaptureReplayer extends EventEmitter {
+    private speed;
+    private loop;
+    private field;
+    private records;
+    private duration;
+    private offsets;
+    private interval;
+    private portCount;
+    private ports;
+    private byPath;
+    private finished;
+    private started;
+    private startedAt;
+    private latencies;
+    private counters;
+    constructor(chunks: CaptureChunk[], options?: ReplayOptions);
+    /**
+     * Opens the ptys and returns their paths. Opening a port discards its pending input, so have the
+     * application open them before calling `start()`.
+     */
+    open(): string[];
+    /**
+     * Starts replaying, opening the ptys first if needed. Returns their paths.
+     */
+    start(): string[];
+    get paths(): string[];
+    /**
+     * Records that the application handled line `seq` of the port at `path`, returns the latency in
+     * milliseconds or null if the line isn't known (not tagged or too old)
+     */
+    observe(path: string, seq: number): number | null;
+    get stats(): ReplayStats;
+    /**
+     * Clears the counters and latencies, e.g. after a warm up
+     */
+    resetStats(): void;
+    close(): void;
+    private advance;
+    private schedule;
+    private fill;
+    private send;
+    private flush;
+    private readCommands;
+}
@@ -0,0 +1,369 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.CaptureReplayer = exports.loadCapture = exports.openPty = void 0;
+const fs_1 = require("fs");
+const events_1 = require("events");
+const debug_1 = __importDefault(require("debug"));
+const linux_capture_1 = require("./linux-capture");
+const poller_1 = require("./poller");
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/replay');
+const NEWLINE = 0x0a;
+const CARRIAGE_RETURN = 0x0d;
+// send times kept per port for `observe()`, older sequence numbers can't be matched any more
+const SENT_WINDOW = 4096;
+// records written back to back at `speed: 'max'` before letting the loop run
+const MAX_BURST = 256;
+/**
+ * Opens a raw pseudo terminal. Applications open `path` like a serial port, `masterFd` is the device's
+ * side. `slaveFd` keeps the pty up while the application has the port closed, close both when done.
+ */
+const openPty = () => serialport_bindings_1.binding.openPty();
+exports.openPty = openPty;
+/**
+ * Reads captures recorded with the `capture` open option into chunks as they were read from the port.
+ * Pass rotated files oldest first, e.g. `['port.raw.1', 'port.raw']`.
+ */
+const loadCapture = async (paths) => {
+    const chunks = [];
+    for (const path of typeof paths === 'string' ? [paths] : paths) {
+        const [data, index] = await Promise.all([fs_1.promises.readFile(path), (0, linux_capture_1.readCaptureIndex)(path)]);
+        for (const { offset, length, timestamp } of index) {
+            chunks.push({ data: data.subarray(offset, offset + length), timestamp });
+        }
+    }
+    return chunks;
+};
+exports.loadCapture = loadCapture;
+/**
+ * Splits chunks into lines, each sent when the chunk completing it was read. A trailing partial line is
+ * kept as the last entry.
+ */
+const toLines = (chunks) => {
+    const lines = [];
+    let partial = [];
+    for (const { data, timestamp } of chunks) {
+        let start = 0;
+        let end;
+        while ((end = data.indexOf(NEWLINE, start)) !== -1) {
+            partial.push(data.subarray(start, end + 1));
+            lines.push({ data: Buffer.concat(partial), timestamp });
+            partial = [];
+            start = end + 1;
+        }
+        if (start < data.length) {
+            partial.push(data.subarray(start));
+        }
+    }
+    if (partial.length > 0) {
+        lines.push({ data: Buffer.concat(partial), timestamp: chunks[chunks.length - 1].timestamp });
+    }
+    return lines;
+};
+/**
+ * Appends `,FIELD:seq` to a line, before its CRLF or LF
+ */
+const tagLine = (line, field, seq) => {
+    let end = line.length;
+    if (end > 0 && line[end - 1] === NEWLINE) {
+        end--;
+        if (end > 0 && line[end - 1] === CARRIAGE_RETURN) {
+            end--;
+        }
+    }
+    return Buffer.concat([line.subarray(0, end), Buffer.from(`,${field}:${seq}`), line.subarray(end)]);
+};
+/**
+ * Plays captures back into pseudo terminals, one per simulated device, so an application reading serial
+ * ports can be load tested with recorded field traffic.
+ *
+ * Every port replays the whole capture, at the original pace (`speed: 1`), scaled (`speed: 10` is ten
+ * times faster) or as fast as the application reads (`speed: 'max'`). Ports are staggered over the
+ * capture's average interval so a large fleet doesn't send in lockstep.
+ *
+ * With `sequence` each line gets a `,SEQ:<n>` field (numbered per port) and the application reports what
+ * it has handled with `observe(path, n)`, which records the latency from the moment the line was written.
+ *
+ * Emits 'data' (path, Buffer) with what the application writes to a port and 'end' once every port has
+ * replayed the capture, unless `loop` is set.
+ */
+class CaptureReplayer extends events_1.EventEmitter {
+    constructor(chunks, { ports = 1, speed = 1, sequence = false, loop = false } = {}) {
+        super();
+        if (chunks.length === 0) {
+            throw new TypeError('"chunks" is empty');
+        }
+        if (speed !== 'max' && !(typeof speed === 'number' && speed > 0)) {
+            throw new TypeError('"speed" must be a positive number or "max"');
+        }
+        this.speed = speed;
+        this.loop = loop;
+        this.field = sequence === true ? 'SEQ' : sequence || null;
+        this.records = this.field ? toLines(chunks) : chunks;
+        const first = this.records[0].timestamp;
+        this.duration = this.records[this.records.length - 1].timestamp - first;
+        this.offsets = this.records.map(({ timestamp }) => timestamp - first);
+        // a looped capture starts over one average interval after its last record
+        this.interval = this.records.length > 1 ? this.duration / (this.records.length - 1) : 1000;
+        this.portCount = ports;
+        this.ports = [];
+        this.byPath = new Map();
+        this.finished = 0;
+        this.started = false;
+        this.startedAt = 0;
+        this.latencies = [];
+        this.counters = { records: 0, bytes: 0, stalls: 0, missed: 0 };
+    }
+    /**
+     * Opens the ptys and returns their paths. Opening a port discards its pending input, so have the
+     * application open them before calling `start()`.
+     */
+    open() {
+        if (this.ports.length > 0) {
+            return this.paths;
+        }
+        try {
+            for (let i = 0; i < this.portCount; i++) {
+                const pty = (0, exports.openPty)();
+                const port = {
+                    ...pty,
+                    index: i,
+                    poller: new poller_1.Poller(pty.masterFd),
+                    cursor: 0,
+                    cycle: 0,
+                    seq: 0,
+                    queue: [],
+                    waiting: false,
+                    timer: null,
+                    done: false,
+                    sentSeq: new Float64Array(SENT_WINDOW).fill(-1),
+                    sentAt: new Float64Array(SENT_WINDOW),
+                    startAt: 0,
+                };
+                this.ports.push(port);
+                this.byPath.set(port.path, port);
+                this.readCommands(port);
+            }
+        }
+        catch (err) {
+            this.close();
+            throw err;
+        }
+        return this.paths;
+    }
+    /**
+     * Starts replaying, opening the ptys first if needed. Returns their paths.
+     */
+    start() {
+        if (this.started) {
+            throw new Error('Replay already started');
+        }
+        this.open();
+        this.started = true;
+        this.startedAt = performance.now();
+        for (const port of this.ports) {
+            // spread over the first interval, scaled to the replay speed
+            port.startAt = this.startedAt + (this.speed === 'max' ? 0 : (this.interval * port.index) / this.ports.length / this.speed);
+            this.schedule(port);
+        }
+        return this.paths;
+    }
+    get paths() {
+        return this.ports.map(({ path }) => path);
+    }
+    /**
+     * Records that the application handled line `seq` of the port at `path`, returns the latency in
+     * milliseconds or null if the line isn't known (not tagged or too old)
+     */
+    observe(path, seq) {
+        const port = this.byPath.get(path);
+        if (!port || typeof seq !== 'number') {
+            return null;
+        }
+        const slot = seq % SENT_WINDOW;
+        if (port.sentSeq[slot] !== seq) {
+            this.counters.missed++;
+            return null;
+        }
+        port.sentSeq[slot] = -1;
+        const latency = performance.now() - port.sentAt[slot];
+        this.latencies.push(latency);
+        return latency;
+    }
+    get stats() {
+        const sorted = Float64Array.from(this.latencies).sort();
+        const at = (q) => (sorted.length ? sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))] : 0);
+        const elapsed = (performance.now() - this.startedAt) / 1000;
+        return {
+            ports: this.ports.length,
+            ...this.counters,
+            recordsPerSecond: elapsed > 0 ? this.counters.records / elapsed : 0,
+            latency: {
+                count: sorted.length,
+                mean: sorted.length ? sorted.reduce((a, b) => a + b, 0) / sorted.length : 0,
+                p50: at(0.5),
+                p99: at(0.99),
+                max: sorted.length ? sorted[sorted.length - 1] : 0,
+            },
+        };
+    }
+    /**
+     * Clears the counters and latencies, e.g. after a warm up
+     */
+    resetStats() {
+        this.latencies = [];
+        this.counters = { records: 0, bytes: 0, stalls: 0, missed: 0 };
+        this.startedAt = performance.now();
+    }
+    close() {
+        for (const port of this.ports) {
+            port.done = true;
+            clearTimeout(port.timer);
+            port.poller.stop();
+            port.poller.destroy();
+            (0, fs_1.closeSync)(port.masterFd);
+            (0, fs_1.closeSync)(port.slaveFd);
+        }
+        this.ports = [];
+        this.byPath.clear();
+    }
+    /**
+     * Moves the port's cursor to its next record, false when the port has finished
+     */
+    advance(port) {
+        if (port.done) {
+            return false;
+        }
+        if (port.cursor === this.records.length) {
+            if (!this.loop) {
+                port.done = true;
+                if (++this.finished === this.ports.length) {
+                    this.emit('end');
+                }
+                return false;
+            }
+            port.cursor = 0;
+            port.cycle++;
+        }
+        return true;
+    }
+    schedule(port) {
+        if (!this.advance(port)) {
+            return;
+        }
+        if (this.speed === 'max') {
+            this.fill(port);
+            return;
+        }
+        const due = port.startAt + (port.cycle * (this.duration + this.interval) + this.offsets[port.cursor]) / this.speed;
+        port.timer = setTimeout(() => {
+            port.timer = null;
+            this.send(port);
+            this.schedule(port);
+        }, Math.max(0, due - performance.now()));
+    }
+    /**
+     * Sends records until the pty is full, yielding to the loop every `MAX_BURST` records
+     */
+    fill(port) {
+        for (let burst = 0; burst < MAX_BURST; burst++) {
+            if (!this.send(port) || !this.advance(port)) {
+                return;
+            }
+        }
+        port.timer = setTimeout(() => {
+            port.timer = null;
+            this.fill(port);
+        }, 0);
+    }
+    /**
+     * Queues the record under the cursor and writes it, false when it has to wait for room in the pty
+     */
+    send(port) {
+        const record = this.records[port.cursor++];
+        let data = record.data;
+        if (this.field) {
+            const seq = port.seq++;
+            const slot = seq % SENT_WINDOW;
+            port.sentSeq[slot] = seq;
+            port.sentAt[slot] = performance.now();
+            data = tagLine(data, this.field, seq);
+        }
+        this.counters.records++;
+        this.counters.bytes += data.length;
+        port.queue.push(data);
+        return this.flush(port);
+    }
+    /**
+     * Writes what the pty has room for, the rest waits for it to become writable. False while waiting
+     */
+    flush(port) {
+        if (port.waiting) {
+            return false;
+        }
+        while (port.queue.length > 0) {
+            const data = port.queue[0];
+            let written;
+            try {
+                written = (0, fs_1.writeSync)(port.masterFd, data);
+            }
+            catch (err) {
+                if (err.code !== 'EAGAIN' && err.code !== 'EWOULDBLOCK' && err.code !== 'EINTR') {
+                    logger('write error', port.path, err);
+                    port.done = true;
+                    this.emit('error', err);
+                    return false;
+                }
+                written = 0;
+            }
+            if (written === data.length) {
+                port.queue.shift();
+                continue;
+            }
+            port.queue[0] = data.subarray(written);
+            // the application isn't keeping up
+            this.counters.stalls++;
+            port.waiting = true;
+            port.poller.once('writable', err => {
+                port.waiting = false;
+                if (!err && this.flush(port) && this.speed === 'max' && this.advance(port)) {
+                    this.fill(port);
+                }
+            });
+            return false;
+        }
+        return true;
+    }
+    /**
+     * Drains what the application writes to the port, a full pty would block it
+     */
+    readCommands(port) {
+        port.poller.once('readable', err => {
+            if (err) {
+                return;
+            }
+            const buffer = Buffer.allocUnsafe(4096);
+            for (;;) {
+                let bytesRead;
+                try {
+                    bytesRead = (0, fs_1.readSync)(port.masterFd, buffer, 0, buffer.length, null);
+                }
+                catch (err) {
+                    if (err.code !== 'EAGAIN' && err.code !== 'EWOULDBLOCK' && err.code !== 'EINTR') {
+                        logger('read error', port.path, err);
+                    }
+                    break;
+                }
+                if (bytesRead === 0) {
+                    break;
+                }
+                this.emit('data', port.path, Buffer.from(buffer.subarray(0, bytesRead)));
+            }
+            this.readCommands(port);
+        });
+    }
+}
+exports.CaptureReplayer = CaptureReplayer;
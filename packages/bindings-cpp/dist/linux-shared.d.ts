@@ -0,0 +1,98 @@
+/// <reference types="node" />
+import { EventEmitter } from 'events';
+export declare const hasSharedReader: boolean;
+export interface SharedReaderOptions {
+    /** Size of the buffers reads go into. Defaults to 65536 */
+    slabSize?: number;
+}
+export interface SubscribeOptions {
+    /** What happens when the subscriber falls `highWaterMark` bytes behind. Defaults to 'block' */
+    policy?: 'block' | 'drop-oldest';
+    /** Unread bytes before the policy applies. Defaults to 262144 */
+    highWaterMark?: number;
+}
+export interface SharedReaderStats {
+    reads: number;
+    bytes: number;
+    /** times reading paused for a blocking subscriber */
+    stalls: number;
+    /** reading is paused for a blocking subscriber */
+    blocked: boolean;
+    subscribers: number;
+    /** slabs held for subscribers that haven't read them yet */
+    slabs: number;
+    /** bytes in those slabs */
+    retained: number;
+}
+export interface SharedSubscriberStats {
+    policy: 'block' | 'drop-oldest';
+    highWaterMark: number;
+    /** handed to the subscriber */
+    delivered: number;
+    /** lost with the drop-oldest policy */
+    dropped: number;
+    /** read from the port but not yet by the subscriber */
+    lag: number;
+}
+/**
+ * One consumer of a SharedReader. `next()` hands out the data as it was read, the Buffers share the
+ * reader's memory with every other subscriber and must not be modified.
+ */
+export declare class SharedSubscriber {
+    readonly id: number;
+    private reader;
+    private queue;
+    private leftover;
+    private pending;
+    private closed;
+    private constructor();
+    /**
+     * Resolves with the next bytes read from the port, or null once the subscriber or the reader is
+     * closed. Rejects with the port's error once everything read before it has been handed out.
+     */
+    next(): Promise<Buffer | null>;
+    /**
+     * Copies up to `length` bytes into `buffer`, like the binding's `read()`. What doesn't fit is kept
+     * for the next call.
+     */
+    read(buffer: Buffer, offset?: number, length?: number): Promise<{
+        buffer: Buffer;
+        bytesRead: number;
+    }>;
+    get stats(): SharedSubscriberStats | null;
+    [Symbol.asyncIterator](): AsyncGenerator<Buffer, void, undefined>;
+    /**
+     * Stops receiving, the reader no longer keeps data or waits for this subscriber
+     */
+    close(): void;
+    private settle;
+}
+/**
+ * Reads an open port once for several consumers, e.g. a logger, a parser and a bridge, without each of
+ * them copying the data. Reads go into shared slabs and every subscriber is handed the same memory.
+ *
+ * Each subscriber reads at its own pace from where it subscribed. One more than `highWaterMark` bytes
+ * behind either holds up reading the port until it is down to half (`policy: 'block'`, the default,
+ * the data waits in the kernel) or loses its oldest unread bytes (`policy: 'drop-oldest'`, counted in
+ * its stats). Without subscribers the port's data is dropped.
+ *
+ * Don't read the port while it is shared and close the reader before the port. Emits 'error' when the
+ * port fails, subscribers get the error after the data read before it, and 'close'.
+ */
+export declare class SharedReader extends EventEmitter {
+    private native;
+    private subscribers;
+    private error;
+    private closed;
+    constructor(port: number | {
+        fd: number | null;
+    }, options?: SharedReaderOptions);
+    subscribe(options?: SubscribeOptions): SharedSubscriber;
+    get stats(): SharedReaderStats;
+    private onData;
+    private remove;
+    /**
+     * Stops reading, pending `next()` calls resolve with null. The port stays open.
+     */
+    close(): void;
+}
@@ -0,0 +1,202 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.SharedReader = exports.SharedSubscriber = exports.hasSharedReader = void 0;
+const events_1 = require("events");
+const debug_1 = __importDefault(require("debug"));
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/shared');
+exports.hasSharedReader = typeof serialport_bindings_1.binding.SharedReader === 'function';
+/**
+ * One consumer of a SharedReader. `next()` hands out the data as it was read, the Buffers share the
+ * reader's memory with every other subscriber and must not be modified.
+ */
+class SharedSubscriber {
+    constructor(reader, id) {
+        this.reader = reader;
+        this.id = id;
+        // views taken when the port failed, handed out before the error
+        this.queue = [];
+        // the rest of a view partly copied by `read()`
+        this.leftover = null;
+        this.pending = null;
+        this.closed = false;
+    }
+    /**
+     * Resolves with the next bytes read from the port, or null once the subscriber or the reader is
+     * closed. Rejects with the port's error once everything read before it has been handed out.
+     */
+    next() {
+        if (this.pending) {
+            return Promise.reject(new Error('next() is already pending'));
+        }
+        if (this.closed) {
+            return Promise.resolve(null);
+        }
+        if (this.leftover) {
+            const data = this.leftover;
+            this.leftover = null;
+            return Promise.resolve(data);
+        }
+        if (this.queue.length > 0) {
+            return Promise.resolve(this.queue.shift());
+        }
+        if (this.reader.error) {
+            return Promise.reject(this.reader.error);
+        }
+        if (this.reader.closed) {
+            return Promise.resolve(null);
+        }
+        const view = this.reader.native.take(this.id);
+        if (view) {
+            return Promise.resolve(toBuffer(view));
+        }
+        return new Promise((resolve, reject) => {
+            this.pending = { resolve, reject };
+            this.reader.native.wait(this.id);
+        });
+    }
+    /**
+     * Copies up to `length` bytes into `buffer`, like the binding's `read()`. What doesn't fit is kept
+     * for the next call.
+     */
+    async read(buffer, offset = 0, length = buffer.length - offset) {
+        const data = await this.next();
+        if (data === null) {
+            return { buffer, bytesRead: 0 };
+        }
+        const bytesRead = data.copy(buffer, offset, 0, Math.min(length, data.length));
+        if (bytesRead < data.length) {
+            this.leftover = data.subarray(bytesRead);
+        }
+        return { buffer, bytesRead };
+    }
+    get stats() {
+        return this.closed ? null : this.reader.native.subscriberStats(this.id);
+    }
+    async *[Symbol.asyncIterator]() {
+        let data;
+        while ((data = await this.next()) !== null) {
+            yield data;
+        }
+    }
+    /**
+     * Stops receiving, the reader no longer keeps data or waits for this subscriber
+     */
+    close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.leftover = null;
+        this.queue = [];
+        this.reader.remove(this);
+        this.settle(null, null);
+    }
+    settle(error, data) {
+        const pending = this.pending;
+        if (!pending) {
+            return;
+        }
+        this.pending = null;
+        if (error) {
+            pending.reject(error);
+        }
+        else {
+            pending.resolve(data);
+        }
+    }
+}
+exports.SharedSubscriber = SharedSubscriber;
+const toBuffer = (view) => Buffer.from(view.buffer, view.byteOffset, view.byteLength);
+/**
+ * Reads an open port once for several consumers, e.g. a logger, a parser and a bridge, without each of
+ * them copying the data. Reads go into shared slabs and every subscriber is handed the same memory.
+ *
+ * Each subscriber reads at its own pace from where it subscribed. One more than `highWaterMark` bytes
+ * behind either holds up reading the port until it is down to half (`policy: 'block'`, the default,
+ * the data waits in the kernel) or loses its oldest unread bytes (`policy: 'drop-oldest'`, counted in
+ * its stats). Without subscribers the port's data is dropped.
+ *
+ * Don't read the port while it is shared and close the reader before the port. Emits 'error' when the
+ * port fails, subscribers get the error after the data read before it, and 'close'.
+ */
+class SharedReader extends events_1.EventEmitter {
+    constructor(port, { slabSize = 65536 } = {}) {
+        super();
+        const fd = typeof port === 'number' ? port : port.fd;
+        if (typeof fd !== 'number') {
+            throw new TypeError('"port" is not open');
+        }
+        this.native = new serialport_bindings_1.binding.SharedReader(fd, { slabSize }, (err, id, view) => this.onData(err, id, view));
+        this.subscribers = new Map();
+        this.error = null;
+        this.closed = false;
+    }
+    subscribe({ policy = 'block', highWaterMark = 262144 } = {}) {
+        if (this.closed) {
+            throw new Error('Reader is closed');
+        }
+        const id = this.native.subscribe({ policy, highWaterMark });
+        const subscriber = new SharedSubscriber(this, id);
+        this.subscribers.set(id, subscriber);
+        return subscriber;
+    }
+    get stats() {
+        return this.native.stats;
+    }
+    onData(err, id, view) {
+        if (!err) {
+            const subscriber = this.subscribers.get(id);
+            if (subscriber) {
+                subscriber.settle(null, toBuffer(view));
+            }
+            return;
+        }
+        logger('port error', err);
+        if (err.code === 'EBADF' || err.code === 'ENXIO' || err.code === 'EIO' || err.code === 'EOF') {
+            err.disconnect = true;
+        }
+        this.error = err;
+        for (const subscriber of this.subscribers.values()) {
+            // the views keep their slabs once the reader is closed
+            let view;
+            while ((view = this.native.take(subscriber.id))) {
+                subscriber.queue.push(toBuffer(view));
+            }
+            if (subscriber.queue.length > 0) {
+                subscriber.settle(null, subscriber.queue.shift());
+            }
+            else {
+                subscriber.settle(err, null);
+            }
+        }
+        this.close();
+        if (this.listenerCount('error') > 0) {
+            this.emit('error', err);
+        }
+    }
+    remove(subscriber) {
+        this.subscribers.delete(subscriber.id);
+        if (!this.closed) {
+            this.native.unsubscribe(subscriber.id);
+        }
+    }
+    /**
+     * Stops reading, pending `next()` calls resolve with null. The port stays open.
+     */
+    close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.native.close();
+        for (const subscriber of this.subscribers.values()) {
+            subscriber.settle(null, null);
+        }
+        this.emit('close');
+    }
+}
+exports.SharedReader = SharedReader;
@@ -0,0 +1,94 @@
+/// <reference types="node" />
+import { EventEmitter } from 'events';
+import { ReadTiming } from './linux-coalesce';
+export declare const hasTransactor: boolean;
+export interface TransactorOptions {
+    /** Ends every frame in both directions. Defaults to '\n' */
+    delimiter?: number | string | Buffer | number[];
+    /** Longer responses are dropped and counted as overruns. Defaults to 4096 */
+    maxFrame?: number;
+    /** Requests written before their responses arrive. Defaults to 16 */
+    maxInFlight?: number;
+    /** Precedes the sequence number in responses. Defaults to 'SEQ:' */
+    sequenceField?: string | Buffer;
+    /** Default request timeout in milliseconds, 0 waits forever. Defaults to 1000 */
+    timeout?: number;
+}
+export interface RequestOptions {
+    /** The response starts with this */
+    expect?: string | Buffer;
+    /** The response contains this */
+    contains?: string | Buffer;
+    /** The response carries this number after `sequenceField` */
+    sequence?: number;
+    /** Milliseconds from the request, 0 waits forever */
+    timeout?: number;
+    signal?: AbortSignal;
+}
+/**
+ * `readAt` is the read() that completed the response
+ */
+export interface TransactionResult extends ReadTiming {
+    /** the response without its delimiter */
+    frame: Buffer;
+    /** milliseconds from the command reaching the kernel to the response being read */
+    rtt: number;
+}
+export interface TransactorStats {
+    requests: number;
+    completed: number;
+    timeouts: number;
+    cancelled: number;
+    /** frames no request matched */
+    unsolicited: number;
+    /** frames dropped for being longer than `maxFrame` */
+    overruns: number;
+    /** written or being written, waiting for a response */
+    inFlight: number;
+    /** waiting for a slot */
+    queued: number;
+    rtt: {
+        count: number;
+        mean: number;
+        min: number;
+        max: number;
+    };
+}
+/**
+ * Sends commands on an open port and waits for their responses natively, e.g. `WATER:AUTO` and the
+ * node's `Received command: WATER:AUTO`. The port is split into frames on `delimiter`, each request
+ * completes with the first frame (delimiter removed) matching it:
+ * - `expect`, the frame starts with it
+ * - `contains`, the frame contains it
+ * - `sequence`, the number after `sequenceField` in the frame, e.g. `SEQ:` in `OK,SEQ:42`
+ * - none of them, the next frame
+ *
+ * Up to `maxInFlight` requests are written without waiting for earlier responses, later ones queue.
+ * Requests made in the same tick are written together. A request that hasn't completed within its
+ * `timeout` rejects with ETIMEDOUT, the deadlines are native timers rather than a JS timer each.
+ *
+ * Frames no request matches are emitted as 'frame', with their `ReadTiming` as the second argument. A
+ * request is cancelled with its `signal`. Don't read or write the port while it is used here. Emits
+ * 'error' when the port fails, after which the transactor is closed.
+ */
+export declare class Transactor extends EventEmitter {
+    private delimiter;
+    private timeout;
+    private native;
+    private pending;
+    private closed;
+    constructor(port: number | {
+        fd: number | null;
+    }, options?: TransactorOptions);
+    /**
+     * Writes `command`, with the delimiter appended when it doesn't end with it, and resolves with the
+     * matching response and its round trip time in milliseconds
+     */
+    request(command: string | Buffer, options?: RequestOptions): Promise<TransactionResult>;
+    get stats(): TransactorStats;
+    private onResult;
+    /**
+     * Stops reading, pending requests reject. The port stays open.
+     */
+    close(): void;
+}
@@ -0,0 +1,139 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.Transactor = exports.hasTransactor = void 0;
+const events_1 = require("events");
+const debug_1 = __importDefault(require("debug"));
+const linux_coalesce_1 = require("./linux-coalesce");
+const serialport_bindings_1 = require("./serialport-bindings");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/transaction');
+exports.hasTransactor = typeof serialport_bindings_1.binding.SerialTransactor === 'function';
+const abortError = () => {
+    const err = new Error('Transaction aborted');
+    err.code = 'ABORT_ERR';
+    return err;
+};
+const toBuffer = (value) => (value === undefined || value === null ? undefined : Buffer.isBuffer(value) ? value : Buffer.from(value));
+/**
+ * Sends commands on an open port and waits for their responses natively, e.g. `WATER:AUTO` and the
+ * node's `Received command: WATER:AUTO`. The port is split into frames on `delimiter`, each request
+ * completes with the first frame (delimiter removed) matching it:
+ * - `expect`, the frame starts with it
+ * - `contains`, the frame contains it
+ * - `sequence`, the number after `sequenceField` in the frame, e.g. `SEQ:` in `OK,SEQ:42`
+ * - none of them, the next frame
+ *
+ * Up to `maxInFlight` requests are written without waiting for earlier responses, later ones queue.
+ * Requests made in the same tick are written together. A request that hasn't completed within its
+ * `timeout` rejects with ETIMEDOUT, the deadlines are native timers rather than a JS timer each.
+ *
+ * Frames no request matches are emitted as 'frame', with their `ReadTiming` as the second argument. A
+ * request is cancelled with its `signal`. Don't read or write the port while it is used here. Emits
+ * 'error' when the port fails, after which the transactor is closed.
+ */
+class Transactor extends events_1.EventEmitter {
+    constructor(port, { delimiter = '\n', maxFrame = 4096, maxInFlight = 16, sequenceField = 'SEQ:', timeout = 1000 } = {}) {
+        super();
+        const fd = typeof port === 'number' ? port : port.fd;
+        if (typeof fd !== 'number') {
+            throw new TypeError('"port" is not open');
+        }
+        this.delimiter = (0, linux_coalesce_1.toDelimiter)(delimiter);
+        this.timeout = timeout;
+        this.native = new serialport_bindings_1.binding.SerialTransactor(fd, { delimiter: this.delimiter, maxFrame, maxInFlight, sequenceField: toBuffer(sequenceField) }, (err, id, frame, rtt, readAt, wakeAt) => this.onResult(err, id, frame, rtt, readAt, wakeAt));
+        this.pending = new Map();
+        this.closed = false;
+    }
+    /**
+     * Writes `command`, with the delimiter appended when it doesn't end with it, and resolves with the
+     * matching response and its round trip time in milliseconds
+     */
+    request(command, { expect, contains, sequence, timeout = this.timeout, signal } = {}) {
+        if (this.closed) {
+            return Promise.reject(new Error('Transactor is closed'));
+        }
+        if (signal?.aborted) {
+            return Promise.reject(abortError());
+        }
+        let frame = toBuffer(command);
+        if (!frame.subarray(frame.length - this.delimiter.length).equals(this.delimiter)) {
+            frame = Buffer.concat([frame, this.delimiter]);
+        }
+        return new Promise((resolve, reject) => {
+            const id = this.native.request(frame, { prefix: toBuffer(expect), contains: toBuffer(contains), sequence, timeout });
+            if (!signal) {
+                this.pending.set(id, { resolve, reject });
+                return;
+            }
+            // the command may already have been written, its response then arrives as a 'frame'
+            const onAbort = () => {
+                if (this.pending.delete(id)) {
+                    this.native.cancel(id);
+                    reject(abortError());
+                }
+            };
+            signal.addEventListener('abort', onAbort, { once: true });
+            const done = () => signal.removeEventListener('abort', onAbort);
+            this.pending.set(id, {
+                resolve: value => {
+                    done();
+                    resolve(value);
+                },
+                reject: err => {
+                    done();
+                    reject(err);
+                },
+            });
+        });
+    }
+    get stats() {
+        return this.native.stats;
+    }
+    onResult(err, id, frame, rtt, readAt, wakeAt) {
+        if (id === 0) {
+            if (err) {
+                logger('port error', err);
+                if (err.code === 'EBADF' || err.code === 'ENXIO' || err.code === 'EIO' || err.code === 'EOF') {
+                    err.disconnect = true;
+                }
+                this.close();
+                if (this.listenerCount('error') > 0) {
+                    this.emit('error', err);
+                }
+                return;
+            }
+            this.emit('frame', frame, { readAt, wakeAt });
+            return;
+        }
+        const pending = this.pending.get(id);
+        if (!pending) {
+            return;
+        }
+        this.pending.delete(id);
+        if (err) {
+            pending.reject(err);
+        }
+        else {
+            pending.resolve({ frame, rtt, readAt, wakeAt });
+        }
+    }
+    /**
+     * Stops reading, pending requests reject. The port stays open.
+     */
+    close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        this.native.close();
+        const pending = [...this.pending.values()];
+        this.pending.clear();
+        for (const { reject } of pending) {
+            reject(new Error('Transactor is closed'));
+        }
+        this.emit('close');
+    }
+}
+exports.Transactor = Transactor;
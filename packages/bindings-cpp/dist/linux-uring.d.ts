@@ -0,0 +1,41 @@
+/// <reference types="node" />
+import { CoalesceStats, CoalescingReader, TimedReadResult } from './linux-coalesce';
+/**
+ * Whether ports can be opened with `ioUring`, false when the binding was built without it or the kernel
+ * lacks multishot reads (linux 6.7) or has io_uring disabled
+ */
+export declare const hasIoUring: boolean;
+export interface IoUringOptions {
+    /** Size of each provided read buffer. Defaults to 4096 */
+    bufferSize?: number;
+    /** Provided read buffers per port, a power of 2. Defaults to 16 */
+    bufferCount?: number;
+    /** Stop reading while this many bytes are waiting for `read()`. Defaults to 65536 */
+    highWaterMark?: number;
+}
+export interface IoUringStats extends CoalesceStats {
+    /** bytes written */
+    bytesWritten: number;
+    /** writev completions, one per batch of queued writes */
+    writes: number;
+    /** io_uring_enter() calls made by the environment's ring, shared by all its ports */
+    ringSubmits: number;
+    /** completion wake ups of the environment's ring, shared by all its ports */
+    ringWakeups: number;
+}
+/**
+ * Reads and writes a port through the environment's io_uring instead of poll readiness plus `fs.read`
+ * and `fs.write` on the threadpool. Reads are queued like a `CoalescingReader` with every batch
+ * delivered as soon as it is read. The kernel doesn't say when it completed a read, `readAt` is when
+ * the completion was reaped.
+ */
+export declare class UringIo {
+    private native;
+    readonly reader: CoalescingReader;
+    constructor(fd: number, options?: IoUringOptions);
+    get stats(): IoUringStats;
+    read(buffer: Buffer, offset: number, length: number): Promise<TimedReadResult>;
+    write(buffer: Buffer): Promise<void>;
+    discard(): void;
+    close(): void;
+}
@@ -0,0 +1,64 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.UringIo = exports.hasIoUring = void 0;
+const debug_1 = __importDefault(require("debug"));
+const errors_1 = require("./errors");
+const serialport_bindings_1 = require("./serialport-bindings");
+const linux_coalesce_1 = require("./linux-coalesce");
+const logger = (0, debug_1.default)('serialport/bindings-cpp/io_uring');
+/**
+ * Whether ports can be opened with `ioUring`, false when the binding was built without it or the kernel
+ * lacks multishot reads (linux 6.7) or has io_uring disabled
+ */
+exports.hasIoUring = typeof serialport_bindings_1.binding.UringPort === 'function' && serialport_bindings_1.binding.ioUringSupported();
+/**
+ * Reads and writes a port through the environment's io_uring instead of poll readiness plus `fs.read`
+ * and `fs.write` on the threadpool. Reads are queued like a `CoalescingReader` with every batch
+ * delivered as soon as it is read. The kernel doesn't say when it completed a read, `readAt` is when
+ * the completion was reaped.
+ */
+class UringIo {
+    constructor(fd, options = {}) {
+        const { bufferSize, bufferCount, highWaterMark } = options;
+        this.native = null;
+        this.reader = new linux_coalesce_1.CoalescingReader(fd, highWaterMark === undefined ? {} : { highWaterMark }, (fd, nativeOptions, callback) => {
+            this.native = new serialport_bindings_1.binding.UringPort(fd, { bufferSize, bufferCount }, callback);
+            return this.native;
+        });
+    }
+    get stats() {
+        return this.reader.stats;
+    }
+    read(buffer, offset, length) {
+        return this.reader.read(buffer, offset, length);
+    }
+    write(buffer) {
+        return new Promise((resolve, reject) => {
+            this.native.write(buffer, err => {
+                if (!err) {
+                    resolve();
+                    return;
+                }
+                logger('write error', err);
+                if (err.code === 'ECANCELED') {
+                    reject(new errors_1.BindingsError('Port is not open', { canceled: true }));
+                    return;
+                }
+                if (err.code === 'EBADF' || err.code === 'ENXIO' || err.code === 'EIO') {
+                    err.disconnect = true;
+                }
+                reject(err);
+            });
+        });
+    }
+    discard() {
+        this.reader.discard();
+    }
+    close() {
+        this.reader.close();
+    }
+}
+exports.UringIo = UringIo;
@@ -0,0 +1,139 @@
+import { Poller } from './poller';
+import { BindingInterface, OpenOptions, PortStatus, SetOptions, UpdateOptions } from '@serialport/bindings-interface';
+import { BindingPortInterface } from '.';
+import { ReconnectOptions, ReconnectingPortBinding } from './linux-reconnect';
+import { CoalesceOptions, CoalescingReader, TimedReadResult } from './linux-coalesce';
+import { IoUringOptions, UringIo } from './linux-uring';
+import { CaptureOptions, SerialCapture } from './linux-capture';
+export interface LinuxOpenOptions extends OpenOptions {
+    /** Defaults to none */
+    parity?: 'none' | 'even' | 'odd';
+    /** see [`man termios`](http://linux.die.net/man/3/termios) defaults to 1 */
+    vmin?: number;
+    /** see [`man termios`](http://linux.die.net/man/3/termios) defaults to 0 */
+    vtime?: number;
+    /**
+     * Let the tty assemble lines (ICANON). Each read returns at most one complete line, partial lines
+     * stay in the kernel until their newline arrives. vmin and vtime are ignored. Meant for text protocols,
+     * lines longer than the kernel's line buffer (4095 bytes on linux) are truncated. Defaults to false
+     */
+    icanon?: boolean;
+    /** Translate CR to NL on input (ICRNL), for devices that end lines with a bare CR. Defaults to false */
+    icrnl?: boolean;
+    /** Discard CR on input (IGNCR), for CRLF terminated lines. Defaults to false */
+    igncr?: boolean;
+    /** Reopen the port when the device re-enumerates, see `ReconnectingPortBinding`. Defaults to false */
+    reconnect?: boolean | ReconnectOptions;
+    /**
+     * Read natively and deliver data in batches, trading a bounded latency for fewer JS callbacks on fast
+     * ports. See `CoalescingReader`. Ignored when the binding was built without it. Defaults to false
+     */
+    coalesce?: boolean | CoalesceOptions;
+    /**
+     * Read and write through io_uring, see `UringIo`. `coalesce` is ignored when it is used. Falls back to
+     * polling when `hasIoUring` is false. Defaults to false
+     */
+    ioUring?: boolean | IoUringOptions;
+    /**
+     * Record everything read from the port to a file, a path or `CaptureOptions`. See `SerialCapture`.
+     * `ioUring` is ignored while capturing, `coalesce` still applies. Defaults to false
+     */
+    capture?: false | string | CaptureOptions;
+}
+export interface LinuxPortStatus extends PortStatus {
+    lowLatency: boolean;
+}
+export interface LinuxSetOptions extends SetOptions {
+    /** Low latency mode */
+    lowLatency?: boolean;
+}
+export interface DetectBaudOptions {
+    /** Rates to try, in order. Defaults to 9600, 115200, 57600, 38400, 19200, 230400, 4800, 2400, 1200 */
+    candidates?: number[];
+    /** How long to listen at each rate. Defaults to 500 */
+    sampleMillis?: number;
+    /** Stop listening at a rate once this many bytes arrived. Defaults to 256 */
+    maxBytes?: number;
+    /** Bytes needed before a rate is accepted without trying the rest. Defaults to 32 */
+    minBytes?: number;
+    /** Score (0 to 1) at which a rate is accepted without trying the rest. Defaults to 0.95 */
+    accept?: number;
+    /** No rate is picked when the best scores less. Defaults to 0.5 */
+    minScore?: number;
+    /** Score by printable ASCII as well as framing errors, for line based nodes. Defaults to true */
+    text?: boolean;
+    /**
+     * Scores a sample instead, e.g. by checking frame CRCs. Every candidate is sampled and the highest
+     * score wins
+     */
+    score?: (data: Buffer, sample: BaudSample) => number;
+}
+export interface BaudSample {
+    baudRate: number;
+    /** false when the driver refused the rate */
+    supported: boolean;
+    /** received without an error */
+    bytes: number;
+    /** framing and parity errors and breaks */
+    errors: number;
+    /** printable ASCII, tab, CR and LF */
+    printable: number;
+    lines: number;
+    score: number;
+    /** what was received without error */
+    data: Buffer;
+}
+export type LinuxBindingInterface = BindingInterface<LinuxPortBinding | ReconnectingPortBinding, LinuxOpenOptions>;
+export declare const LinuxBinding: LinuxBindingInterface;
+/**
+ * The linux binding layer
+ */
+export declare class LinuxPortBinding implements BindingPortInterface {
+    readonly openOptions: Required<LinuxOpenOptions>;
+    readonly poller: Poller;
+    private writeOperation;
+    /** Set when the port was opened with `coalesce`, `ioUring` or `capture` */
+    readonly reader: CoalescingReader | SerialCapture | null;
+    /** Set when the port was opened with `ioUring` and it is available */
+    readonly uring: UringIo | null;
+    /** Set when the port was opened with `capture` and it is available */
+    readonly capture: SerialCapture | null;
+    fd: number | null;
+    constructor(fd: number, openOptions: Required<LinuxOpenOptions>);
+    get isOpen(): boolean;
+    close(): Promise<void>;
+    read(buffer: Buffer, offset: number, length: number): Promise<TimedReadResult>;
+    write(buffer: Buffer): Promise<void>;
+    update(options: UpdateOptions): Promise<void>;
+    set(options: LinuxSetOptions): Promise<void>;
+    get(): Promise<LinuxPortStatus>;
+    getBaudRate(): Promise<{
+        baudRate: number;
+    }>;
+    /**
+     * Finds the rate the device is sending at and switches the port to it. Resolves with the rate (null
+     * when nothing convincing arrived) and the samples it was picked from.
+     *
+     * Each candidate is set, what arrives for `sampleMillis` is read with framing errors marked, and the
+     * sample is scored by the share of bytes received cleanly and, with `text`, printable. The first rate
+     * scoring `accept` ends the search. Can't be used with `coalesce`, `ioUring` or `capture`, and
+     * nothing else should read the port meanwhile.
+     */
+    detectBaud(options?: DetectBaudOptions): Promise<{
+        baudRate: number | null;
+        samples: BaudSample[];
+    }>;
+    /**
+     * Same as `set()` but runs on the calling thread, changing the control lines is a single non blocking ioctl
+     */
+    setSync(options: LinuxSetOptions): void;
+    /**
+     * Same as `get()` but runs on the calling thread, cheap enough to poll the control lines at high frequency
+     */
+    getSync(): LinuxPortStatus;
+    getBaudRateSync(): {
+        baudRate: number;
+    };
+    flush(): Promise<void>;
+    drain(): Promise<void>;
+}
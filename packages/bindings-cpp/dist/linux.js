@@ -0,0 +1,280 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.LinuxPortBinding = exports.LinuxBinding = void 0;
+const debug_1 = __importDefault(require("debug"));
+const linux_list_1 = require("./linux-list");
+const poller_1 = require("./poller");
+const unix_read_1 = require("./unix-read");
+const unix_write_1 = require("./unix-write");
+const load_bindings_1 = require("./load-bindings");
+const linux_reconnect_1 = require("./linux-reconnect");
+const linux_coalesce_1 = require("./linux-coalesce");
+const linux_uring_1 = require("./linux-uring");
+const linux_capture_1 = require("./linux-capture");
+const debug = (0, debug_1.default)('serialport/bindings-cpp');
+// SoftwareSerial nodes first, then the hardware UART rates from fastest common to slowest
+const DETECT_BAUD_CANDIDATES = [9600, 115200, 57600, 38400, 19200, 230400, 4800, 2400, 1200];
+exports.LinuxBinding = {
+    list() {
+        debug('list');
+        // the native lister reads sysfs directly, udevadm is kept for prebuilt binaries without it
+        if (load_bindings_1.hasNativeList) {
+            return (0, load_bindings_1.asyncList)();
+        }
+        return (0, linux_list_1.linuxList)();
+    },
+    async open(options) {
+        if (!options || typeof options !== 'object' || Array.isArray(options)) {
+            throw new TypeError('"options" is not an object');
+        }
+        if (!options.path) {
+            throw new TypeError('"path" is not a valid port');
+        }
+        if (!options.baudRate) {
+            throw new TypeError('"baudRate" is not a valid baudRate');
+        }
+        debug('open');
+        const openOptions = Object.assign({ vmin: 1, vtime: 0, icanon: false, icrnl: false, igncr: false, dataBits: 8, lock: true, stopBits: 1, parity: 'none', rtscts: false, xon: false, xoff: false, xany: false, hupcl: true, reconnect: false, coalesce: false, ioUring: false, capture: false }, options);
+        if (openOptions.reconnect) {
+            const list = () => this.list();
+            const identity = await (0, linux_reconnect_1.resolvePortIdentity)(openOptions.path, list);
+            const port = await openPort(openOptions);
+            return new linux_reconnect_1.ReconnectingPortBinding({ port, identity, openOptions, openPort, list, reconnect: openOptions.reconnect });
+        }
+        const fd = await (0, load_bindings_1.asyncOpen)(openOptions.path, openOptions);
+        this.fd = fd;
+        return new LinuxPortBinding(fd, openOptions);
+    },
+};
+async function openPort(openOptions) {
+    const fd = await (0, load_bindings_1.asyncOpen)(openOptions.path, openOptions);
+    return new LinuxPortBinding(fd, openOptions);
+}
+/**
+ * The linux binding layer
+ */
+class LinuxPortBinding {
+    constructor(fd, openOptions) {
+        this.fd = fd;
+        this.openOptions = openOptions;
+        this.poller = new poller_1.Poller(fd);
+        this.writeOperation = null;
+        this.reader = null;
+        this.uring = null;
+        this.capture = null;
+        let readFd = fd;
+        if (openOptions.capture && linux_capture_1.hasCapture) {
+            this.capture = new linux_capture_1.SerialCapture(fd, typeof openOptions.capture === 'string' ? { path: openOptions.capture } : openOptions.capture);
+            this.reader = this.capture;
+            readFd = this.capture.readFd;
+        }
+        else if (openOptions.capture) {
+            debug('capture is not available, not recording');
+        }
+        if (openOptions.ioUring && this.capture) {
+            debug('io_uring is not used while capturing');
+        }
+        else if (openOptions.ioUring && linux_uring_1.hasIoUring) {
+            this.uring = new linux_uring_1.UringIo(fd, typeof openOptions.ioUring === 'object' ? openOptions.ioUring : {});
+            this.reader = this.uring.reader;
+        }
+        else if (openOptions.ioUring) {
+            debug('io_uring is not available, using poll');
+        }
+        if (!this.uring && openOptions.coalesce && linux_coalesce_1.hasReadCoalescer) {
+            this.reader = new linux_coalesce_1.CoalescingReader(readFd, typeof openOptions.coalesce === 'object' ? openOptions.coalesce : {});
+        }
+    }
+    get isOpen() {
+        return this.fd !== null;
+    }
+    async close() {
+        debug('close');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        const fd = this.fd;
+        this.poller.stop();
+        this.poller.destroy();
+        if (this.reader) {
+            this.reader.close();
+        }
+        if (this.capture && this.reader !== this.capture) {
+            this.capture.close();
+        }
+        this.fd = null;
+        await (0, load_bindings_1.asyncClose)(fd);
+    }
+    async read(buffer, offset, length) {
+        if (!Buffer.isBuffer(buffer)) {
+            throw new TypeError('"buffer" is not a Buffer');
+        }
+        if (typeof offset !== 'number' || isNaN(offset)) {
+            throw new TypeError(`"offset" is not an integer got "${isNaN(offset) ? 'NaN' : typeof offset}"`);
+        }
+        if (typeof length !== 'number' || isNaN(length)) {
+            throw new TypeError(`"length" is not an integer got "${isNaN(length) ? 'NaN' : typeof length}"`);
+        }
+        debug('read');
+        if (buffer.length < offset + length) {
+            throw new Error('buffer is too small');
+        }
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        if (this.reader) {
+            return this.reader.read(buffer, offset, length);
+        }
+        return (0, unix_read_1.unixRead)({ binding: this, buffer, offset, length });
+    }
+    async write(buffer) {
+        if (!Buffer.isBuffer(buffer)) {
+            throw new TypeError('"buffer" is not a Buffer');
+        }
+        debug('write', buffer.length, 'bytes');
+        if (!this.isOpen) {
+            debug('write', 'error port is not open');
+            throw new Error('Port is not open');
+        }
+        this.writeOperation = (async () => {
+            if (buffer.length === 0) {
+                return;
+            }
+            if (this.uring) {
+                await this.uring.write(buffer);
+            }
+            else {
+                await (0, unix_write_1.unixWrite)({ binding: this, buffer });
+            }
+            this.writeOperation = null;
+        })();
+        return this.writeOperation;
+    }
+    async update(options) {
+        if (!options || typeof options !== 'object' || Array.isArray(options)) {
+            throw TypeError('"options" is not an object');
+        }
+        if (typeof options.baudRate !== 'number') {
+            throw new TypeError('"options.baudRate" is not a number');
+        }
+        debug('update');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        await (0, load_bindings_1.asyncUpdate)(this.fd, options);
+    }
+    async set(options) {
+        if (!options || typeof options !== 'object' || Array.isArray(options)) {
+            throw new TypeError('"options" is not an object');
+        }
+        debug('set');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        await (0, load_bindings_1.asyncSet)(this.fd, options);
+    }
+    async get() {
+        debug('get');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        return (0, load_bindings_1.asyncGet)(this.fd);
+    }
+    async getBaudRate() {
+        debug('getBaudRate');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        return (0, load_bindings_1.asyncGetBaudRate)(this.fd);
+    }
+    /**
+     * Finds the rate the device is sending at and switches the port to it. Resolves with the rate (null
+     * when nothing convincing arrived) and the samples it was picked from.
+     */
+    async detectBaud(options = {}) {
+        debug('detectBaud');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        if (this.reader) {
+            throw new Error('detectBaud() reads the port itself, open it without coalesce, ioUring or capture');
+        }
+        const { candidates = DETECT_BAUD_CANDIDATES, sampleMillis = 500, maxBytes = 256, minBytes = 32, accept = 0.95, minScore = 0.5, text = true, score } = options;
+        // a custom score needs every candidate sampled
+        const result = await (0, load_bindings_1.asyncDetectBaud)(this.fd, { candidates, sampleMillis, maxBytes, minBytes, accept: score ? Infinity : accept, minScore, text });
+        let baudRate = result.baudRate;
+        if (score) {
+            let best = -Infinity;
+            baudRate = null;
+            for (const sample of result.samples) {
+                if (!sample.supported) {
+                    continue;
+                }
+                sample.score = score(sample.data, sample);
+                if (sample.score >= minScore && sample.score > best) {
+                    best = sample.score;
+                    baudRate = sample.baudRate;
+                }
+            }
+        }
+        if (baudRate !== null) {
+            await this.update({ baudRate });
+        }
+        return { baudRate, samples: result.samples };
+    }
+    /**
+     * Same as `set()` but runs on the calling thread, changing the control lines is a single non blocking ioctl
+     */
+    setSync(options) {
+        if (!options || typeof options !== 'object' || Array.isArray(options)) {
+            throw new TypeError('"options" is not an object');
+        }
+        debug('setSync');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        (0, load_bindings_1.syncSet)(this.fd, options);
+    }
+    /**
+     * Same as `get()` but runs on the calling thread, cheap enough to poll the control lines at high frequency
+     */
+    getSync() {
+        debug('getSync');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        return (0, load_bindings_1.syncGet)(this.fd);
+    }
+    getBaudRateSync() {
+        debug('getBaudRateSync');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        return (0, load_bindings_1.syncGetBaudRate)(this.fd);
+    }
+    async flush() {
+        debug('flush');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        await (0, load_bindings_1.asyncFlush)(this.fd);
+        if (this.reader) {
+            this.reader.discard();
+        }
+        if (this.capture && this.reader !== this.capture) {
+            this.capture.discard();
+        }
+    }
+    async drain() {
+        debug('drain');
+        if (!this.isOpen) {
+            throw new Error('Port is not open');
+        }
+        await this.writeOperation;
+        await (0, load_bindings_1.asyncDrain)(this.fd);
+    }
+}
+exports.LinuxPortBinding = LinuxPortBinding;
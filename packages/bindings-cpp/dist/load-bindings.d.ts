@@ -9,3 +9,8 @@ export declare const asyncSet: Function;
 export declare const asyncUpdate: Function;
 export declare const asyncRead: Function;
 export declare const asyncWrite: Function;
+export declare const hasNativeList: boolean;
+export declare const syncSet: Function;
+export declare const syncGet: Function;
+export declare const syncGetBaudRate: Function;
+export declare const asyncDetectBaud: Function;
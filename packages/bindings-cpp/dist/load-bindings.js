@@ -1,6 +1,6 @@
 "use strict";
 Object.defineProperty(exports, "__esModule", { value: true });
-exports.asyncWrite = exports.asyncRead = exports.asyncUpdate = exports.asyncSet = exports.asyncOpen = exports.asyncList = exports.asyncGetBaudRate = exports.asyncGet = exports.asyncFlush = exports.asyncDrain = exports.asyncClose = void 0;
+exports.asyncDetectBaud = exports.syncGetBaudRate = exports.syncGet = exports.syncSet = exports.hasNativeList = exports.asyncWrite = exports.asyncRead = exports.asyncUpdate = exports.asyncSet = exports.asyncOpen = exports.asyncList = exports.asyncGetBaudRate = exports.asyncGet = exports.asyncFlush = exports.asyncDrain = exports.asyncClose = void 0;
 const util_1 = require("util");
 const serialport_bindings_1 = require("./serialport-bindings");
 exports.asyncClose = serialport_bindings_1.binding.close ? (0, util_1.promisify)(serialport_bindings_1.binding.close) : async () => { throw new Error('"binding.close" Method not implemented'); };
@@ -14,3 +14,9 @@ exports.asyncSet = serialport_bindings_1.binding.set ? (0, util_1.promisify)(ser
 exports.asyncUpdate = serialport_bindings_1.binding.update ? (0, util_1.promisify)(serialport_bindings_1.binding.update) : async () => { throw new Error('"binding.update" Method not implemented'); };
 exports.asyncRead = serialport_bindings_1.binding.read ? (0, util_1.promisify)(serialport_bindings_1.binding.read) : async () => { throw new Error('"binding.read" Method not implemented'); };
 exports.asyncWrite = serialport_bindings_1.binding.write ? (0, util_1.promisify)(serialport_bindings_1.binding.write) : async () => { throw new Error('"binding.write" Method not implemented'); };
+exports.hasNativeList = typeof serialport_bindings_1.binding.list === 'function';
+// set, get and getBaudRate are single ioctls that never block, these skip the worker round trip
+exports.syncSet = serialport_bindings_1.binding.setSync ? serialport_bindings_1.binding.setSync : () => { throw new Error('"binding.setSync" Method not implemented'); };
+exports.syncGet = serialport_bindings_1.binding.getSync ? serialport_bindings_1.binding.getSync : () => { throw new Error('"binding.getSync" Method not implemented'); };
+exports.syncGetBaudRate = serialport_bindings_1.binding.getBaudRateSync ? serialport_bindings_1.binding.getBaudRateSync : () => { throw new Error('"binding.getBaudRateSync" Method not implemented'); };
+exports.asyncDetectBaud = serialport_bindings_1.binding.detectBaud ? (0, util_1.promisify)(serialport_bindings_1.binding.detectBaud) : async () => { throw new Error('"binding.detectBaud" Method not implemented'); };
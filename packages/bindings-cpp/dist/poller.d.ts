@@ -1,6 +1,6 @@
 import { EventEmitter } from 'events';
 interface PollerClass {
-    new (fd: number, cb: (err: Error, flag: number) => void): PollerInstance;
+    new (fd: number, cb: (err: Error, flag: number) => void, batchId?: number): PollerInstance;
 }
 interface PollerInstance {
     poll(flag: number): void;
@@ -12,11 +12,34 @@ export declare const EVENTS: {
     UV_WRITABLE: number;
     UV_DISCONNECT: number;
 };
+export declare const hasPollBatching: boolean;
+export interface PollBatchStats {
+    /** calls into JS */
+    flushes: number;
+    /** poller events delivered by those calls */
+    events: number;
+    largest: number;
+    pending: number;
+}
+/**
+ * Turns batched polling on or off for pollers created afterwards. While on, the events of all those
+ * pollers that fire in one loop iteration reach JS in a single call rather than one call per port and
+ * event, which is what dominates with many ports. Each poller still emits its own events. Pollers
+ * created while batching was off keep their own callbacks. Returns whether batching is on.
+ */
+export declare function setPollBatching(enabled: boolean): boolean;
+/**
+ * How many calls into JS batching made (`flushes`) for how many poller `events`, the `largest` batch
+ * and the events `pending` for the current iteration. Null while batching is off.
+ */
+export declare function getPollBatchStats(): PollBatchStats | null;
 /**
  * Polls unix systems for readable or writable states of a file or serialport
  */
 export declare class Poller extends EventEmitter {
     poller: PollerInstance;
+    /** non zero when the poller's events are batched */
+    batchId: number;
     constructor(fd: number, FDPoller?: PollerClass);
     /**
      * Wait for the next event to occur
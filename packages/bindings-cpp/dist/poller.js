@@ -3,12 +3,14 @@ var __importDefault = (this && this.__importDefault) || function (mod) {
     return (mod && mod.__esModule) ? mod : { "default": mod };
 };
 Object.defineProperty(exports, "__esModule", { value: true });
-exports.Poller = exports.EVENTS = void 0;
+exports.Poller = exports.hasPollBatching = exports.EVENTS = void 0;
+exports.setPollBatching = setPollBatching;
+exports.getPollBatchStats = getPollBatchStats;
 const debug_1 = __importDefault(require("debug"));
 const events_1 = require("events");
 const errors_1 = require("./errors");
 const serialport_bindings_1 = require("./serialport-bindings");
-const { Poller: PollerBindings } = serialport_bindings_1.binding;
+const { Poller: PollerBindings, PollBatch } = serialport_bindings_1.binding;
 const logger = (0, debug_1.default)('serialport/bindings-cpp/poller');
 exports.EVENTS = {
     UV_READABLE: 0b0001,
@@ -18,6 +20,8 @@ exports.EVENTS = {
 function handleEvent(error, eventFlag) {
     if (error) {
         logger('error', error);
+        // the native poller stopped, poll() adds it back
+        batchedPollers.delete(this.batchId);
         this.emit('readable', error);
         this.emit('writable', error);
         this.emit('disconnect', error);
@@ -36,6 +40,51 @@ function handleEvent(error, eventFlag) {
         this.emit('disconnect', null);
     }
 }
+exports.hasPollBatching = typeof PollBatch === 'function';
+let pollBatch = null;
+let nextBatchId = 0;
+// batch id to Poller, for pollers created while batching was on that are polling. Pollers leave it
+// when they stop, fail or are destroyed, so a poller that stopped but was never destroyed isn't kept
+const batchedPollers = new Map();
+function dispatchBatch(pairs) {
+    for (let i = 0; i < pairs.length; i += 2) {
+        const poller = batchedPollers.get(pairs[i]);
+        if (poller) {
+            handleEvent.call(poller, null, pairs[i + 1]);
+        }
+    }
+}
+/**
+ * Turns batched polling on or off for pollers created afterwards. While on, the events of all those
+ * pollers that fire in one loop iteration reach JS in a single call rather than one call per port and
+ * event, which is what dominates with many ports. Each poller still emits its own events. Pollers
+ * created while batching was off keep their own callbacks. Returns whether batching is on.
+ */
+function setPollBatching(enabled) {
+    if (!exports.hasPollBatching) {
+        return false;
+    }
+    if (enabled && !pollBatch) {
+        logger('Batching pollers');
+        pollBatch = new PollBatch(dispatchBatch);
+    }
+    else if (!enabled && pollBatch) {
+        logger('Stopped batching pollers');
+        const pending = pollBatch.close();
+        pollBatch = null;
+        if (pending.length > 0) {
+            process.nextTick(dispatchBatch, pending);
+        }
+    }
+    return pollBatch !== null;
+}
+/**
+ * How many calls into JS batching made (`flushes`) for how many poller `events`, the `largest` batch
+ * and the events `pending` for the current iteration. Null while batching is off.
+ */
+function getPollBatchStats() {
+    return pollBatch ? pollBatch.stats : null;
+}
 /**
  * Polls unix systems for readable or writable states of a file or serialport
  */
@@ -43,7 +92,12 @@ class Poller extends events_1.EventEmitter {
     constructor(fd, FDPoller = PollerBindings) {
         logger('Creating poller');
         super();
-        this.poller = new FDPoller(fd, handleEvent.bind(this));
+        this.batchId = 0;
+        if (pollBatch && FDPoller === PollerBindings) {
+            nextBatchId = (nextBatchId % 0x7fffffff) + 1;
+            this.batchId = nextBatchId;
+        }
+        this.poller = new FDPoller(fd, handleEvent.bind(this), this.batchId);
     }
     /**
      * Wait for the next event to occur
@@ -79,6 +133,9 @@ class Poller extends events_1.EventEmitter {
             logger('Polling for "disconnect"');
         }
         this.poller.poll(eventFlag);
+        if (this.batchId) {
+            batchedPollers.set(this.batchId, this);
+        }
     }
     /**
      * Stop listening for events and cancel all outstanding listening with an error
@@ -86,11 +143,13 @@ class Poller extends events_1.EventEmitter {
     stop() {
         logger('Stopping poller');
         this.poller.stop();
+        batchedPollers.delete(this.batchId);
         this.emitCanceled();
     }
     destroy() {
         logger('Destroying poller');
         this.poller.destroy();
+        batchedPollers.delete(this.batchId);
         this.emitCanceled();
     }
     emitCanceled() {
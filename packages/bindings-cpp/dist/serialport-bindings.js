@@ -0,0 +1,17 @@
+"use strict";
+var __importDefault = (this && this.__importDefault) || function (mod) {
+    return (mod && mod.__esModule) ? mod : { "default": mod };
+};
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.binding = void 0;
+const path_1 = require("path");
+const node_gyp_build_1 = __importDefault(require("node-gyp-build"));
+// SERIALPORT_NATIVE_REVISION in src/serialport.h, the addon these sources were written against
+const NATIVE_REVISION = 2;
+// eslint-disable-next-line @typescript-eslint/no-explicit-any
+exports.binding = (0, node_gyp_build_1.default)((0, path_1.join)(__dirname, '../'));
+// A stock prebuild loads fine but lacks most of this package's native code, the JS would quietly fall back
+if (exports.binding.nativeRevision !== NATIVE_REVISION) {
+    throw new Error(`@serialport/bindings-cpp: the loaded addon is native revision ${exports.binding.nativeRevision ?? 'none'}, ` +
+        `expected ${NATIVE_REVISION}. Rebuild it with \`npm rebuild @serialport/bindings-cpp --build-from-source\``);
+}
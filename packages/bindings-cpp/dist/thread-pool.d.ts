@@ -0,0 +1,24 @@
+export interface ThreadPoolStats {
+    /** Maximum number of threads */
+    size: number;
+    /** Threads currently started, they are started on demand */
+    threads: number;
+    /** Operations currently running */
+    active: number;
+    /** Operations waiting for a thread */
+    queued: number;
+    maxQueued: number;
+    completed: number;
+    totalWaitMicros: number;
+    maxWaitMicros: number;
+}
+/**
+ * Set how many threads run blocking serial operations (open, drain, set, get...). These run on the
+ * binding's own pool rather than the libuv threadpool so a slow device can't starve fs, dns or crypto.
+ * Defaults to 4, or the SERIALPORT_THREADPOOL_SIZE environment variable. Must be between 1 and 64.
+ */
+export declare function setThreadPoolSize(size: number): void;
+/**
+ * Counters for the serial thread pool. Wait times are how long operations sat in the queue before a thread picked them up.
+ */
+export declare function getThreadPoolStats(): ThreadPoolStats;
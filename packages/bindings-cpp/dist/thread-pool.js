@@ -0,0 +1,25 @@
+"use strict";
+Object.defineProperty(exports, "__esModule", { value: true });
+exports.setThreadPoolSize = setThreadPoolSize;
+exports.getThreadPoolStats = getThreadPoolStats;
+const serialport_bindings_1 = require("./serialport-bindings");
+/**
+ * Set how many threads run blocking serial operations (open, drain, set, get...). These run on the
+ * binding's own pool rather than the libuv threadpool so a slow device can't starve fs, dns or crypto.
+ * Defaults to 4, or the SERIALPORT_THREADPOOL_SIZE environment variable. Must be between 1 and 64.
+ */
+function setThreadPoolSize(size) {
+    if (!serialport_bindings_1.binding.setThreadPoolSize) {
+        throw new Error('"binding.setThreadPoolSize" Method not implemented');
+    }
+    serialport_bindings_1.binding.setThreadPoolSize(size);
+}
+/**
+ * Counters for the serial thread pool. Wait times are how long operations sat in the queue before a thread picked them up.
+ */
+function getThreadPoolStats() {
+    if (!serialport_bindings_1.binding.getThreadPoolStats) {
+        throw new Error('"binding.getThreadPoolStats" Method not implemented');
+    }
+    return serialport_bindings_1.binding.getThreadPoolStats();
+}
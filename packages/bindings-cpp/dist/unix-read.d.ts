@@ -1,6 +1,7 @@
 import { read as fsRead } from 'fs';
 import { LinuxPortBinding } from './linux';
 import { DarwinPortBinding } from './darwin';
+import { TimedReadResult } from './linux-coalesce';
 declare const readAsync: typeof fsRead.__promisify__;
 interface UnixReadOptions {
     binding: LinuxPortBinding | DarwinPortBinding;
@@ -8,9 +9,12 @@ interface UnixReadOptions {
     offset: number;
     length: number;
     fsReadAsync?: typeof readAsync;
+    /** when the poller woke this read up, defaults to the start of the read */
+    wakeAt?: number;
 }
-export declare const unixRead: ({ binding, buffer, offset, length, fsReadAsync, }: UnixReadOptions) => Promise<{
-    buffer: Buffer;
-    bytesRead: number;
-}>;
+/**
+ * Reads through fs.read, waiting for the poller when there is nothing to read. The result carries the
+ * same `ReadTiming` as the native readers, `readAt` is when fs.read completed on the loop.
+ */
+export declare const unixRead: ({ binding, buffer, offset, length, fsReadAsync, wakeAt, }: UnixReadOptions) => Promise<TimedReadResult>;
 export {};
@@ -10,6 +10,8 @@ const errors_1 = require("./errors");
 const debug_1 = __importDefault(require("debug"));
 const logger = (0, debug_1.default)('serialport/bindings-cpp/unixRead');
 const readAsync = (0, util_1.promisify)(fs_1.read);
+// nanoseconds of CLOCK_MONOTONIC, the clock the native readers stamp with
+const monotonicNow = () => Number(process.hrtime.bigint());
 const readable = (binding) => {
     return new Promise((resolve, reject) => {
         if (!binding.poller) {
@@ -18,18 +20,20 @@ const readable = (binding) => {
         binding.poller.once('readable', err => (err ? reject(err) : resolve()));
     });
 };
-const unixRead = async ({ binding, buffer, offset, length, fsReadAsync = readAsync, }) => {
+const unixRead = async ({ binding, buffer, offset, length, fsReadAsync = readAsync, wakeAt = monotonicNow(), }) => {
     logger('Starting read');
     if (!binding.isOpen || !binding.fd) {
         throw new errors_1.BindingsError('Port is not open', { canceled: true });
     }
     try {
         const { bytesRead } = await fsReadAsync(binding.fd, buffer, offset, length, null);
+        // fs.read runs on the threadpool, readAt is when its result got back to the loop
+        const readAt = monotonicNow();
         if (bytesRead === 0) {
             return (0, exports.unixRead)({ binding, buffer, offset, length, fsReadAsync });
         }
         logger('Finished read', bytesRead, 'bytes');
-        return { bytesRead, buffer };
+        return { bytesRead, buffer, readAt, wakeAt };
     }
     catch (err) {
         logger('read error', err);
@@ -39,7 +43,7 @@ const unixRead = async ({ binding, buffer, offset, length, fsReadAsync = readAsy
             }
             logger('waiting for readable because of code:', err.code);
             await readable(binding);
-            return (0, exports.unixRead)({ binding, buffer, offset, length, fsReadAsync });
+            return (0, exports.unixRead)({ binding, buffer, offset, length, fsReadAsync, wakeAt: monotonicNow() });
         }
         const disconnectError = err.code === 'EBADF' || // Bad file number means we got closed
             err.code === 'ENXIO' || // No such device or address probably usb disconnect
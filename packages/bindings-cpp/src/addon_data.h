@@ -0,0 +1,47 @@
+#ifndef PACKAGES_SERIALPORT_SRC_ADDON_DATA_H_
+#define PACKAGES_SERIALPORT_SRC_ADDON_DATA_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <memory>
+#include <set>
+#include "./worker_pool.h"
+
+// An object owning a uv handle on its environment's loop. A worker thread's loop is closed when the
+// worker exits, which can be before the JS objects owning handles on it are garbage collected.
+class PollBatch;
+#ifdef __linux__
+class Uring;
+#endif
+
+class LoopHandleOwner {
+ public:
+  virtual ~LoopHandleOwner() {}
+  // Stops and closes the handle, the owner must not touch it afterwards
+  virtual void closeHandle() = 0;
+};
+
+// Per environment state, stored as the addon's instance data. Each environment (the main thread and
+// every worker_thread) loads its own copy so ports opened in a worker are polled on that worker's loop.
+struct AddonData {
+  explicit AddonData(Napi::Env env);
+
+  uv_loop_t* loop = nullptr;
+  Napi::FunctionReference pollerConstructor;
+  // set while pollers' events are batched
+  PollBatch* pollBatch = nullptr;
+  std::shared_ptr<WorkerEnv> workers;
+  std::set<LoopHandleOwner*> handleOwners;
+  #ifdef __linux__
+  // created by the first port opened with `ioUring`
+  std::shared_ptr<Uring> uring;
+  #endif
+
+  void addHandleOwner(LoopHandleOwner* owner) { handleOwners.insert(owner); }
+  void removeHandleOwner(LoopHandleOwner* owner) { handleOwners.erase(owner); }
+
+  // Runs before the environment's loop is closed
+  static void Cleanup(AddonData* data);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_ADDON_DATA_H_
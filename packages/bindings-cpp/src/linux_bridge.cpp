@@ -0,0 +1,604 @@
+#include "./linux_bridge.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+static const size_t kReadSize = 65536;
+static const size_t kClientReadSize = 16384;
+// reads per wake up, the poll fires again if there is more
+static const unsigned kReadsPerWake = 16;
+
+static Napi::Error uvError(Napi::Env env, int status, const std::string& what) {
+  Napi::Error error = Napi::Error::New(env, std::string("Error: ") + uv_strerror(status) + ", " + what);
+  error.Set("errno", Napi::Number::New(env, status));
+  error.Set("code", uv_err_name(status));
+  return error;
+}
+
+static std::string socketName(const struct sockaddr_storage& address, int* port) {
+  char name[INET6_ADDRSTRLEN] = "";
+  if (AF_INET6 == address.ss_family) {
+    const struct sockaddr_in6* in6 = reinterpret_cast<const struct sockaddr_in6*>(&address);
+    uv_ip6_name(in6, name, sizeof(name));
+    *port = ntohs(in6->sin6_port);
+  } else {
+    const struct sockaddr_in* in = reinterpret_cast<const struct sockaddr_in*>(&address);
+    uv_ip4_name(in, name, sizeof(name));
+    *port = ntohs(in->sin_port);
+  }
+  return name;
+}
+
+// End of the last complete frame in `data`, counting the frames. `from` is where new data starts.
+static size_t lastFrameEnd(const std::vector<char>& data, size_t from, const std::string& delimiter,
+                           uint64_t* frames) {
+  // a delimiter may straddle the old and the new data
+  size_t start = from >= delimiter.size() - 1 ? from - (delimiter.size() - 1) : 0;
+  size_t end = 0;
+  const void* found;
+  while (start + delimiter.size() <= data.size() &&
+         (found = memmem(data.data() + start, data.size() - start, delimiter.data(), delimiter.size())) != NULL) {
+    end = static_cast<const char*>(found) - data.data() + delimiter.size();
+    start = end;
+    (*frames)++;
+  }
+  return end;
+}
+
+SerialBridge::SerialBridge(const Napi::CallbackInfo &info) : Napi::ObjectWrap<SerialBridge>(info),
+  context(info.Env(), "node-serialport:SerialBridge") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int portFd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[2].As<Napi::Function>());
+
+  std::string host = "127.0.0.1";
+  Napi::Value value = options.Get("host");
+  if (value.IsString()) {
+    host = value.As<Napi::String>().Utf8Value();
+  }
+  int port = 0;
+  value = options.Get("port");
+  if (value.IsNumber()) {
+    port = value.As<Napi::Number>().Int32Value();
+    if (port < 0 || port > 65535) {
+      Napi::RangeError::New(env, "port must be between 0 and 65535").ThrowAsJavaScriptException();
+      return;
+    }
+  }
+  value = options.Get("maxClients");
+  if (value.IsNumber()) {
+    int64_t count = value.As<Napi::Number>().Int64Value();
+    if (count < 1 || count > 1024) {
+      Napi::RangeError::New(env, "maxClients must be between 1 and 1024").ThrowAsJavaScriptException();
+      return;
+    }
+    this->maxClients = count;
+  }
+  value = options.Get("highWaterMark");
+  if (value.IsNumber()) {
+    int64_t size = value.As<Napi::Number>().Int64Value();
+    if (size < 1) {
+      Napi::RangeError::New(env, "highWaterMark must be at least 1").ThrowAsJavaScriptException();
+      return;
+    }
+    this->highWaterMark = size;
+  }
+  value = options.Get("maxFrame");
+  if (value.IsNumber()) {
+    int64_t size = value.As<Napi::Number>().Int64Value();
+    if (size < 1) {
+      Napi::RangeError::New(env, "maxFrame must be at least 1").ThrowAsJavaScriptException();
+      return;
+    }
+    this->maxFrame = size;
+  }
+  value = options.Get("delimiter");
+  if (value.IsBuffer()) {
+    Napi::Buffer<char> delimiterBuffer = value.As<Napi::Buffer<char>>();
+    this->delimiter.assign(delimiterBuffer.Data(), delimiterBuffer.Length());
+  }
+
+  struct sockaddr_storage address;
+  int status = host.find(':') != std::string::npos ?
+    uv_ip6_addr(host.c_str(), port, reinterpret_cast<struct sockaddr_in6*>(&address)) :
+    uv_ip4_addr(host.c_str(), port, reinterpret_cast<struct sockaddr_in*>(&address));
+  if (0 != status) {
+    uvError(env, status, "invalid host " + host).ThrowAsJavaScriptException();
+    return;
+  }
+
+  this->ttyFd = fcntl(portFd, F_DUPFD_CLOEXEC, 0);
+  if (-1 == this->ttyFd) {
+    SerialError(errno, "Error: %s, cannot duplicate fd %d", portFd).ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  this->readBuffer.resize(kReadSize);
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  this->tty_handle = new uv_poll_t();
+  tty_handle->data = this;
+  status = uv_poll_init(data->loop, tty_handle, ttyFd);
+  if (0 != status) {
+    delete tty_handle;
+    tty_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  this->server_handle = new uv_tcp_t();
+  server_handle->data = this;
+  uv_tcp_init(data->loop, server_handle);
+  status = uv_tcp_bind(server_handle, reinterpret_cast<const struct sockaddr*>(&address), 0);
+  if (0 == status) {
+    status = uv_listen(reinterpret_cast<uv_stream_t*>(server_handle), 16, SerialBridge::onConnection);
+  }
+  if (0 != status) {
+    uv_close(reinterpret_cast<uv_handle_t*>(tty_handle), SerialBridge::onClose);
+    uv_close(reinterpret_cast<uv_handle_t*>(server_handle), SerialBridge::onClose);
+    tty_handle = nullptr;
+    server_handle = nullptr;
+    uvError(env, status, "cannot listen on " + host + ":" + std::to_string(port)).ThrowAsJavaScriptException();
+    return;
+  }
+  handles_open = true;
+  data->addHandleOwner(this);
+  updateTtyPoll();
+  // a listening bridge lives until it is closed, like a net.Server
+  Ref();
+}
+
+SerialBridge::~SerialBridge() {
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  if (-1 != ttyFd) {
+    ::close(ttyFd);
+  }
+}
+
+void SerialBridge::closeHandle() {
+  uv_poll_stop(tty_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(tty_handle), SerialBridge::onClose);
+  uv_close(reinterpret_cast<uv_handle_t*>(server_handle), SerialBridge::onClose);
+  for (auto& entry : clients) {
+    // pending writes are cancelled before the client is freed, they must not reach the bridge
+    entry.second->bridge = nullptr;
+    uv_close(reinterpret_cast<uv_handle_t*>(&entry.second->handle), SerialBridge::onClientClose);
+  }
+  clients.clear();
+  // the handles are freed by onClose
+  tty_handle = nullptr;
+  server_handle = nullptr;
+  handles_open = false;
+  // the dup keeps the tty (and its lock) open, release it with the port rather than when collected
+  ::close(ttyFd);
+  ttyFd = -1;
+}
+
+void SerialBridge::onClose(uv_handle_t* handle) {
+  if (UV_POLL == handle->type) {
+    delete reinterpret_cast<uv_poll_t*>(handle);
+  } else {
+    delete reinterpret_cast<uv_tcp_t*>(handle);
+  }
+}
+
+void SerialBridge::onClientClose(uv_handle_t* handle) {
+  delete static_cast<Client*>(handle->data);
+}
+
+void SerialBridge::call(Napi::Env env, const char* event, uint32_t id, napi_value detail) {
+  try {
+    callback.MakeCallback(Value(), {Napi::String::New(env, event), Napi::Number::New(env, id), detail}, context);
+  } catch (const Napi::Error& e) {
+    // same as an exception thrown from any other callback
+    napi_fatal_exception(env, e.Value());
+  }
+}
+
+void SerialBridge::updateTtyPoll() {
+  int events = (ttyPaused ? 0 : UV_READABLE) | (ttyOutOffset < ttyOut.size() ? UV_WRITABLE : 0);
+  if (events == ttyEvents) {
+    return;
+  }
+  ttyEvents = events;
+  if (0 == events) {
+    uv_poll_stop(tty_handle);
+  } else {
+    uv_poll_start(tty_handle, events, SerialBridge::onTty);
+  }
+}
+
+size_t SerialBridge::maxQueued() const {
+  size_t queued = 0;
+  for (const auto& entry : clients) {
+    queued = std::max(queued, entry.second->handle.write_queue_size);
+  }
+  return queued;
+}
+
+// Sends data read from the port to every connection, it is dropped when there are none
+void SerialBridge::broadcast(const char* data, size_t length, uint64_t frames) {
+  if (clients.empty()) {
+    dropped += length;
+    return;
+  }
+  framesFromPort += frames;
+  auto slab = std::make_shared<std::vector<char>>(data, data + length);
+  for (auto& entry : clients) {
+    Client* client = entry.second;
+    WriteRequest* request = new WriteRequest();
+    request->req.data = request;
+    request->client = client;
+    request->data = slab;
+    uv_buf_t buf = uv_buf_init(slab->data(), length);
+    if (0 != uv_write(&request->req, reinterpret_cast<uv_stream_t*>(&client->handle), &buf, 1,
+                      SerialBridge::onWrite)) {
+      // the connection is going away, its read callback reports it
+      delete request;
+      continue;
+    }
+    client->bytesOut += length;
+    client->framesOut += frames;
+  }
+  if (maxQueued() > highWaterMark) {
+    // the slowest connection sets the pace, the port's data waits in the kernel
+    ttyPaused = true;
+    stalls++;
+    updateTtyPoll();
+  }
+}
+
+// Reads the port again once every connection is down to half the high water mark
+void SerialBridge::resumeTty() {
+  if (ttyPaused && !failed && maxQueued() <= highWaterMark / 2) {
+    ttyPaused = false;
+    updateTtyPoll();
+  }
+}
+
+void SerialBridge::readTty(Napi::Env env) {
+  for (unsigned reads = 0; reads < kReadsPerWake && handles_open && !ttyPaused; reads++) {
+    ssize_t count = read(ttyFd, readBuffer.data(), readBuffer.size());
+    if (-1 == count) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        return;
+      }
+      if (EINTR == errno) {
+        continue;
+      }
+      fail(env, errno);
+      return;
+    }
+    if (0 == count) {
+      // a tty only reads 0 bytes once it is hung up
+      fail(env, 0);
+      return;
+    }
+    bytesFromPort += count;
+    if (delimiter.empty()) {
+      broadcast(readBuffer.data(), count, 0);
+      continue;
+    }
+    size_t from = ttyPartial.size();
+    ttyPartial.insert(ttyPartial.end(), readBuffer.data(), readBuffer.data() + count);
+    uint64_t frames = 0;
+    size_t end = lastFrameEnd(ttyPartial, from, delimiter, &frames);
+    if (0 == end && ttyPartial.size() >= maxFrame) {
+      // too long to be a frame, pass it on rather than buffer without bound
+      end = ttyPartial.size();
+      frames = 1;
+    }
+    if (end > 0) {
+      broadcast(ttyPartial.data(), end, frames);
+      ttyPartial.erase(ttyPartial.begin(), ttyPartial.begin() + end);
+    }
+  }
+}
+
+void SerialBridge::writeTty(Napi::Env env) {
+  while (ttyOutOffset < ttyOut.size()) {
+    ssize_t written = write(ttyFd, ttyOut.data() + ttyOutOffset, ttyOut.size() - ttyOutOffset);
+    if (-1 == written) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        break;
+      }
+      if (EINTR == errno) {
+        continue;
+      }
+      fail(env, errno);
+      return;
+    }
+    ttyOutOffset += written;
+    bytesToPort += written;
+  }
+  if (ttyOutOffset == ttyOut.size()) {
+    ttyOut.clear();
+    ttyOutOffset = 0;
+    if (clientsPaused) {
+      pauseClients(false);
+    }
+  } else if (ttyOutOffset > ttyOut.size() / 2) {
+    ttyOut.erase(ttyOut.begin(), ttyOut.begin() + ttyOutOffset);
+    ttyOutOffset = 0;
+  }
+  updateTtyPoll();
+}
+
+// Queues what a connection sent for the port, whole frames only when there is a delimiter
+void SerialBridge::receive(Client* client, const char* data, size_t length) {
+  client->bytesIn += length;
+  if (delimiter.empty()) {
+    ttyOut.insert(ttyOut.end(), data, data + length);
+  } else {
+    size_t from = client->partial.size();
+    client->partial.insert(client->partial.end(), data, data + length);
+    uint64_t frames = 0;
+    size_t end = lastFrameEnd(client->partial, from, delimiter, &frames);
+    if (0 == end && client->partial.size() >= maxFrame) {
+      end = client->partial.size();
+      frames = 1;
+    }
+    if (0 == end) {
+      return;
+    }
+    ttyOut.insert(ttyOut.end(), client->partial.begin(), client->partial.begin() + end);
+    client->partial.erase(client->partial.begin(), client->partial.begin() + end);
+    client->framesIn += frames;
+    framesToPort += frames;
+  }
+  writeTty(Env());
+  if (handles_open && ttyOut.size() - ttyOutOffset > highWaterMark) {
+    // the port is slower than the connections, stop reading them until it catches up
+    pauseClients(true);
+  }
+}
+
+void SerialBridge::pauseClients(bool pause) {
+  clientsPaused = pause;
+  for (auto& entry : clients) {
+    Client* client = entry.second;
+    if (pause && client->reading) {
+      uv_read_stop(reinterpret_cast<uv_stream_t*>(&client->handle));
+      client->reading = false;
+    } else if (!pause && !client->reading) {
+      uv_read_start(reinterpret_cast<uv_stream_t*>(&client->handle), SerialBridge::onAlloc,
+                    SerialBridge::onClientRead);
+      client->reading = true;
+    }
+  }
+}
+
+void SerialBridge::disconnect(Napi::Env env, Client* client, int status) {
+  uint32_t id = client->id;
+  clients.erase(id);
+  client->bridge = nullptr;
+  uv_close(reinterpret_cast<uv_handle_t*>(&client->handle), SerialBridge::onClientClose);
+  resumeTty();
+  call(env, "disconnect", id, 0 == status ? env.Null() : uvError(env, status, "connection lost").Value());
+}
+
+// The port failed, the connections are closed and JS closes the bridge
+void SerialBridge::fail(Napi::Env env, int code) {
+  failed = true;
+  ttyPaused = true;
+  ttyOut.clear();
+  ttyOutOffset = 0;
+  updateTtyPoll();
+  for (auto& entry : clients) {
+    entry.second->bridge = nullptr;
+    uv_close(reinterpret_cast<uv_handle_t*>(&entry.second->handle), SerialBridge::onClientClose);
+  }
+  clients.clear();
+  if (0 == code) {
+    Napi::Error error = Napi::Error::New(env, "Error: Port hung up, cannot read");
+    error.Set("code", "EOF");
+    call(env, "error", 0, error.Value());
+  } else {
+    call(env, "error", 0, SerialError(code, "Error: %s, cannot read").ToError(env).Value());
+  }
+}
+
+void SerialBridge::onTty(uv_poll_t* handle, int status, int events) {
+  SerialBridge* obj = static_cast<SerialBridge*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  if (0 != status) {
+    // libuv reports POLLERR as EBADF, reading tells what happened to the port
+    obj->ttyEvents = 0;
+    obj->readTty(env);
+    if (obj->handles_open && !obj->failed) {
+      obj->fail(env, -status);
+    }
+    return;
+  }
+  if (events & UV_WRITABLE) {
+    obj->writeTty(env);
+  }
+  if ((events & UV_READABLE) && obj->handles_open) {
+    obj->readTty(env);
+  }
+}
+
+void SerialBridge::onConnection(uv_stream_t* server, int status) {
+  SerialBridge* obj = static_cast<SerialBridge*>(server->data);
+  if (0 != status) {
+    return;
+  }
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  Client* client = new Client();
+  client->handle.data = client;
+  uv_tcp_init(server->loop, &client->handle);
+  if (0 != uv_accept(server, reinterpret_cast<uv_stream_t*>(&client->handle))) {
+    uv_close(reinterpret_cast<uv_handle_t*>(&client->handle), SerialBridge::onClientClose);
+    return;
+  }
+  if (obj->clients.size() >= obj->maxClients) {
+    obj->rejected++;
+    uv_close(reinterpret_cast<uv_handle_t*>(&client->handle), SerialBridge::onClientClose);
+    return;
+  }
+  struct sockaddr_storage address;
+  int length = sizeof(address);
+  int port = 0;
+  if (0 == uv_tcp_getpeername(&client->handle, reinterpret_cast<struct sockaddr*>(&address), &length)) {
+    client->address = socketName(address, &port);
+    client->address += ":" + std::to_string(port);
+  }
+  // frames are small and latency matters more than packet count
+  uv_tcp_nodelay(&client->handle, 1);
+  client->bridge = obj;
+  client->id = obj->nextId++;
+  client->readBuffer.resize(kClientReadSize);
+  obj->clients[client->id] = client;
+  obj->connections++;
+  if (!obj->clientsPaused) {
+    uv_read_start(reinterpret_cast<uv_stream_t*>(&client->handle), SerialBridge::onAlloc, SerialBridge::onClientRead);
+    client->reading = true;
+  }
+  obj->call(env, "connection", client->id, Napi::String::New(env, client->address));
+}
+
+void SerialBridge::onAlloc(uv_handle_t* handle, size_t suggested, uv_buf_t* buf) {
+  Client* client = static_cast<Client*>(handle->data);
+  *buf = uv_buf_init(client->readBuffer.data(), client->readBuffer.size());
+}
+
+void SerialBridge::onClientRead(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  Client* client = static_cast<Client*>(stream->data);
+  SerialBridge* obj = client->bridge;
+  if (nullptr == obj || 0 == nread) {
+    return;
+  }
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  if (nread < 0) {
+    obj->disconnect(env, client, UV_EOF == nread ? 0 : nread);
+    return;
+  }
+  obj->receive(client, buf->base, nread);
+}
+
+void SerialBridge::onWrite(uv_write_t* req, int status) {
+  WriteRequest* request = static_cast<WriteRequest*>(req->data);
+  Client* client = request->client;
+  delete request;
+  SerialBridge* obj = client->bridge;
+  if (nullptr == obj) {
+    return;
+  }
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  if (0 != status) {
+    obj->disconnect(env, client, status);
+    return;
+  }
+  obj->resumeTty();
+}
+
+Napi::Value SerialBridge::getAddress(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handles_open) {
+    return env.Null();
+  }
+  struct sockaddr_storage address;
+  int length = sizeof(address);
+  if (0 != uv_tcp_getsockname(server_handle, reinterpret_cast<struct sockaddr*>(&address), &length)) {
+    return env.Null();
+  }
+  int port = 0;
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("address", socketName(address, &port));
+  result.Set("family", AF_INET6 == address.ss_family ? "IPv6" : "IPv4");
+  result.Set("port", port);
+  return result;
+}
+
+// Closes a connection, it gets a 'disconnect' like any other
+Napi::Value SerialBridge::drop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  auto entry = clients.find(info[0].As<Napi::Number>().Uint32Value());
+  if (entry != clients.end()) {
+    disconnect(env, entry->second, 0);
+  }
+  return env.Undefined();
+}
+
+Napi::Value SerialBridge::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+    Unref();
+  }
+  return env.Undefined();
+}
+
+Napi::Value SerialBridge::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("bytesFromPort", static_cast<double>(bytesFromPort));
+  stats.Set("bytesToPort", static_cast<double>(bytesToPort));
+  stats.Set("framesFromPort", static_cast<double>(framesFromPort));
+  stats.Set("framesToPort", static_cast<double>(framesToPort));
+  stats.Set("dropped", static_cast<double>(dropped));
+  stats.Set("stalls", static_cast<double>(stalls));
+  stats.Set("rejected", static_cast<double>(rejected));
+  stats.Set("connections", static_cast<double>(connections));
+  stats.Set("queuedToPort", static_cast<double>(ttyOut.size() - ttyOutOffset));
+  Napi::Array list = Napi::Array::New(env, clients.size());
+  uint32_t i = 0;
+  for (const auto& entry : clients) {
+    const Client* client = entry.second;
+    Napi::Object item = Napi::Object::New(env);
+    item.Set("id", client->id);
+    item.Set("address", client->address);
+    item.Set("bytesIn", static_cast<double>(client->bytesIn));
+    item.Set("bytesOut", static_cast<double>(client->bytesOut));
+    item.Set("framesIn", static_cast<double>(client->framesIn));
+    item.Set("framesOut", static_cast<double>(client->framesOut));
+    item.Set("queued", static_cast<double>(client->handle.write_queue_size));
+    list.Set(i++, item);
+  }
+  stats.Set("clients", list);
+  return stats;
+}
+
+Napi::Object SerialBridge::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "SerialBridge", {
+    InstanceAccessor<&SerialBridge::getAddress>("address"),
+    InstanceMethod<&SerialBridge::drop>("drop"),
+    InstanceMethod<&SerialBridge::close>("close"),
+    InstanceAccessor<&SerialBridge::getStats>("stats"),
+  });
+  exports.Set("SerialBridge", func);
+  return exports;
+}
@@ -0,0 +1,112 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_BRIDGE_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_BRIDGE_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "./addon_data.h"
+
+// Serves a port on a TCP socket, like ser2net. Bytes are moved between the tty and the connections
+// natively, JS only hears about connections coming and going.
+//
+// Everything read from the port goes to every connection. With a delimiter only complete frames are
+// sent, so a connection never starts or stops in the middle of one, and each connection's frames are
+// written to the port whole rather than interleaved with another's. When a connection can't keep up the
+// port isn't read until it catches up, and the data waits in the kernel. Without connections the port's
+// data is read and dropped.
+class SerialBridge : public Napi::ObjectWrap<SerialBridge>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit SerialBridge(const Napi::CallbackInfo &info);
+  ~SerialBridge();
+  void closeHandle() override;
+
+ private:
+  struct Client {
+    // first so the handle's address is the client's
+    uv_tcp_t handle;
+    SerialBridge* bridge = nullptr;
+    uint32_t id = 0;
+    std::string address;
+    std::vector<char> readBuffer;
+    // the start of a frame whose delimiter hasn't arrived
+    std::vector<char> partial;
+    bool reading = false;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t framesIn = 0;
+    uint64_t framesOut = 0;
+  };
+  struct WriteRequest {
+    uv_write_t req;
+    Client* client;
+    // shared by every connection the data was sent to
+    std::shared_ptr<std::vector<char>> data;
+  };
+
+  int ttyFd = -1;
+  uv_poll_t* tty_handle = nullptr;
+  uv_tcp_t* server_handle = nullptr;
+  bool handles_open = false;
+  int ttyEvents = 0;
+  bool ttyPaused = false;
+  bool clientsPaused = false;
+  bool failed = false;
+
+  std::string delimiter;
+  size_t maxFrame = 65536;
+  size_t highWaterMark = 65536;
+  unsigned maxClients = 8;
+
+  std::map<uint32_t, Client*> clients;
+  uint32_t nextId = 1;
+  std::vector<char> readBuffer;
+  // bytes read from the port after the last complete frame
+  std::vector<char> ttyPartial;
+  // waiting to be written to the port
+  std::vector<char> ttyOut;
+  size_t ttyOutOffset = 0;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t bytesFromPort = 0;
+  uint64_t bytesToPort = 0;
+  uint64_t framesFromPort = 0;
+  uint64_t framesToPort = 0;
+  uint64_t dropped = 0;
+  uint64_t stalls = 0;
+  uint64_t rejected = 0;
+  uint64_t connections = 0;
+
+  static void onTty(uv_poll_t* handle, int status, int events);
+  static void onConnection(uv_stream_t* server, int status);
+  static void onAlloc(uv_handle_t* handle, size_t suggested, uv_buf_t* buf);
+  static void onClientRead(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+  static void onWrite(uv_write_t* req, int status);
+  static void onClose(uv_handle_t* handle);
+  static void onClientClose(uv_handle_t* handle);
+
+  void updateTtyPoll();
+  void resumeTty();
+  void readTty(Napi::Env env);
+  void broadcast(const char* data, size_t length, uint64_t frames);
+  void writeTty(Napi::Env env);
+  void receive(Client* client, const char* data, size_t length);
+  void pauseClients(bool pause);
+  size_t maxQueued() const;
+  void disconnect(Napi::Env env, Client* client, int status);
+  void fail(Napi::Env env, int code);
+  void call(Napi::Env env, const char* event, uint32_t id, napi_value detail);
+
+  Napi::Value getAddress(const Napi::CallbackInfo& info);
+  Napi::Value drop(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_BRIDGE_H_
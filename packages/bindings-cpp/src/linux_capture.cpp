@@ -0,0 +1,480 @@
+#include "./linux_capture.h"
+
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+static const size_t kChunkSize = 65536;
+static const int kPipeSize = 1024 * 1024;
+static const size_t kIndexFlushRecords = 256;
+static const uint64_t kIndexFlushNanos = 1000000000ULL;
+
+static uint64_t realtimeNanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+static void closeFd(int* fd) {
+  if (-1 != *fd) {
+    ::close(*fd);
+    *fd = -1;
+  }
+}
+
+PortCapture::PortCapture(const Napi::CallbackInfo &info) : Napi::ObjectWrap<PortCapture>(info),
+  context(info.Env(), "node-serialport:PortCapture") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int portFd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[2].As<Napi::Function>());
+
+  Napi::Value value = options.Get("path");
+  if (!value.IsString() || value.As<Napi::String>().Utf8Value().empty()) {
+    Napi::TypeError::New(env, "\"path\" must be a string").ThrowAsJavaScriptException();
+    return;
+  }
+  this->path = value.As<Napi::String>().Utf8Value();
+  value = options.Get("maxBytes");
+  if (value.IsNumber()) {
+    int64_t size = value.As<Napi::Number>().Int64Value();
+    if (size < 1) {
+      Napi::RangeError::New(env, "maxBytes must be at least 1").ThrowAsJavaScriptException();
+      return;
+    }
+    this->maxBytes = size;
+  }
+  value = options.Get("maxFiles");
+  if (value.IsNumber()) {
+    int64_t files = value.As<Napi::Number>().Int64Value();
+    if (files < 1 || files > 1000) {
+      Napi::RangeError::New(env, "maxFiles must be between 1 and 1000").ThrowAsJavaScriptException();
+      return;
+    }
+    this->maxFiles = files;
+  }
+  this->scratch.resize(kChunkSize);
+
+  this->ttyFd = fcntl(portFd, F_DUPFD_CLOEXEC, 0);
+  if (-1 == this->ttyFd) {
+    SerialError(errno, "Error: %s, cannot duplicate fd %d", portFd).ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  if (-1 == pipe2(capturePipe, O_NONBLOCK | O_CLOEXEC) || -1 == pipe2(appPipe, O_NONBLOCK | O_CLOEXEC)) {
+    SerialError(errno, "Error: %s, cannot create capture pipes").ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  // bigger pipes hold more small chunks, unprivileged processes may be limited to the default
+  fcntl(capturePipe[1], F_SETPIPE_SZ, kPipeSize);
+  fcntl(appPipe[1], F_SETPIPE_SZ, kPipeSize);
+
+  // a restart keeps the previous capture as path.1 rather than truncating it
+  struct stat existing;
+  int code = (0 == stat(path.c_str(), &existing) && existing.st_size > 0) ? rotate() : openFiles();
+  if (0 != code) {
+    SerialError(code, "Error: %s, cannot open capture file %s", path.c_str()).ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  this->tty_handle = new uv_poll_t();
+  this->room_handle = new uv_poll_t();
+  tty_handle->data = this;
+  room_handle->data = this;
+  int status = uv_poll_init(data->loop, tty_handle, ttyFd);
+  if (0 == status) {
+    status = uv_poll_init(data->loop, room_handle, appPipe[1]);
+    if (0 != status) {
+      uv_close(reinterpret_cast<uv_handle_t*>(tty_handle), PortCapture::onClose);
+      tty_handle = nullptr;
+    }
+  }
+  if (0 != status) {
+    delete tty_handle;
+    delete room_handle;
+    tty_handle = room_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  handles_open = true;
+  data->addHandleOwner(this);
+  uv_poll_start(tty_handle, UV_READABLE, PortCapture::onReadable);
+}
+
+PortCapture::~PortCapture() {
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  flushIndex();
+  closeFd(&ttyFd);
+  closeFd(&capturePipe[0]);
+  closeFd(&capturePipe[1]);
+  closeFd(&appPipe[0]);
+  closeFd(&appPipe[1]);
+  closeFd(&fileFd);
+  closeFd(&indexFd);
+}
+
+void PortCapture::closeHandle() {
+  uv_poll_stop(tty_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(tty_handle), PortCapture::onClose);
+  if (room_handle) {
+    uv_poll_stop(room_handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(room_handle), PortCapture::onClose);
+  }
+  // the handles are freed by onClose
+  tty_handle = room_handle = nullptr;
+  handles_open = false;
+  // the dup keeps the tty (and its lock) open, release it with the port rather than when collected
+  closeFd(&ttyFd);
+  flushIndex();
+  closeFd(&fileFd);
+  closeFd(&indexFd);
+}
+
+void PortCapture::onClose(uv_handle_t* poll_handle) {
+  delete reinterpret_cast<uv_poll_t*>(poll_handle);
+}
+
+std::string PortCapture::fileName(unsigned generation, const char* suffix) const {
+  if (0 == generation) {
+    return path + suffix;
+  }
+  return path + "." + std::to_string(generation) + suffix;
+}
+
+int PortCapture::openFiles() {
+  fileFd = open(fileName(0, "").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (-1 == fileFd) {
+    return errno;
+  }
+  indexFd = open(fileName(0, ".idx").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  if (-1 == indexFd) {
+    int code = errno;
+    closeFd(&fileFd);
+    return code;
+  }
+  fileOffset = 0;
+  return 0;
+}
+
+int PortCapture::rotate() {
+  flushIndex();
+  closeFd(&fileFd);
+  closeFd(&indexFd);
+  for (unsigned generation = maxFiles - 1; generation > 0; generation--) {
+    for (const char* suffix : {"", ".idx"}) {
+      if (0 != rename(fileName(generation - 1, suffix).c_str(), fileName(generation, suffix).c_str()) &&
+          ENOENT != errno) {
+        return errno;
+      }
+    }
+  }
+  return openFiles();
+}
+
+int PortCapture::flushIndex() {
+  indexFlushedAt = realtimeNanos();
+  if (index.empty() || -1 == indexFd) {
+    index.clear();
+    return 0;
+  }
+  const char* data = reinterpret_cast<const char*>(index.data());
+  size_t left = index.size() * sizeof(CaptureIndexRecord);
+  while (left > 0) {
+    ssize_t written = write(indexFd, data, left);
+    if (-1 == written) {
+      if (EINTR == errno) {
+        continue;
+      }
+      index.clear();
+      return errno;
+    }
+    data += written;
+    left -= written;
+  }
+  index.clear();
+  return 0;
+}
+
+void PortCapture::call(Napi::Env env, napi_value error, bool fatal) {
+  try {
+    callback.MakeCallback(Value(), {error, Napi::Boolean::New(env, fatal)}, context);
+  } catch (const Napi::Error& e) {
+    // same as an exception thrown from any other callback
+    napi_fatal_exception(env, e.Value());
+  }
+}
+
+// The capture file failed, the application keeps getting the port's data
+void PortCapture::stopRecording(Napi::Env env, int code, const char* message) {
+  recording = false;
+  index.clear();
+  closeFd(&fileFd);
+  closeFd(&indexFd);
+  call(env, SerialError(code, message).ToError(env).Value(), false);
+}
+
+// The port failed. The application reads what is left in its pipe then end of file.
+void PortCapture::fail(Napi::Env env, int code) {
+  uv_poll_stop(tty_handle);
+  if (room_handle) {
+    uv_poll_stop(room_handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(room_handle), PortCapture::onClose);
+    room_handle = nullptr;
+  }
+  closeFd(&appPipe[1]);
+  flushIndex();
+  if (0 == code) {
+    // a tty only reads 0 bytes once it is hung up
+    Napi::Error error = Napi::Error::New(env, "Error: Port hung up, cannot read");
+    error.Set("code", "EOF");
+    call(env, error.Value(), true);
+  } else {
+    call(env, SerialError(code, "Error: %s, cannot read").ToError(env).Value(), true);
+  }
+}
+
+// Reads the next chunk from the tty into the empty capture pipe. False when there is nothing to read.
+bool PortCapture::fillCapturePipe(Napi::Env env) {
+  ssize_t count = -1;
+  if (spliceTty) {
+    count = splice(ttyFd, NULL, capturePipe[1], NULL, kChunkSize, SPLICE_F_NONBLOCK);
+    if (-1 == count && EINVAL == errno) {
+      // no splice_read for this tty (or it hung up, which read() reports properly)
+      spliceTty = false;
+    }
+  }
+  if (!spliceTty) {
+    count = read(ttyFd, scratch.data(), scratch.size());
+    if (count > 0) {
+      // the capture pipe is empty and holds at least a chunk
+      if (count != write(capturePipe[1], scratch.data(), count)) {
+        fail(env, EIO);
+        return false;
+      }
+      copied += count;
+    }
+  }
+  if (-1 == count) {
+    if (EAGAIN == errno || EWOULDBLOCK == errno) {
+      return false;
+    }
+    if (EINTR == errno) {
+      return true;
+    }
+    fail(env, errno);
+    return false;
+  }
+  if (0 == count) {
+    fail(env, 0);
+    return false;
+  }
+
+  uint64_t now = realtimeNanos();
+  if (recording) {
+    CaptureIndexRecord record;
+    record.offset = htole64(fileOffset);
+    record.timestamp = htole64(now);
+    index.push_back(record);
+    if (index.size() >= kIndexFlushRecords || now - indexFlushedAt >= kIndexFlushNanos) {
+      int code = flushIndex();
+      if (0 != code) {
+        stopRecording(env, code, "Error: %s, cannot write capture index");
+      }
+    }
+  }
+  bytes += count;
+  chunks++;
+  pending = count;
+  return true;
+}
+
+// Moves `count` bytes the application already has from the capture pipe to the file
+bool PortCapture::consume(Napi::Env env, size_t count) {
+  while (count > 0) {
+    ssize_t moved;
+    if (recording && spliceFile) {
+      loff_t offset = fileOffset;
+      moved = splice(capturePipe[0], NULL, fileFd, &offset, count, 0);
+      if (-1 == moved && EINVAL == errno) {
+        // file systems without splice_write
+        spliceFile = false;
+        continue;
+      }
+      if (-1 == moved && EINTR != errno) {
+        stopRecording(env, errno, "Error: %s, cannot write capture file");
+        continue;
+      }
+    } else {
+      moved = read(capturePipe[0], scratch.data(), std::min(count, scratch.size()));
+      if (moved > 0 && recording) {
+        ssize_t written = 0;
+        while (written < moved) {
+          ssize_t result = pwrite(fileFd, scratch.data() + written, moved - written, fileOffset + written);
+          if (-1 == result && EINTR == errno) {
+            continue;
+          }
+          if (-1 == result) {
+            stopRecording(env, errno, "Error: %s, cannot write capture file");
+            break;
+          }
+          written += result;
+        }
+      }
+      if (-1 == moved && EINTR != errno) {
+        fail(env, errno);
+        return false;
+      }
+    }
+    if (moved > 0) {
+      if (recording) {
+        fileOffset += moved;
+      }
+      count -= moved;
+    }
+  }
+  return true;
+}
+
+void PortCapture::pump(Napi::Env env) {
+  unsigned chunksRead = 0;
+  while (handles_open && -1 != appPipe[1]) {
+    if (pending > 0) {
+      ssize_t teed = tee(capturePipe[0], appPipe[1], pending, SPLICE_F_NONBLOCK);
+      if (-1 == teed) {
+        if (EAGAIN == errno) {
+          // wait for the application to read, the tty data waits in the kernel meanwhile
+          uv_poll_stop(tty_handle);
+          uv_poll_start(room_handle, UV_WRITABLE, PortCapture::onRoom);
+          return;
+        }
+        if (EINTR == errno) {
+          continue;
+        }
+        fail(env, errno);
+        return;
+      }
+      if (!consume(env, teed)) {
+        return;
+      }
+      pending -= teed;
+      continue;
+    }
+    // keep one busy port from starving the loop, the poll fires again if there is more
+    if (chunksRead++ == 16) {
+      return;
+    }
+    if (recording && static_cast<uint64_t>(fileOffset) >= maxBytes) {
+      rotations++;
+      int code = rotate();
+      if (0 != code) {
+        stopRecording(env, code, "Error: %s, cannot rotate capture file");
+      }
+    }
+    if (!fillCapturePipe(env)) {
+      return;
+    }
+  }
+}
+
+void PortCapture::onReadable(uv_poll_t* handle, int status, int events) {
+  PortCapture* obj = static_cast<PortCapture*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  if (0 != status) {
+    // libuv reports POLLERR as EBADF, reading tells what happened to the port
+    obj->pump(env);
+    if (-1 != obj->appPipe[1]) {
+      obj->fail(env, -status);
+    }
+    return;
+  }
+  obj->pump(env);
+}
+
+void PortCapture::onRoom(uv_poll_t* handle, int status, int events) {
+  PortCapture* obj = static_cast<PortCapture*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  uv_poll_stop(handle);
+  uv_poll_start(obj->tty_handle, UV_READABLE, PortCapture::onReadable);
+  obj->pump(env);
+}
+
+Napi::Value PortCapture::getReadFd(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), appPipe[0]);
+}
+
+// Drops what the application hasn't read yet, used by flush(). It stays in the capture.
+Napi::Value PortCapture::discard(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  while (-1 != appPipe[0] && read(appPipe[0], scratch.data(), scratch.size()) > 0) {}
+  if (handles_open && pending > 0 && consume(env, pending)) {
+    pending = 0;
+  }
+  return env.Undefined();
+}
+
+Napi::Value PortCapture::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  closeFd(&capturePipe[0]);
+  closeFd(&capturePipe[1]);
+  closeFd(&appPipe[0]);
+  closeFd(&appPipe[1]);
+  return env.Undefined();
+}
+
+Napi::Value PortCapture::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("bytes", static_cast<double>(bytes));
+  stats.Set("chunks", static_cast<double>(chunks));
+  stats.Set("copied", static_cast<double>(copied));
+  stats.Set("rotations", static_cast<double>(rotations));
+  stats.Set("fileBytes", static_cast<double>(fileOffset));
+  stats.Set("pending", static_cast<double>(pending));
+  stats.Set("recording", recording);
+  return stats;
+}
+
+Napi::Object PortCapture::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "PortCapture", {
+    InstanceAccessor<&PortCapture::getReadFd>("readFd"),
+    InstanceMethod<&PortCapture::discard>("discard"),
+    InstanceMethod<&PortCapture::close>("close"),
+    InstanceAccessor<&PortCapture::getStats>("stats"),
+  });
+  exports.Set("PortCapture", func);
+  return exports;
+}
@@ -0,0 +1,84 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_CAPTURE_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_CAPTURE_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "./addon_data.h"
+
+// One record of a capture's `.idx` sidecar, little endian: `offset` in the capture file where a chunk
+// read from the port starts and when it was read, in nanoseconds since the epoch
+struct CaptureIndexRecord {
+  uint64_t offset;
+  uint64_t timestamp;
+};
+
+// Records everything read from a port to a file while the application keeps reading it from a pipe.
+//
+// Data is spliced from the tty into a capture pipe, tee()d into the pipe the application reads from
+// and spliced from the capture pipe into the file, so it isn't copied through user space. Kernels
+// whose ttys can't splice fall back to read() and write() into the capture pipe. Bytes the
+// application pipe has no room for stay in the capture pipe and the tty isn't read until it has.
+//
+// The file rotates to `path.1`, `path.2`... once it reaches `maxBytes`, keeping `maxFiles` files.
+class PortCapture : public Napi::ObjectWrap<PortCapture>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit PortCapture(const Napi::CallbackInfo &info);
+  static void onReadable(uv_poll_t* handle, int status, int events);
+  static void onRoom(uv_poll_t* handle, int status, int events);
+  static void onClose(uv_handle_t* poll_handle);
+  ~PortCapture();
+  void closeHandle() override;
+
+ private:
+  int ttyFd = -1;
+  int capturePipe[2] = {-1, -1};
+  int appPipe[2] = {-1, -1};
+  int fileFd = -1;
+  int indexFd = -1;
+  uv_poll_t* tty_handle = nullptr;
+  uv_poll_t* room_handle = nullptr;
+  bool handles_open = false;
+
+  std::string path;
+  uint64_t maxBytes = 64 * 1024 * 1024;
+  unsigned maxFiles = 2;
+  int64_t fileOffset = 0;
+  // bytes in the capture pipe not yet tee()d to the application
+  size_t pending = 0;
+  bool recording = true;
+  bool spliceTty = true;
+  bool spliceFile = true;
+  std::vector<char> scratch;
+  std::vector<CaptureIndexRecord> index;
+  uint64_t indexFlushedAt = 0;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t bytes = 0;
+  uint64_t chunks = 0;
+  uint64_t copied = 0;
+  uint64_t rotations = 0;
+
+  std::string fileName(unsigned generation, const char* suffix) const;
+  int openFiles();
+  int rotate();
+  int flushIndex();
+  void pump(Napi::Env env);
+  bool fillCapturePipe(Napi::Env env);
+  bool consume(Napi::Env env, size_t count);
+  void stopRecording(Napi::Env env, int code, const char* message);
+  void fail(Napi::Env env, int code);
+  void call(Napi::Env env, napi_value error, bool fatal);
+
+  Napi::Value getReadFd(const Napi::CallbackInfo& info);
+  Napi::Value discard(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_CAPTURE_H_
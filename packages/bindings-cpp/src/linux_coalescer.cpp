@@ -0,0 +1,366 @@
+#include "./linux_coalescer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+
+static uint64_t monotonicNow() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+// A tty read returns 0 once it hung up, but also with VMIN 0 when there is nothing left to read
+static bool hungUp(int fd) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  return 1 == poll(&pfd, 1, 0) && 0 != (pfd.revents & (POLLHUP | POLLERR));
+}
+
+ReadCoalescer::ReadCoalescer(const Napi::CallbackInfo &info) : Napi::ObjectWrap<ReadCoalescer>(info),
+  context(info.Env(), "node-serialport:ReadCoalescer") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int portFd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[2].As<Napi::Function>());
+
+  Napi::Value value = options.Get("maxBytes");
+  if (value.IsNumber()) {
+    int64_t size = value.As<Napi::Number>().Int64Value();
+    if (size < 1) {
+      Napi::RangeError::New(env, "maxBytes must be at least 1").ThrowAsJavaScriptException();
+      return;
+    }
+    this->maxBytes = size;
+  }
+  value = options.Get("maxDelayMicros");
+  if (value.IsNumber()) {
+    int64_t delay = value.As<Napi::Number>().Int64Value();
+    this->maxDelayMicros = delay > 0 ? delay : 0;
+  }
+  value = options.Get("delimiter");
+  if (value.IsBuffer()) {
+    Napi::Buffer<char> delimiterBuffer = value.As<Napi::Buffer<char>>();
+    this->delimiter.assign(delimiterBuffer.Data(), delimiterBuffer.Length());
+  }
+  this->buffer.resize(this->maxBytes);
+
+  this->fd = fcntl(portFd, F_DUPFD_CLOEXEC, 0);
+  if (-1 == this->fd) {
+    SerialError(errno, "Error: %s, cannot duplicate fd %d", portFd).ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  this->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (-1 == this->timerFd) {
+    SerialError(errno, "Error: %s, cannot create timer").ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  this->read_handle = new uv_poll_t();
+  this->timer_handle = new uv_poll_t();
+  read_handle->data = this;
+  timer_handle->data = this;
+  int status = uv_poll_init(data->loop, read_handle, this->fd);
+  if (0 != status) {
+    delete read_handle;
+    delete timer_handle;
+    read_handle = timer_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  status = uv_poll_init(data->loop, timer_handle, this->timerFd);
+  if (0 != status) {
+    uv_close(reinterpret_cast<uv_handle_t*>(read_handle), ReadCoalescer::onClose);
+    delete timer_handle;
+    read_handle = timer_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  handles_open = true;
+  data->addHandleOwner(this);
+}
+
+ReadCoalescer::~ReadCoalescer() {
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  if (-1 != fd) {
+    ::close(fd);
+  }
+  if (-1 != timerFd) {
+    ::close(timerFd);
+  }
+}
+
+void ReadCoalescer::closeHandle() {
+  uv_poll_stop(read_handle);
+  uv_poll_stop(timer_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(read_handle), ReadCoalescer::onClose);
+  uv_close(reinterpret_cast<uv_handle_t*>(timer_handle), ReadCoalescer::onClose);
+  // the handles are freed by onClose
+  read_handle = timer_handle = nullptr;
+  handles_open = false;
+  reading = false;
+  timerArmed = false;
+  // the dup keeps the tty (and its lock) open, release it with the port rather than when collected
+  ::close(fd);
+  ::close(timerFd);
+  fd = timerFd = -1;
+}
+
+void ReadCoalescer::onClose(uv_handle_t* poll_handle) {
+  delete reinterpret_cast<uv_poll_t*>(poll_handle);
+}
+
+// Fires maxDelayMicros after `since`, the monotonic time the oldest buffered byte was read. Already
+// late fires at once.
+void ReadCoalescer::armTimer(uint64_t since) {
+  uint64_t deadline = since + static_cast<uint64_t>(maxDelayMicros) * 1000;
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  spec.it_value.tv_sec = deadline / 1000000000ULL;
+  spec.it_value.tv_nsec = deadline % 1000000000ULL;
+  timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+  uv_poll_start(timer_handle, UV_READABLE, ReadCoalescer::onTimer);
+  timerArmed = true;
+}
+
+void ReadCoalescer::disarmTimer() {
+  if (!timerArmed) {
+    return;
+  }
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  timerfd_settime(timerFd, 0, &spec, NULL);
+  uv_poll_stop(timer_handle);
+  timerArmed = false;
+}
+
+// End of the last complete delimiter in the buffer, or 0. `from` is where new data starts.
+size_t ReadCoalescer::lastDelimiterEnd(size_t from) const {
+  if (delimiter.empty() || length < delimiter.size()) {
+    return 0;
+  }
+  // a delimiter may straddle the old and the new data
+  size_t start = from >= delimiter.size() - 1 ? from - (delimiter.size() - 1) : 0;
+  size_t end = 0;
+  const char *data = buffer.data();
+  const void *found;
+  while (start + delimiter.size() <= length &&
+         (found = memmem(data + start, length - start, delimiter.data(), delimiter.size())) != NULL) {
+    end = static_cast<const char*>(found) - data + delimiter.size();
+    start = end;
+  }
+  return end;
+}
+
+void ReadCoalescer::call(Napi::Env env, std::initializer_list<napi_value> args) {
+  try {
+    callback.MakeCallback(Value(), args, context);
+  } catch (const Napi::Error& e) {
+    // same as an exception thrown from any other callback
+    napi_fatal_exception(env, e.Value());
+  }
+}
+
+void ReadCoalescer::deliver(Napi::Env env, size_t count) {
+  Napi::Buffer<char> data = Napi::Buffer<char>::Copy(env, buffer.data(), count);
+  Napi::Number readAt = Napi::Number::New(env, static_cast<double>(firstReadAt));
+  Napi::Number readWakeAt = Napi::Number::New(env, static_cast<double>(firstWakeAt));
+  length -= count;
+  if (length > 0) {
+    memmove(buffer.data(), buffer.data() + count, length);
+    // the rest ends at a delimiter found in the last read, so that is where it came from
+    firstReadAt = lastReadAt;
+    firstWakeAt = lastWakeAt;
+    // the deadline now applies to the first of the remaining bytes, counted from when they were read
+    armTimer(firstReadAt);
+  } else {
+    disarmTimer();
+  }
+  deliveries++;
+  call(env, {env.Null(), data, readAt, readWakeAt});
+}
+
+void ReadCoalescer::fail(Napi::Env env, int code) {
+  uv_poll_stop(read_handle);
+  reading = false;
+  if (length > 0) {
+    deliver(env, length);
+  }
+  if (handles_open) {
+    call(env, {SerialError(code, "Error: %s, cannot read").ToError(env).Value(), env.Undefined()});
+  }
+}
+
+void ReadCoalescer::fill(Napi::Env env) {
+  while (handles_open && reading) {
+    ssize_t count = read(fd, buffer.data() + length, buffer.size() - length);
+    reads++;
+    if (count > 0) {
+      lastReadAt = monotonicNow();
+      lastWakeAt = wakeAt;
+      if (0 == length) {
+        firstReadAt = lastReadAt;
+        firstWakeAt = lastWakeAt;
+      }
+      size_t from = length;
+      length += count;
+      bytes += count;
+      if (!timerArmed && maxDelayMicros > 0) {
+        armTimer(firstReadAt);
+      }
+      if (length >= maxBytes || maxDelayMicros == 0) {
+        deliver(env, length);
+      } else {
+        size_t end = lastDelimiterEnd(from);
+        if (end > 0) {
+          deliver(env, end);
+        }
+      }
+      continue;
+    }
+    if (count == 0) {
+      // POLLHUP stays set after a hang up, polling on would wake every loop iteration
+      if (hungUp(fd)) {
+        fail(env, EIO);
+      }
+      return;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    fail(env, errno);
+    return;
+  }
+}
+
+void ReadCoalescer::onReadable(uv_poll_t* handle, int status, int events) {
+  ReadCoalescer* obj = static_cast<ReadCoalescer*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+
+  if (0 != status) {
+    uv_poll_stop(handle);
+    obj->reading = false;
+    obj->call(env, {Napi::Error::New(env, uv_strerror(status)).Value(), env.Undefined()});
+    return;
+  }
+  obj->wakeAt = monotonicNow();
+  obj->fill(env);
+}
+
+void ReadCoalescer::onTimer(uv_poll_t* handle, int status, int events) {
+  ReadCoalescer* obj = static_cast<ReadCoalescer*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+
+  uint64_t expirations;
+  if (-1 == read(obj->timerFd, &expirations, sizeof(expirations))) {
+    return;
+  }
+  obj->timerArmed = false;
+  uv_poll_stop(handle);
+  if (obj->length > 0) {
+    obj->timeouts++;
+    obj->deliver(env, obj->length);
+  }
+}
+
+Napi::Value ReadCoalescer::start(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handles_open) {
+    Napi::Error::New(env, "Read coalescer is closed").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  int status = uv_poll_start(read_handle, UV_READABLE, ReadCoalescer::onReadable);
+  if (0 != status) {
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  reading = true;
+  return env.Undefined();
+}
+
+// Stops reading, data stays in the kernel until start() is called again. A partial batch is still
+// delivered when its deadline passes.
+Napi::Value ReadCoalescer::stop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    uv_poll_stop(read_handle);
+    reading = false;
+  }
+  return env.Undefined();
+}
+
+Napi::Value ReadCoalescer::discard(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    disarmTimer();
+  }
+  length = 0;
+  return env.Undefined();
+}
+
+Napi::Value ReadCoalescer::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  length = 0;
+  return env.Undefined();
+}
+
+Napi::Value ReadCoalescer::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("reads", static_cast<double>(reads));
+  stats.Set("deliveries", static_cast<double>(deliveries));
+  stats.Set("bytes", static_cast<double>(bytes));
+  stats.Set("timeouts", static_cast<double>(timeouts));
+  stats.Set("buffered", static_cast<double>(length));
+  return stats;
+}
+
+Napi::Object ReadCoalescer::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "ReadCoalescer", {
+    InstanceMethod<&ReadCoalescer::start>("start"),
+    InstanceMethod<&ReadCoalescer::stop>("stop"),
+    InstanceMethod<&ReadCoalescer::discard>("discard"),
+    InstanceMethod<&ReadCoalescer::close>("close"),
+    InstanceAccessor<&ReadCoalescer::getStats>("stats"),
+  });
+  exports.Set("ReadCoalescer", func);
+  return exports;
+}
@@ -0,0 +1,75 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_COALESCER_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_COALESCER_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "./addon_data.h"
+
+// Reads a port natively and hands the data to JS in batches: once `maxBytes` have accumulated, a
+// delimiter has been seen, or `maxDelayMicros` have passed since the first buffered byte, whichever
+// comes first. The deadline is a timerfd so it isn't rounded to the loop's millisecond timers.
+// Each batch carries the CLOCK_MONOTONIC time of the read() of its first byte and of the poll wake
+// up before it, so JS can tell the time spent in the tty from the time spent waiting for the loop.
+//
+// It polls its own dup() of the port's fd, libuv doesn't allow two poll handles on one fd and the
+// port's Poller is still used for writes.
+class ReadCoalescer : public Napi::ObjectWrap<ReadCoalescer>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit ReadCoalescer(const Napi::CallbackInfo &info);
+  static void onReadable(uv_poll_t* handle, int status, int events);
+  static void onTimer(uv_poll_t* handle, int status, int events);
+  static void onClose(uv_handle_t* poll_handle);
+  ~ReadCoalescer();
+  void closeHandle() override;
+
+ private:
+  int fd = -1;
+  int timerFd = -1;
+  uv_poll_t* read_handle = nullptr;
+  uv_poll_t* timer_handle = nullptr;
+  bool handles_open = false;
+  bool reading = false;
+  bool timerArmed = false;
+
+  size_t maxBytes = 4096;
+  uint64_t maxDelayMicros = 1000;
+  std::string delimiter;
+  std::vector<char> buffer;
+  size_t length = 0;
+
+  // CLOCK_MONOTONIC nanoseconds of the current poll wake up, and of the read() of the first buffered
+  // byte and the wake up that led to it
+  uint64_t wakeAt = 0;
+  uint64_t firstReadAt = 0;
+  uint64_t firstWakeAt = 0;
+  uint64_t lastReadAt = 0;
+  uint64_t lastWakeAt = 0;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t reads = 0;
+  uint64_t deliveries = 0;
+  uint64_t bytes = 0;
+  uint64_t timeouts = 0;
+
+  void fill(Napi::Env env);
+  void deliver(Napi::Env env, size_t count);
+  void fail(Napi::Env env, int code);
+  void call(Napi::Env env, std::initializer_list<napi_value> args);
+  void armTimer(uint64_t since);
+  void disarmTimer();
+  size_t lastDelimiterEnd(size_t from) const;
+
+  Napi::Value start(const Napi::CallbackInfo& info);
+  Napi::Value stop(const Napi::CallbackInfo& info);
+  Napi::Value discard(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_COALESCER_H_
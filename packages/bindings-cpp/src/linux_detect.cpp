@@ -0,0 +1,236 @@
+#include "./linux_detect.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include "./serialport_linux.h"
+
+static int64_t monotonicMillis() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+// Reads what arrives within `millis`, up to `maxBytes`
+static int readSample(const int fd, const int millis, const size_t maxBytes, std::string* raw) {
+  char buffer[1024];
+  int64_t deadline = monotonicMillis() + millis;
+  while (raw->size() < maxBytes) {
+    int64_t remaining = deadline - monotonicMillis();
+    if (remaining <= 0) {
+      return 0;
+    }
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int ready = poll(&pfd, 1, static_cast<int>(remaining));
+    if (-1 == ready) {
+      if (EINTR == errno) {
+        continue;
+      }
+      return -1;
+    }
+    if (0 == ready) {
+      return 0;
+    }
+    if (!(pfd.revents & POLLIN)) {
+      errno = EIO;
+      return -1;
+    }
+    ssize_t count = read(fd, buffer, std::min(sizeof(buffer), maxBytes - raw->size()));
+    if (-1 == count) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno) {
+        continue;
+      }
+      return -1;
+    }
+    if (0 == count) {
+      // hung up
+      errno = EIO;
+      return -1;
+    }
+    raw->append(buffer, count);
+  }
+  return 0;
+}
+
+// Decodes the PARMRK marking set up by linuxMarkInputErrors() and scores the sample
+static void scoreSample(const std::string& raw, const bool text, BaudSample* sample) {
+  const unsigned char* data = reinterpret_cast<const unsigned char*>(raw.data());
+  size_t size = raw.size();
+  for (size_t i = 0; i < size; i++) {
+    unsigned char c = data[i];
+    if (0377 == c && i + 1 < size) {
+      if (0 == data[i + 1]) {
+        // 0377 0 <byte>, a framing or parity error or (with a 0 byte) a break
+        sample->errors++;
+        i += 2;
+        continue;
+      }
+      if (0377 == data[i + 1]) {
+        i++;
+      }
+    }
+    sample->bytes++;
+    sample->data.push_back(c);
+    if ((c >= 0x20 && c < 0x7f) || '\t' == c || '\r' == c || '\n' == c) {
+      sample->printable++;
+    }
+    if ('\n' == c) {
+      sample->lines++;
+    }
+  }
+  unsigned int total = sample->bytes + sample->errors;
+  if (0 == total) {
+    sample->score = 0;
+    return;
+  }
+  if (!text) {
+    sample->score = static_cast<double>(sample->bytes) / total;
+    return;
+  }
+  sample->score = static_cast<double>(sample->printable) / total;
+  if (0 == sample->lines) {
+    // text nodes send lines, a window without one is less convincing
+    sample->score *= 0.9;
+  }
+}
+
+void DetectBaudBaton::Execute() {
+  LinuxSavedTermios saved;
+  if (-1 == linuxSaveTermios(fd, &saved)) {
+    error = SerialError(errno, "Error: %s, cannot get port settings");
+    this->SetError(error);
+    return;
+  }
+  if (linuxMarkInputErrors(fd) < 0) {
+    error = SerialError(errno, "Error: %s, cannot mark input errors");
+    this->SetError(error);
+    return;
+  }
+  for (unsigned int baudRate : candidates) {
+    samples.emplace_back();
+    BaudSample& sample = samples.back();
+    sample.baudRate = baudRate;
+    if (linuxSetCustomBaudRate(fd, baudRate) < 0) {
+      // the driver doesn't do this rate
+      sample.supported = false;
+      continue;
+    }
+    // what arrived at the previous rate
+    tcflush(fd, TCIFLUSH);
+    std::string raw;
+    if (-1 == readSample(fd, sampleMillis, maxBytes, &raw)) {
+      error = SerialError(errno, "Error: %s, cannot read sample at %d baud", static_cast<int>(baudRate));
+      break;
+    }
+    scoreSample(raw, text, &sample);
+    if (-1 == best || sample.score > samples[best].score) {
+      best = samples.size() - 1;
+    }
+    if (sample.score >= accept && sample.bytes >= minBytes) {
+      break;
+    }
+  }
+  linuxRestoreTermios(fd, &saved);
+  tcflush(fd, TCIFLUSH);
+  if (error.failed()) {
+    this->SetError(error);
+  }
+}
+
+void DetectBaudBaton::OnOK() {
+  Napi::Env env = Env();
+  Napi::HandleScope scope(env);
+  Napi::Array list = Napi::Array::New(env, samples.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    const BaudSample& sample = samples[i];
+    Napi::Object item = Napi::Object::New(env);
+    item.Set("baudRate", sample.baudRate);
+    item.Set("supported", sample.supported);
+    item.Set("bytes", sample.bytes);
+    item.Set("errors", sample.errors);
+    item.Set("printable", sample.printable);
+    item.Set("lines", sample.lines);
+    item.Set("score", sample.score);
+    item.Set("data", Napi::Buffer<char>::Copy(env, sample.data.data(), sample.data.size()));
+    list.Set(i, item);
+  }
+  Napi::Object result = Napi::Object::New(env);
+  bool found = -1 != best && samples[best].score >= minScore;
+  result.Set("baudRate", found ? Napi::Number::New(env, samples[best].baudRate) : env.Null());
+  result.Set("samples", list);
+  Callback().Call({env.Null(), result});
+}
+
+Napi::Value DetectBaud(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int fd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Function callback = info[2].As<Napi::Function>();
+
+  Napi::Value value = options.Get("candidates");
+  if (!value.IsArray() || 0 == value.As<Napi::Array>().Length()) {
+    Napi::TypeError::New(env, "candidates must be a non empty array").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Array candidates = value.As<Napi::Array>();
+  std::vector<unsigned int> rates;
+  for (uint32_t i = 0; i < candidates.Length(); i++) {
+    Napi::Value rate = candidates.Get(i);
+    if (!rate.IsNumber() || rate.As<Napi::Number>().Int64Value() < 1) {
+      Napi::TypeError::New(env, "candidates must be positive numbers").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    rates.push_back(rate.As<Napi::Number>().Uint32Value());
+  }
+
+  DetectBaudBaton* baton = new DetectBaudBaton(callback);
+  baton->fd = fd;
+  baton->candidates = rates;
+  value = options.Get("sampleMillis");
+  if (value.IsNumber()) {
+    baton->sampleMillis = std::max(1, value.As<Napi::Number>().Int32Value());
+  }
+  value = options.Get("maxBytes");
+  if (value.IsNumber()) {
+    baton->maxBytes = std::max<int64_t>(1, value.As<Napi::Number>().Int64Value());
+  }
+  value = options.Get("minBytes");
+  if (value.IsNumber()) {
+    baton->minBytes = std::max(0, value.As<Napi::Number>().Int32Value());
+  }
+  value = options.Get("accept");
+  if (value.IsNumber()) {
+    baton->accept = value.As<Napi::Number>().DoubleValue();
+  }
+  value = options.Get("minScore");
+  if (value.IsNumber()) {
+    baton->minScore = value.As<Napi::Number>().DoubleValue();
+  }
+  value = options.Get("text");
+  if (value.IsBoolean()) {
+    baton->text = value.As<Napi::Boolean>().Value();
+  }
+
+  baton->Queue();
+  return env.Undefined();
+}
@@ -0,0 +1,47 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_DETECT_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_DETECT_H_
+#include <napi.h>
+#include <string>
+#include <vector>
+#include "./worker_pool.h"
+
+Napi::Value DetectBaud(const Napi::CallbackInfo& info);
+
+struct BaudSample {
+  unsigned int baudRate = 0;
+  bool supported = true;
+  // bytes received without an error
+  unsigned int bytes = 0;
+  // framing and parity errors and breaks
+  unsigned int errors = 0;
+  // printable ASCII, tab, CR and LF
+  unsigned int printable = 0;
+  unsigned int lines = 0;
+  double score = 0;
+  std::string data;
+};
+
+// Tries each candidate rate on an open port: the rate is set, what arrives within `sampleMillis` (or
+// until `maxBytes`) is read and scored, by the share of bytes without framing errors and, for text,
+// the share that is printable. Stops at the first rate scoring `accept` or more with `minBytes`. The
+// port's settings are put back afterwards, the caller applies the rate picked.
+struct DetectBaudBaton : public SerialWorker {
+  DetectBaudBaton(Napi::Function& callback) : SerialWorker(callback, "node-serialport:DetectBaudBaton") {}
+  SerialError error;
+  int fd = 0;
+  std::vector<unsigned int> candidates;
+  int sampleMillis = 500;
+  size_t maxBytes = 256;
+  unsigned int minBytes = 32;
+  double accept = 0.95;
+  // below this no rate is picked
+  double minScore = 0.5;
+  bool text = true;
+  std::vector<BaudSample> samples;
+  int best = -1;
+
+  void Execute() override;
+  void OnOK() override;
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_DETECT_H_
@@ -0,0 +1,299 @@
+#include "./linux_hotplug.h"
+#include "./linux_list.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+#include <map>
+#include <string>
+
+#define UEVENT_BUFFER_SIZE 8192
+#define UDEV_MONITOR_MAGIC 0xfeedcafe
+
+// Header prepended by udevd to the messages it rebroadcasts on the udev group (see libudev-monitor.c)
+struct UdevMonitorNetlinkHeader {
+  char prefix[8];
+  unsigned int magic;
+  unsigned int header_size;
+  unsigned int properties_off;
+  unsigned int properties_len;
+  unsigned int filter_subsystem_hash;
+  unsigned int filter_devtype_hash;
+  unsigned int filter_tag_bloom_hi;
+  unsigned int filter_tag_bloom_lo;
+};
+
+typedef std::map<std::string, std::string> UeventProperties;
+
+static std::string getProperty(const UeventProperties& properties, const char *key) {
+  UeventProperties::const_iterator it = properties.find(key);
+  return it == properties.end() ? std::string() : it->second;
+}
+
+// DEVLINKS is a space separated list of every symlink udev created for the node
+static std::string byIdFromDevlinks(const std::string& devlinks) {
+  static const char byIdPrefix[] = "/dev/serial/by-id/";
+  size_t start = devlinks.find(byIdPrefix);
+  if (start == std::string::npos) {
+    return std::string();
+  }
+  start += sizeof(byIdPrefix) - 1;
+  size_t end = devlinks.find(' ', start);
+  return devlinks.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+HotplugMonitor::HotplugMonitor(const Napi::CallbackInfo &info) : Napi::ObjectWrap<HotplugMonitor>(info) {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // callback
+  if (!info[0].IsFunction()) {
+    Napi::TypeError::New(env, "First argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[0].As<Napi::Function>());
+
+  // Prefer the udev group when udevd is running so listeners see fully set up device nodes
+  this->source = (0 == access("/run/udev/control", F_OK)) ? HOTPLUG_SOURCE_UDEV : HOTPLUG_SOURCE_KERNEL;
+  if (info[1].IsObject()) {
+    Napi::Value source = info[1].ToObject().Get("source");
+    if (source.IsString()) {
+      std::string value = source.ToString().Utf8Value();
+      if (value == "kernel") {
+        this->source = HOTPLUG_SOURCE_KERNEL;
+      } else if (value == "udev") {
+        this->source = HOTPLUG_SOURCE_UDEV;
+      }
+    }
+  }
+
+  this->fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+  if (-1 == this->fd) {
+    Napi::Error::New(env, std::string("Error: ") + strerror(errno) + ", cannot open uevent socket")
+      .ThrowAsJavaScriptException();
+    return;
+  }
+
+  // udevd messages are only trusted when they come from root
+  int on = 1;
+  setsockopt(this->fd, SOL_SOCKET, SO_PASSCRED, &on, sizeof(on));
+
+  struct sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = this->source;
+  if (-1 == bind(this->fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr))) {
+    Napi::Error::New(env, std::string("Error: ") + strerror(errno) + ", cannot bind uevent socket")
+      .ThrowAsJavaScriptException();
+    return;
+  }
+
+  this->poll_handle = new uv_poll_t();
+  memset(this->poll_handle, 0, sizeof(uv_poll_t));
+  poll_handle->data = this;
+  AddonData* data = env.GetInstanceData<AddonData>();
+  int status = uv_poll_init(data->loop, poll_handle, this->fd);
+  if (0 != status) {
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  uv_poll_init_success = true;
+  data->addHandleOwner(this);
+}
+
+HotplugMonitor::~HotplugMonitor() {
+  // if we call uv_poll_stop after uv_poll_init failed we segfault
+  if (uv_poll_init_success) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  } else {
+    delete poll_handle;
+  }
+  if (-1 != fd) {
+    close(fd);
+  }
+}
+
+void HotplugMonitor::closeHandle() {
+  uv_poll_stop(poll_handle);
+  uv_close(reinterpret_cast<uv_handle_t*> (poll_handle), HotplugMonitor::onClose);
+  // the handle is freed by onClose
+  poll_handle = nullptr;
+  uv_poll_init_success = false;
+}
+
+void HotplugMonitor::onClose(uv_handle_t* poll_handle) {
+  // allocated as a uv_poll_t, deleting it through the base type frees the wrong size
+  delete reinterpret_cast<uv_poll_t*>(poll_handle);
+}
+
+void HotplugMonitor::onData(uv_poll_t* handle, int status, int events) {
+  HotplugMonitor* obj = static_cast<HotplugMonitor*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+
+  if (0 != status) {
+    uv_poll_stop(handle);
+    obj->callback.Call({Napi::Error::New(env, uv_strerror(status)).Value(), env.Undefined()});
+    return;
+  }
+  obj->receive(env);
+}
+
+void HotplugMonitor::receive(Napi::Env env) {
+  char buf[UEVENT_BUFFER_SIZE];
+  char control[CMSG_SPACE(sizeof(struct ucred))];
+
+  for (;;) {
+    struct iovec iov = { buf, sizeof(buf) - 1 };
+    struct sockaddr_nl sender;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &sender;
+    msg.msg_namelen = sizeof(sender);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t length = recvmsg(fd, &msg, 0);
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // ENOBUFS means the kernel dropped events, the caller is expected to re-list
+      if (errno == ENOBUFS) {
+        callback.Call({Napi::Error::New(env, "uevent buffer overrun, events were lost").Value(), env.Undefined()});
+        continue;
+      }
+      return;
+    }
+    buf[length] = '\0';
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_type != SCM_CREDENTIALS) {
+      continue;
+    }
+    struct ucred* cred = reinterpret_cast<struct ucred*>(CMSG_DATA(cmsg));
+    if (cred->uid != 0) {
+      continue;
+    }
+
+    if (0 == memcmp(buf, "libudev", 8)) {
+      if (source != HOTPLUG_SOURCE_UDEV || static_cast<size_t>(length) < sizeof(UdevMonitorNetlinkHeader)) {
+        continue;
+      }
+      UdevMonitorNetlinkHeader* header = reinterpret_cast<UdevMonitorNetlinkHeader*>(buf);
+      if (ntohl(header->magic) != UDEV_MONITOR_MAGIC ||
+          header->properties_off + header->properties_len > static_cast<size_t>(length)) {
+        continue;
+      }
+      dispatch(env, buf + header->properties_off, header->properties_len);
+    } else {
+      // kernel messages are "action@devpath\0KEY=VALUE\0..." and may only come from the kernel itself
+      if (source != HOTPLUG_SOURCE_KERNEL || sender.nl_pid != 0) {
+        continue;
+      }
+      size_t headerLength = strlen(buf) + 1;
+      if (headerLength >= static_cast<size_t>(length)) {
+        continue;
+      }
+      dispatch(env, buf + headerLength, length - headerLength);
+    }
+  }
+}
+
+void HotplugMonitor::dispatch(Napi::Env env, const char *properties, size_t length) {
+  UeventProperties props;
+  for (size_t i = 0; i < length; i += strlen(properties + i) + 1) {
+    const char *line = properties + i;
+    const char *equals = strchr(line, '=');
+    if (equals != NULL) {
+      props[std::string(line, equals - line)] = std::string(equals + 1);
+    }
+  }
+
+  if (getProperty(props, "SUBSYSTEM") != "tty") {
+    return;
+  }
+  std::string action = getProperty(props, "ACTION");
+  if (action != "add" && action != "remove") {
+    return;
+  }
+
+  // The kernel reports "ttyUSB0", udev reports "/dev/ttyUSB0"
+  std::string name = getProperty(props, "DEVNAME");
+  if (0 == name.compare(0, 5, "/dev/")) {
+    name.erase(0, 5);
+  }
+  if (name.empty() || !linuxIsSerialDeviceName(name.c_str())) {
+    return;
+  }
+
+  ListResultItem port;
+  if (action == "add") {
+    ByIdMap byId;
+    if (source == HOTPLUG_SOURCE_UDEV) {
+      byId["/dev/" + name] = byIdFromDevlinks(getProperty(props, "DEVLINKS"));
+    }
+    if (!linuxReadPortInfo(name.c_str(), byId, &port)) {
+      return;
+    }
+  } else {
+    // sysfs is already gone on remove, report what the event itself carries
+    port.path = "/dev/" + name;
+    port.pnpId = byIdFromDevlinks(getProperty(props, "DEVLINKS"));
+    port.serialNumber = getProperty(props, "ID_SERIAL_SHORT");
+    port.vendorId = getProperty(props, "ID_VENDOR_ID");
+    port.productId = getProperty(props, "ID_MODEL_ID");
+  }
+
+  Napi::Object event = ListResultItemToObject(env, port);
+  event.Set("action", action);
+  event.Set("devpath", getProperty(props, "DEVPATH"));
+  callback.Call({env.Null(), event});
+}
+
+Napi::Value HotplugMonitor::start(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!uv_poll_init_success) {
+    Napi::Error::New(env, "Hotplug monitor is not initialized").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  int status = uv_poll_start(poll_handle, UV_READABLE, HotplugMonitor::onData);
+  if (0 != status) {
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
+Napi::Value HotplugMonitor::stop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!uv_poll_init_success) {
+    Napi::Error::New(env, "Hotplug monitor is not initialized").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  int status = uv_poll_stop(poll_handle);
+  if (0 != status) {
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
+Napi::Value HotplugMonitor::getSource(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), source == HOTPLUG_SOURCE_UDEV ? "udev" : "kernel");
+}
+
+Napi::Object HotplugMonitor::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "HotplugMonitor", {
+    InstanceMethod<&HotplugMonitor::start>("start"),
+    InstanceMethod<&HotplugMonitor::stop>("stop"),
+    InstanceAccessor<&HotplugMonitor::getSource>("source"),
+  });
+  exports.Set("HotplugMonitor", func);
+  return exports;
+}
@@ -0,0 +1,39 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_HOTPLUG_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_HOTPLUG_H_
+
+#include <napi.h>
+#include <uv.h>
+#include "./addon_data.h"
+
+// Which netlink multicast group to listen on. The kernel group fires as soon as the tty exists,
+// the udev group fires after udevd has created the device node and its /dev/serial/by-id links.
+enum HotplugSource {
+  HOTPLUG_SOURCE_KERNEL = 1,
+  HOTPLUG_SOURCE_UDEV   = 2
+};
+
+class HotplugMonitor : public Napi::ObjectWrap<HotplugMonitor>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit HotplugMonitor(const Napi::CallbackInfo &info);
+  static void onData(uv_poll_t* handle, int status, int events);
+  static void onClose(uv_handle_t* poll_handle);
+  ~HotplugMonitor();
+  void closeHandle() override;
+
+ private:
+  int fd = -1;
+  HotplugSource source = HOTPLUG_SOURCE_KERNEL;
+  uv_poll_t* poll_handle = nullptr;
+  Napi::FunctionReference callback;
+  bool uv_poll_init_success = false;
+
+  void receive(Napi::Env env);
+  void dispatch(Napi::Env env, const char *properties, size_t length);
+
+  Napi::Value start(const Napi::CallbackInfo& info);
+  Napi::Value stop(const Napi::CallbackInfo& info);
+  Napi::Value getSource(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_HOTPLUG_H_
@@ -0,0 +1,176 @@
+#include "./linux_list.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <list>
+
+#define SYS_CLASS_TTY "/sys/class/tty"
+#define DEV_SERIAL_BY_ID "/dev/serial/by-id"
+
+static const char* serialDevicePrefixes[] = {
+  "ttyS", "ttyWCH", "ttyACM", "ttyUSB", "ttyAMA", "ttyMFD", "ttyO", "ttyXRUSB", "rfcomm", NULL
+};
+
+Napi::Value List(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  // callback
+  if (!info[0].IsFunction()) {
+    Napi::TypeError::New(env, "First argument must be a function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Function callback = info[0].As<Napi::Function>();
+  ListBaton* baton = new ListBaton(callback);
+
+  baton->Queue();
+  return env.Undefined();
+}
+
+void setIfNotEmpty(Napi::Object item, std::string key, const char *value) {
+  Napi::Env env = item.Env();
+  Napi::String v8key = Napi::String::New(env, key);
+  if (strlen(value) > 0) {
+    (item).Set(v8key, Napi::String::New(env, value));
+  } else {
+    (item).Set(v8key, env.Undefined());
+  }
+}
+
+Napi::Object ListResultItemToObject(Napi::Env env, const ListResultItem& port) {
+  Napi::Object item = Napi::Object::New(env);
+  setIfNotEmpty(item, "path", port.path.c_str());
+  setIfNotEmpty(item, "manufacturer", port.manufacturer.c_str());
+  setIfNotEmpty(item, "serialNumber", port.serialNumber.c_str());
+  setIfNotEmpty(item, "pnpId", port.pnpId.c_str());
+  setIfNotEmpty(item, "locationId", port.locationId.c_str());
+  setIfNotEmpty(item, "vendorId", port.vendorId.c_str());
+  setIfNotEmpty(item, "productId", port.productId.c_str());
+  return item;
+}
+
+bool linuxIsSerialDeviceName(const char *name) {
+  for (int i = 0; serialDevicePrefixes[i] != NULL; i++) {
+    if (0 == strncmp(name, serialDevicePrefixes[i], strlen(serialDevicePrefixes[i]))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Reads a single line sysfs attribute without the trailing newline
+static bool readAttribute(const std::string& dir, const char *attribute, std::string* value) {
+  std::string file = dir + "/" + attribute;
+  FILE* fp = fopen(file.c_str(), "re");
+  if (fp == NULL) {
+    return false;
+  }
+  char buf[256];
+  size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+  fclose(fp);
+  while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == ' ')) {
+    len--;
+  }
+  value->assign(buf, len);
+  return true;
+}
+
+void linuxReadByIdLinks(ByIdMap* byId) {
+  DIR* dir = opendir(DEV_SERIAL_BY_ID);
+  if (dir == NULL) {
+    return;
+  }
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    std::string link = std::string(DEV_SERIAL_BY_ID "/") + entry->d_name;
+    char target[PATH_MAX];
+    if (realpath(link.c_str(), target) != NULL) {
+      (*byId)[target] = entry->d_name;
+    }
+  }
+  closedir(dir);
+}
+
+bool linuxReadPortInfo(const char *name, const ByIdMap& byId, ListResultItem* port) {
+  std::string ttyDir = std::string(SYS_CLASS_TTY "/") + name;
+  std::string deviceLink = ttyDir + "/device";
+
+  // Virtual consoles and ptys have no backing device, rfcomm is virtual but still a serial port
+  char devicePath[PATH_MAX];
+  bool hasDevice = realpath(deviceLink.c_str(), devicePath) != NULL;
+  if (!hasDevice && 0 != strncmp(name, "rfcomm", 6)) {
+    return false;
+  }
+
+  port->path = std::string("/dev/") + name;
+
+  ByIdMap::const_iterator link = byId.find(port->path);
+  if (link != byId.end()) {
+    port->pnpId = link->second;
+  }
+
+  if (!hasDevice) {
+    return true;
+  }
+
+  // Walk up from the tty's device (usually the usb interface) to the usb device that carries the ids
+  std::string dir = devicePath;
+  while (dir.length() > strlen("/sys/devices")) {
+    std::string vendorId;
+    if (readAttribute(dir, "idVendor", &vendorId)) {
+      port->vendorId = vendorId;
+      readAttribute(dir, "idProduct", &port->productId);
+      readAttribute(dir, "manufacturer", &port->manufacturer);
+      readAttribute(dir, "serial", &port->serialNumber);
+      break;
+    }
+    size_t slash = dir.rfind('/');
+    if (slash == std::string::npos) {
+      break;
+    }
+    dir.erase(slash);
+  }
+
+  return true;
+}
+
+static bool comparePath(const ListResultItem* a, const ListResultItem* b) {
+  return a->path < b->path;
+}
+
+void ListBaton::Execute() {
+  DIR* dir = opendir(SYS_CLASS_TTY);
+  if (dir == NULL) {
+    snprintf(errorString, sizeof(errorString), "Error: %s, cannot open " SYS_CLASS_TTY, strerror(errno));
+    this->SetError(errorString);
+    return;
+  }
+
+  ByIdMap byId;
+  linuxReadByIdLinks(&byId);
+
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (!linuxIsSerialDeviceName(entry->d_name)) {
+      continue;
+    }
+    ListResultItem* resultItem = new ListResultItem();
+    if (linuxReadPortInfo(entry->d_name, byId, resultItem)) {
+      results.push_back(resultItem);
+    } else {
+      delete resultItem;
+    }
+  }
+  closedir(dir);
+
+  results.sort(comparePath);
+}
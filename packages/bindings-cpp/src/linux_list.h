@@ -0,0 +1,60 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_LIST_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_LIST_H_
+#include <napi.h>
+#include <uv.h>
+#include <list>
+#include <map>
+#include <string>
+
+#define ERROR_STRING_SIZE 1088
+
+Napi::Value List(const Napi::CallbackInfo& info);
+void setIfNotEmpty(Napi::Object item, std::string key, const char *value);
+
+struct ListResultItem {
+  std::string path;
+  std::string manufacturer;
+  std::string serialNumber;
+  std::string pnpId;
+  std::string locationId;
+  std::string vendorId;
+  std::string productId;
+};
+
+Napi::Object ListResultItemToObject(Napi::Env env, const ListResultItem& port);
+
+struct ListBaton : public Napi::AsyncWorker {
+  ListBaton(Napi::Function& callback) : Napi::AsyncWorker(callback, "node-serialport:ListBaton"),
+  errorString() {}
+  ~ListBaton() {
+    for (std::list<ListResultItem*>::iterator it = results.begin(); it != results.end(); ++it) {
+      delete *it;
+    }
+  }
+  std::list<ListResultItem*> results;
+  char errorString[ERROR_STRING_SIZE];
+  void Execute() override;
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::HandleScope scope(env);
+    Napi::Array result = Napi::Array::New(env);
+    int i = 0;
+    for (std::list<ListResultItem*>::iterator it = results.begin(); it != results.end(); ++it, i++) {
+      (result).Set(i, ListResultItemToObject(env, **it));
+    }
+    Callback().Call({env.Null(), result});
+  }
+};
+
+// True for the tty names the udevadm based lister used to report (ttyS, ttyUSB, ttyACM, rfcomm...)
+bool linuxIsSerialDeviceName(const char *name);
+
+// Map of /dev/<name> to the link name in /dev/serial/by-id that resolves to it
+typedef std::map<std::string, std::string> ByIdMap;
+void linuxReadByIdLinks(ByIdMap* byId);
+
+// Fills `port` from /sys/class/tty/<name>, returns false when the tty has no backing device
+bool linuxReadPortInfo(const char *name, const ByIdMap& byId, ListResultItem* port);
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_LIST_H_
@@ -0,0 +1,585 @@
+#include "./linux_mock.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+
+// reads per wake up, the poll fires again if there is more
+static const unsigned kReadsPerWake = 16;
+// the sketch reads commands into an Arduino String, longer lines are cut
+static const size_t kMaxCommand = 256;
+// an RFID block, the sketch cuts USB text to it
+static const size_t kCardBlock = 16;
+// the Arduino's serial receive buffer holds a few lines, later ones are lost
+static const size_t kMaxUsbLines = 4;
+
+static uint64_t monotonicNow() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+static double numberOption(const Napi::Object& options, const char* name, double fallback) {
+  Napi::Value value = options.Get(name);
+  return value.IsNumber() ? value.As<Napi::Number>().DoubleValue() : fallback;
+}
+
+static bool boolOption(const Napi::Object& options, const char* name, bool fallback) {
+  Napi::Value value = options.Get(name);
+  return value.IsBoolean() ? value.As<Napi::Boolean>().Value() : fallback;
+}
+
+static const char* onOff(bool on) {
+  return on ? "ON" : "OFF";
+}
+
+MockDevice::MockDevice(const Napi::CallbackInfo &info) : Napi::ObjectWrap<MockDevice>(info),
+  context(info.Env(), "node-serialport:MockDevice") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // options
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env, "First argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[0].ToObject();
+
+  // callback
+  if (!info[1].IsFunction()) {
+    Napi::TypeError::New(env, "Second argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[1].As<Napi::Function>());
+
+  this->interval = numberOption(options, "interval", interval);
+  if (!(interval >= 1)) {
+    Napi::RangeError::New(env, "interval must be at least 1ms").ThrowAsJavaScriptException();
+    return;
+  }
+  this->jitter = std::max(0.0, numberOption(options, "jitter", jitter));
+  this->ackDelay = numberOption(options, "ackDelay", ackDelay);
+  this->loss = std::min(1.0, std::max(0.0, numberOption(options, "loss", loss)));
+  this->corruption = std::min(1.0, std::max(0.0, numberOption(options, "corruption", corruption)));
+  this->speed = numberOption(options, "speed", speed);
+  if (!(speed >= 0)) {
+    Napi::RangeError::New(env, "speed must not be negative").ThrowAsJavaScriptException();
+    return;
+  }
+  this->usb = boolOption(options, "usb", usb);
+  this->drift = boolOption(options, "drift", drift);
+  this->maxQueued = std::max(1.0, numberOption(options, "maxQueued", maxQueued));
+  this->random.seed(static_cast<uint32_t>(numberOption(options, "seed", 1)));
+
+  SerialError error;
+  if (-1 == openPtyPair(&pty, &error)) {
+    error.ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  this->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (-1 == this->timerFd) {
+    SerialError(errno, "Error: %s, cannot create timer").ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  this->port_handle = new uv_poll_t();
+  this->timer_handle = new uv_poll_t();
+  port_handle->data = this;
+  timer_handle->data = this;
+  int status = uv_poll_init(data->loop, port_handle, pty.masterFd);
+  if (0 != status) {
+    delete port_handle;
+    delete timer_handle;
+    port_handle = timer_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  status = uv_poll_init(data->loop, timer_handle, this->timerFd);
+  if (0 != status) {
+    uv_close(reinterpret_cast<uv_handle_t*>(port_handle), MockDevice::onClose);
+    delete timer_handle;
+    port_handle = timer_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  handles_open = true;
+  data->addHandleOwner(this);
+  updatePoll();
+}
+
+MockDevice::~MockDevice() {
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  if (-1 != pty.masterFd) {
+    ::close(pty.masterFd);
+  }
+  if (-1 != pty.slaveFd) {
+    ::close(pty.slaveFd);
+  }
+  if (-1 != timerFd) {
+    ::close(timerFd);
+  }
+}
+
+void MockDevice::closeHandle() {
+  uv_poll_stop(port_handle);
+  uv_poll_stop(timer_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(port_handle), MockDevice::onClose);
+  uv_close(reinterpret_cast<uv_handle_t*>(timer_handle), MockDevice::onClose);
+  // the handles are freed by onClose
+  port_handle = timer_handle = nullptr;
+  handles_open = false;
+  portEvents = 0;
+  timerDeadline = 0;
+  // closing both ends hangs the port up, as if the board was unplugged
+  ::close(pty.masterFd);
+  ::close(pty.slaveFd);
+  ::close(timerFd);
+  pty.masterFd = pty.slaveFd = timerFd = -1;
+}
+
+void MockDevice::onClose(uv_handle_t* poll_handle) {
+  delete reinterpret_cast<uv_poll_t*>(poll_handle);
+}
+
+void MockDevice::call(Napi::Env env, napi_value error, napi_value command) {
+  try {
+    callback.MakeCallback(Value(), {error, command}, context);
+  } catch (const Napi::Error& e) {
+    // same as an exception thrown from any other callback
+    napi_fatal_exception(env, e.Value());
+  }
+}
+
+// The virtual time, milliseconds since start()
+double MockDevice::clock() const {
+  if (!started || 0 == speed) {
+    return now;
+  }
+  return virtualBase + (monotonicNow() - realBase) / 1e6 * speed;
+}
+
+double MockDevice::uniform(double low, double high) {
+  return std::uniform_real_distribution<double>(low, high)(random);
+}
+
+// Arms the timer for the next loop or acknowledgement
+void MockDevice::schedule() {
+  if (!handles_open || !started || 0 == speed) {
+    return;
+  }
+  double next = nextLoop;
+  if (ackDelay >= 0 && !commands.empty()) {
+    next = std::min(next, commands.front().due);
+  }
+  uint64_t deadline = realBase + static_cast<uint64_t>(std::ceil(std::max(0.0, next - virtualBase) / speed * 1e6));
+  // 0 disarms a timerfd
+  deadline = std::max<uint64_t>(deadline, 1);
+  if (deadline == timerDeadline) {
+    return;
+  }
+  timerDeadline = deadline;
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  spec.it_value.tv_sec = deadline / 1000000000ULL;
+  spec.it_value.tv_nsec = deadline % 1000000000ULL;
+  timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+  uv_poll_start(timer_handle, UV_READABLE, MockDevice::onTimer);
+}
+
+// Plays everything due up to `until` in order, the clock then stands at `until`
+void MockDevice::run(Napi::Env env, double until) {
+  while (handles_open && !failed) {
+    double next = nextLoop;
+    bool acknowledge = false;
+    if (ackDelay >= 0 && !commands.empty() && commands.front().due <= nextLoop) {
+      next = commands.front().due;
+      acknowledge = true;
+    }
+    if (next > until) {
+      break;
+    }
+    now = std::max(now, next);
+    if (acknowledge) {
+      handle(commands.front().line);
+      commands.pop_front();
+      continue;
+    }
+    // the sketch reads one command at the top of each loop
+    if (ackDelay < 0 && !commands.empty()) {
+      handle(commands.front().line);
+      commands.pop_front();
+    }
+    loop();
+    nextLoop = now + std::max(1.0, interval + (jitter > 0 ? uniform(-jitter, jitter) : 0));
+  }
+  now = std::max(now, until);
+  flush(env);
+}
+
+// One pass of the sketch's loop(): read the sensors, switch the relays, send the packet
+void MockDevice::loop() {
+  loops++;
+  if (drift) {
+    temp1 = std::min(45.0, std::max(5.0, temp1 + uniform(-0.2, 0.2)));
+    hum1 = std::min(95.0, std::max(20.0, hum1 + uniform(-0.5, 0.5)));
+    // the fan pulls the greenhouse towards the outside air
+    temp2 = std::min(45.0, std::max(5.0, temp2 + uniform(-0.2, 0.2) + (fan.on ? (temp1 - temp2) * 0.05 : 0.05)));
+    hum2 = std::min(95.0, std::max(20.0, hum2 + uniform(-0.5, 0.5)));
+    soil = std::min(100.0, std::max(0.0, soil + (waterPump.on ? 3 : -0.2)));
+    tank = std::min(100.0, std::max(0.0, tank - (waterPump.on ? 0.5 : 0)));
+    light = std::min(100.0, std::max(0.0, light + uniform(-1, 1)));
+    ph = std::min(14.0, std::max(0.0, ph + uniform(-0.02, 0.02)));
+  }
+  int soilPercent = static_cast<int>(soil);
+  int tankPercent = static_cast<int>(tank);
+  waterPump.on = waterPump.automatic ? soilPercent < 50 && tankPercent > 20 : waterPump.manualState;
+  fan.on = fan.automatic ? temp2 > 30.0 : fan.manualState;
+
+  // the sketch reads one USB line per loop, the text is written to the next card and read back
+  if (!usbLines.empty()) {
+    cardText = usbLines.front();
+    usbLines.pop_front();
+  }
+  std::string card = rfid.empty() ? "NoCard" : rfid;
+  if (!rfid.empty()) {
+    if (!cardText.empty()) {
+      card = cardText + std::string(kCardBlock - cardText.size(), ' ');
+    }
+    cardText.clear();
+  }
+
+  char packet[384];
+  snprintf(packet, sizeof(packet),
+           "T1:%.2f,H1:%.2f,T2:%.2f,H2:%.2f,Soil:%d,Light:%d,Tank:%d,pH:%.2f,"
+           "WaterPump:%s,WaterMode:%s,Fan:%s,FanMode:%s,Fertilizer:%s,RFID:%s",
+           temp1, hum1, temp2, hum2, soilPercent, static_cast<int>(light), tankPercent, ph,
+           onOff(waterPump.on), waterPump.automatic ? "AUTO" : "MANUAL",
+           onOff(fan.on), fan.automatic ? "AUTO" : "MANUAL",
+           onOff(fertilizer), card.c_str());
+  rfid.clear();
+  // the USB port echoes what went to the ESP32
+  send(usb ? std::string("Sent: ") + packet : std::string(packet));
+}
+
+// The sketch's processESP32Commands(). Its acknowledgements go to the USB port, the espSerial link
+// this came in on doesn't carry them.
+void MockDevice::handle(const std::string& command) {
+  handled++;
+  if (0 == command.compare(0, 6, "WATER:") || 0 == command.compare(0, 4, "FAN:")) {
+    Relay& relay = 'W' == command[0] ? waterPump : fan;
+    if (std::string::npos != command.find("AUTO")) {
+      relay.automatic = true;
+    } else if (std::string::npos != command.find("MANUAL")) {
+      relay.automatic = false;
+      if (std::string::npos != command.find("ON")) {
+        relay.manualState = true;
+      } else if (std::string::npos != command.find("OFF")) {
+        relay.manualState = false;
+      }
+    }
+  } else if (0 == command.compare(0, 11, "FERTILIZER:")) {
+    if (std::string::npos != command.find("ON")) {
+      fertilizer = true;
+    } else if (std::string::npos != command.find("OFF")) {
+      fertilizer = false;
+    }
+  }
+}
+
+// Queues a line as println() would, unless the link loses it. A full queue drops it like a UART
+// nobody reads.
+void MockDevice::send(const std::string& line) {
+  lines++;
+  if (loss > 0 && uniform(0, 1) < loss) {
+    lost++;
+    return;
+  }
+  std::string data = line + "\r\n";
+  if (corruption > 0 && !line.empty() && uniform(0, 1) < corruption) {
+    size_t at = std::uniform_int_distribution<size_t>(0, line.size() - 1)(random);
+    data[at] ^= 1 << std::uniform_int_distribution<int>(0, 7)(random);
+    corrupted++;
+  }
+  if (output.size() + data.size() > maxQueued) {
+    overruns++;
+    return;
+  }
+  output += data;
+}
+
+void MockDevice::flush(Napi::Env env) {
+  while (handles_open && !failed && !output.empty()) {
+    ssize_t written = write(pty.masterFd, output.data(), output.size());
+    if (-1 == written) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        break;
+      }
+      if (EINTR == errno) {
+        continue;
+      }
+      fail(env, SerialError(errno, "Error: %s, cannot write").ToError(env).Value());
+      return;
+    }
+    bytesWritten += written;
+    output.erase(0, written);
+  }
+  updatePoll();
+}
+
+void MockDevice::updatePoll() {
+  if (!handles_open) {
+    return;
+  }
+  int events = failed ? 0 : UV_READABLE | (output.empty() ? 0 : UV_WRITABLE);
+  if (events == portEvents) {
+    return;
+  }
+  portEvents = events;
+  if (0 == events) {
+    uv_poll_stop(port_handle);
+  } else {
+    uv_poll_start(port_handle, events, MockDevice::onPort);
+  }
+}
+
+void MockDevice::fail(Napi::Env env, napi_value error) {
+  failed = true;
+  output.clear();
+  updatePoll();
+  call(env, error, env.Undefined());
+}
+
+// Takes what the application writes, one line at a time: commands on the espSerial link, card text
+// on the USB port, which the sketch never reads commands from
+void MockDevice::readPort(Napi::Env env) {
+  char buffer[1024];
+  for (unsigned reads = 0; reads < kReadsPerWake && handles_open && !failed; reads++) {
+    ssize_t count = read(pty.masterFd, buffer, sizeof(buffer));
+    if (-1 == count) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        break;
+      }
+      if (EINTR == errno) {
+        continue;
+      }
+      fail(env, SerialError(errno, "Error: %s, cannot read").ToError(env).Value());
+      return;
+    }
+    if (0 == count) {
+      break;
+    }
+    bytesRead += count;
+    for (ssize_t i = 0; i < count && handles_open; i++) {
+      char c = buffer[i];
+      if ('\n' != c) {
+        if (input.size() < kMaxCommand) {
+          input.push_back(c);
+        }
+        continue;
+      }
+      // String::trim()
+      size_t start = input.find_first_not_of(" \t\r");
+      std::string command = std::string::npos == start ? "" : input.substr(start, input.find_last_not_of(" \t\r") - start + 1);
+      input.clear();
+      if (usb) {
+        if (usbLines.size() < kMaxUsbLines) {
+          usbLines.push_back(command.substr(0, kCardBlock));
+        }
+        continue;
+      }
+      if (command.empty()) {
+        continue;
+      }
+      received++;
+      commands.push_back({clock() + std::max(0.0, ackDelay), command});
+      call(env, env.Null(), Napi::String::New(env, command));
+    }
+  }
+  schedule();
+}
+
+void MockDevice::onPort(uv_poll_t* handle, int status, int events) {
+  MockDevice* obj = static_cast<MockDevice*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  if (0 != status) {
+    obj->fail(env, Napi::Error::New(env, uv_strerror(status)).Value());
+    return;
+  }
+  if (events & UV_WRITABLE) {
+    obj->flush(env);
+  }
+  if ((events & UV_READABLE) && obj->handles_open) {
+    obj->readPort(env);
+  }
+}
+
+void MockDevice::onTimer(uv_poll_t* handle, int status, int events) {
+  MockDevice* obj = static_cast<MockDevice*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+
+  uint64_t expirations;
+  if (-1 == read(obj->timerFd, &expirations, sizeof(expirations))) {
+    return;
+  }
+  obj->timerDeadline = 0;
+  uv_poll_stop(handle);
+  obj->run(env, obj->clock());
+  obj->schedule();
+}
+
+// Boots the node: the banner and the first loop go out at virtual time 0
+Napi::Value MockDevice::start(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!handles_open) {
+    Napi::Error::New(env, "Device is closed").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (started) {
+    Napi::Error::New(env, "Device already started").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  started = true;
+  realBase = monotonicNow();
+  virtualBase = now;
+  nextLoop = now;
+  if (usb) {
+    send("Arduino Enhanced Sensor+RFID+Relay node ready.");
+  }
+  run(env, now);
+  schedule();
+  return env.Undefined();
+}
+
+// Moves the clock forward by `ms`, playing everything due meanwhile. Returns the lines sent.
+Napi::Value MockDevice::advance(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 0) {
+    Napi::TypeError::New(env, "First argument must be a positive number").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!handles_open || !started) {
+    Napi::Error::New(env, "Device is not running").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  double ms = info[0].As<Napi::Number>().DoubleValue();
+  uint64_t before = lines;
+  if (0 == speed) {
+    run(env, now + ms);
+  } else {
+    // a running clock jumps ahead
+    virtualBase += ms;
+    run(env, clock());
+    schedule();
+  }
+  return Napi::Number::New(env, static_cast<double>(lines - before));
+}
+
+// Sets sensor readings, the next loop reports them
+Napi::Value MockDevice::set(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env, "First argument must be an object").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Object values = info[0].ToObject();
+  temp1 = numberOption(values, "temp1", temp1);
+  hum1 = numberOption(values, "hum1", hum1);
+  temp2 = numberOption(values, "temp2", temp2);
+  hum2 = numberOption(values, "hum2", hum2);
+  soil = numberOption(values, "soil", soil);
+  light = numberOption(values, "light", light);
+  tank = numberOption(values, "tank", tank);
+  ph = numberOption(values, "ph", ph);
+  Napi::Value card = values.Get("rfid");
+  if (card.IsString()) {
+    rfid = card.As<Napi::String>().Utf8Value();
+  }
+  return env.Undefined();
+}
+
+Napi::Value MockDevice::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  commands.clear();
+  usbLines.clear();
+  cardText.clear();
+  input.clear();
+  output.clear();
+  return env.Undefined();
+}
+
+Napi::Value MockDevice::getPath(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), pty.path);
+}
+
+Napi::Value MockDevice::getNow(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), clock());
+}
+
+Napi::Value MockDevice::getState(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object state = Napi::Object::New(env);
+  state.Set("temp1", temp1);
+  state.Set("hum1", hum1);
+  state.Set("temp2", temp2);
+  state.Set("hum2", hum2);
+  state.Set("soil", soil);
+  state.Set("light", light);
+  state.Set("tank", tank);
+  state.Set("ph", ph);
+  Napi::Object relay = Napi::Object::New(env);
+  relay.Set("on", waterPump.on);
+  relay.Set("mode", waterPump.automatic ? "AUTO" : "MANUAL");
+  state.Set("waterPump", relay);
+  relay = Napi::Object::New(env);
+  relay.Set("on", fan.on);
+  relay.Set("mode", fan.automatic ? "AUTO" : "MANUAL");
+  state.Set("fan", relay);
+  state.Set("fertilizer", fertilizer);
+  return state;
+}
+
+Napi::Value MockDevice::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("loops", static_cast<double>(loops));
+  stats.Set("lines", static_cast<double>(lines));
+  stats.Set("commands", static_cast<double>(received));
+  stats.Set("handled", static_cast<double>(handled));
+  stats.Set("lost", static_cast<double>(lost));
+  stats.Set("corrupted", static_cast<double>(corrupted));
+  stats.Set("overruns", static_cast<double>(overruns));
+  stats.Set("queued", static_cast<double>(output.size()));
+  stats.Set("bytesWritten", static_cast<double>(bytesWritten));
+  stats.Set("bytesRead", static_cast<double>(bytesRead));
+  return stats;
+}
+
+Napi::Object MockDevice::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "MockDevice", {
+    InstanceMethod<&MockDevice::start>("start"),
+    InstanceMethod<&MockDevice::advance>("advance"),
+    InstanceMethod<&MockDevice::set>("set"),
+    InstanceMethod<&MockDevice::close>("close"),
+    InstanceAccessor<&MockDevice::getPath>("path"),
+    InstanceAccessor<&MockDevice::getNow>("now"),
+    InstanceAccessor<&MockDevice::getState>("state"),
+    InstanceAccessor<&MockDevice::getStats>("stats"),
+  });
+  exports.Set("MockDevice", func);
+  return exports;
+}
@@ -0,0 +1,131 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_MOCK_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_MOCK_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <deque>
+#include <random>
+#include <string>
+#include "./addon_data.h"
+#include "./linux_pty.h"
+
+// A stand-in for the greenhouse Arduino node behind a pty. Every loop it sends a telemetry line
+// (T1:..,H1:..,...,RFID:..). Like the sketch, it takes the node's commands (WATER:AUTO,
+// FAN:MANUAL:ON, FERTILIZER:OFF, ...) on the espSerial link only, switching its relays. On the USB
+// port a line is the text the sketch writes to the next RFID card.
+//
+// The device runs on a virtual clock in milliseconds. With a `speed` it follows the monotonic clock
+// scaled by it, the next event sharing one timerfd; with speed 0 it only moves when advance() is
+// called, so a test can run hours of traffic without waiting. Lines can be delayed (`jitter`),
+// dropped (`loss`) or have a bit flipped (`corruption`), drawn from a seeded generator so a run can
+// be repeated.
+class MockDevice : public Napi::ObjectWrap<MockDevice>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit MockDevice(const Napi::CallbackInfo &info);
+  static void onPort(uv_poll_t* handle, int status, int events);
+  static void onTimer(uv_poll_t* handle, int status, int events);
+  static void onClose(uv_handle_t* poll_handle);
+  ~MockDevice();
+  void closeHandle() override;
+
+ private:
+  struct Relay {
+    bool automatic = true;
+    bool manualState = false;
+    bool on = false;
+  };
+  struct Command {
+    double due = 0;
+    std::string line;
+  };
+
+  PtyPair pty;
+  uv_poll_t* port_handle = nullptr;
+  uv_poll_t* timer_handle = nullptr;
+  int timerFd = -1;
+  bool handles_open = false;
+  // the pty failed, the device stops talking
+  bool failed = false;
+  int portEvents = 0;
+
+  // virtual milliseconds
+  double interval = 3000;
+  double jitter = 0;
+  // < 0 handles commands at the start of the next loop, like the sketch
+  double ackDelay = -1;
+  double loss = 0;
+  double corruption = 0;
+  double speed = 1;
+  bool usb = true;
+  bool drift = true;
+  size_t maxQueued = 65536;
+  std::mt19937 random;
+
+  bool started = false;
+  double now = 0;
+  double nextLoop = 0;
+  // the clock's origin, CLOCK_MONOTONIC nanoseconds and the virtual time it stands for
+  uint64_t realBase = 0;
+  double virtualBase = 0;
+  uint64_t timerDeadline = 0;
+
+  double temp1 = 24;
+  double hum1 = 55;
+  double temp2 = 27;
+  double hum2 = 65;
+  double soil = 60;
+  double light = 70;
+  double tank = 80;
+  double ph = 6.8;
+  // reported by the next loop only, like a card held to the reader
+  std::string rfid;
+  Relay waterPump;
+  Relay fan;
+  bool fertilizer = false;
+
+  std::deque<Command> commands;
+  // USB lines waiting for the sketch to read them, one per loop, and the text it holds for a card
+  std::deque<std::string> usbLines;
+  std::string cardText;
+  std::string input;
+  std::string output;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t loops = 0;
+  uint64_t lines = 0;
+  uint64_t received = 0;
+  uint64_t handled = 0;
+  uint64_t lost = 0;
+  uint64_t corrupted = 0;
+  uint64_t overruns = 0;
+  uint64_t bytesWritten = 0;
+  uint64_t bytesRead = 0;
+
+  double clock() const;
+  double uniform(double low, double high);
+  void schedule();
+  void run(Napi::Env env, double until);
+  void loop();
+  void handle(const std::string& command);
+  void send(const std::string& line);
+  void flush(Napi::Env env);
+  void updatePoll();
+  void readPort(Napi::Env env);
+  void fail(Napi::Env env, napi_value error);
+  void call(Napi::Env env, napi_value error, napi_value command);
+
+  Napi::Value start(const Napi::CallbackInfo& info);
+  Napi::Value advance(const Napi::CallbackInfo& info);
+  Napi::Value set(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getPath(const Napi::CallbackInfo& info);
+  Napi::Value getNow(const Napi::CallbackInfo& info);
+  Napi::Value getState(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_MOCK_H_
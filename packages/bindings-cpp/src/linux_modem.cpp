@@ -0,0 +1,316 @@
+#include "./linux_modem.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/serial.h>
+#include <algorithm>
+#include <chrono>
+
+// Interrupts TIOCMIWAIT. Nothing else in node uses it and it is ignored by default, so a stray one
+// can't kill the process.
+static const int kWakeSignal = SIGURG;
+
+static void onWakeSignal(int signal) {}
+
+static void installWakeSignal() {
+  static std::once_flag once;
+  std::call_once(once, [] {
+    struct sigaction action;
+    if (0 == sigaction(kWakeSignal, NULL, &action) && SIG_DFL != action.sa_handler && SIG_IGN != action.sa_handler) {
+      // the application handles it already
+      return;
+    }
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onWakeSignal;
+    sigemptyset(&action.sa_mask);
+    // without SA_RESTART, so the ioctl fails with EINTR instead of going back to sleep
+    sigaction(kWakeSignal, &action, NULL);
+  });
+}
+
+static double epochMillis() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+static const char* const kLineNames[] = {"cts", "dsr", "dcd", "ri"};
+
+static int lineBit(const std::string& name) {
+  if ("cts" == name) {
+    return TIOCM_CTS;
+  }
+  if ("dsr" == name) {
+    return TIOCM_DSR;
+  }
+  if ("dcd" == name) {
+    return TIOCM_CD;
+  }
+  if ("ri" == name) {
+    return TIOCM_RI;
+  }
+  return 0;
+}
+
+ModemWatcher::ModemWatcher(const Napi::CallbackInfo &info) : Napi::ObjectWrap<ModemWatcher>(info) {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int portFd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Function callback = info[2].As<Napi::Function>();
+
+  Napi::Value value = options.Get("lines");
+  if (value.IsArray()) {
+    Napi::Array lines = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < lines.Length(); i++) {
+      Napi::Value line = lines.Get(i);
+      int bit = line.IsString() ? lineBit(line.As<Napi::String>().Utf8Value()) : 0;
+      if (0 == bit) {
+        Napi::TypeError::New(env, "lines must be cts, dsr, dcd or ri").ThrowAsJavaScriptException();
+        return;
+      }
+      this->mask |= bit;
+    }
+  } else {
+    this->mask = TIOCM_CTS | TIOCM_DSR | TIOCM_CD | TIOCM_RI;
+  }
+  if (0 == this->mask) {
+    Napi::TypeError::New(env, "lines must not be empty").ThrowAsJavaScriptException();
+    return;
+  }
+  value = options.Get("pollInterval");
+  if (value.IsNumber()) {
+    this->pollInterval = std::max(0, value.As<Napi::Number>().Int32Value());
+  }
+
+  this->fd = fcntl(portFd, F_DUPFD_CLOEXEC, 0);
+  if (-1 == this->fd) {
+    SerialError(errno, "Error: %s, cannot duplicate fd %d", portFd).ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  int initial;
+  if (-1 == ioctl(this->fd, TIOCMGET, &initial)) {
+    SerialError(errno, "Error: %s, cannot get modem lines").ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  this->bits = initial;
+
+  installWakeSignal();
+  this->events = EventFunction::New(env, callback, "node-serialport:ModemWatcher", 0, 1);
+  this->thread = std::thread(&ModemWatcher::run, this);
+  running = true;
+  env.GetInstanceData<AddonData>()->addHandleOwner(this);
+}
+
+ModemWatcher::~ModemWatcher() {
+  if (running) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  if (-1 != fd) {
+    ::close(fd);
+  }
+}
+
+void ModemWatcher::closeHandle() {
+  stop();
+  // the dup keeps the tty open, release it with the port rather than when collected
+  ::close(fd);
+  fd = -1;
+}
+
+// Runs on the JS thread, or with a null env while the function is torn down
+void ModemWatcher::OnEvent(Napi::Env env, Napi::Function callback, std::nullptr_t* context, ModemEvent* event) {
+  if (env != nullptr && !callback.IsEmpty()) {
+    try {
+      if (0 != event->error) {
+        callback.Call({SerialError(event->error, "Error: %s, cannot watch modem lines").ToError(env).Value()});
+      } else {
+        Napi::Object change = Napi::Object::New(env);
+        Napi::Array changed = Napi::Array::New(env);
+        for (const char* name : kLineNames) {
+          int bit = lineBit(name);
+          change.Set(name, static_cast<bool>(event->bits & bit));
+          if (event->changed & bit) {
+            changed.Set(changed.Length(), name);
+          }
+        }
+        change.Set("changed", changed);
+        Napi::Object transitions = Napi::Object::New(env);
+        transitions.Set("cts", event->cts);
+        transitions.Set("dsr", event->dsr);
+        transitions.Set("dcd", event->dcd);
+        transitions.Set("ri", event->ri);
+        change.Set("transitions", transitions);
+        change.Set("timestamp", event->timestamp);
+        callback.Call({env.Null(), change});
+      }
+    } catch (const Napi::Error& e) {
+      // same as an exception thrown from any other callback
+      napi_fatal_exception(env, e.Value());
+    }
+  }
+  delete event;
+}
+
+void ModemWatcher::post(ModemEvent* event) {
+  if (napi_ok != events.NonBlockingCall(event)) {
+    // the environment is going away
+    delete event;
+  }
+}
+
+void ModemWatcher::run() {
+  // threads inherit the creator's mask, the wake up has to get through
+  sigset_t wakeSet;
+  sigemptyset(&wakeSet);
+  sigaddset(&wakeSet, kWakeSignal);
+  pthread_sigmask(SIG_UNBLOCK, &wakeSet, NULL);
+
+  int last = bits;
+  struct serial_icounter_struct counts;
+  bool counting = 0 == ioctl(fd, TIOCGICOUNT, &counts);
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopping) {
+        break;
+      }
+    }
+    if (!polling) {
+      if (-1 == ioctl(fd, TIOCMIWAIT, mask)) {
+        if (EINTR == errno) {
+          continue;
+        }
+        if ((EINVAL == errno || ENOTTY == errno) && pollInterval > 0) {
+          // the driver can't wait for changes
+          polling = true;
+          continue;
+        }
+        ModemEvent* event = new ModemEvent();
+        event->error = errno;
+        post(event);
+        break;
+      }
+    } else {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (wake.wait_for(lock, std::chrono::milliseconds(pollInterval), [this] { return stopping; })) {
+        break;
+      }
+    }
+    wakeups++;
+
+    int current;
+    if (-1 == ioctl(fd, TIOCMGET, &current)) {
+      if (EINTR == errno) {
+        continue;
+      }
+      ModemEvent* event = new ModemEvent();
+      event->error = errno;
+      post(event);
+      break;
+    }
+    ModemEvent* event = new ModemEvent();
+    struct serial_icounter_struct now;
+    if (counting && 0 == ioctl(fd, TIOCGICOUNT, &now)) {
+      event->cts = (mask & TIOCM_CTS) ? now.cts - counts.cts : 0;
+      event->dsr = (mask & TIOCM_DSR) ? now.dsr - counts.dsr : 0;
+      event->dcd = (mask & TIOCM_CD) ? now.dcd - counts.dcd : 0;
+      event->ri = (mask & TIOCM_RI) ? now.rng - counts.rng : 0;
+      counts = now;
+    }
+    event->bits = current;
+    event->changed = (current ^ last) & mask;
+    if (0 == event->changed && 0 == event->cts + event->dsr + event->dcd + event->ri) {
+      // a line outside the mask, or a poll that found nothing
+      delete event;
+      continue;
+    }
+    event->timestamp = epochMillis();
+    last = current;
+    bits = current;
+    changes++;
+    post(event);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  exited = true;
+  wake.notify_all();
+}
+
+void ModemWatcher::stop() {
+  running = false;
+  std::unique_lock<std::mutex> lock(mutex);
+  stopping = true;
+  wake.notify_all();
+  // the signal may land before the thread is back in the ioctl, so it is repeated until it leaves
+  while (!exited) {
+    pthread_kill(thread.native_handle(), kWakeSignal);
+    wake.wait_for(lock, std::chrono::milliseconds(10));
+  }
+  lock.unlock();
+  thread.join();
+  events.Release();
+}
+
+Napi::Value ModemWatcher::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (running) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  return env.Undefined();
+}
+
+Napi::Value ModemWatcher::getState(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  int current = bits;
+  Napi::Object state = Napi::Object::New(env);
+  for (const char* name : kLineNames) {
+    state.Set(name, static_cast<bool>(current & lineBit(name)));
+  }
+  return state;
+}
+
+Napi::Value ModemWatcher::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("mode", polling ? "poll" : "wait");
+  stats.Set("wakeups", static_cast<double>(wakeups));
+  stats.Set("changes", static_cast<double>(changes));
+  return stats;
+}
+
+Napi::Object ModemWatcher::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "ModemWatcher", {
+    InstanceMethod<&ModemWatcher::close>("close"),
+    InstanceAccessor<&ModemWatcher::getState>("state"),
+    InstanceAccessor<&ModemWatcher::getStats>("stats"),
+  });
+  exports.Set("ModemWatcher", func);
+  return exports;
+}
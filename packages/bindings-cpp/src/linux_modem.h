@@ -0,0 +1,70 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_MODEM_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_MODEM_H_
+
+#include <napi.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "./addon_data.h"
+
+// A change of the modem status lines, TIOCM_* bits
+struct ModemEvent {
+  int bits = 0;
+  int changed = 0;
+  // edges counted by the driver since the previous event, a pulse shorter than the wake up shows
+  // here without changing `bits`
+  uint32_t cts = 0;
+  uint32_t dsr = 0;
+  uint32_t dcd = 0;
+  uint32_t ri = 0;
+  // milliseconds since the epoch
+  double timestamp = 0;
+  int error = 0;
+};
+
+// Watches CTS, DSR, DCD and RI on a helper thread blocked in TIOCMIWAIT, so nothing runs while the
+// lines are quiet. Changes are handed to JS through a thread-safe function. Drivers without
+// TIOCMIWAIT (ptys, some USB adapters) are polled with TIOCMGET every `pollInterval` instead.
+//
+// TIOCMIWAIT only returns on a line change, stopping interrupts it with a signal aimed at the thread.
+class ModemWatcher : public Napi::ObjectWrap<ModemWatcher>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit ModemWatcher(const Napi::CallbackInfo &info);
+  static void OnEvent(Napi::Env env, Napi::Function callback, std::nullptr_t* context, ModemEvent* event);
+  ~ModemWatcher();
+  void closeHandle() override;
+
+ private:
+  using EventFunction = Napi::TypedThreadSafeFunction<std::nullptr_t, ModemEvent, ModemWatcher::OnEvent>;
+
+  int fd = -1;
+  int mask = 0;
+  unsigned pollInterval = 100;
+  bool running = false;
+
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+  bool exited = false;
+  EventFunction events;
+
+  // written by the helper thread
+  std::atomic<int> bits{0};
+  std::atomic<bool> polling{false};
+  std::atomic<uint64_t> wakeups{0};
+  std::atomic<uint64_t> changes{0};
+
+  void run();
+  void stop();
+  void post(ModemEvent* event);
+
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getState(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_MODEM_H_
@@ -0,0 +1,62 @@
+#include "./linux_pty.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+int openPtyPair(PtyPair* pty, SerialError* error) {
+  int masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (-1 == masterFd) {
+    *error = SerialError(errno, "Error: %s, cannot open pty");
+    return -1;
+  }
+  char name[128];
+  if (-1 == grantpt(masterFd) || -1 == unlockpt(masterFd) || 0 != ptsname_r(masterFd, name, sizeof(name))) {
+    *error = SerialError(errno, "Error: %s, cannot unlock pty");
+    close(masterFd);
+    return -1;
+  }
+  int slaveFd = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (-1 == slaveFd) {
+    *error = SerialError(errno, "Error: %s, cannot open pty slave");
+    close(masterFd);
+    return -1;
+  }
+  // the line discipline would otherwise echo, translate CR and swallow control characters before the
+  // application sets up the port
+  struct termios options;
+  if (-1 == tcgetattr(slaveFd, &options)) {
+    *error = SerialError(errno, "Error: %s, cannot get pty attributes");
+    close(slaveFd);
+    close(masterFd);
+    return -1;
+  }
+  cfmakeraw(&options);
+  if (-1 == tcsetattr(slaveFd, TCSANOW, &options)) {
+    *error = SerialError(errno, "Error: %s, cannot set pty attributes");
+    close(slaveFd);
+    close(masterFd);
+    return -1;
+  }
+  pty->masterFd = masterFd;
+  pty->slaveFd = slaveFd;
+  pty->path = name;
+  return 0;
+}
+
+Napi::Value OpenPty(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  PtyPair pty;
+  SerialError error;
+  if (-1 == openPtyPair(&pty, &error)) {
+    error.ToError(env).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("path", pty.path);
+  result.Set("masterFd", pty.masterFd);
+  result.Set("slaveFd", pty.slaveFd);
+  return result;
+}
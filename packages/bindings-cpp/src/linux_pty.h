@@ -0,0 +1,22 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_PTY_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_PTY_H_
+
+#include <napi.h>
+#include <string>
+#include "./worker_pool.h"
+
+// A pseudo terminal standing in for a serial device. The application opens `path` like any port,
+// the other end is `masterFd`. `slaveFd` keeps the pty from hanging up while the application has
+// the port closed, e.g. between reopens.
+struct PtyPair {
+  int masterFd = -1;
+  int slaveFd = -1;
+  std::string path;
+};
+
+// Opens a raw pty with a non blocking, close on exec master. Returns -1 and fills `error` on failure.
+int openPtyPair(PtyPair* pty, SerialError* error);
+
+Napi::Value OpenPty(const Napi::CallbackInfo& info);
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_PTY_H_
@@ -0,0 +1,450 @@
+#include "./linux_shared.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+// a new slab is started rather than reading less than this into the current one
+static const size_t kMinRead = 1024;
+// reads per wake up, the poll fires again if there is more
+static const unsigned kReadsPerWake = 16;
+
+SharedReader::SharedReader(const Napi::CallbackInfo &info) : Napi::ObjectWrap<SharedReader>(info),
+  context(info.Env(), "node-serialport:SharedReader") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int portFd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[2].As<Napi::Function>());
+
+  Napi::Value value = options.Get("slabSize");
+  if (value.IsNumber()) {
+    int64_t size = value.As<Napi::Number>().Int64Value();
+    if (size < static_cast<int64_t>(kMinRead) * 4 || size > 16 * 1024 * 1024) {
+      Napi::RangeError::New(env, "slabSize must be between 4096 and 16777216").ThrowAsJavaScriptException();
+      return;
+    }
+    this->slabSize = size;
+  }
+
+  this->fd = fcntl(portFd, F_DUPFD_CLOEXEC, 0);
+  if (-1 == this->fd) {
+    SerialError(errno, "Error: %s, cannot duplicate fd %d", portFd).ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  this->read_handle = new uv_poll_t();
+  read_handle->data = this;
+  int status = uv_poll_init(data->loop, read_handle, fd);
+  if (0 != status) {
+    delete read_handle;
+    read_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  handles_open = true;
+  data->addHandleOwner(this);
+  updatePoll();
+}
+
+SharedReader::~SharedReader() {
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  if (-1 != fd) {
+    ::close(fd);
+  }
+  for (auto& slab : slabs) {
+    release(slab);
+  }
+}
+
+void SharedReader::closeHandle() {
+  uv_poll_stop(read_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(read_handle), SharedReader::onClose);
+  // the handle is freed by onClose
+  read_handle = nullptr;
+  handles_open = false;
+  reading = false;
+  // the dup keeps the tty (and its lock) open, release it with the port rather than when collected
+  ::close(fd);
+  fd = -1;
+}
+
+void SharedReader::onClose(uv_handle_t* poll_handle) {
+  delete reinterpret_cast<uv_poll_t*>(poll_handle);
+}
+
+void SharedReader::finalizeSlab(napi_env env, void* data, void* hint) {
+  std::shared_ptr<Slab>* slab = static_cast<std::shared_ptr<Slab>*>(hint);
+  int64_t adjusted;
+  napi_adjust_external_memory(env, -static_cast<int64_t>((*slab)->capacity), &adjusted);
+  delete slab;
+}
+
+void SharedReader::call(Napi::Env env, napi_value error, uint32_t id, napi_value data) {
+  try {
+    callback.MakeCallback(Value(), {error, Napi::Number::New(env, id), data}, context);
+  } catch (const Napi::Error& e) {
+    // same as an exception thrown from any other callback
+    napi_fatal_exception(env, e.Value());
+  }
+}
+
+void SharedReader::updatePoll() {
+  bool wanted = handles_open && !blocked && !failed;
+  if (wanted == reading) {
+    return;
+  }
+  reading = wanted;
+  if (wanted) {
+    uv_poll_start(read_handle, UV_READABLE, SharedReader::onReadable);
+  } else {
+    uv_poll_stop(read_handle);
+  }
+}
+
+// Drops the slab's reference to its ArrayBuffer, views JS still has keep the slab alive
+void SharedReader::release(std::shared_ptr<Slab>& slab) {
+  if (nullptr != slab->arrayBuffer) {
+    napi_delete_reference(Env(), slab->arrayBuffer);
+    slab->arrayBuffer = nullptr;
+  }
+}
+
+// Applies the subscribers' policies after a read
+void SharedReader::enforce() {
+  for (auto& entry : subscribers) {
+    Subscriber& subscriber = entry.second;
+    if (head - subscriber.cursor <= subscriber.highWaterMark) {
+      continue;
+    }
+    if (subscriber.dropOldest) {
+      uint64_t cursor = head - subscriber.highWaterMark;
+      subscriber.dropped += cursor - subscriber.cursor;
+      subscriber.cursor = cursor;
+    } else if (!blocked) {
+      // the slowest subscriber sets the pace, the port's data waits in the kernel
+      blocked = true;
+      stalls++;
+    }
+  }
+  updatePoll();
+}
+
+// Reads the port again once every blocking subscriber is down to half its high water mark
+void SharedReader::unblock() {
+  if (!blocked) {
+    return;
+  }
+  for (const auto& entry : subscribers) {
+    const Subscriber& subscriber = entry.second;
+    if (!subscriber.dropOldest && head - subscriber.cursor > subscriber.highWaterMark / 2) {
+      return;
+    }
+  }
+  blocked = false;
+  updatePoll();
+}
+
+// Frees the slabs every cursor has moved past, the one being read into is kept
+void SharedReader::trim() {
+  uint64_t oldest = head;
+  for (const auto& entry : subscribers) {
+    oldest = std::min(oldest, entry.second.cursor);
+  }
+  while (slabs.size() > 1 && slabs.front()->start + slabs.front()->used <= oldest) {
+    release(slabs.front());
+    slabs.pop_front();
+  }
+}
+
+void SharedReader::fill(Napi::Env env) {
+  // reported after what was read has been delivered
+  int failure = -1;
+  for (unsigned count = 0; count < kReadsPerWake && handles_open && !blocked; count++) {
+    if (slabs.empty() || slabs.back()->capacity - slabs.back()->used < kMinRead) {
+      auto slab = std::make_shared<Slab>(slabSize);
+      slab->start = head;
+      slabs.push_back(slab);
+    }
+    Slab* slab = slabs.back().get();
+    ssize_t length = read(fd, slab->data.get() + slab->used, slab->capacity - slab->used);
+    if (-1 == length) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        break;
+      }
+      if (EINTR == errno) {
+        continue;
+      }
+      failure = errno;
+      break;
+    }
+    if (0 == length) {
+      // a tty only reads 0 bytes once it is hung up
+      failure = 0;
+      break;
+    }
+    slab->used += length;
+    head += length;
+    bytes += length;
+    reads++;
+    enforce();
+  }
+  if (handles_open) {
+    deliver(env);
+  }
+  if (handles_open) {
+    trim();
+  }
+  if (handles_open && -1 != failure) {
+    fail(env, failure);
+  }
+}
+
+// A view of the subscriber's next bytes, up to the end of the slab they are in. Null when it has
+// read everything.
+Napi::Value SharedReader::view(Napi::Env env, Subscriber* subscriber) {
+  if (subscriber->cursor >= head) {
+    return env.Null();
+  }
+  std::shared_ptr<Slab> slab;
+  for (const auto& candidate : slabs) {
+    if (subscriber->cursor < candidate->start + candidate->used) {
+      slab = candidate;
+      break;
+    }
+  }
+  napi_value arrayBuffer = nullptr;
+  if (nullptr != slab->arrayBuffer) {
+    napi_get_reference_value(env, slab->arrayBuffer, &arrayBuffer);
+  } else {
+    std::shared_ptr<Slab>* hint = new std::shared_ptr<Slab>(slab);
+    napi_status status = napi_create_external_arraybuffer(env, slab->data.get(), slab->capacity,
+                                                          SharedReader::finalizeSlab, hint, &arrayBuffer);
+    if (napi_ok != status) {
+      delete hint;
+      NAPI_THROW_IF_FAILED(env, status, env.Null());
+    }
+    int64_t adjusted;
+    napi_adjust_external_memory(env, slab->capacity, &adjusted);
+    // strong while the slab is held here, so it is never wrapped twice
+    napi_create_reference(env, arrayBuffer, 1, &slab->arrayBuffer);
+  }
+  size_t offset = subscriber->cursor - slab->start;
+  size_t length = slab->used - offset;
+  subscriber->cursor += length;
+  subscriber->delivered += length;
+  return Napi::Uint8Array::New(env, length, Napi::ArrayBuffer(env, arrayBuffer), offset);
+}
+
+// Hands new data to the subscribers waiting for it
+void SharedReader::deliver(Napi::Env env) {
+  std::vector<uint32_t> waiting;
+  for (const auto& entry : subscribers) {
+    if (entry.second.waiting && entry.second.cursor < head) {
+      waiting.push_back(entry.first);
+    }
+  }
+  for (uint32_t id : waiting) {
+    // a callback may have unsubscribed it or closed the reader
+    auto entry = subscribers.find(id);
+    if (!handles_open || entry == subscribers.end() || !entry->second.waiting) {
+      continue;
+    }
+    entry->second.waiting = false;
+    Napi::Value data = view(env, &entry->second);
+    call(env, env.Null(), id, data);
+  }
+  if (handles_open) {
+    unblock();
+  }
+}
+
+// The port failed, subscribers can still take what was read and JS closes the reader
+void SharedReader::fail(Napi::Env env, int code) {
+  failed = true;
+  updatePoll();
+  if (0 == code) {
+    Napi::Error error = Napi::Error::New(env, "Error: Port hung up, cannot read");
+    error.Set("code", "EOF");
+    call(env, error.Value(), 0, env.Undefined());
+  } else {
+    call(env, SerialError(code, "Error: %s, cannot read").ToError(env).Value(), 0, env.Undefined());
+  }
+}
+
+void SharedReader::onReadable(uv_poll_t* handle, int status, int events) {
+  SharedReader* obj = static_cast<SharedReader*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  if (obj->failed) {
+    return;
+  }
+  // libuv reports POLLERR as EBADF, reading tells what happened to the port
+  obj->fill(env);
+  if (0 != status && obj->handles_open && !obj->failed) {
+    obj->fail(env, -status);
+  }
+}
+
+// Adds a subscriber starting at the next byte read, returns its id
+Napi::Value SharedReader::subscribe(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Subscriber subscriber;
+  if (info[0].IsObject()) {
+    Napi::Object options = info[0].ToObject();
+    Napi::Value value = options.Get("policy");
+    if (value.IsString()) {
+      std::string policy = value.As<Napi::String>().Utf8Value();
+      if (policy == "drop-oldest") {
+        subscriber.dropOldest = true;
+      } else if (policy != "block") {
+        Napi::TypeError::New(env, "policy must be \"block\" or \"drop-oldest\"").ThrowAsJavaScriptException();
+        return env.Undefined();
+      }
+    }
+    value = options.Get("highWaterMark");
+    if (value.IsNumber()) {
+      int64_t size = value.As<Napi::Number>().Int64Value();
+      if (size < 1) {
+        Napi::RangeError::New(env, "highWaterMark must be at least 1").ThrowAsJavaScriptException();
+        return env.Undefined();
+      }
+      subscriber.highWaterMark = size;
+    }
+  }
+  subscriber.cursor = head;
+  uint32_t id = nextId++;
+  subscribers[id] = subscriber;
+  return Napi::Number::New(env, id);
+}
+
+Napi::Value SharedReader::unsubscribe(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  subscribers.erase(info[0].As<Napi::Number>().Uint32Value());
+  if (handles_open) {
+    unblock();
+    trim();
+  }
+  return env.Undefined();
+}
+
+// The subscriber's next bytes, or null when there are none yet
+Napi::Value SharedReader::take(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  auto entry = subscribers.find(info[0].As<Napi::Number>().Uint32Value());
+  if (entry == subscribers.end() || !handles_open) {
+    return env.Null();
+  }
+  Napi::Value data = view(env, &entry->second);
+  unblock();
+  trim();
+  return data;
+}
+
+// Has the callback called with the subscriber's next bytes once there are some
+Napi::Value SharedReader::wait(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  auto entry = subscribers.find(info[0].As<Napi::Number>().Uint32Value());
+  if (entry != subscribers.end()) {
+    entry->second.waiting = true;
+  }
+  return env.Undefined();
+}
+
+Napi::Value SharedReader::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  subscribers.clear();
+  for (auto& slab : slabs) {
+    release(slab);
+  }
+  slabs.clear();
+  return env.Undefined();
+}
+
+Napi::Value SharedReader::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("reads", static_cast<double>(reads));
+  stats.Set("bytes", static_cast<double>(bytes));
+  stats.Set("stalls", static_cast<double>(stalls));
+  stats.Set("blocked", blocked);
+  stats.Set("subscribers", static_cast<double>(subscribers.size()));
+  stats.Set("slabs", static_cast<double>(slabs.size()));
+  stats.Set("retained", static_cast<double>(slabs.empty() ? 0 : head - slabs.front()->start));
+  return stats;
+}
+
+Napi::Value SharedReader::getSubscriberStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  auto entry = subscribers.find(info[0].As<Napi::Number>().Uint32Value());
+  if (entry == subscribers.end()) {
+    return env.Null();
+  }
+  const Subscriber& subscriber = entry->second;
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("policy", subscriber.dropOldest ? "drop-oldest" : "block");
+  stats.Set("highWaterMark", static_cast<double>(subscriber.highWaterMark));
+  stats.Set("delivered", static_cast<double>(subscriber.delivered));
+  stats.Set("dropped", static_cast<double>(subscriber.dropped));
+  stats.Set("lag", static_cast<double>(head - subscriber.cursor));
+  return stats;
+}
+
+Napi::Object SharedReader::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "SharedReader", {
+    InstanceMethod<&SharedReader::subscribe>("subscribe"),
+    InstanceMethod<&SharedReader::unsubscribe>("unsubscribe"),
+    InstanceMethod<&SharedReader::take>("take"),
+    InstanceMethod<&SharedReader::wait>("wait"),
+    InstanceMethod<&SharedReader::close>("close"),
+    InstanceAccessor<&SharedReader::getStats>("stats"),
+    InstanceMethod<&SharedReader::getSubscriberStats>("subscriberStats"),
+  });
+  exports.Set("SharedReader", func);
+  return exports;
+}
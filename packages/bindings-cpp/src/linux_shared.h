@@ -0,0 +1,91 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_SHARED_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_SHARED_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include "./addon_data.h"
+
+// Reads a port once for several consumers. Reads are appended to slabs, each subscriber has its own
+// cursor into them and is handed views of the slabs rather than copies: every subscriber gets the
+// same memory, and a slab is freed once all cursors have moved past it and JS has dropped its views.
+//
+// A subscriber more than `highWaterMark` bytes behind either blocks reading until it is down to half
+// (the data waits in the kernel) or, with the drop-oldest policy, skips ahead losing the oldest bytes.
+class SharedReader : public Napi::ObjectWrap<SharedReader>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit SharedReader(const Napi::CallbackInfo &info);
+  static void onReadable(uv_poll_t* handle, int status, int events);
+  static void onClose(uv_handle_t* poll_handle);
+  ~SharedReader();
+  void closeHandle() override;
+
+ private:
+  struct Slab {
+    explicit Slab(size_t capacity) : data(new char[capacity]), capacity(capacity) {}
+    std::unique_ptr<char[]> data;
+    size_t capacity;
+    size_t used = 0;
+    // stream position of data[0]
+    uint64_t start = 0;
+    // The ArrayBuffer over the slab, created for its first view. V8 allows a single ArrayBuffer per
+    // external memory block so every view has to share it, the reference keeps it until the slab is
+    // trimmed. The ArrayBuffer then keeps the slab alive for as long as JS has views of it.
+    napi_ref arrayBuffer = nullptr;
+  };
+  struct Subscriber {
+    uint64_t cursor = 0;
+    bool dropOldest = false;
+    size_t highWaterMark = 262144;
+    bool waiting = false;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+  };
+
+  int fd = -1;
+  uv_poll_t* read_handle = nullptr;
+  bool handles_open = false;
+  bool reading = false;
+  bool blocked = false;
+  bool failed = false;
+
+  size_t slabSize = 65536;
+  std::deque<std::shared_ptr<Slab>> slabs;
+  // stream position of the next byte read
+  uint64_t head = 0;
+  std::map<uint32_t, Subscriber> subscribers;
+  uint32_t nextId = 1;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t reads = 0;
+  uint64_t bytes = 0;
+  uint64_t stalls = 0;
+
+  static void finalizeSlab(napi_env env, void* data, void* hint);
+  void updatePoll();
+  void fill(Napi::Env env);
+  void enforce();
+  void trim();
+  void release(std::shared_ptr<Slab>& slab);
+  void unblock();
+  Napi::Value view(Napi::Env env, Subscriber* subscriber);
+  void deliver(Napi::Env env);
+  void fail(Napi::Env env, int code);
+  void call(Napi::Env env, napi_value error, uint32_t id, napi_value data);
+
+  Napi::Value subscribe(const Napi::CallbackInfo& info);
+  Napi::Value unsubscribe(const Napi::CallbackInfo& info);
+  Napi::Value take(const Napi::CallbackInfo& info);
+  Napi::Value wait(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+  Napi::Value getSubscriberStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_SHARED_H_
@@ -0,0 +1,601 @@
+#include "./linux_transaction.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+
+// frames gathered into one writev()
+static const int kMaxIov = 64;
+// reads per wake up, the poll fires again if there is more
+static const unsigned kReadsPerWake = 16;
+
+static uint64_t monotonicNow() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+static std::string bufferOption(const Napi::Object& options, const char* name) {
+  Napi::Value value = options.Get(name);
+  if (!value.IsBuffer()) {
+    return std::string();
+  }
+  Napi::Buffer<char> buffer = value.As<Napi::Buffer<char>>();
+  return std::string(buffer.Data(), buffer.Length());
+}
+
+SerialTransactor::SerialTransactor(const Napi::CallbackInfo &info) : Napi::ObjectWrap<SerialTransactor>(info),
+  context(info.Env(), "node-serialport:SerialTransactor") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int portFd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[2].As<Napi::Function>());
+
+  this->delimiter = bufferOption(options, "delimiter");
+  if (this->delimiter.empty()) {
+    Napi::TypeError::New(env, "delimiter must be set").ThrowAsJavaScriptException();
+    return;
+  }
+  this->sequenceField = bufferOption(options, "sequenceField");
+  Napi::Value value = options.Get("maxFrame");
+  if (value.IsNumber()) {
+    int64_t size = value.As<Napi::Number>().Int64Value();
+    if (size < static_cast<int64_t>(delimiter.size()) + 1) {
+      Napi::RangeError::New(env, "maxFrame must be longer than the delimiter").ThrowAsJavaScriptException();
+      return;
+    }
+    this->maxFrame = size;
+  }
+  value = options.Get("maxInFlight");
+  if (value.IsNumber()) {
+    int64_t count = value.As<Napi::Number>().Int64Value();
+    if (count < 1 || count > 65536) {
+      Napi::RangeError::New(env, "maxInFlight must be between 1 and 65536").ThrowAsJavaScriptException();
+      return;
+    }
+    this->maxInFlight = count;
+  }
+  this->buffer.resize(this->maxFrame);
+
+  this->fd = fcntl(portFd, F_DUPFD_CLOEXEC, 0);
+  if (-1 == this->fd) {
+    SerialError(errno, "Error: %s, cannot duplicate fd %d", portFd).ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  this->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (-1 == this->timerFd) {
+    SerialError(errno, "Error: %s, cannot create timer").ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  this->port_handle = new uv_poll_t();
+  this->timer_handle = new uv_poll_t();
+  port_handle->data = this;
+  timer_handle->data = this;
+  int status = uv_poll_init(data->loop, port_handle, this->fd);
+  if (0 != status) {
+    delete port_handle;
+    delete timer_handle;
+    port_handle = timer_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  status = uv_poll_init(data->loop, timer_handle, this->timerFd);
+  if (0 != status) {
+    uv_close(reinterpret_cast<uv_handle_t*>(port_handle), SerialTransactor::onClose);
+    delete timer_handle;
+    port_handle = timer_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  handles_open = true;
+  data->addHandleOwner(this);
+  updatePoll();
+}
+
+SerialTransactor::~SerialTransactor() {
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  if (-1 != fd) {
+    ::close(fd);
+  }
+  if (-1 != timerFd) {
+    ::close(timerFd);
+  }
+}
+
+void SerialTransactor::closeHandle() {
+  uv_poll_stop(port_handle);
+  uv_poll_stop(timer_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(port_handle), SerialTransactor::onClose);
+  uv_close(reinterpret_cast<uv_handle_t*>(timer_handle), SerialTransactor::onClose);
+  // the handles are freed by onClose
+  port_handle = timer_handle = nullptr;
+  handles_open = false;
+  portEvents = 0;
+  timerDeadline = 0;
+  // the dup keeps the tty (and its lock) open, release it with the port rather than when collected
+  ::close(fd);
+  ::close(timerFd);
+  fd = timerFd = -1;
+}
+
+void SerialTransactor::onClose(uv_handle_t* poll_handle) {
+  delete reinterpret_cast<uv_poll_t*>(poll_handle);
+}
+
+void SerialTransactor::call(Napi::Env env, napi_value error, uint32_t id, napi_value data, double rtt,
+                            uint64_t readAt) {
+  try {
+    // frames carry the read() that completed them and the poll wake up before it
+    napi_value readTime = 0 == readAt ? env.Undefined() : Napi::Number::New(env, static_cast<double>(readAt));
+    napi_value wakeTime = 0 == readAt ? env.Undefined() : Napi::Number::New(env, static_cast<double>(wakeAt));
+    callback.MakeCallback(Value(), {error, Napi::Number::New(env, id), data, Napi::Number::New(env, rtt), readTime,
+                                    wakeTime}, context);
+  } catch (const Napi::Error& e) {
+    // same as an exception thrown from any other callback
+    napi_fatal_exception(env, e.Value());
+  }
+}
+
+void SerialTransactor::updatePoll() {
+  if (!handles_open) {
+    return;
+  }
+  bool writing = !partial.empty();
+  for (const Transaction& transaction : transactions) {
+    if (!transaction.admitted) {
+      break;
+    }
+    if (transaction.written < transaction.frame.size()) {
+      writing = true;
+      break;
+    }
+  }
+  int events = failed ? 0 : UV_READABLE | (writing ? UV_WRITABLE : 0);
+  if (events == portEvents) {
+    return;
+  }
+  portEvents = events;
+  if (0 == events) {
+    uv_poll_stop(port_handle);
+  } else {
+    uv_poll_start(port_handle, events, SerialTransactor::onPort);
+  }
+}
+
+// Arms the timer for the earliest deadline
+void SerialTransactor::updateTimer() {
+  if (!handles_open) {
+    return;
+  }
+  uint64_t earliest = 0;
+  for (const Transaction& transaction : transactions) {
+    if (transaction.deadline > 0 && (0 == earliest || transaction.deadline < earliest)) {
+      earliest = transaction.deadline;
+    }
+  }
+  if (earliest == timerDeadline) {
+    return;
+  }
+  timerDeadline = earliest;
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  if (0 == earliest) {
+    timerfd_settime(timerFd, 0, &spec, NULL);
+    uv_poll_stop(timer_handle);
+    return;
+  }
+  spec.it_value.tv_sec = earliest / 1000000000ULL;
+  spec.it_value.tv_nsec = earliest % 1000000000ULL;
+  timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+  uv_poll_start(timer_handle, UV_READABLE, SerialTransactor::onTimer);
+}
+
+// Lets waiting requests be written, in order, while fewer than maxInFlight are outstanding
+void SerialTransactor::admit() {
+  for (Transaction& transaction : transactions) {
+    if (inFlight >= maxInFlight) {
+      return;
+    }
+    if (!transaction.admitted) {
+      transaction.admitted = true;
+      inFlight++;
+    }
+  }
+}
+
+void SerialTransactor::remove(std::list<Transaction>::iterator transaction) {
+  if (transaction->written > 0 && transaction->written < transaction->frame.size()) {
+    // the port has seen the start of the frame, the rest has to follow
+    partial.append(transaction->frame, transaction->written, std::string::npos);
+  }
+  if (transaction->admitted) {
+    inFlight--;
+  }
+  transactions.erase(transaction);
+}
+
+void SerialTransactor::writePort(Napi::Env env) {
+  while (handles_open && !failed) {
+    struct iovec iov[kMaxIov];
+    int count = 0;
+    if (!partial.empty()) {
+      iov[count].iov_base = const_cast<char*>(partial.data());
+      iov[count++].iov_len = partial.size();
+    }
+    for (Transaction& transaction : transactions) {
+      if (!transaction.admitted || count == kMaxIov) {
+        break;
+      }
+      if (transaction.written < transaction.frame.size()) {
+        iov[count].iov_base = const_cast<char*>(transaction.frame.data() + transaction.written);
+        iov[count++].iov_len = transaction.frame.size() - transaction.written;
+      }
+    }
+    if (0 == count) {
+      break;
+    }
+    ssize_t written = writev(fd, iov, count);
+    if (-1 == written) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        break;
+      }
+      if (EINTR == errno) {
+        continue;
+      }
+      fail(env, errno, "cannot write");
+      return;
+    }
+    uint64_t sentAt = monotonicNow();
+    size_t left = written;
+    size_t fromPartial = std::min(left, partial.size());
+    partial.erase(0, fromPartial);
+    left -= fromPartial;
+    for (Transaction& transaction : transactions) {
+      if (0 == left || !transaction.admitted) {
+        break;
+      }
+      size_t part = std::min(left, transaction.frame.size() - transaction.written);
+      transaction.written += part;
+      left -= part;
+      if (part > 0 && transaction.written == transaction.frame.size()) {
+        transaction.sentAt = sentAt;
+      }
+    }
+  }
+  updatePoll();
+}
+
+bool SerialTransactor::matches(const Transaction& transaction, const char* data, size_t size) const {
+  if (!transaction.prefix.empty() &&
+      (size < transaction.prefix.size() || 0 != memcmp(data, transaction.prefix.data(), transaction.prefix.size()))) {
+    return false;
+  }
+  if (!transaction.contains.empty() &&
+      NULL == memmem(data, size, transaction.contains.data(), transaction.contains.size())) {
+    return false;
+  }
+  if (transaction.sequence >= 0) {
+    const char* field = static_cast<const char*>(memmem(data, size, sequenceField.data(), sequenceField.size()));
+    if (NULL == field) {
+      return false;
+    }
+    const char* end = data + size;
+    const char* digit = field + sequenceField.size();
+    if (digit == end || *digit < '0' || *digit > '9') {
+      return false;
+    }
+    int64_t sequence = 0;
+    for (; digit < end && *digit >= '0' && *digit <= '9'; digit++) {
+      sequence = sequence * 10 + (*digit - '0');
+    }
+    if (sequence != transaction.sequence) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Completes the oldest request the frame (without its delimiter) matches, or hands it to JS as is
+void SerialTransactor::frame(Napi::Env env, const char* data, size_t size, uint64_t readAt) {
+  if (skipping) {
+    // the end of an overlong frame
+    skipping = false;
+    return;
+  }
+  for (auto transaction = transactions.begin(); transaction != transactions.end(); ++transaction) {
+    if (!transaction->admitted) {
+      break;
+    }
+    if (0 == transaction->sentAt || !matches(*transaction, data, size)) {
+      continue;
+    }
+    uint32_t id = transaction->id;
+    double rtt = (readAt - transaction->sentAt) / 1e6;
+    remove(transaction);
+    completed++;
+    rttMin = 0 == rttCount ? rtt : std::min(rttMin, rtt);
+    rttMax = std::max(rttMax, rtt);
+    rttTotal += rtt;
+    rttCount++;
+    admit();
+    writePort(env);
+    updateTimer();
+    call(env, env.Null(), id, Napi::Buffer<char>::Copy(env, data, size), rtt, readAt);
+    return;
+  }
+  unsolicited++;
+  call(env, env.Null(), 0, Napi::Buffer<char>::Copy(env, data, size), 0, readAt);
+}
+
+void SerialTransactor::readPort(Napi::Env env) {
+  for (unsigned reads = 0; reads < kReadsPerWake && handles_open && !failed; reads++) {
+    ssize_t count = read(fd, buffer.data() + length, buffer.size() - length);
+    if (-1 == count) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        return;
+      }
+      if (EINTR == errno) {
+        continue;
+      }
+      fail(env, errno, "cannot read");
+      return;
+    }
+    if (0 == count) {
+      // a tty only reads 0 bytes once it is hung up
+      fail(env, 0, "cannot read");
+      return;
+    }
+    uint64_t readAt = monotonicNow();
+    // a delimiter may straddle the old and the new data
+    size_t start = 0;
+    size_t from = length >= delimiter.size() - 1 ? length - (delimiter.size() - 1) : 0;
+    length += count;
+    const void* found;
+    while (from + delimiter.size() <= length &&
+           (found = memmem(buffer.data() + from, length - from, delimiter.data(), delimiter.size())) != NULL) {
+      size_t end = static_cast<const char*>(found) - buffer.data();
+      frame(env, buffer.data() + start, end - start, readAt);
+      if (!handles_open) {
+        return;
+      }
+      start = from = end + delimiter.size();
+    }
+    length -= start;
+    memmove(buffer.data(), buffer.data() + start, length);
+    if (length == buffer.size()) {
+      // no delimiter within maxFrame, drop it and whatever follows up to the next one
+      overruns++;
+      length = 0;
+      skipping = true;
+    }
+  }
+}
+
+// Fails the requests whose deadline has passed
+void SerialTransactor::expire(Napi::Env env) {
+  uint64_t now = monotonicNow();
+  std::vector<uint32_t> expired;
+  for (auto transaction = transactions.begin(); transaction != transactions.end();) {
+    auto current = transaction++;
+    if (current->deadline > 0 && current->deadline <= now) {
+      expired.push_back(current->id);
+      remove(current);
+    }
+  }
+  timeouts += expired.size();
+  admit();
+  writePort(env);
+  updateTimer();
+  for (uint32_t id : expired) {
+    if (!handles_open) {
+      return;
+    }
+    Napi::Error error = Napi::Error::New(env, "Error: Transaction timed out");
+    error.Set("code", "ETIMEDOUT");
+    call(env, error.Value(), id, env.Undefined(), 0);
+  }
+}
+
+// The port failed, every request fails with it and JS closes the transactor
+void SerialTransactor::fail(Napi::Env env, int code, const char* action) {
+  failed = true;
+  updatePoll();
+  std::vector<uint32_t> ids;
+  for (const Transaction& transaction : transactions) {
+    ids.push_back(transaction.id);
+  }
+  transactions.clear();
+  partial.clear();
+  inFlight = 0;
+  updateTimer();
+  Napi::Error error;
+  if (0 == code) {
+    error = Napi::Error::New(env, std::string("Error: Port hung up, ") + action);
+    error.Set("code", "EOF");
+  } else {
+    error = SerialError(code, "Error: %s, %s", action).ToError(env);
+  }
+  for (uint32_t id : ids) {
+    if (!handles_open) {
+      return;
+    }
+    call(env, error.Value(), id, env.Undefined(), 0);
+  }
+  if (handles_open) {
+    call(env, error.Value(), 0, env.Undefined(), 0);
+  }
+}
+
+void SerialTransactor::onPort(uv_poll_t* handle, int status, int events) {
+  SerialTransactor* obj = static_cast<SerialTransactor*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+  obj->wakeAt = monotonicNow();
+  if (0 != status) {
+    // libuv reports POLLERR as EBADF, reading tells what happened to the port
+    obj->readPort(env);
+    if (obj->handles_open && !obj->failed) {
+      obj->fail(env, -status, "cannot read");
+    }
+    return;
+  }
+  if (events & UV_WRITABLE) {
+    obj->writePort(env);
+  }
+  if ((events & UV_READABLE) && obj->handles_open) {
+    obj->readPort(env);
+  }
+}
+
+void SerialTransactor::onTimer(uv_poll_t* handle, int status, int events) {
+  SerialTransactor* obj = static_cast<SerialTransactor*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+
+  uint64_t expirations;
+  if (-1 == read(obj->timerFd, &expirations, sizeof(expirations))) {
+    return;
+  }
+  obj->timerDeadline = 0;
+  uv_poll_stop(handle);
+  obj->expire(env);
+}
+
+// Queues a frame to be written, returns the request's id. Requests made in the same tick go out in
+// one write.
+Napi::Value SerialTransactor::request(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsBuffer()) {
+    Napi::TypeError::New(env, "First argument must be a buffer").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!handles_open || failed) {
+    Napi::Error::New(env, "Transactor is closed").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Buffer<char> data = info[0].As<Napi::Buffer<char>>();
+  Transaction transaction;
+  transaction.frame.assign(data.Data(), data.Length());
+  if (info[1].IsObject()) {
+    Napi::Object options = info[1].ToObject();
+    transaction.prefix = bufferOption(options, "prefix");
+    transaction.contains = bufferOption(options, "contains");
+    Napi::Value value = options.Get("sequence");
+    if (value.IsNumber()) {
+      if (sequenceField.empty()) {
+        Napi::TypeError::New(env, "sequence needs a sequenceField").ThrowAsJavaScriptException();
+        return env.Undefined();
+      }
+      transaction.sequence = std::max<int64_t>(0, value.As<Napi::Number>().Int64Value());
+    }
+    value = options.Get("timeout");
+    if (value.IsNumber() && value.As<Napi::Number>().DoubleValue() > 0) {
+      transaction.deadline = monotonicNow() + static_cast<uint64_t>(value.As<Napi::Number>().DoubleValue() * 1e6);
+    }
+  }
+  transaction.id = nextId++;
+  if (0 == nextId) {
+    // 0 is for frames no request matched
+    nextId = 1;
+  }
+  transactions.push_back(std::move(transaction));
+  requests++;
+  admit();
+  updatePoll();
+  updateTimer();
+  return Napi::Number::New(env, transactions.back().id);
+}
+
+// Drops a request without failing it, false if it already completed
+Napi::Value SerialTransactor::cancel(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  uint32_t id = info[0].As<Napi::Number>().Uint32Value();
+  for (auto transaction = transactions.begin(); transaction != transactions.end(); ++transaction) {
+    if (transaction->id == id) {
+      remove(transaction);
+      cancelled++;
+      admit();
+      updatePoll();
+      updateTimer();
+      return Napi::Boolean::New(env, true);
+    }
+  }
+  return Napi::Boolean::New(env, false);
+}
+
+Napi::Value SerialTransactor::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (handles_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  transactions.clear();
+  partial.clear();
+  inFlight = 0;
+  length = 0;
+  return env.Undefined();
+}
+
+Napi::Value SerialTransactor::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("requests", static_cast<double>(requests));
+  stats.Set("completed", static_cast<double>(completed));
+  stats.Set("timeouts", static_cast<double>(timeouts));
+  stats.Set("cancelled", static_cast<double>(cancelled));
+  stats.Set("unsolicited", static_cast<double>(unsolicited));
+  stats.Set("overruns", static_cast<double>(overruns));
+  stats.Set("inFlight", static_cast<double>(inFlight));
+  stats.Set("queued", static_cast<double>(transactions.size() - inFlight));
+  Napi::Object rtt = Napi::Object::New(env);
+  rtt.Set("count", static_cast<double>(rttCount));
+  rtt.Set("mean", rttCount > 0 ? rttTotal / rttCount : 0);
+  rtt.Set("min", rttMin);
+  rtt.Set("max", rttMax);
+  stats.Set("rtt", rtt);
+  return stats;
+}
+
+Napi::Object SerialTransactor::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "SerialTransactor", {
+    InstanceMethod<&SerialTransactor::request>("request"),
+    InstanceMethod<&SerialTransactor::cancel>("cancel"),
+    InstanceMethod<&SerialTransactor::close>("close"),
+    InstanceAccessor<&SerialTransactor::getStats>("stats"),
+  });
+  exports.Set("SerialTransactor", func);
+  return exports;
+}
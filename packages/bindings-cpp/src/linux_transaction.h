@@ -0,0 +1,104 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_TRANSACTION_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_TRANSACTION_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <list>
+#include <string>
+#include <vector>
+#include "./addon_data.h"
+
+// Runs command/response exchanges on a port natively. Each request writes a frame and completes with
+// the first response frame that matches it: one starting with `prefix`, containing `contains`, and
+// carrying its sequence number after `sequenceField`, or simply the next frame when none are given.
+// Up to `maxInFlight` requests are written without waiting for the earlier ones' responses, frames no
+// request matches are handed to JS as they are.
+//
+// A request that hasn't matched by its deadline fails with ETIMEDOUT. The deadlines share one timerfd,
+// armed for the earliest. The round trip time runs from its last byte reaching the kernel to the
+// response's delimiter being read.
+class SerialTransactor : public Napi::ObjectWrap<SerialTransactor>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit SerialTransactor(const Napi::CallbackInfo &info);
+  static void onPort(uv_poll_t* handle, int status, int events);
+  static void onTimer(uv_poll_t* handle, int status, int events);
+  static void onClose(uv_handle_t* poll_handle);
+  ~SerialTransactor();
+  void closeHandle() override;
+
+ private:
+  struct Transaction {
+    uint32_t id = 0;
+    std::string frame;
+    size_t written = 0;
+    bool admitted = false;
+    std::string prefix;
+    std::string contains;
+    int64_t sequence = -1;
+    // CLOCK_MONOTONIC nanoseconds
+    uint64_t deadline = 0;
+    uint64_t sentAt = 0;
+  };
+
+  int fd = -1;
+  int timerFd = -1;
+  uv_poll_t* port_handle = nullptr;
+  uv_poll_t* timer_handle = nullptr;
+  bool handles_open = false;
+  bool failed = false;
+  int portEvents = 0;
+  uint64_t timerDeadline = 0;
+  // CLOCK_MONOTONIC nanoseconds of the current poll wake up
+  uint64_t wakeAt = 0;
+
+  std::string delimiter;
+  std::string sequenceField;
+  size_t maxFrame = 4096;
+  unsigned maxInFlight = 16;
+
+  // in the order they were requested
+  std::list<Transaction> transactions;
+  unsigned inFlight = 0;
+  uint32_t nextId = 1;
+  // the unwritten rest of a frame whose request ended mid-write, it goes out before anything else
+  std::string partial;
+  std::vector<char> buffer;
+  size_t length = 0;
+  // the rest of an overlong frame is dropped up to its delimiter
+  bool skipping = false;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t requests = 0;
+  uint64_t completed = 0;
+  uint64_t timeouts = 0;
+  uint64_t cancelled = 0;
+  uint64_t unsolicited = 0;
+  uint64_t overruns = 0;
+  uint64_t rttCount = 0;
+  double rttTotal = 0;
+  double rttMin = 0;
+  double rttMax = 0;
+
+  void updatePoll();
+  void updateTimer();
+  void admit();
+  void writePort(Napi::Env env);
+  void readPort(Napi::Env env);
+  void frame(Napi::Env env, const char* data, size_t size, uint64_t readAt);
+  bool matches(const Transaction& transaction, const char* data, size_t size) const;
+  void remove(std::list<Transaction>::iterator transaction);
+  void expire(Napi::Env env);
+  void fail(Napi::Env env, int code, const char* action);
+  void call(Napi::Env env, napi_value error, uint32_t id, napi_value data, double rtt, uint64_t readAt = 0);
+
+  Napi::Value request(const Napi::CallbackInfo& info);
+  Napi::Value cancel(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_TRANSACTION_H_
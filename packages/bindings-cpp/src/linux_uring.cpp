@@ -0,0 +1,822 @@
+#include "./linux_uring.h"
+
+#include <errno.h>
+#include <endian.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <algorithm>
+
+// Not in the uapi headers of older distributions, the kernel is probed for it at runtime
+static const uint8_t kOpReadMultishot = 49;
+static const unsigned kRingEntries = 256;
+static const unsigned kCompletionEntries = 4096;
+
+static uint64_t monotonicNow() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+static const size_t kMaxIovecs = 64;
+
+static int uringSetup(unsigned entries, struct io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  return syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+static int uringRegister(int ringFd, unsigned opcode, void* arg, unsigned count) {
+  return syscall(__NR_io_uring_register, ringFd, opcode, arg, count);
+}
+
+static bool probeKernel() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ringFd = uringSetup(4, &params);
+  if (-1 == ringFd) {
+    // ENOSYS, or EPERM when disabled by the kernel.io_uring_disabled sysctl or a seccomp filter
+    return false;
+  }
+  bool supported = (params.features & IORING_FEAT_SINGLE_MMAP) && (params.features & IORING_FEAT_NODROP);
+  std::vector<char> probeBuffer(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op), 0);
+  struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(probeBuffer.data());
+  if (supported && 0 == uringRegister(ringFd, IORING_REGISTER_PROBE, probe, 256)) {
+    for (uint8_t op : {kOpReadMultishot, static_cast<uint8_t>(IORING_OP_POLL_ADD),
+                       static_cast<uint8_t>(IORING_OP_WRITEV), static_cast<uint8_t>(IORING_OP_ASYNC_CANCEL)}) {
+      supported = supported && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+  } else {
+    supported = false;
+  }
+  ::close(ringFd);
+  return supported;
+}
+
+bool Uring::Supported() {
+  static bool supported = probeKernel();
+  return supported;
+}
+
+std::shared_ptr<Uring> Uring::Get(Napi::Env env) {
+  AddonData* data = env.GetInstanceData<AddonData>();
+  if (data->uring && !data->uring->closed()) {
+    return data->uring;
+  }
+  std::shared_ptr<Uring> ring(new Uring());
+  ring->env = env;
+  int code = Uring::Supported() ? ring->setup(data->loop) : ENOSYS;
+  if (0 != code) {
+    SerialError(code, "Error: %s, cannot set up io_uring").ToError(env).ThrowAsJavaScriptException();
+    return nullptr;
+  }
+  data->uring = ring;
+  data->addHandleOwner(ring.get());
+  return ring;
+}
+
+int Uring::setup(uv_loop_t* loop) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  // room for the read, poll and writev completions of every port, overflowing costs an extra enter
+  params.flags = IORING_SETUP_CLAMP | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_CQSIZE;
+  params.cq_entries = kCompletionEntries;
+  ringFd = uringSetup(kRingEntries, &params);
+  if (-1 == ringFd) {
+    return errno;
+  }
+  entries = params.sq_entries;
+
+  // one mapping holds both rings, Supported() checked for IORING_FEAT_SINGLE_MMAP
+  sqRingSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+  sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+  if (MAP_FAILED == sqRing) {
+    int code = errno;
+    sqRing = nullptr;
+    release();
+    return code;
+  }
+  cqRing = sqRing;
+  sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* mapped = mmap(NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+  if (MAP_FAILED == mapped) {
+    int code = errno;
+    release();
+    return code;
+  }
+  sqes = static_cast<struct io_uring_sqe*>(mapped);
+
+  char* sq = static_cast<char*>(sqRing);
+  sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sqFlags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+  sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  char* cq = static_cast<char*>(cqRing);
+  cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (-1 == eventFd || 0 != uringRegister(ringFd, IORING_REGISTER_EVENTFD, &eventFd, 1)) {
+    int code = errno;
+    release();
+    return code;
+  }
+
+  poll_handle = new uv_poll_t();
+  poll_handle->data = this;
+  int status = uv_poll_init(loop, poll_handle, eventFd);
+  if (0 != status) {
+    delete poll_handle;
+    poll_handle = nullptr;
+    release();
+    return -status;
+  }
+  uv_poll_start(poll_handle, UV_READABLE, Uring::onEvent);
+  uv_unref(reinterpret_cast<uv_handle_t*>(poll_handle));
+
+  prepare_handle = new uv_prepare_t();
+  prepare_handle->data = this;
+  uv_prepare_init(loop, prepare_handle);
+  uv_prepare_start(prepare_handle, Uring::onPrepare);
+  uv_unref(reinterpret_cast<uv_handle_t*>(prepare_handle));
+  return 0;
+}
+
+void Uring::release() {
+  if (sqes) {
+    munmap(sqes, sqesSize);
+    sqes = nullptr;
+  }
+  if (sqRing) {
+    munmap(sqRing, sqRingSize);
+    sqRing = cqRing = nullptr;
+  }
+  if (-1 != eventFd) {
+    ::close(eventFd);
+    eventFd = -1;
+  }
+  if (-1 != ringFd) {
+    ::close(ringFd);
+    ringFd = -1;
+  }
+}
+
+Uring::~Uring() {
+  release();
+}
+
+void Uring::closeHandle() {
+  if (closed()) {
+    return;
+  }
+  // Cancel whatever the ports still have in flight before their buffers are freed, closing the ring
+  // cancels it as well when the queue is full
+  reserve(1);
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+    uringEnter(ringFd, pendingSubmit, 1, IORING_ENTER_GETEVENTS);
+  }
+  pendingSubmit = 0;
+
+  uv_poll_stop(poll_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(poll_handle), Uring::onPollClose);
+  uv_prepare_stop(prepare_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(prepare_handle), Uring::onPrepareClose);
+  // the handles are freed by their close callbacks
+  poll_handle = nullptr;
+  prepare_handle = nullptr;
+  release();
+  // lets the ports waiting for room drop their references
+  std::vector<UringPort*> ports;
+  ports.swap(deferred);
+  for (UringPort* port : ports) {
+    port->resubmit();
+  }
+}
+
+void Uring::onPollClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_poll_t*>(handle);
+}
+
+void Uring::onPrepareClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_prepare_t*>(handle);
+}
+
+bool Uring::reserve(unsigned count) {
+  if (*sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) + count > entries) {
+    submit();
+  }
+  return *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) + count <= entries;
+}
+
+struct io_uring_sqe* Uring::getSqe() {
+  if (!reserve(1)) {
+    // the entry at the tail is still the kernel's
+    return nullptr;
+  }
+  unsigned tail = *sqTail;
+  unsigned index = tail & sqMask;
+  struct io_uring_sqe* sqe = &sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqArray[index] = index;
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+  pendingSubmit++;
+  return sqe;
+}
+
+void Uring::submit() {
+  while (pendingSubmit > 0) {
+    int submitted = uringEnter(ringFd, pendingSubmit, 0, 0);
+    if (-1 == submitted) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // EAGAIN or EBUSY while completions are backed up, the entries stay queued for the next prepare.
+      // Wakes the loop so the completions are reaped even when the eventfd was read already.
+      uint64_t one = 1;
+      if (-1 == ::write(eventFd, &one, sizeof(one))) {
+        // already signalled
+      }
+      return;
+    }
+    submits++;
+    pendingSubmit -= submitted;
+  }
+}
+
+void Uring::defer(UringPort* port) {
+  deferred.push_back(port);
+}
+
+void Uring::track(int delta) {
+  bool wasActive = inflight > 0;
+  inflight += delta;
+  if (closed() || wasActive == (inflight > 0)) {
+    return;
+  }
+  if (inflight > 0) {
+    uv_ref(reinterpret_cast<uv_handle_t*>(poll_handle));
+  } else {
+    uv_unref(reinterpret_cast<uv_handle_t*>(poll_handle));
+  }
+}
+
+int Uring::registerBufferRing(void* ring, unsigned ringEntries, uint16_t* group) {
+  uint16_t id;
+  if (!freeGroups.empty()) {
+    id = freeGroups.back();
+    freeGroups.pop_back();
+  } else {
+    id = nextGroup++;
+  }
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = reinterpret_cast<uintptr_t>(ring);
+  reg.ring_entries = ringEntries;
+  reg.bgid = id;
+  if (0 != uringRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1)) {
+    freeGroups.push_back(id);
+    return errno;
+  }
+  *group = id;
+  return 0;
+}
+
+void Uring::unregisterBufferRing(uint16_t group) {
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.bgid = group;
+  if (0 == uringRegister(ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1)) {
+    freeGroups.push_back(group);
+  }
+}
+
+void Uring::reap(Napi::Env env) {
+  unsigned head = *cqHead;
+  for (;;) {
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      if (!(__atomic_load_n(sqFlags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)) {
+        break;
+      }
+      // completions that didn't fit in the completion queue wait in the kernel until asked for, and
+      // submits fail with EBUSY meanwhile
+      uringEnter(ringFd, 0, 0, IORING_ENTER_GETEVENTS);
+      if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        break;
+      }
+      continue;
+    }
+    while (head != tail && !closed()) {
+      struct io_uring_cqe cqe = cqes[head & cqMask];
+      head++;
+      __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+      if (0 == cqe.user_data) {
+        // cancel requests
+        continue;
+      }
+      UringPort* port = reinterpret_cast<UringPort*>(cqe.user_data & ~static_cast<uint64_t>(3));
+      port->complete(env, cqe.user_data & 3, cqe.res, cqe.flags);
+    }
+    if (closed()) {
+      return;
+    }
+  }
+  std::vector<UringPort*> ports;
+  ports.swap(delivering);
+  for (UringPort* port : ports) {
+    port->deliver(env);
+  }
+}
+
+void Uring::onEvent(uv_poll_t* handle, int status, int events) {
+  Uring* ring = static_cast<Uring*>(handle->data);
+  Napi::Env env(ring->env);
+  Napi::HandleScope scope(env);
+  uint64_t count;
+  if (-1 == read(ring->eventFd, &count, sizeof(count))) {
+    return;
+  }
+  ring->wakeups++;
+  ring->wakeAt = monotonicNow();
+  ring->reap(env);
+}
+
+void Uring::onPrepare(uv_prepare_t* handle) {
+  Uring* ring = static_cast<Uring*>(handle->data);
+  ring->submit();
+  if (!ring->deferred.empty()) {
+    std::vector<UringPort*> ports;
+    ports.swap(ring->deferred);
+    for (UringPort* port : ports) {
+      port->resubmit();
+    }
+    ring->submit();
+  }
+}
+
+UringPort::UringPort(const Napi::CallbackInfo &info) : Napi::ObjectWrap<UringPort>(info),
+  context(info.Env(), "node-serialport:UringPort") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  this->fd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].ToObject();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[2].As<Napi::Function>());
+
+  Napi::Value value = options.Get("bufferCount");
+  if (value.IsNumber()) {
+    int64_t count = value.As<Napi::Number>().Int64Value();
+    if (count < 1 || count > 32768 || (count & (count - 1)) != 0) {
+      Napi::RangeError::New(env, "bufferCount must be a power of 2 up to 32768").ThrowAsJavaScriptException();
+      return;
+    }
+    this->bufferCount = count;
+  }
+  value = options.Get("bufferSize");
+  if (value.IsNumber()) {
+    int64_t size = value.As<Napi::Number>().Int64Value();
+    if (size < 1 || size > 65536) {
+      Napi::RangeError::New(env, "bufferSize must be between 1 and 65536").ThrowAsJavaScriptException();
+      return;
+    }
+    this->bufferSize = size;
+  }
+
+  this->ring = Uring::Get(env);
+  if (!this->ring) {
+    return;
+  }
+
+  void* memory = nullptr;
+  if (0 != posix_memalign(&memory, sysconf(_SC_PAGESIZE), bufferCount * sizeof(struct io_uring_buf))) {
+    Napi::Error::New(env, "Cannot allocate the read buffers").ThrowAsJavaScriptException();
+    return;
+  }
+  memset(memory, 0, bufferCount * sizeof(struct io_uring_buf));
+  this->bufferRing = static_cast<struct io_uring_buf_ring*>(memory);
+  this->buffers = new char[static_cast<size_t>(bufferCount) * bufferSize];
+
+  int code = ring->registerBufferRing(bufferRing, bufferCount, &group);
+  if (0 != code) {
+    SerialError(code, "Error: %s, cannot register read buffers").ToError(env).ThrowAsJavaScriptException();
+    return;
+  }
+  groupRegistered = true;
+  for (unsigned bid = 0; bid < bufferCount; bid++) {
+    recycle(bid);
+  }
+}
+
+UringPort::~UringPort() {
+  if (groupRegistered && !ring->closed()) {
+    ring->unregisterBufferRing(group);
+  }
+  for (Write* write : writes) {
+    delete write;
+  }
+  free(bufferRing);
+  delete[] buffers;
+}
+
+void UringPort::track(int delta) {
+  if (0 == outstanding && delta > 0) {
+    Ref();
+  }
+  outstanding += delta;
+  ring->track(delta);
+  if (0 == outstanding) {
+    Unref();
+  }
+}
+
+void UringPort::recycle(uint16_t bid) {
+  // not bufferRing->bufs, the uapi header's flexible array has a non zero offset when compiled as C++
+  struct io_uring_buf* buf = reinterpret_cast<struct io_uring_buf*>(bufferRing) + (bufferTail & (bufferCount - 1));
+  buf->addr = reinterpret_cast<uintptr_t>(buffers + static_cast<size_t>(bid) * bufferSize);
+  buf->len = bufferSize;
+  buf->bid = bid;
+  bufferTail++;
+  __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+}
+
+void UringPort::armRead() {
+  if (readArmed || !reading || ended || closing || ring->closed()) {
+    return;
+  }
+  struct io_uring_sqe* sqe = ring->getSqe();
+  if (!sqe) {
+    defer();
+    return;
+  }
+  sqe->opcode = kOpReadMultishot;
+  sqe->fd = fd;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = group;
+  sqe->off = static_cast<uint64_t>(-1);
+  sqe->user_data = tag(OP_READ);
+  readArmed = true;
+  track(1);
+}
+
+void UringPort::armWrite() {
+  if (writeArmed || writes.empty() || closing || ring->closed()) {
+    return;
+  }
+  iov.clear();
+  for (Write* write : writes) {
+    if (iov.size() == kMaxIovecs) {
+      break;
+    }
+    struct iovec vec;
+    vec.iov_base = const_cast<char*>(write->data + write->offset);
+    vec.iov_len = write->length - write->offset;
+    iov.push_back(vec);
+  }
+  if (!ring->reserve(2)) {
+    defer();
+    return;
+  }
+  struct io_uring_sqe* sqe = ring->getSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->flags = IOSQE_IO_LINK;
+  uint32_t events = POLLOUT;
+  #if __BYTE_ORDER == __BIG_ENDIAN
+  events = (events << 16) | (events >> 16);
+  #endif
+  sqe->poll32_events = events;
+  sqe->user_data = tag(OP_POLL);
+
+  sqe = ring->getSqe();
+  sqe->opcode = IORING_OP_WRITEV;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uintptr_t>(iov.data());
+  sqe->len = iov.size();
+  sqe->off = static_cast<uint64_t>(-1);
+  sqe->user_data = tag(OP_WRITEV);
+  writeArmed = true;
+  track(2);
+}
+
+void UringPort::cancel(Op op) {
+  struct io_uring_sqe* sqe = ring->getSqe();
+  if (!sqe) {
+    if (OP_READ == op) {
+      cancelReadPending = true;
+    } else {
+      cancelWritePending = true;
+    }
+    defer();
+    return;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->addr = tag(op);
+}
+
+void UringPort::defer() {
+  if (deferred) {
+    return;
+  }
+  deferred = true;
+  // keeps the port and the loop alive until the prepare handle retries
+  track(1);
+  ring->defer(this);
+}
+
+void UringPort::resubmit() {
+  deferred = false;
+  if (!ring->closed()) {
+    if (cancelReadPending && readArmed) {
+      cancelReadPending = false;
+      cancel(OP_READ);
+    }
+    if (cancelWritePending && writeArmed) {
+      cancelWritePending = false;
+      cancel(OP_POLL);
+      cancel(OP_WRITEV);
+    }
+    armRead();
+    armWrite();
+  }
+  track(-1);
+}
+
+void UringPort::call(Napi::Env env, const Napi::FunctionReference& fn, std::initializer_list<napi_value> args) {
+  try {
+    fn.MakeCallback(Value(), args, context);
+  } catch (const Napi::Error& e) {
+    // same as an exception thrown from any other callback
+    napi_fatal_exception(env, e.Value());
+  }
+}
+
+void UringPort::finishWrite(Napi::Env env, Write* write, int code) {
+  Napi::HandleScope scope(env);
+  if (0 == code) {
+    call(env, write->callback, {env.Null()});
+  } else {
+    call(env, write->callback, {SerialError(code, "Error: %s, cannot write").ToError(env).Value()});
+  }
+  delete write;
+}
+
+void UringPort::complete(Napi::Env env, unsigned op, int32_t res, uint32_t flags) {
+  if (OP_READ == op) {
+    if (res > 0) {
+      reads++;
+      bytes += res;
+      uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+      if (!closing) {
+        if (received.empty()) {
+          // the kernel doesn't say when it completed the read, reaping it is the earliest we know
+          receivedAt = monotonicNow();
+          receivedWakeAt = ring->wakeAt;
+        }
+        const char* data = buffers + static_cast<size_t>(bid) * bufferSize;
+        received.insert(received.end(), data, data + res);
+      }
+      recycle(bid);
+    } else if (res == 0 && !closing && !ended) {
+      // a tty only reads 0 bytes once it is hung up, re-arming would spin
+      hungUp = true;
+      ended = true;
+    } else if (res < 0 && res != -ECANCELED && res != -ENOBUFS && !closing && !ended) {
+      readError = -res;
+      ended = true;
+    }
+    if ((!received.empty() || readError || hungUp) && !dirty) {
+      dirty = true;
+      track(1);
+      ring->delivering.push_back(this);
+    }
+    if (!(flags & IORING_CQE_F_MORE)) {
+      // ended by stop(), a hang up or an error, or -ENOBUFS when a burst used every buffer before this
+      // reap. armRead() only re-arms the last while reading.
+      readArmed = false;
+      cancelReadPending = false;
+      armRead();
+      track(-1);
+    }
+    return;
+  }
+
+  if (OP_POLL == op) {
+    if (res < 0 && res != -ECANCELED) {
+      // the linked writev is canceled, report why
+      writeError = -res;
+    }
+    track(-1);
+    return;
+  }
+
+  // OP_WRITEV, still marked armed so writes made from the callbacks are only queued
+  if (res >= 0) {
+    writevs++;
+    bytesWritten += res;
+    size_t written = res;
+    while (written > 0 && !writes.empty()) {
+      Write* write = writes.front();
+      size_t count = std::min(written, write->length - write->offset);
+      write->offset += count;
+      written -= count;
+      if (write->offset < write->length) {
+        break;
+      }
+      writes.pop_front();
+      finishWrite(env, write, 0);
+    }
+  } else if ((-res == EAGAIN || -res == EINTR) && !closing) {
+    // the tty filled up again between the poll and the write, or the write was interrupted, retry
+    // like unixWrite does
+    writeError = 0;
+  } else {
+    int code = -res;
+    if (ECANCELED == code && writeError) {
+      code = writeError;
+    }
+    writeError = 0;
+    // the port is unusable or closing, fail everything queued
+    std::deque<Write*> failed;
+    failed.swap(writes);
+    for (Write* write : failed) {
+      finishWrite(env, write, code);
+    }
+  }
+  writeArmed = false;
+  cancelWritePending = false;
+  armWrite();
+  track(-1);
+}
+
+void UringPort::deliver(Napi::Env env) {
+  Napi::HandleScope scope(env);
+  dirty = false;
+  if (!received.empty() && !closing) {
+    Napi::Buffer<char> data = Napi::Buffer<char>::Copy(env, received.data(), received.size());
+    received.clear();
+    deliveries++;
+    call(env, callback, {env.Null(), data, Napi::Number::New(env, static_cast<double>(receivedAt)),
+                         Napi::Number::New(env, static_cast<double>(receivedWakeAt))});
+  }
+  if (readError && !closing) {
+    int code = readError;
+    readError = 0;
+    call(env, callback, {SerialError(code, "Error: %s, cannot read").ToError(env).Value(), env.Undefined()});
+  }
+  if (hungUp && !closing) {
+    hungUp = false;
+    Napi::Error error = Napi::Error::New(env, "Error: Port hung up, cannot read");
+    error.Set("code", "EOF");
+    call(env, callback, {error.Value(), env.Undefined()});
+  }
+  received.clear();
+  track(-1);
+}
+
+// Starts reading. A port that hung up or failed to read stays stopped, its error was delivered once.
+Napi::Value UringPort::start(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (closing || ring->closed()) {
+    Napi::Error::New(env, "Port is closed").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  reading = true;
+  // a stop() that hasn't reached the kernel yet
+  cancelReadPending = false;
+  armRead();
+  return env.Undefined();
+}
+
+// Stops reading, data stays in the kernel until start() is called again. Data already read is still
+// delivered.
+Napi::Value UringPort::stop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  reading = false;
+  if (readArmed && !ring->closed()) {
+    cancel(OP_READ);
+    // now rather than before the loop blocks, data arriving meanwhile would be read
+    ring->submit();
+  }
+  return env.Undefined();
+}
+
+Napi::Value UringPort::discard(const Napi::CallbackInfo& info) {
+  received.clear();
+  return info.Env().Undefined();
+}
+
+Napi::Value UringPort::write(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsBuffer()) {
+    Napi::TypeError::New(env, "First argument must be a buffer").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!info[1].IsFunction()) {
+    Napi::TypeError::New(env, "Second argument must be a function").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (closing || ring->closed()) {
+    Napi::Error::New(env, "Port is closed").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Buffer<char> buffer = info[0].As<Napi::Buffer<char>>();
+  if (0 == buffer.Length()) {
+    Napi::RangeError::New(env, "Cannot write an empty buffer").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  // the buffer is referenced until the kernel is done with it
+  Write* write = new Write();
+  write->buffer = Napi::Persistent(buffer.As<Napi::Object>());
+  write->callback = Napi::Persistent(info[1].As<Napi::Function>());
+  write->data = buffer.Data();
+  write->length = buffer.Length();
+  writes.push_back(write);
+  armWrite();
+  return env.Undefined();
+}
+
+Napi::Value UringPort::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (closing) {
+    return env.Undefined();
+  }
+  closing = true;
+  reading = false;
+  received.clear();
+  if (!ring->closed() && (readArmed || writeArmed)) {
+    if (readArmed) {
+      cancel(OP_READ);
+    }
+    if (writeArmed) {
+      cancel(OP_POLL);
+      cancel(OP_WRITEV);
+    }
+    // before the fd is closed and its number reused
+    ring->submit();
+  }
+  return env.Undefined();
+}
+
+Napi::Value UringPort::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("reads", static_cast<double>(reads));
+  stats.Set("bytes", static_cast<double>(bytes));
+  stats.Set("deliveries", static_cast<double>(deliveries));
+  stats.Set("writes", static_cast<double>(writevs));
+  stats.Set("bytesWritten", static_cast<double>(bytesWritten));
+  stats.Set("buffered", static_cast<double>(received.size()));
+  if (ring) {
+    stats.Set("ringSubmits", static_cast<double>(ring->submits));
+    stats.Set("ringWakeups", static_cast<double>(ring->wakeups));
+  }
+  return stats;
+}
+
+Napi::Value IoUringSupported(const Napi::CallbackInfo& info) {
+  return Napi::Boolean::New(info.Env(), Uring::Supported());
+}
+
+Napi::Object UringPort::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "UringPort", {
+    InstanceMethod<&UringPort::start>("start"),
+    InstanceMethod<&UringPort::stop>("stop"),
+    InstanceMethod<&UringPort::discard>("discard"),
+    InstanceMethod<&UringPort::write>("write"),
+    InstanceMethod<&UringPort::close>("close"),
+    InstanceAccessor<&UringPort::getStats>("stats"),
+  });
+  exports.Set("UringPort", func);
+  exports.Set("ioUringSupported", Napi::Function::New(env, IoUringSupported));
+  return exports;
+}
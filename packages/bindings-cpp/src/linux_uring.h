@@ -0,0 +1,181 @@
+#ifndef PACKAGES_SERIALPORT_SRC_LINUX_URING_H_
+#define PACKAGES_SERIALPORT_SRC_LINUX_URING_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "./addon_data.h"
+
+class UringPort;
+
+// An io_uring shared by all the ports of an environment. Submissions made while JS runs are sent in
+// one io_uring_enter() before the loop blocks, completions are signalled on an eventfd polled on the
+// environment's loop, so a concentrator with many ports costs one wake up per batch of completions.
+class Uring : public LoopHandleOwner {
+ public:
+  // Whether the kernel has everything UringPort needs (multishot reads need linux 6.7), checked once
+  static bool Supported();
+  // The environment's ring, created on first use. Throws when it can't be set up.
+  static std::shared_ptr<Uring> Get(Napi::Env env);
+  ~Uring();
+  void closeHandle() override;
+
+  bool closed() const { return ringFd == -1; }
+  // A zeroed submission queue entry, sent with the next submit(). Null when the queue is full and the
+  // kernel can't take entries yet (EAGAIN or EBUSY while completions are backed up).
+  struct io_uring_sqe* getSqe();
+  // Makes room for `count` entries so a linked chain isn't split across two submits, false when the
+  // queue can't take them yet
+  bool reserve(unsigned count);
+  void submit();
+  // Calls the port's resubmit() from the next prepare, for entries it couldn't get
+  void defer(UringPort* port);
+  // Operations with a completion pending keep the loop alive, like a started Poller
+  void track(int delta);
+  int registerBufferRing(void* ring, unsigned entries, uint16_t* group);
+  void unregisterBufferRing(uint16_t group);
+
+  // Ports with data read during the current reap
+  std::vector<UringPort*> delivering;
+  uint64_t submits = 0;
+  uint64_t wakeups = 0;
+  // CLOCK_MONOTONIC nanoseconds of the eventfd wake up being reaped
+  uint64_t wakeAt = 0;
+
+ private:
+  Uring() {}
+  int ringFd = -1;
+  int eventFd = -1;
+  unsigned entries = 0;
+  void* sqRing = nullptr;
+  size_t sqRingSize = 0;
+  void* cqRing = nullptr;
+  size_t cqRingSize = 0;
+  struct io_uring_sqe* sqes = nullptr;
+  size_t sqesSize = 0;
+  unsigned* sqHead = nullptr;
+  unsigned* sqTail = nullptr;
+  unsigned* sqArray = nullptr;
+  unsigned* sqFlags = nullptr;
+  unsigned sqMask = 0;
+  unsigned* cqHead = nullptr;
+  unsigned* cqTail = nullptr;
+  unsigned cqMask = 0;
+  struct io_uring_cqe* cqes = nullptr;
+  unsigned pendingSubmit = 0;
+  int64_t inflight = 0;
+  std::vector<uint16_t> freeGroups;
+  uint16_t nextGroup = 0;
+  std::vector<UringPort*> deferred;
+
+  uv_poll_t* poll_handle = nullptr;
+  uv_prepare_t* prepare_handle = nullptr;
+
+  napi_env env = nullptr;
+  int setup(uv_loop_t* loop);
+  void release();
+  void reap(Napi::Env env);
+  static void onEvent(uv_poll_t* handle, int status, int events);
+  static void onPrepare(uv_prepare_t* handle);
+  static void onPollClose(uv_handle_t* handle);
+  static void onPrepareClose(uv_handle_t* handle);
+};
+
+// Reads and writes a port through the environment's Uring. Reads are a single multishot read into a
+// ring of provided buffers, re-armed when it ends while the port is reading. Writes are a POLL_ADD(POLLOUT) linked to a
+// writev of everything queued, the port's fd is non blocking and a bare write would fail with EAGAIN.
+//
+// The JS object is kept alive while the kernel still has one of its operations.
+class UringPort : public Napi::ObjectWrap<UringPort> {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit UringPort(const Napi::CallbackInfo &info);
+  ~UringPort();
+
+  // Operation kinds, stored in the low bits of the user_data next to the port's address
+  enum Op { OP_READ = 1, OP_POLL = 2, OP_WRITEV = 3 };
+  void complete(Napi::Env env, unsigned op, int32_t res, uint32_t flags);
+  // Hands the data read during one reap to JS as a single buffer, with the time it was reaped
+  void deliver(Napi::Env env);
+  // Queues what couldn't be queued while the submission queue was full
+  void resubmit();
+
+ private:
+  struct Write {
+    Napi::ObjectReference buffer;
+    Napi::FunctionReference callback;
+    const char* data;
+    size_t length;
+    size_t offset = 0;
+  };
+
+  std::shared_ptr<Uring> ring;
+  int fd = -1;
+  bool closing = false;
+  int outstanding = 0;
+
+  uint16_t group = 0;
+  bool groupRegistered = false;
+  unsigned bufferCount = 16;
+  unsigned bufferSize = 4096;
+  struct io_uring_buf_ring* bufferRing = nullptr;
+  char* buffers = nullptr;
+  uint16_t bufferTail = 0;
+
+  bool reading = false;
+  bool readArmed = false;
+  // Hung up or failed, reads aren't armed again
+  bool ended = false;
+  // Waiting for room in the submission queue
+  bool deferred = false;
+  bool cancelReadPending = false;
+  bool cancelWritePending = false;
+  std::vector<char> received;
+  // CLOCK_MONOTONIC nanoseconds of the completion of the first received read, and of the wake up
+  // that reaped it
+  uint64_t receivedAt = 0;
+  uint64_t receivedWakeAt = 0;
+  int readError = 0;
+  bool hungUp = false;
+  bool dirty = false;
+
+  std::deque<Write*> writes;
+  bool writeArmed = false;
+  int writeError = 0;
+  std::vector<struct iovec> iov;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t reads = 0;
+  uint64_t bytes = 0;
+  uint64_t deliveries = 0;
+  uint64_t writevs = 0;
+  uint64_t bytesWritten = 0;
+
+  void track(int delta);
+  uint64_t tag(Op op) const { return reinterpret_cast<uintptr_t>(this) | op; }
+  void armRead();
+  void armWrite();
+  void cancel(Op op);
+  void defer();
+  void recycle(uint16_t bid);
+  void finishWrite(Napi::Env env, Write* write, int code);
+  void call(Napi::Env env, const Napi::FunctionReference& fn, std::initializer_list<napi_value> args);
+
+  Napi::Value start(const Napi::CallbackInfo& info);
+  Napi::Value stop(const Napi::CallbackInfo& info);
+  Napi::Value discard(const Napi::CallbackInfo& info);
+  Napi::Value write(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+Napi::Value IoUringSupported(const Napi::CallbackInfo& info);
+
+#endif  // PACKAGES_SERIALPORT_SRC_LINUX_URING_H_
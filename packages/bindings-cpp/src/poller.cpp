@@ -0,0 +1,337 @@
+#include <napi.h>
+#include <uv.h>
+#include <string.h>
+#include <algorithm>
+#include "./poller.h"
+#include "./addon_data.h"
+
+Poller::Poller (const Napi::CallbackInfo &info) : Napi::ObjectWrap<Poller>(info)
+  {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  this->fd = info[0].As<Napi::Number>().Int32Value();
+
+  // callback
+  if (!info[1].IsFunction()) {
+    Napi::TypeError::New(env, "Second argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[1].As<Napi::Function>());
+
+  // batch id, optional
+  if (info[2].IsNumber()) {
+    this->batchId = info[2].As<Napi::Number>().Int32Value();
+  }
+
+  this->poll_handle = new uv_poll_t();
+  memset(this->poll_handle, 0, sizeof(uv_poll_t));
+  poll_handle->data = this;
+  // poll on the loop of the thread that created the poller, which may be a worker_thread
+  AddonData* data = env.GetInstanceData<AddonData>();
+  int status = uv_poll_init(data->loop, poll_handle, fd);
+  if (0 != status) {
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  uv_poll_init_success = true;
+  data->addHandleOwner(this);
+}
+
+Poller::~Poller() {
+  // if we call uv_poll_stop after uv_poll_init failed we segfault
+  if (uv_poll_init_success) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  } else {
+    delete poll_handle;
+  }
+  return;
+}
+
+void Poller::closeHandle() {
+  if (0 != batchId && Env().GetInstanceData<AddonData>()->pollBatch) {
+    Env().GetInstanceData<AddonData>()->pollBatch->discard(batchId);
+  }
+  uv_poll_stop(poll_handle);
+  uv_unref(reinterpret_cast<uv_handle_t*> (poll_handle));
+  uv_close(reinterpret_cast<uv_handle_t*> (poll_handle), Poller::onClose);
+  // the handle is freed by onClose
+  poll_handle = nullptr;
+  uv_poll_init_success = false;
+}
+
+void Poller::onClose(uv_handle_t* poll_handle) {
+  // fprintf(stdout, "~Poller is closed\n");
+  // allocated as a uv_poll_t, deleting it through the base type frees the wrong size
+  delete reinterpret_cast<uv_poll_t*>(poll_handle);
+}
+
+// Events can be UV_READABLE | UV_WRITABLE | UV_DISCONNECT
+void Poller::poll(Napi::Env env, int events) {
+  Napi::HandleScope scope(env);
+  // fprintf(stdout, "Poller:poll for %d\n", events);
+  this->events = this->events | events;
+  int status = uv_poll_start(this->poll_handle, events, Poller::onData);
+  if (0 != status) {
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+  }
+  return;
+}
+
+void Poller::stop(Napi::Env env) {
+  Napi::HandleScope scope(env);
+  PollBatch* batch = env.GetInstanceData<AddonData>()->pollBatch;
+  if (0 != batchId && batch) {
+    // events collected before the stop would arrive after the cancellation
+    batch->discard(batchId);
+  }
+  int status = uv_poll_stop(this->poll_handle);
+  if (0 != status) {
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+  }
+  return;
+}
+
+int Poller::_stop() {
+  return uv_poll_stop(poll_handle);
+}
+
+void Poller::onData(uv_poll_t* handle, int status, int events) {
+  Poller* obj = static_cast<Poller*>(handle->data);
+  Napi::Env env = obj->Env();
+  Napi::HandleScope scope(env);
+
+  // if Error
+  if (0 != status) {
+    // fprintf(stdout, "OnData Error status=%s events=%d\n", uv_strerror(status), events);
+    obj->_stop(); // doesn't matter if this errors
+    obj->callback.Call({Napi::Error::New(env, uv_strerror(status)).Value(), env.Undefined()});
+  } else {
+    // fprintf(stdout, "OnData status=%d events=%d subscribed=%d\n", status, events, obj->events);
+    // remove triggered events from the poll
+    int newEvents = obj->events & ~events;
+    obj->poll(env, newEvents);
+    PollBatch* batch = env.GetInstanceData<AddonData>()->pollBatch;
+    if (0 != obj->batchId && batch) {
+      batch->add(obj->batchId, events);
+      return;
+    }
+    obj->callback.Call({env.Null(), Napi::Number::New(env, events)});
+  }
+
+}
+
+Napi::Object Poller::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Poller", {
+    StaticMethod<&Poller::New>("New"),
+    InstanceMethod<&Poller::poll>("poll"),
+    InstanceMethod<&Poller::stop>("stop"),
+    InstanceMethod<&Poller::destroy>("destroy"),
+  });
+
+  env.GetInstanceData<AddonData>()->pollerConstructor = Napi::Persistent(func);
+  exports.Set("Poller", func);
+
+  return PollBatch::Init(env, exports);
+}
+
+Napi::Value Poller::New(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Value  fd = info[0];
+  if (!info[1].IsFunction()) {
+    Napi::TypeError::New(env, "cb must be a function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Function callback = info[1].As<Napi::Function>();
+  Napi::FunctionReference& constructor = info.Env().GetInstanceData<AddonData>()->pollerConstructor;
+  return constructor.New({fd, callback, info[2]});
+}
+
+Napi::Value Poller::poll(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+  Poller* obj = this;
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "events must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int events = info[0].As<Napi::Number>().Int32Value();
+  obj->poll(env, events);
+  return env.Undefined();
+}
+
+Napi::Value Poller::stop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+  this->stop(env);
+  return env.Undefined();
+}
+
+Napi::Value Poller::destroy(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+  Poller* obj = this;
+  // TODO Fix destruction Segfault
+  obj->Reset();
+  // delete obj;
+  return env.Undefined();
+}
+
+inline Napi::FunctionReference & Poller::constructor() {
+  static Napi::FunctionReference my_constructor;
+  // TODO Check if required
+  // my_constructor.SuppressDestruct();
+  return my_constructor;
+}
+
+PollBatch::PollBatch(const Napi::CallbackInfo &info) : Napi::ObjectWrap<PollBatch>(info),
+  context(info.Env(), "node-serialport:PollBatch") {
+  Napi::Env env = info.Env();
+  Napi::HandleScope scope(env);
+
+  // callback
+  if (!info[0].IsFunction()) {
+    Napi::TypeError::New(env, "First argument must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  this->callback = Napi::Persistent(info[0].As<Napi::Function>());
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  if (data->pollBatch) {
+    Napi::Error::New(env, "Pollers are already batched").ThrowAsJavaScriptException();
+    return;
+  }
+  this->check_handle = new uv_check_t();
+  memset(this->check_handle, 0, sizeof(uv_check_t));
+  check_handle->data = this;
+  int status = uv_check_init(data->loop, check_handle);
+  if (0 != status) {
+    delete check_handle;
+    check_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  // only runs while events are pending, and those don't keep the loop alive on their own
+  uv_unref(reinterpret_cast<uv_handle_t*>(check_handle));
+  handle_open = true;
+  data->pollBatch = this;
+  data->addHandleOwner(this);
+}
+
+PollBatch::~PollBatch() {
+  if (handle_open) {
+    Env().GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+}
+
+void PollBatch::closeHandle() {
+  AddonData* data = Env().GetInstanceData<AddonData>();
+  if (data->pollBatch == this) {
+    data->pollBatch = nullptr;
+  }
+  uv_check_stop(check_handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(check_handle), PollBatch::onClose);
+  // the handle is freed by onClose
+  check_handle = nullptr;
+  handle_open = false;
+  checking = false;
+}
+
+void PollBatch::onClose(uv_handle_t* check_handle) {
+  delete reinterpret_cast<uv_check_t*>(check_handle);
+}
+
+void PollBatch::add(int id, int events) {
+  pending.push_back(id);
+  pending.push_back(events);
+  if (!checking) {
+    uv_check_start(check_handle, PollBatch::onCheck);
+    checking = true;
+  }
+}
+
+void PollBatch::discard(int id) {
+  size_t kept = 0;
+  for (size_t i = 0; i < pending.size(); i += 2) {
+    if (pending[i] != id) {
+      pending[kept++] = pending[i];
+      pending[kept++] = pending[i + 1];
+    }
+  }
+  pending.resize(kept);
+}
+
+void PollBatch::onCheck(uv_check_t* handle) {
+  static_cast<PollBatch*>(handle->data)->flush();
+}
+
+void PollBatch::flush() {
+  uv_check_stop(check_handle);
+  checking = false;
+  if (pending.empty()) {
+    return;
+  }
+  Napi::Env env = Env();
+  Napi::HandleScope scope(env);
+  Napi::Int32Array pairs = Napi::Int32Array::New(env, pending.size());
+  memcpy(pairs.Data(), pending.data(), pending.size() * sizeof(int32_t));
+  flushes++;
+  events += pending.size() / 2;
+  largest = std::max(largest, pending.size() / 2);
+  pending.clear();
+  // called through napi directly, MakeCallback() aborts when a worker exits from the callback
+  napi_value args[] = {pairs};
+  napi_value result;
+  if (napi_ok != napi_make_callback(env, context, Value(), callback.Value(), 1, args, &result)) {
+    napi_value error;
+    if (napi_ok == napi_get_and_clear_last_exception(env, &error) && !Napi::Value(env, error).IsUndefined()) {
+      // same as an exception thrown from any other callback
+      napi_fatal_exception(env, error);
+    }
+  }
+}
+
+// Stops batching, returns the events that were still pending
+Napi::Value PollBatch::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Int32Array pairs = Napi::Int32Array::New(env, pending.size());
+  if (!pending.empty()) {
+    memcpy(pairs.Data(), pending.data(), pending.size() * sizeof(int32_t));
+    pending.clear();
+  }
+  if (handle_open) {
+    env.GetInstanceData<AddonData>()->removeHandleOwner(this);
+    closeHandle();
+  }
+  return pairs;
+}
+
+Napi::Value PollBatch::getStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("flushes", static_cast<double>(flushes));
+  stats.Set("events", static_cast<double>(events));
+  stats.Set("largest", static_cast<double>(largest));
+  stats.Set("pending", static_cast<double>(pending.size() / 2));
+  return stats;
+}
+
+Napi::Object PollBatch::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "PollBatch", {
+    InstanceMethod<&PollBatch::close>("close"),
+    InstanceAccessor<&PollBatch::getStats>("stats"),
+  });
+  exports.Set("PollBatch", func);
+  return exports;
+}
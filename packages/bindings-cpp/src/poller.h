@@ -0,0 +1,80 @@
+#ifndef PACKAGES_SERIALPORT_SRC_POLLER_H_
+#define PACKAGES_SERIALPORT_SRC_POLLER_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <vector>
+#include "./addon_data.h"
+
+class Poller : public Napi::ObjectWrap<Poller>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit Poller(const Napi::CallbackInfo &info);
+  static Napi::Value New(const Napi::CallbackInfo& info);
+  static void onData(uv_poll_t* handle, int status, int events);
+  static void onClose(uv_handle_t* poll_handle);
+  ~Poller();
+  void closeHandle() override;
+
+ private:
+  int fd;
+  uv_poll_t* poll_handle = nullptr;
+	Napi::FunctionReference callback;
+  bool uv_poll_init_success = false;
+  // non zero when the poller's events go through the environment's PollBatch
+  int batchId = 0;
+
+  // can this be read off of poll_handle?
+  int events = 0;
+
+  void poll(Napi::Env env, int events);
+  void stop(Napi::Env env);
+  int _stop();
+
+  Napi::Value poll(const Napi::CallbackInfo& info);
+  Napi::Value stop(const Napi::CallbackInfo& info);
+  Napi::Value destroy(const Napi::CallbackInfo& info);
+  static inline Napi::FunctionReference & constructor();
+};
+
+// Collects the events of every poller created with a batch id during one loop iteration and hands
+// them to JS in a single call, as an Int32Array of (id, events) pairs. The pairs are flushed from a
+// check handle, which runs right after the loop has polled, so with many ports one call into JS
+// replaces one per port and event. Errors still go to the poller's own callback.
+//
+// There is at most one per environment. Pollers keep their id when it is closed and fall back to
+// their own callbacks.
+class PollBatch : public Napi::ObjectWrap<PollBatch>, public LoopHandleOwner {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  explicit PollBatch(const Napi::CallbackInfo &info);
+  static void onCheck(uv_check_t* handle);
+  static void onClose(uv_handle_t* check_handle);
+  ~PollBatch();
+  void closeHandle() override;
+
+  void add(int id, int events);
+  // drops the pending events of a poller that stopped
+  void discard(int id);
+
+ private:
+  uv_check_t* check_handle = nullptr;
+  bool handle_open = false;
+  bool checking = false;
+  std::vector<int32_t> pending;
+
+  Napi::FunctionReference callback;
+  Napi::AsyncContext context;
+
+  uint64_t flushes = 0;
+  uint64_t events = 0;
+  size_t largest = 0;
+
+  void flush();
+
+  Napi::Value close(const Napi::CallbackInfo& info);
+  Napi::Value getStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_POLLER_H_
\ No newline at end of file
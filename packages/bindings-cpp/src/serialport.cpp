@@ -1,9 +1,25 @@
 #include "./serialport.h"
+#include "./addon_data.h"
 
 #ifdef __APPLE__
   #include "./darwin_list.h"
 #endif
 
+#ifdef __linux__
+  #include "./linux_list.h"
+  #include "./linux_hotplug.h"
+  #include "./linux_coalescer.h"
+  #include "./linux_uring.h"
+  #include "./linux_capture.h"
+  #include "./linux_pty.h"
+  #include "./linux_bridge.h"
+  #include "./linux_shared.h"
+  #include "./linux_transaction.h"
+  #include "./linux_detect.h"
+  #include "./linux_mock.h"
+  #include "./linux_modem.h"
+#endif
+
 #ifdef WIN32
   #define strncasecmp strnicmp
   #include "./serialport_win.h"
@@ -32,6 +48,15 @@ double getDoubleFromObject(Napi::Object options, std::string key) {
   return getValueFromObject(options, key).ToNumber().DoubleValue();
 }
 
+void setOptionsFromObject(Napi::Object options, SetOptions *data) {
+  data->brk = getBoolFromObject(options, "brk");
+  data->rts = getBoolFromObject(options, "rts");
+  data->cts = getBoolFromObject(options, "cts");
+  data->dtr = getBoolFromObject(options, "dtr");
+  data->dsr = getBoolFromObject(options, "dsr");
+  data->lowLatency = getBoolFromObject(options, "lowLatency");
+}
+
 Napi::Value Open(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   // path
@@ -71,6 +96,9 @@ Napi::Value Open(const Napi::CallbackInfo& info) {
   #ifndef WIN32
     baton->vmin = getIntFromObject(options, "vmin");
     baton->vtime = getIntFromObject(options, "vtime");
+    baton->icanon = getBoolFromObject(options, "icanon");
+    baton->icrnl = getBoolFromObject(options, "icrnl");
+    baton->igncr = getBoolFromObject(options, "igncr");
   #endif
 
   baton->Queue();
@@ -184,17 +212,36 @@ Napi::Value Set(const Napi::CallbackInfo& info) {
 
   SetBaton* baton = new SetBaton(callback);
   baton->fd = fd;
-  baton->brk = getBoolFromObject(options, "brk");
-  baton->rts = getBoolFromObject(options, "rts");
-  baton->cts = getBoolFromObject(options, "cts");
-  baton->dtr = getBoolFromObject(options, "dtr");
-  baton->dsr = getBoolFromObject(options, "dsr");
-  baton->lowLatency = getBoolFromObject(options, "lowLatency");
+  setOptionsFromObject(options, baton);
 
   baton->Queue();
   return env.Undefined();
 }
 
+Napi::Value SetSync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  SetOptions data;
+  data.fd = info[0].As<Napi::Number>().Int32Value();
+  setOptionsFromObject(info[1].ToObject(), &data);
+  if (-1 == setControlLines(&data)) {
+    data.error.ToError(env).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return env.Undefined();
+}
+
 Napi::Value Get(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   // file descriptor
@@ -213,15 +260,37 @@ Napi::Value Get(const Napi::CallbackInfo& info) {
 
   GetBaton* baton = new GetBaton(callback);
   baton->fd = fd;
-  baton->cts = false;
-  baton->dsr = false;
-  baton->dcd = false;
-  baton->lowLatency = false;
 
   baton->Queue();
   return env.Undefined();
 }
 
+Napi::Value GetSync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  GetResult data;
+  data.fd = info[0].As<Napi::Number>().Int32Value();
+  if (-1 == getControlLines(&data)) {
+    data.error.ToError(env).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return GetResultToObject(env, data);
+}
+
+Napi::Object GetResultToObject(Napi::Env env, const GetResult& data) {
+  Napi::Object results = Napi::Object::New(env);
+  results.Set("cts", data.cts);
+  results.Set("dsr", data.dsr);
+  results.Set("dcd", data.dcd);
+  results.Set("lowLatency", data.lowLatency);
+  return results;
+}
+
 Napi::Value GetBaudRate(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   // file descriptor
@@ -240,12 +309,34 @@ Napi::Value GetBaudRate(const Napi::CallbackInfo& info) {
   Napi::Function callback = info[1].As<Napi::Function>();
   GetBaudRateBaton* baton = new GetBaudRateBaton(callback);
   baton->fd = fd;
-  baton->baudRate = 0;
 
   baton->Queue();
   return env.Undefined();
 }
 
+Napi::Value GetBaudRateSync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  GetBaudRateResult data;
+  data.fd = info[0].As<Napi::Number>().Int32Value();
+  if (-1 == getSystemBaudRate(&data)) {
+    data.error.ToError(env).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return GetBaudRateResultToObject(env, data);
+}
+
+Napi::Object GetBaudRateResultToObject(Napi::Env env, const GetBaudRateResult& data) {
+  Napi::Object results = Napi::Object::New(env);
+  results.Set("baudRate", data.baudRate);
+  return results;
+}
+
 Napi::Value Drain(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   // file descriptor
@@ -315,7 +406,25 @@ inline SerialPortRtsMode ToRtsModeEnum(const Napi::String& napistr) {
   return mode;
 }
 
+AddonData::AddonData(Napi::Env env) : workers(std::make_shared<WorkerEnv>()) {
+  napi_get_uv_event_loop(env, &loop);
+}
+
+void AddonData::Cleanup(AddonData* data) {
+  WorkerPool::Get().Abandon(data->workers.get());
+  std::set<LoopHandleOwner*> owners;
+  owners.swap(data->handleOwners);
+  for (LoopHandleOwner* owner : owners) {
+    owner->closeHandle();
+  }
+}
+
 Napi::Object init(Napi::Env env, Napi::Object exports) {
+  AddonData* data = new AddonData(env);
+  env.SetInstanceData<AddonData>(data);
+  WorkerPool::Init(env, exports);
+
+  exports.Set("nativeRevision", Napi::Number::New(env, SERIALPORT_NATIVE_REVISION));
   exports.Set("set", Napi::Function::New(env, Set));
   exports.Set("get", Napi::Function::New(env, Get));
   exports.Set("getBaudRate", Napi::Function::New(env, GetBaudRate));
@@ -324,11 +433,29 @@ Napi::Object init(Napi::Env env, Napi::Object exports) {
   exports.Set("close", Napi::Function::New(env, Close));
   exports.Set("flush", Napi::Function::New(env, Flush));
   exports.Set("drain", Napi::Function::New(env, Drain));
+  exports.Set("setSync", Napi::Function::New(env, SetSync));
+  exports.Set("getSync", Napi::Function::New(env, GetSync));
+  exports.Set("getBaudRateSync", Napi::Function::New(env, GetBaudRateSync));
 
   #ifdef __APPLE__
   exports.Set("list", Napi::Function::New(env, List));
   #endif
 
+  #ifdef __linux__
+  exports.Set("list", Napi::Function::New(env, List));
+  HotplugMonitor::Init(env, exports);
+  ReadCoalescer::Init(env, exports);
+  UringPort::Init(env, exports);
+  PortCapture::Init(env, exports);
+  exports.Set("openPty", Napi::Function::New(env, OpenPty));
+  SerialBridge::Init(env, exports);
+  SharedReader::Init(env, exports);
+  SerialTransactor::Init(env, exports);
+  MockDevice::Init(env, exports);
+  ModemWatcher::Init(env, exports);
+  exports.Set("detectBaud", Napi::Function::New(env, DetectBaud));
+  #endif
+
   #ifdef WIN32
   exports.Set("write", Napi::Function::New(env, Write));
   exports.Set("read", Napi::Function::New(env, Read));
@@ -336,6 +463,9 @@ Napi::Object init(Napi::Env env, Napi::Object exports) {
   #else
   Poller::Init(env, exports);
   #endif
+
+  // Added last so it runs first, before the thread-safe function created above is torn down
+  env.AddCleanupHook(AddonData::Cleanup, data);
   return exports;
 }
 
@@ -13,9 +13,14 @@
 #include <string.h>
 #include <napi.h>
 #include <string>
+#include "./worker_pool.h"
 
 #define ERROR_STRING_SIZE 1088
 
+// Bumped whenever the addon's exports change, dist/serialport-bindings.js refuses a binary built from
+// other sources, such as the stock prebuilds
+#define SERIALPORT_NATIVE_REVISION 2
+
 Napi::Value Open(const Napi::CallbackInfo& info);
 
 Napi::Value Update(const Napi::CallbackInfo& info);
@@ -32,6 +37,12 @@ Napi::Value GetBaudRate(const Napi::CallbackInfo& info);
 
 Napi::Value Drain(const Napi::CallbackInfo& info);
 
+Napi::Value SetSync(const Napi::CallbackInfo& info);
+
+Napi::Value GetSync(const Napi::CallbackInfo& info);
+
+Napi::Value GetBaudRateSync(const Napi::CallbackInfo& info);
+
 enum SerialPortParity {
   SERIALPORT_PARITY_NONE  = 1,
   SERIALPORT_PARITY_MARK  = 2,
@@ -56,10 +67,22 @@ SerialPortParity ToParityEnum(const Napi::String& str);
 SerialPortStopBits ToStopBitEnum(double stopBits);
 SerialPortRtsMode ToRtsModeEnum(const Napi::String& str);
 
-struct OpenBaton : public Napi::AsyncWorker {
-  OpenBaton(Napi::Function& callback) : Napi::AsyncWorker(callback, "node-serialport:OpenBaton"),
-  errorString(), path() {}
-  char errorString[ERROR_STRING_SIZE];
+struct SetOptions;
+struct GetResult;
+struct GetBaudRateResult;
+
+// Implemented per platform, they return -1 and fill `data->error` on failure
+int setControlLines(SetOptions *data);
+int getControlLines(GetResult *data);
+int getSystemBaudRate(GetBaudRateResult *data);
+
+Napi::Object GetResultToObject(Napi::Env env, const GetResult& data);
+Napi::Object GetBaudRateResultToObject(Napi::Env env, const GetBaudRateResult& data);
+
+struct OpenBaton : public SerialWorker {
+  OpenBaton(Napi::Function& callback) : SerialWorker(callback, "node-serialport:OpenBaton"),
+  path() {}
+  SerialError error;
   char path[1024];
   int fd = 0;
   int result = 0;
@@ -77,6 +100,9 @@ struct OpenBaton : public Napi::AsyncWorker {
 #ifndef WIN32
   uint8_t vmin = 0;
   uint8_t vtime = 0;
+  bool icanon = false;
+  bool icrnl = false;
+  bool igncr = false;
 #endif
   void Execute() override;
 
@@ -88,13 +114,12 @@ struct OpenBaton : public Napi::AsyncWorker {
 };
 
 struct ConnectionOptions {
-  ConnectionOptions() : errorString() {}
-  char errorString[ERROR_STRING_SIZE];
+  SerialError error;
   int fd = 0;
   int baudRate = 0;
 };
-struct ConnectionOptionsBaton : ConnectionOptions , Napi::AsyncWorker {
-  ConnectionOptionsBaton(Napi::Function& callback) : ConnectionOptions() , Napi::AsyncWorker(callback, "node-serialport:ConnectionOptionsBaton") {}
+struct ConnectionOptionsBaton : ConnectionOptions , SerialWorker {
+  ConnectionOptionsBaton(Napi::Function& callback) : ConnectionOptions() , SerialWorker(callback, "node-serialport:ConnectionOptionsBaton") {}
 
   void Execute() override;
 
@@ -105,20 +130,26 @@ struct ConnectionOptionsBaton : ConnectionOptions , Napi::AsyncWorker {
   }
 };
 
-struct SetBaton : public Napi::AsyncWorker {
-  SetBaton(Napi::Function& callback) : Napi::AsyncWorker(callback, "node-serialport:SetBaton"),
-  errorString() {}
+// set(), get() and getBaudRate() are single non blocking calls, so they also have synchronous
+// variants that fill these directly on the JS thread instead of going through a worker
+struct SetOptions {
+  SerialError error;
   int fd = 0;
-  int result = 0;
-  char errorString[ERROR_STRING_SIZE];
   bool rts = false;
   bool cts = false;
   bool dtr = false;
   bool dsr = false;
   bool brk = false;
   bool lowLatency = false;
+};
+struct SetBaton : SetOptions, SerialWorker {
+  SetBaton(Napi::Function& callback) : SetOptions(), SerialWorker(callback, "node-serialport:SetBaton") {}
 
-  void Execute() override;
+  void Execute() override {
+    if (-1 == setControlLines(this)) {
+      this->SetError(error);
+    }
+  }
 
   void OnOK() override {
     Napi::Env env = Env();
@@ -127,53 +158,55 @@ struct SetBaton : public Napi::AsyncWorker {
   }
 };
 
-struct GetBaton : public Napi::AsyncWorker {
-  GetBaton(Napi::Function& callback) : Napi::AsyncWorker(callback, "node-serialport:GetBaton"),
-  errorString() {}
+struct GetResult {
+  SerialError error;
   int fd = 0;
-  char errorString[ERROR_STRING_SIZE];
   bool cts = false;
   bool dsr = false;
   bool dcd = false;
   bool lowLatency = false;
+};
+struct GetBaton : GetResult, SerialWorker {
+  GetBaton(Napi::Function& callback) : GetResult(), SerialWorker(callback, "node-serialport:GetBaton") {}
 
-  void Execute() override;
+  void Execute() override {
+    if (-1 == getControlLines(this)) {
+      this->SetError(error);
+    }
+  }
 
   void OnOK() override {
     Napi::Env env = Env();
     Napi::HandleScope scope(env);
-    Napi::Object results = Napi::Object::New(env);
-    results.Set("cts", cts);
-    results.Set("dsr", dsr);
-    results.Set("dcd", dcd);
-    results.Set("lowLatency", lowLatency);
-    Callback().Call({env.Null(), results});
+    Callback().Call({env.Null(), GetResultToObject(env, *this)});
   }
 };
 
-struct GetBaudRateBaton : public Napi::AsyncWorker {
-  GetBaudRateBaton(Napi::Function& callback) : Napi::AsyncWorker(callback, "node-serialport:GetBaudRateBaton"),
-  errorString() {}
+struct GetBaudRateResult {
+  SerialError error;
   int fd = 0;
-  char errorString[ERROR_STRING_SIZE];
   int baudRate = 0;
-
-  void Execute() override;
+};
+struct GetBaudRateBaton : GetBaudRateResult, SerialWorker {
+  GetBaudRateBaton(Napi::Function& callback) : GetBaudRateResult(),
+  SerialWorker(callback, "node-serialport:GetBaudRateBaton") {}
+
+  void Execute() override {
+    if (-1 == getSystemBaudRate(this)) {
+      this->SetError(error);
+    }
+  }
 
   void OnOK() override {
     Napi::Env env = Env();
     Napi::HandleScope scope(env);
-    Napi::Object results = Napi::Object::New(env);
-    (results).Set(Napi::String::New(env, "baudRate"), Napi::Number::New(env, baudRate));
-    Callback().Call({env.Null(),results});
+    Callback().Call({env.Null(), GetBaudRateResultToObject(env, *this)});
   }
 };
 
-struct VoidBaton : public Napi::AsyncWorker {
-  VoidBaton(Napi::Function& callback, const char *resource_name) : Napi::AsyncWorker(callback, resource_name),
-  errorString() {}
+struct VoidBaton : public SerialWorker {
+  VoidBaton(Napi::Function& callback, const char *resource_name) : SerialWorker(callback, resource_name) {}
   int fd = 0;
-  char errorString[ERROR_STRING_SIZE];
 
   void OnOK() override {
     Napi::Env env = Env();
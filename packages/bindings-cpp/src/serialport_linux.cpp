@@ -0,0 +1,190 @@
+#if defined(__linux__)
+#include "./serialport_linux.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <asm/ioctls.h>
+#include <asm/termbits.h>
+#include <linux/serial.h>
+
+static void setSpeed(struct termios2* t, const int baudConstant, const unsigned int baudrate) {
+  t->c_cflag &= ~CBAUD;
+  t->c_cflag |= (baudConstant == -1) ? BOTHER : baudConstant;
+  t->c_ospeed = t->c_ispeed = baudrate;
+}
+
+// Within the 2% the kernel allows when it matches a rate to a Bxxx constant
+static bool closeTo(const unsigned int speed, const unsigned int baudrate) {
+  unsigned int diff = speed > baudrate ? speed - baudrate : baudrate - speed;
+  return diff <= baudrate / 50;
+}
+
+// ioctl() reports success if any of the changes were made, read the baud rate back to be sure. Drivers
+// quietly adjust other flags (CRTSCTS, parity on some USB adapters) and may report a BOTHER rate as a
+// Bxxx constant, so only the speed itself is checked, the rest stays best effort.
+static int verifyBaudRate(const int fd, const unsigned int baudrate) {
+  struct termios2 t;
+  if (ioctl(fd, TCGETS2, &t) == -1) {
+    return -1;
+  }
+  // an input speed of 0 means the same as the output speed
+  if (!closeTo(t.c_ospeed, baudrate) || (0 != t.c_ispeed && !closeTo(t.c_ispeed, baudrate))) {
+    errno = EINVAL;
+    return -3;
+  }
+  return 0;
+}
+
+// Applies every setting and the baud rate (standard or custom) with a single TCSETSF2, which also
+// discards pending input, then reads the baud rate back
+int linuxApplyTermios(const int fd, const LinuxTermios* options, const int baudConstant, const unsigned int baudrate) {
+  struct termios2 t;
+  memset(&t, 0, sizeof(t));
+  t.c_iflag = options->iflag;
+  t.c_oflag = options->oflag;
+  t.c_cflag = options->cflag;
+  t.c_lflag = options->lflag;
+  t.c_line = options->line;
+  memcpy(t.c_cc, options->cc, sizeof(t.c_cc) < sizeof(options->cc) ? sizeof(t.c_cc) : sizeof(options->cc));
+  setSpeed(&t, baudConstant, baudrate);
+
+  if (ioctl(fd, TCSETSF2, &t) == -1) {
+    return -2;
+  }
+
+  return verifyBaudRate(fd, baudrate);
+}
+
+// Changes only the baud rate, throwing away anything buffered at the old rate
+int linuxSetBaudRate(const int fd, const int baudConstant, const unsigned int baudrate) {
+  struct termios2 t;
+
+  if (ioctl(fd, TCGETS2, &t) == -1) {
+    return -1;
+  }
+
+  setSpeed(&t, baudConstant, baudrate);
+
+  ioctl(fd, TCFLSH, TCIOFLUSH);
+  if (ioctl(fd, TCSETS2, &t) == -1) {
+    return -2;
+  }
+
+  return verifyBaudRate(fd, baudrate);
+}
+
+// Uses the termios2 interface to set nonstandard baud rates
+int linuxSetCustomBaudRate(const int fd, const unsigned int baudrate) {
+    struct termios2 t;
+
+    if (ioctl(fd, TCGETS2, &t) == -1) {
+      return -1;
+    }
+
+    t.c_cflag &= ~CBAUD;
+    t.c_cflag |= BOTHER;
+    t.c_ospeed = t.c_ispeed = baudrate;
+
+    if (ioctl(fd, TCSETS2, &t) == -1) {
+      return -2;
+    }
+
+    return 0;
+}
+
+// Uses termios2 interface to retrieve system reported baud rate
+int linuxGetSystemBaudRate(const int fd, int* const outbaud) {
+  struct termios2 t;
+
+  if (ioctl(fd, TCGETS2, &t) == -1) {
+    return -1;
+  }
+
+  *outbaud = static_cast<int>(t.c_ospeed);
+
+  return 0;
+}
+
+int linuxSetLowLatencyMode(const int fd, const bool enable) {
+  struct serial_struct ss;
+
+  if (ioctl(fd, TIOCGSERIAL, &ss) == -1) {
+    return -1;
+  }
+
+  if ((ss.flags & ASYNC_LOW_LATENCY) == enable) {
+    return 0;
+  }
+
+  if (enable) {
+    ss.flags |= ASYNC_LOW_LATENCY;
+  } else {
+    ss.flags &= ~ASYNC_LOW_LATENCY;
+  }
+
+  if (ioctl(fd, TIOCSSERIAL, &ss) == -1) {
+    return -2;
+  }
+
+  return 0;
+}
+
+int linuxGetLowLatencyMode(const int fd, bool* const enabled) {
+  struct serial_struct ss;
+
+  if (ioctl(fd, TIOCGSERIAL, &ss) == -1) {
+    return -1;
+  }
+
+  *enabled = ss.flags & ASYNC_LOW_LATENCY;
+
+  return 0;
+}
+
+static_assert(sizeof(struct termios2) <= sizeof(LinuxSavedTermios::data), "LinuxSavedTermios is too small");
+
+int linuxSaveTermios(const int fd, LinuxSavedTermios* const saved) {
+  struct termios2 t;
+
+  if (ioctl(fd, TCGETS2, &t) == -1) {
+    return -1;
+  }
+
+  memcpy(saved->data, &t, sizeof(t));
+
+  return 0;
+}
+
+int linuxRestoreTermios(const int fd, const LinuxSavedTermios* const saved) {
+  struct termios2 t;
+
+  memcpy(&t, saved->data, sizeof(t));
+
+  if (ioctl(fd, TCSETS2, &t) == -1) {
+    return -2;
+  }
+
+  return 0;
+}
+
+// Bytes received with a framing or parity error read as 0377 0 <byte>, a break as 0377 0 0 and a real
+// 0377 as 0377 0377, so the errors can be counted
+int linuxMarkInputErrors(const int fd) {
+  struct termios2 t;
+
+  if (ioctl(fd, TCGETS2, &t) == -1) {
+    return -1;
+  }
+
+  t.c_iflag |= INPCK | PARMRK;
+  t.c_iflag &= ~(IGNPAR | IGNBRK | BRKINT | ISTRIP);
+
+  if (ioctl(fd, TCSETS2, &t) == -1) {
+    return -2;
+  }
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef PACKAGES_SERIALPORT_SRC_SERIALPORT_LINUX_H_
+#define PACKAGES_SERIALPORT_SRC_SERIALPORT_LINUX_H_
+
+// The termios fields built by setup(). <termios.h> and <asm/termbits.h> can't be included together
+// so the termios2 helpers take this instead of a struct termios.
+struct LinuxTermios {
+  unsigned int iflag;
+  unsigned int oflag;
+  unsigned int cflag;
+  unsigned int lflag;
+  unsigned char line;
+  unsigned char cc[32];
+};
+
+int linuxApplyTermios(const int fd, const LinuxTermios* options, const int baudConstant, const unsigned int baudrate);
+int linuxSetBaudRate(const int fd, const int baudConstant, const unsigned int baudrate);
+int linuxSetCustomBaudRate(const int fd, const unsigned int baudrate);
+int linuxGetSystemBaudRate(const int fd, int* const outbaud);
+int linuxSetLowLatencyMode(const int fd, const bool enable);
+
+// Room for a struct termios2, which can't be declared where <termios.h> is used
+struct LinuxSavedTermios {
+  unsigned char data[64];
+};
+
+int linuxSaveTermios(const int fd, LinuxSavedTermios* const saved);
+int linuxRestoreTermios(const int fd, const LinuxSavedTermios* const saved);
+int linuxMarkInputErrors(const int fd);
+int linuxGetLowLatencyMode(const int fd, bool* const enabled);
+
+#endif  // PACKAGES_SERIALPORT_SRC_SERIALPORT_LINUX_H_
+
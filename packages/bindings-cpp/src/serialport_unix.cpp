@@ -0,0 +1,471 @@
+#include "serialport_unix.h"
+#include "serialport.h"
+
+#include <sys/file.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <termios.h>
+
+#ifdef __APPLE__
+#include <AvailabilityMacros.h>
+#include <sys/param.h>
+#endif
+
+#if defined(MAC_OS_X_VERSION_10_4) && (MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_4)
+#include <sys/ioctl.h>
+#include <IOKit/serial/ioss.h>
+
+#elif defined(__NetBSD__)
+#include <sys/ioctl.h>
+
+#elif defined(__OpenBSD__)
+#include <sys/ioctl.h>
+
+#elif defined(__linux__)
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include "serialport_linux.h"
+#endif
+
+int ToStopBitsConstant(SerialPortStopBits stopBits);
+
+std::string SerialError::Message() const {
+  char message[ERROR_STRING_SIZE];
+  if (system) {
+    if (text != nullptr) {
+      snprintf(message, sizeof(message), format, strerror(code), text);
+    } else {
+      snprintf(message, sizeof(message), format, strerror(code), arg);
+    }
+  } else if (text != nullptr) {
+    snprintf(message, sizeof(message), format, text);
+  } else {
+    snprintf(message, sizeof(message), format, arg);
+  }
+  return message;
+}
+
+int ToBaudConstant(int baudRate) {
+  switch (baudRate) {
+    case 0: return B0;
+    case 50: return B50;
+    case 75: return B75;
+    case 110: return B110;
+    case 134: return B134;
+    case 150: return B150;
+    case 200: return B200;
+    case 300: return B300;
+    case 600: return B600;
+    case 1200: return B1200;
+    case 1800: return B1800;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+#if defined(__linux__)
+    case 460800: return B460800;
+    case 500000: return B500000;
+    case 576000: return B576000;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1152000: return B1152000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    case 2500000: return B2500000;
+    case 3000000: return B3000000;
+    case 3500000: return B3500000;
+    case 4000000: return B4000000;
+#endif
+  }
+  return -1;
+}
+
+int ToDataBitsConstant(int dataBits) {
+  switch (dataBits) {
+    case 8: default: return CS8;
+    case 7: return CS7;
+    case 6: return CS6;
+    case 5: return CS5;
+  }
+  return -1;
+}
+
+void OpenBaton::Execute() {
+
+  int flags = (O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC | O_SYNC);
+  int fd = open(path, flags);
+
+  if (-1 == fd) {
+    this->SetError(SerialError(errno, "Error: %s, cannot open %s", path));
+    return;
+  }
+
+  if (-1 == setup(fd, this)) {
+    this->SetError(error);
+    close(fd);
+    return;
+  }
+
+  result = fd;
+}
+
+void ConnectionOptionsBaton::Execute() {
+  if (-1 == setBaudRate(this)) {
+    this->SetError(error);
+  }
+}
+
+// Sets the baud rate on `options` and applies them with a single call, then checks they took effect
+static int applyOptions(int fd, struct termios *options, int requestedBaudRate, SerialError *error) {
+  // lookup the standard baudrates from the table
+  int baudRate = ToBaudConstant(requestedBaudRate);
+
+  // On linux termios2 sets standard and custom rates alike, TCSETSF2 also discards pending input
+  #if defined(__linux__)
+    LinuxTermios linuxOptions;
+    linuxOptions.iflag = options->c_iflag;
+    linuxOptions.oflag = options->c_oflag;
+    linuxOptions.cflag = options->c_cflag;
+    linuxOptions.lflag = options->c_lflag;
+    linuxOptions.line = options->c_line;
+    memset(linuxOptions.cc, 0, sizeof(linuxOptions.cc));
+    memcpy(linuxOptions.cc, options->c_cc, sizeof(options->c_cc) < sizeof(linuxOptions.cc) ?
+      sizeof(options->c_cc) : sizeof(linuxOptions.cc));
+
+    int err = linuxApplyTermios(fd, &linuxOptions, baudRate, requestedBaudRate);
+    if (err == -2) {
+      *error = SerialError(errno, "Error: %s || while setting baud rate of %d", requestedBaudRate);
+      return -1;
+    } else if (err == -1) {
+      *error = SerialError(errno, "Error: %s || while retrieving termios2 info");
+      return -1;
+    } else if (err == -3) {
+      *error = SerialError("Error: baud rate of %d was not applied by the driver", requestedBaudRate);
+      return -1;
+    }
+    return 1;
+  #else
+    bool customBaudRate = false;
+    if (-1 == baudRate) {
+      // On OS X, starting with Tiger, we can set a custom baud rate with ioctl after the other settings
+      #if defined(MAC_OS_X_VERSION_10_4) && (MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_4)
+        customBaudRate = true;
+      #else
+        *error = SerialError("Error baud rate of %d is not supported on your platform", requestedBaudRate);
+        return -1;
+      #endif
+    } else {
+      cfsetospeed(options, baudRate);
+      cfsetispeed(options, baudRate);
+    }
+
+    // TCSAFLUSH throws away unread input as part of the same call.
+    // The return value isn't trusted since this also fails on OSX, the read back below is what counts.
+    tcsetattr(fd, TCSAFLUSH, options);
+
+    #if defined(MAC_OS_X_VERSION_10_4) && (MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_4)
+      if (customBaudRate) {
+        speed_t speed = requestedBaudRate;
+        if (-1 == ioctl(fd, IOSSIOSPEED, &speed)) {
+          *error = SerialError(errno, "Error: %s calling ioctl(.., IOSSIOSPEED, %d )", requestedBaudRate);
+          return -1;
+        }
+      }
+    #endif
+
+    // tcsetattr() returns success if any of the requested changes could be made, check the baud rate took.
+    // Other flags stay best effort, drivers adjust them quietly.
+    if (!customBaudRate) {
+      struct termios applied;
+      if (-1 == tcgetattr(fd, &applied)) {
+        *error = SerialError(errno, "Error: %s, cannot get attributes");
+        return -1;
+      }
+      if (cfgetospeed(&applied) != static_cast<speed_t>(baudRate)) {
+        *error = SerialError("Error: baud rate of %d was not applied by the driver", requestedBaudRate);
+        return -1;
+      }
+    }
+    return 1;
+  #endif
+}
+
+int setup(int fd, OpenBaton *data) {
+  int dataBits = ToDataBitsConstant(data->dataBits);
+  if (-1 == dataBits) {
+    data->error = SerialError("Invalid data bits setting %d", data->dataBits);
+    return -1;
+  }
+
+  // Snow Leopard doesn't have O_CLOEXEC
+  #ifndef O_CLOEXEC
+  if (-1 == fcntl(fd, F_SETFD, FD_CLOEXEC)) {
+    data->error = SerialError(errno, "Error %s Cannot open %s", data->path);
+    return -1;
+  }
+  #endif
+
+  // Take the lock before touching the settings of a port someone else may own
+  if (data->lock) {
+    if (-1 == flock(fd, LOCK_EX | LOCK_NB)) {
+      data->error = SerialError(errno, "Error %s Cannot lock port");
+      return -1;
+    }
+  }
+
+  // Get port configuration for modification
+  struct termios options;
+  if (-1 == tcgetattr(fd, &options)) {
+    data->error = SerialError(errno, "Error %s Cannot get attributes of %s", data->path);
+    return -1;
+  }
+
+  // IGNPAR: ignore bytes with parity errors
+  options.c_iflag = IGNPAR;
+
+  // ICRNL: map CR to NL (otherwise a CR input on the other computer will not terminate input)
+  if (data->icrnl) {
+    options.c_iflag |= ICRNL;
+  }
+  // IGNCR: drop CR, for CRLF terminated lines. Takes precedence over ICRNL.
+  if (data->igncr) {
+    options.c_iflag |= IGNCR;
+  }
+  // otherwise make device raw (no other input processing)
+
+  // Specify data bits
+  options.c_cflag &= ~CSIZE;
+  options.c_cflag |= dataBits;
+
+  options.c_cflag &= ~(CRTSCTS);
+
+  if (data->rtscts) {
+    options.c_cflag |= CRTSCTS;
+    // evaluate specific flow control options
+  }
+
+  options.c_iflag &= ~(IXON | IXOFF | IXANY);
+
+  if (data->xon) {
+    options.c_iflag |= IXON;
+  }
+
+  if (data->xoff) {
+    options.c_iflag |= IXOFF;
+  }
+
+  if (data->xany) {
+    options.c_iflag |= IXANY;
+  }
+
+  switch (data->parity) {
+  case SERIALPORT_PARITY_NONE:
+    options.c_cflag &= ~PARENB;
+    // options.c_cflag &= ~CSTOPB;
+    // options.c_cflag &= ~CSIZE;
+    // options.c_cflag |= CS8;
+    break;
+  case SERIALPORT_PARITY_ODD:
+    options.c_cflag |= PARENB;
+    options.c_cflag |= PARODD;
+    // options.c_cflag &= ~CSTOPB;
+    // options.c_cflag &= ~CSIZE;
+    // options.c_cflag |= CS7;
+    break;
+  case SERIALPORT_PARITY_EVEN:
+    options.c_cflag |= PARENB;
+    options.c_cflag &= ~PARODD;
+    // options.c_cflag &= ~CSTOPB;
+    // options.c_cflag &= ~CSIZE;
+    // options.c_cflag |= CS7;
+    break;
+  default:
+    data->error = SerialError("Invalid parity setting %d", data->parity);
+    return -1;
+  }
+
+  switch (data->stopBits) {
+  case SERIALPORT_STOPBITS_ONE:
+    options.c_cflag &= ~CSTOPB;
+    break;
+  case SERIALPORT_STOPBITS_TWO:
+    options.c_cflag |= CSTOPB;
+    break;
+  default:
+    data->error = SerialError("Invalid stop bits setting %d", data->stopBits);
+    return -1;
+  }
+
+  options.c_cflag |= CLOCAL;  // ignore status lines
+  options.c_cflag |= CREAD;   // enable receiver
+  if (data->hupcl) {
+    options.c_cflag |= HUPCL;  // drop DTR (i.e. hangup) on close
+  }
+
+  // Raw output
+  options.c_oflag = 0;
+
+  // ICANON makes partial lines not readable, each read() returns at most one line.
+  // It works with ICRNL.
+  if (data->icanon) {
+    options.c_lflag = ICANON;
+    // Without ISIG and IEXTEN these are the only special characters left, pass them through as data.
+    // VMIN and VTIME are ignored in canonical mode and share slots with VEOF and VEOL on some systems.
+    options.c_cc[VEOF] = _POSIX_VDISABLE;
+    options.c_cc[VEOL] = _POSIX_VDISABLE;
+    options.c_cc[VEOL2] = _POSIX_VDISABLE;
+    options.c_cc[VERASE] = _POSIX_VDISABLE;
+    options.c_cc[VKILL] = _POSIX_VDISABLE;
+  } else {
+    options.c_lflag = 0;
+    options.c_cc[VMIN]= data->vmin;
+    options.c_cc[VTIME]= data->vtime;
+  }
+
+  // Everything including the baud rate is applied in one go and then verified
+  return applyOptions(fd, &options, data->baudRate, &data->error);
+}
+
+int setBaudRate(ConnectionOptions *data) {
+  // lookup the standard baudrates from the table
+  int baudRate = ToBaudConstant(data->baudRate);
+  int fd = data->fd;
+
+  #if defined(__linux__)
+    int err = linuxSetBaudRate(fd, baudRate, data->baudRate);
+    if (err == -1) {
+      data->error = SerialError(errno, "Error: %s || while retrieving termios2 info");
+      return -1;
+    } else if (err == -2) {
+      data->error = SerialError(errno, "Error: %s || while setting baud rate of %d", data->baudRate);
+      return -1;
+    } else if (err == -3) {
+      data->error = SerialError("Error: baud rate of %d was not applied by the driver", data->baudRate);
+      return -1;
+    }
+    return 1;
+  #else
+    // get port options
+    struct termios options;
+    if (-1 == tcgetattr(fd, &options)) {
+      data->error = SerialError(errno, "Error: %s setting custom baud rate of %d", data->baudRate);
+      return -1;
+    }
+
+    // throw away all the buffered data
+    tcflush(fd, TCIOFLUSH);
+    return applyOptions(fd, &options, data->baudRate, &data->error);
+  #endif
+}
+
+void CloseBaton::Execute() {
+
+  if (-1 == close(fd)) {
+    this->SetError(SerialError(errno, "Error: %s, unable to close fd %d", fd));
+  }
+}
+
+int setControlLines(SetOptions *data) {
+  int fd = data->fd;
+  int bits;
+  ioctl(fd, TIOCMGET, &bits);
+
+  bits &= ~(TIOCM_RTS | TIOCM_CTS | TIOCM_DTR | TIOCM_DSR);
+
+  if (data->rts) {
+    bits |= TIOCM_RTS;
+  }
+
+  if (data->cts) {
+    bits |= TIOCM_CTS;
+  }
+
+  if (data->dtr) {
+    bits |= TIOCM_DTR;
+  }
+
+  if (data->dsr) {
+    bits |= TIOCM_DSR;
+  }
+
+  int result = 0;
+  if (data->brk) {
+    result = ioctl(fd, TIOCSBRK, NULL);
+  } else {
+    result = ioctl(fd, TIOCCBRK, NULL);
+  }
+
+  if (-1 == result) {
+    data->error = SerialError(errno, "Error: %s, cannot set");
+    return -1;
+  }
+
+  if (-1 == ioctl(fd, TIOCMSET, &bits)) {
+    data->error = SerialError(errno, "Error: %s, cannot set");
+    return -1;
+  }
+
+  #if defined(__linux__)
+  // Failing to change low latency mode has never been reported, plenty of drivers don't support it
+  linuxSetLowLatencyMode(fd, data->lowLatency);
+  #endif
+  return 1;
+}
+
+int getControlLines(GetResult *data) {
+  int bits;
+  if (-1 == ioctl(data->fd, TIOCMGET, &bits)) {
+    data->error = SerialError(errno, "Error: %s, cannot get");
+    return -1;
+  }
+
+  data->cts = bits & TIOCM_CTS;
+  data->dsr = bits & TIOCM_DSR;
+  data->dcd = bits & TIOCM_CD;
+
+  #if defined(__linux__) && defined(ASYNC_LOW_LATENCY)
+  bool lowlatency = false;
+  // Try to get low latency info, but we don't care if fails (a failure state will still return lowlatency = false)
+  linuxGetLowLatencyMode(data->fd, &lowlatency);
+  data->lowLatency = lowlatency;
+  #else
+  data->lowLatency = false;
+  #endif
+  return 1;
+}
+
+int getSystemBaudRate(GetBaudRateResult *data) {
+  #if defined(__linux__) && defined(ASYNC_SPD_CUST)
+  int outbaud = -1;
+  if (-1 == linuxGetSystemBaudRate(data->fd, &outbaud)) {
+    data->error = SerialError(errno, "Error: %s, cannot get baud rate");
+    return -1;
+  }
+  data->baudRate = outbaud;
+  return 1;
+  #else
+  data->error = SerialError("Error: System baud rate check not implemented on this platform");
+  return -1;
+  #endif
+}
+
+void FlushBaton::Execute() {
+
+  if (-1 == tcflush(fd, TCIOFLUSH)) {
+    this->SetError(SerialError(errno, "Error: %s, cannot flush"));
+    return;
+  }
+}
+
+void DrainBaton::Execute() {
+
+  if (-1 == tcdrain(fd)) {
+    this->SetError(SerialError(errno, "Error: %s, cannot drain"));
+    return;
+  }
+}
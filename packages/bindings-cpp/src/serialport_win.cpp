@@ -1,5 +1,6 @@
 #include "./serialport.h"
 #include "./serialport_win.h"
+#include "./addon_data.h"
 #include <napi.h>
 #include <uv.h>
 #include <list>
@@ -72,14 +73,27 @@ void ErrorCodeToString(const char* prefix, int errorCode, char *errorStr) {
   }
 }
 
+std::string SerialError::Message() const {
+  char prefix[ERROR_STRING_SIZE];
+  if (text != nullptr) {
+    _snprintf_s(prefix, sizeof(prefix), _TRUNCATE, format, text);
+  } else {
+    _snprintf_s(prefix, sizeof(prefix), _TRUNCATE, format, arg);
+  }
+  if (!system) {
+    return prefix;
+  }
+  char message[ERROR_STRING_SIZE];
+  ErrorCodeToString(prefix, code, message);
+  return message;
+}
+
 void AsyncCloseCallback(uv_handle_t* handle) {
   uv_async_t* async = reinterpret_cast<uv_async_t*>(handle);
   delete async;
 }
 
 void OpenBaton::Execute() {
-  char originalPath[1024];
-  strncpy_s(originalPath, sizeof(originalPath), path, _TRUNCATE);
   // path is char[1024] but on Windows it has the form "COMx\0" or "COMxx\0"
   // We want to prepend "\\\\.\\" to it before we call CreateFile
   strncpy(path + 20, path, 10);
@@ -101,11 +115,8 @@ void OpenBaton::Execute() {
     NULL);
 
   if (file == INVALID_HANDLE_VALUE) {
-    DWORD errorCode = GetLastError();
-    char temp[100];
-    _snprintf_s(temp, sizeof(temp), _TRUNCATE, "Opening %s", originalPath);
-    ErrorCodeToString(temp, errorCode, errorString);
-    this->SetError(errorString);
+    // path + 4 is the original "COMx" name
+    this->SetError(SerialError(GetLastError(), "Opening %s", path + 4));
     return;
   }
 
@@ -114,8 +125,7 @@ void OpenBaton::Execute() {
   dcb.DCBlength = sizeof(DCB);
 
   if (!GetCommState(file, &dcb)) {
-    ErrorCodeToString("Open (GetCommState)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Open (GetCommState)"));
     CloseHandle(file);
     return;
   }
@@ -197,8 +207,7 @@ void OpenBaton::Execute() {
   }
 
   if (!SetCommState(file, &dcb)) {
-    ErrorCodeToString("Open (SetCommState)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Open (SetCommState)"));
     CloseHandle(file);
     return;
   }
@@ -213,8 +222,7 @@ void OpenBaton::Execute() {
   commTimeouts.WriteTotalTimeoutMultiplier = 0;  // Variable part of write timeout (per byte)
 
   if (!SetCommTimeouts(file, &commTimeouts)) {
-    ErrorCodeToString("Open (SetCommTimeouts)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Open (SetCommTimeouts)"));
     CloseHandle(file);
     return;
   }
@@ -232,86 +240,84 @@ void ConnectionOptionsBaton::Execute() {
   dcb.DCBlength = sizeof(DCB);
 
   if (!GetCommState(int2handle(fd), &dcb)) {
-    ErrorCodeToString("Update (GetCommState)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Update (GetCommState)"));
     return;
   }
 
   dcb.BaudRate = baudRate;
 
   if (!SetCommState(int2handle(fd), &dcb)) {
-    ErrorCodeToString("Update (SetCommState)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Update (SetCommState)"));
     return;
   }
 }
 
-void SetBaton::Execute() {
-  if (rts) {
-    EscapeCommFunction(int2handle(fd), SETRTS);
+int setControlLines(SetOptions *data) {
+  HANDLE handle = int2handle(data->fd);
+  if (data->rts) {
+    EscapeCommFunction(handle, SETRTS);
   } else {
-    EscapeCommFunction(int2handle(fd), CLRRTS);
+    EscapeCommFunction(handle, CLRRTS);
   }
 
-  if (dtr) {
-    EscapeCommFunction(int2handle(fd), SETDTR);
+  if (data->dtr) {
+    EscapeCommFunction(handle, SETDTR);
   } else {
-    EscapeCommFunction(int2handle(fd), CLRDTR);
+    EscapeCommFunction(handle, CLRDTR);
   }
 
-  if (brk) {
-    EscapeCommFunction(int2handle(fd), SETBREAK);
+  if (data->brk) {
+    EscapeCommFunction(handle, SETBREAK);
   } else {
-    EscapeCommFunction(int2handle(fd), CLRBREAK);
+    EscapeCommFunction(handle, CLRBREAK);
   }
 
   DWORD bits = 0;
 
-  GetCommMask(int2handle(fd), &bits);
+  GetCommMask(handle, &bits);
 
   bits &= ~(EV_CTS | EV_DSR);
 
-  if (cts) {
+  if (data->cts) {
     bits |= EV_CTS;
   }
 
-  if (dsr) {
+  if (data->dsr) {
     bits |= EV_DSR;
   }
 
-  if (!SetCommMask(int2handle(fd), bits)) {
-    ErrorCodeToString("Setting options on COM port (SetCommMask)", GetLastError(), errorString);
-    this->SetError(errorString);
-    return;
+  if (!SetCommMask(handle, bits)) {
+    data->error = SerialError(GetLastError(), "Setting options on COM port (SetCommMask)");
+    return -1;
   }
+  return 1;
 }
 
-void GetBaton::Execute() {
+int getControlLines(GetResult *data) {
   DWORD bits = 0;
-  if (!GetCommModemStatus(int2handle(fd), &bits)) {
-    ErrorCodeToString("Getting control settings on COM port (GetCommModemStatus)", GetLastError(), errorString);
-    this->SetError(errorString);
-    return;
+  if (!GetCommModemStatus(int2handle(data->fd), &bits)) {
+    data->error = SerialError(GetLastError(), "Getting control settings on COM port (GetCommModemStatus)");
+    return -1;
   }
 
-  cts = bits & MS_CTS_ON;
-  dsr = bits & MS_DSR_ON;
-  dcd = bits & MS_RLSD_ON;
+  data->cts = bits & MS_CTS_ON;
+  data->dsr = bits & MS_DSR_ON;
+  data->dcd = bits & MS_RLSD_ON;
+  return 1;
 }
 
-void GetBaudRateBaton::Execute() {
-
+int getSystemBaudRate(GetBaudRateResult *data) {
   DCB dcb = { 0 };
   SecureZeroMemory(&dcb, sizeof(DCB));
   dcb.DCBlength = sizeof(DCB);
 
-  if (!GetCommState(int2handle(fd), &dcb)) {
-    ErrorCodeToString("Getting baud rate (GetCommState)", GetLastError(), errorString);
-    this->SetError(errorString);
-    return;
+  if (!GetCommState(int2handle(data->fd), &dcb)) {
+    data->error = SerialError(GetLastError(), "Getting baud rate (GetCommState)");
+    return -1;
   }
 
-  baudRate = static_cast<int>(dcb.BaudRate);
+  data->baudRate = static_cast<int>(dcb.BaudRate);
+  return 1;
 }
 
 bool IsClosingHandle(int fd) {
@@ -424,7 +430,7 @@ Napi::Value Write(const Napi::CallbackInfo& info) {
   baton->complete = false;
 
   uv_async_t* async = new uv_async_t;
-  uv_async_init(uv_default_loop(), async, EIO_AfterWrite);
+  uv_async_init(env.GetInstanceData<AddonData>()->loop, async, EIO_AfterWrite);
   async->data = baton;
   // WriteFileEx requires a thread that can block. Create a new thread to
   // run the write operation, saving the handle so it can be deallocated later.
@@ -611,7 +617,7 @@ Napi::Value Read(const Napi::CallbackInfo& info) {
   baton->complete = false;
 
   uv_async_t* async = new uv_async_t;
-  uv_async_init(uv_default_loop(), async, EIO_AfterRead);
+  uv_async_init(env.GetInstanceData<AddonData>()->loop, async, EIO_AfterRead);
   async->data = baton;
   baton->hThread = CreateThread(NULL, 0, ReadThread, async, 0, NULL);
   // ReadFileEx requires a thread that can block. Create a new thread to
@@ -632,8 +638,7 @@ void CloseBaton::Execute() {
     pCancelIoEx(int2handle(fd), NULL);
   }
   if (!CloseHandle(int2handle(fd))) {
-    ErrorCodeToString("Closing connection (CloseHandle)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Closing connection (CloseHandle)"));
     return;
   }
 }
@@ -949,16 +954,14 @@ void setIfNotEmpty(Napi::Object item, std::string key, const wchar_t *value) {
 void FlushBaton::Execute() {
   DWORD purge_all = PURGE_RXCLEAR | PURGE_TXABORT | PURGE_TXCLEAR;
   if (!PurgeComm(int2handle(fd), purge_all)) {
-    ErrorCodeToString("Flushing connection (PurgeComm)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Flushing connection (PurgeComm)"));
     return;
   }
 }
 
 void DrainBaton::Execute() {
   if (!FlushFileBuffers(int2handle(fd))) {
-    ErrorCodeToString("Draining connection (FlushFileBuffers)", GetLastError(), errorString);
-    this->SetError(errorString);
+    this->SetError(SerialError(GetLastError(), "Draining connection (FlushFileBuffers)"));
     return;
   }
 }
@@ -0,0 +1,207 @@
+#include "./worker_pool.h"
+#include "./addon_data.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+#include <chrono>
+#include <thread>
+
+static uint64_t nowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Napi::Error SerialError::ToError(Napi::Env env) const {
+  Napi::Error error = Napi::Error::New(env, Message());
+  if (system && code != 0) {
+    // same shape as the errors node's fs functions produce, so callers can check err.code === 'EIO'
+    int uvError = uv_translate_sys_error(code);
+    char name[64];
+    uv_err_name_r(uvError, name, sizeof(name));
+    error.Set("errno", Napi::Number::New(env, uvError));
+    if (strncmp(name, "Unknown", 7) != 0) {
+      error.Set("code", Napi::String::New(env, name));
+    }
+  }
+  return error;
+}
+
+SerialWorker::SerialWorker(Napi::Function& callback, const char *resource_name) :
+  _env(callback.Env()), _callback(Napi::Persistent(callback)), _context(callback.Env(), resource_name) {}
+
+void SerialWorker::OnOK() {
+  Napi::Env env = Env();
+  Napi::HandleScope scope(env);
+  Callback().Call({env.Null()});
+}
+
+void SerialWorker::OnError(const Napi::Error& e) {
+  Napi::Env env = Env();
+  Napi::HandleScope scope(env);
+  Callback().Call({e.Value()});
+}
+
+void SerialWorker::Queue() {
+  _workerEnv = Env().GetInstanceData<AddonData>()->workers;
+  if (_workerEnv->pending++ == 0) {
+    _workerEnv->completions.Ref(Env());
+  }
+  WorkerPool::Get().Submit(this);
+}
+
+void WorkerEnv::OnComplete(Napi::Env env, Napi::Function jsCallback, WorkerEnv* context, SerialWorker* worker) {
+  // env is null when the environment is being torn down, the callback can't be called anymore
+  if (env != nullptr) {
+    if (--context->pending == 0) {
+      context->completions.Unref(env);
+    }
+    Napi::HandleScope scope(env);
+    Napi::CallbackScope callbackScope(env, worker->_context);
+    try {
+      if (!worker->_error.failed()) {
+        worker->OnOK();
+      } else {
+        worker->OnError(worker->_error.ToError(env));
+      }
+    } catch (const Napi::Error& e) {
+      // surface it as an uncaught exception, same as an exception thrown from an AsyncWorker callback
+      napi_fatal_exception(env, e.Value());
+    }
+  }
+  delete worker;
+}
+
+WorkerPool& WorkerPool::Get() {
+  // never destroyed, the threads are detached and live as long as the process
+  static WorkerPool* pool = new WorkerPool();
+  return *pool;
+}
+
+WorkerPool::WorkerPool() : size(WORKER_POOL_DEFAULT_SIZE) {
+  const char *env = getenv("SERIALPORT_THREADPOOL_SIZE");
+  if (env != NULL) {
+    int value = atoi(env);
+    if (value > 0) {
+      size = value > WORKER_POOL_MAX_SIZE ? WORKER_POOL_MAX_SIZE : value;
+    }
+  }
+}
+
+void WorkerPool::Submit(SerialWorker* worker) {
+  std::unique_lock<std::mutex> lock(mutex);
+  worker->_queuedAt = nowMicros();
+  queue.push_back(worker);
+  if (queue.size() > maxQueued) {
+    maxQueued = queue.size();
+  }
+  // threads are started lazily so processes that never touch a port don't pay for them
+  if (threads < size && active + queue.size() > threads) {
+    threads++;
+    std::thread(&WorkerPool::Run, this).detach();
+  }
+  lock.unlock();
+  wake.notify_one();
+}
+
+void WorkerPool::Resize(size_t newSize) {
+  std::unique_lock<std::mutex> lock(mutex);
+  size = newSize;
+  while (threads < size && active + queue.size() > threads) {
+    threads++;
+    std::thread(&WorkerPool::Run, this).detach();
+  }
+  lock.unlock();
+  // surplus threads notice the new size and exit
+  wake.notify_all();
+}
+
+void WorkerPool::Abandon(WorkerEnv* workerEnv) {
+  std::deque<SerialWorker*> abandoned;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    workerEnv->closed = true;
+    std::deque<SerialWorker*> remaining;
+    for (SerialWorker* worker : queue) {
+      (worker->_workerEnv.get() == workerEnv ? abandoned : remaining).push_back(worker);
+    }
+    queue.swap(remaining);
+  }
+  // still on the environment's thread, so their references can be released
+  for (SerialWorker* worker : abandoned) {
+    delete worker;
+  }
+}
+
+void WorkerPool::Run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [this] { return !queue.empty() || threads > size; });
+    if (threads > size) {
+      threads--;
+      return;
+    }
+    SerialWorker* worker = queue.front();
+    queue.pop_front();
+    uint64_t wait = nowMicros() - worker->_queuedAt;
+    totalWaitMicros += wait;
+    if (wait > maxWaitMicros) {
+      maxWaitMicros = wait;
+    }
+    active++;
+    lock.unlock();
+
+    worker->Execute();
+
+    lock.lock();
+    // The environment's thread-safe function is only released after Abandon() took the lock, so it is
+    // valid here. A worker whose environment is gone is leaked, its references can't be freed off thread.
+    if (!worker->_workerEnv->closed) {
+      worker->_workerEnv->completions.NonBlockingCall(worker);
+    }
+    active--;
+    completed++;
+  }
+}
+
+Napi::Value WorkerPool::SetSize(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int size = info[0].As<Napi::Number>().Int32Value();
+  if (size < 1 || size > WORKER_POOL_MAX_SIZE) {
+    Napi::RangeError::New(env, "Thread pool size must be between 1 and 64").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Get().Resize(size);
+  return env.Undefined();
+}
+
+Napi::Value WorkerPool::GetStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  WorkerPool& pool = Get();
+  Napi::Object stats = Napi::Object::New(env);
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  stats.Set("size", static_cast<double>(pool.size));
+  stats.Set("threads", static_cast<double>(pool.threads));
+  stats.Set("active", static_cast<double>(pool.active));
+  stats.Set("queued", static_cast<double>(pool.queue.size()));
+  stats.Set("maxQueued", static_cast<double>(pool.maxQueued));
+  stats.Set("completed", static_cast<double>(pool.completed));
+  stats.Set("totalWaitMicros", static_cast<double>(pool.totalWaitMicros));
+  stats.Set("maxWaitMicros", static_cast<double>(pool.maxWaitMicros));
+  return stats;
+}
+
+void WorkerPool::Init(Napi::Env env, Napi::Object exports) {
+  WorkerEnv* workerEnv = env.GetInstanceData<AddonData>()->workers.get();
+  workerEnv->completions = Napi::TypedThreadSafeFunction<WorkerEnv, SerialWorker, WorkerEnv::OnComplete>::New(
+    env, "node-serialport:WorkerPool", 0, 1, workerEnv);
+  // only referenced while work is in flight
+  workerEnv->completions.Unref(env);
+
+  exports.Set("setThreadPoolSize", Napi::Function::New(env, SetSize));
+  exports.Set("getThreadPoolStats", Napi::Function::New(env, GetStats));
+}
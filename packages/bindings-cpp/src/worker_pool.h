@@ -0,0 +1,113 @@
+#ifndef PACKAGES_SERIALPORT_SRC_WORKER_POOL_H_
+#define PACKAGES_SERIALPORT_SRC_WORKER_POOL_H_
+
+#include <napi.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define WORKER_POOL_DEFAULT_SIZE 4
+#define WORKER_POOL_MAX_SIZE 64
+
+class SerialWorker;
+struct WorkerEnv;
+
+// A failure recorded by a serial operation. Only the system error code and a static printf format
+// are kept, the message is formatted on the JS thread and only when the operation actually failed.
+// System errors pass the description of `code` to the format first, then `text` or `arg`.
+struct SerialError {
+  SerialError() {}
+  SerialError(const char *format, int arg = 0) : format(format), arg(arg) {}
+  SerialError(const char *format, const char *text) : format(format), text(text) {}
+  SerialError(int code, const char *format, int arg = 0) : system(true), code(code), format(format), arg(arg) {}
+  SerialError(int code, const char *format, const char *text) : system(true), code(code), format(format), text(text) {}
+
+  bool failed() const { return format != nullptr; }
+  // Implemented per platform, errno on unix and GetLastError() on windows
+  std::string Message() const;
+  // An Error with the message and, when there is a system error, node style `errno` and `code`
+  Napi::Error ToError(Napi::Env env) const;
+
+  bool system = false;
+  int code = 0;
+  const char *format = nullptr;
+  int arg = 0;
+  // must outlive the error, e.g. the path stored in the baton
+  const char *text = nullptr;
+};
+
+// Completed workers are handed back to the JS thread of the environment that queued them
+struct WorkerEnv {
+  static void OnComplete(Napi::Env env, Napi::Function jsCallback, WorkerEnv* context, SerialWorker* worker);
+  Napi::TypedThreadSafeFunction<WorkerEnv, SerialWorker, WorkerEnv::OnComplete> completions;
+  // only touched on the JS thread, keeps the loop alive while work is in flight
+  size_t pending = 0;
+  // set when the environment is torn down, guarded by the pool mutex
+  bool closed = false;
+};
+
+// Replaces Napi::AsyncWorker for serial operations. Blocking calls such as tcdrain() run on the
+// binding's own threads instead of the libuv threadpool so they can't starve fs, dns or crypto work.
+class SerialWorker {
+ public:
+  SerialWorker(Napi::Function& callback, const char *resource_name);
+  virtual ~SerialWorker() {}
+
+  void Queue();
+
+  // Runs on a pool thread
+  virtual void Execute() = 0;
+  // Run on the JS thread once Execute() returns
+  virtual void OnOK();
+  virtual void OnError(const Napi::Error& e);
+
+  void SetError(const SerialError& error) { _error = error; }
+  Napi::Env Env() const { return Napi::Env(_env); }
+  Napi::FunctionReference& Callback() { return _callback; }
+
+ private:
+  friend struct WorkerEnv;
+  friend class WorkerPool;
+
+  napi_env _env;
+  Napi::FunctionReference _callback;
+  Napi::AsyncContext _context;
+  SerialError _error;
+  // shared so a worker still running when its environment goes away doesn't outlive it
+  std::shared_ptr<WorkerEnv> _workerEnv;
+  uint64_t _queuedAt = 0;
+};
+
+class WorkerPool {
+ public:
+  static WorkerPool& Get();
+  static void Init(Napi::Env env, Napi::Object exports);
+
+  void Submit(SerialWorker* worker);
+  void Resize(size_t size);
+  // Drops the queued work of an environment being torn down, work already running is never completed
+  void Abandon(WorkerEnv* workerEnv);
+
+ private:
+  WorkerPool();
+  void Run();
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<SerialWorker*> queue;
+  size_t size;
+  size_t threads = 0;
+  size_t active = 0;
+  size_t maxQueued = 0;
+  uint64_t completed = 0;
+  uint64_t totalWaitMicros = 0;
+  uint64_t maxWaitMicros = 0;
+
+  static Napi::Value SetSize(const Napi::CallbackInfo& info);
+  static Napi::Value GetStats(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_WORKER_POOL_H_
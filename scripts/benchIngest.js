@@ -0,0 +1,135 @@
+// Load test for POST /api/sensors/data: BENCH_DEVICES devices (1000 by default) posting readings
+// through receiveSensorData against MONGODB_URI, reports requests/s and latency percentiles.
+//
+//   MONGODB_URI=mongodb://localhost:27017/agrismart_bench node scripts/benchIngest.js
+//
+// BENCH_REQUESTS (20000) readings are sent, BENCH_CONCURRENCY (100) at a time. The user, greenhouse
+// and readings the run creates are removed afterwards.
+require('dotenv').config();
+const http = require('http');
+const express = require('express');
+const mongoose = require('mongoose');
+const User = require('../models/User');
+const Greenhouse = require('../models/Greenhouse');
+const SensorData = require('../models/SensorData');
+const { receiveSensorData, ingestPipeline } = require('../controllers/sensorController');
+
+const devices = parseInt(process.env.BENCH_DEVICES) || 1000;
+const requests = parseInt(process.env.BENCH_REQUESTS) || 20000;
+const concurrency = parseInt(process.env.BENCH_CONCURRENCY) || 100;
+
+const percentile = (sorted, p) => sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+const reading = (userId, greenhouseId, index) => JSON.stringify({
+  deviceId: `bench-${index % devices}`,
+  userId,
+  greenhouseId,
+  sensors: {
+    outsideTemp: 20 + (index % 10),
+    greenhouseTemp: 24 + (index % 8),
+    outsideHumidity: 55,
+    greenhouseHumidity: 65,
+    soilMoisture: 40 + (index % 30),
+    lightLevel: 70,
+    phLevel: 6.5,
+    waterTank: 80
+  },
+  actuators: {
+    waterPump: { status: index % 2 ? 'ON' : 'OFF', mode: 'AUTO' },
+    ventilationFan: { status: 'OFF', mode: 'AUTO' }
+  },
+  rfid: 'NoCard'
+});
+
+const post = (agent, port, body) => new Promise((resolve, reject) => {
+  const startedAt = process.hrtime.bigint();
+  const req = http.request({
+    agent,
+    port,
+    method: 'POST',
+    path: '/api/sensors/data',
+    headers: { 'Content-Type': 'application/json', 'Content-Length': Buffer.byteLength(body) }
+  }, (res) => {
+    res.resume();
+    res.on('end', () => resolve({
+      status: res.statusCode,
+      ms: Number(process.hrtime.bigint() - startedAt) / 1e6
+    }));
+  });
+  req.on('error', reject);
+  req.end(body);
+});
+
+const run = async () => {
+  if (!process.env.MONGODB_URI) {
+    console.error('❌ MONGODB_URI is required');
+    process.exit(1);
+  }
+  await mongoose.connect(process.env.MONGODB_URI);
+  console.log(`✅ MongoDB Connected: ${mongoose.connection.host}`);
+
+  const tag = Date.now().toString(36);
+  const user = await User.create({
+    username: `bench_${tag}`,
+    email: `bench_${tag}@example.com`,
+    password: 'benchmark',
+    firstName: 'Bench',
+    lastName: 'Mark'
+  });
+  const greenhouse = await Greenhouse.create({
+    name: `Bench ${tag}`,
+    owner: user._id,
+    devices: Array.from({ length: devices }, (_, i) => ({ deviceId: `bench-${i}`, name: `Bench ${i}`, type: 'esp32' }))
+  });
+
+  const app = express();
+  app.use(express.json());
+  const io = { emit: () => {} };
+  app.post('/api/sensors/data', (req, res) => {
+    req.io = io;
+    receiveSensorData(req, res);
+  });
+  const server = app.listen(0);
+  const { port } = server.address();
+  const agent = new http.Agent({ keepAlive: true, maxSockets: concurrency });
+
+  console.log(`📊 ${requests} readings from ${devices} devices, ${concurrency} in flight`);
+  const latencies = [];
+  let failed = 0;
+  let next = 0;
+  const startedAt = Date.now();
+  const worker = async () => {
+    while (next < requests) {
+      const result = await post(agent, port, reading(String(user._id), String(greenhouse._id), next++));
+      latencies.push(result.ms);
+      if (result.status !== 201) {
+        failed++;
+      }
+    }
+  };
+  await Promise.all(Array.from({ length: concurrency }, worker));
+  const elapsed = (Date.now() - startedAt) / 1000;
+  await ingestPipeline.flush();
+
+  latencies.sort((a, b) => a - b);
+  console.log(`✅ ${(requests / elapsed).toFixed(0)} requests/s, ${failed} failed`);
+  console.log(`   p50 ${percentile(latencies, 0.5).toFixed(1)} ms, p99 ${percentile(latencies, 0.99).toFixed(1)} ms, max ${latencies[latencies.length - 1].toFixed(1)} ms`);
+  console.log('   pipeline', ingestPipeline.getStatus());
+
+  const stored = await Greenhouse.findById(greenhouse._id).lean();
+  console.log(`   greenhouse readings ${stored.stats.totalSensorReadings}, active devices ${stored.devices.filter(d => d.status === 'active').length}`);
+
+  agent.destroy();
+  server.close();
+  await ingestPipeline.close();
+  await SensorData.deleteMany({ greenhouseId: greenhouse._id });
+  await Greenhouse.deleteOne({ _id: greenhouse._id });
+  await User.deleteOne({ _id: user._id });
+  await mongoose.connection.close();
+};
+
+run().catch(async (error) => {
+  console.error('❌ Benchmark failed:', error);
+  await mongoose.connection.close();
+  process.exit(1);
+});
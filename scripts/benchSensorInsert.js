@@ -0,0 +1,85 @@
+// Insert throughput of readings: one save() per reading against the write-behind buffer, for
+// BENCH_DEVICES devices (1000 by default) with a reading in flight each, against MONGODB_URI.
+//
+//   MONGODB_URI=mongodb://localhost:27017/agrismart_bench node scripts/benchSensorInsert.js
+//
+// Each mode stores BENCH_READINGS (20000) readings. The readings are removed afterwards.
+require('dotenv').config();
+const os = require('os');
+const path = require('path');
+const mongoose = require('mongoose');
+const SensorData = require('../models/SensorData');
+const SensorDataBuffer = require('../services/sensorDataBuffer');
+
+const devices = parseInt(process.env.BENCH_DEVICES) || 1000;
+const readings = parseInt(process.env.BENCH_READINGS) || 20000;
+
+const percentile = (sorted, p) => sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+const reading = (greenhouseId, userId, index) => new SensorData({
+  deviceId: `bench-${index % devices}`,
+  greenhouseId,
+  userId,
+  readings: {
+    temp1: 20 + (index % 10),
+    temp2: 24 + (index % 8),
+    hum1: 55,
+    hum2: 65,
+    soilMoisture: 40 + (index % 30),
+    lightIntensity: 70,
+    ph: 6.5,
+    waterTankLevel: 80
+  }
+});
+
+// Every device keeps one reading in flight until `readings` are stored
+const run = async (label, store) => {
+  const greenhouseId = new mongoose.Types.ObjectId();
+  const userId = new mongoose.Types.ObjectId();
+  const latencies = [];
+  let next = 0;
+  const startedAt = Date.now();
+  const device = async () => {
+    while (next < readings) {
+      const sensorData = reading(greenhouseId, userId, next++);
+      const sentAt = process.hrtime.bigint();
+      await store(sensorData);
+      latencies.push(Number(process.hrtime.bigint() - sentAt) / 1e6);
+    }
+  };
+  await Promise.all(Array.from({ length: devices }, device));
+  const elapsed = (Date.now() - startedAt) / 1000;
+
+  latencies.sort((a, b) => a - b);
+  const rate = readings / elapsed;
+  console.log(`📊 ${label}: ${rate.toFixed(0)} inserts/s, p50 ${percentile(latencies, 0.5).toFixed(1)} ms, p99 ${percentile(latencies, 0.99).toFixed(1)} ms`);
+  await SensorData.deleteMany({ greenhouseId });
+  return rate;
+};
+
+const main = async () => {
+  if (!process.env.MONGODB_URI) {
+    console.error('❌ MONGODB_URI is required');
+    process.exit(1);
+  }
+  await mongoose.connect(process.env.MONGODB_URI);
+  await SensorData.init();
+  console.log(`✅ MongoDB Connected: ${mongoose.connection.host}, ${readings} readings from ${devices} devices`);
+
+  const saved = await run('save() per reading', sensorData => sensorData.save());
+  const buffer = new SensorDataBuffer({
+    maxBuffered: devices * 2,
+    spillPath: path.join(os.tmpdir(), `agrismart-bench-spill-${process.pid}.ndjson`)
+  });
+  const buffered = await run('write-behind buffer', sensorData => buffer.insert(sensorData));
+  await buffer.close();
+  console.log(`✅ ${(buffered / saved).toFixed(1)}x inserts/s, buffer`, buffer.getStatus());
+
+  await mongoose.connection.close();
+};
+
+main().catch(async (error) => {
+  console.error('❌ Benchmark failed:', error);
+  await mongoose.connection.close();
+  process.exit(1);
+});
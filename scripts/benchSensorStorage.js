@@ -0,0 +1,133 @@
+// Storage and query times of readings in a plain collection against a time-series collection,
+// with the same readings and SensorData's indexes in both, against MONGODB_URI.
+//
+//   MONGODB_URI=mongodb://localhost:27017/agrismart_bench node scripts/benchSensorStorage.js
+//
+// BENCH_DEVICES (50) devices in BENCH_GREENHOUSES (5) greenhouses report every 3 s for BENCH_HOURS
+// (24) hours, each query runs BENCH_RUNS (20) times and the median is reported. Both collections
+// are dropped afterwards.
+require('dotenv').config();
+const mongoose = require('mongoose');
+const SensorData = require('../models/SensorData');
+
+const devices = parseInt(process.env.BENCH_DEVICES) || 50;
+const greenhouses = parseInt(process.env.BENCH_GREENHOUSES) || 5;
+const hours = parseInt(process.env.BENCH_HOURS) || 24;
+const runs = parseInt(process.env.BENCH_RUNS) || 20;
+const cadenceMs = 3000;
+
+const formatBytes = (bytes) => `${(bytes / 1024 / 1024).toFixed(1)} MB`;
+
+const median = (values) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.floor(sorted.length / 2)];
+};
+
+const timed = async (operation) => {
+  const startedAt = process.hrtime.bigint();
+  await operation();
+  return Number(process.hrtime.bigint() - startedAt) / 1e6;
+};
+
+// Slim readings as receiveSensorData stores them, for one device at one time
+const reading = (greenhouseIds, userId, device, at) => ({
+  _id: new mongoose.Types.ObjectId(),
+  deviceId: `bench-${device}`,
+  greenhouseId: greenhouseIds[device % greenhouses],
+  userId,
+  readings: {
+    temp1: 20 + Math.round(Math.random() * 100) / 10,
+    temp2: 24 + Math.round(Math.random() * 100) / 10,
+    tempAverage: 25,
+    hum1: 50 + Math.round(Math.random() * 200) / 10,
+    hum2: 60 + Math.round(Math.random() * 200) / 10,
+    humAverage: 62,
+    soilMoisture: 30 + Math.round(Math.random() * 300) / 10,
+    lightIntensity: Math.round(Math.random() * 100),
+    ph: 6 + Math.round(Math.random() * 10) / 10,
+    waterTankLevel: 80 - Math.round(at.getTime() / 3600000) % 50
+  },
+  createdAt: at
+});
+
+const main = async () => {
+  if (!process.env.MONGODB_URI) {
+    console.error('❌ MONGODB_URI is required');
+    process.exit(1);
+  }
+  await mongoose.connect(process.env.MONGODB_URI);
+  const db = mongoose.connection.db;
+  const tag = Date.now().toString(36);
+
+  const plain = await db.createCollection(`bench_sensor_plain_${tag}`);
+  const timeseries = await db.createCollection(`bench_sensor_ts_${tag}`, { timeseries: SensorData.timeseriesOptions });
+  for (const collection of [plain, timeseries]) {
+    for (const [keys, options] of SensorData.schema.indexes()) {
+      await collection.createIndex(keys, options);
+    }
+  }
+  console.log(`✅ MongoDB Connected: ${mongoose.connection.host}, bucketing`, SensorData.timeseriesOptions);
+
+  // same readings in both, in the order devices would send them
+  const greenhouseIds = Array.from({ length: greenhouses }, () => new mongoose.Types.ObjectId());
+  const userId = new mongoose.Types.ObjectId();
+  const end = new Date();
+  const start = new Date(end.getTime() - hours * 3600000);
+  const insertMs = { plain: 0, timeseries: 0 };
+  let count = 0;
+  for (let at = start.getTime(); at < end.getTime(); at += cadenceMs * 100) {
+    const batch = [];
+    for (let step = 0; step < 100 && at + step * cadenceMs < end.getTime(); step++) {
+      for (let device = 0; device < devices; device++) {
+        batch.push(reading(greenhouseIds, userId, device, new Date(at + step * cadenceMs)));
+      }
+    }
+    insertMs.plain += await timed(() => plain.insertMany(batch, { ordered: false }));
+    insertMs.timeseries += await timed(() => timeseries.insertMany(batch, { ordered: false }));
+    count += batch.length;
+  }
+  console.log(`📊 ${count} readings from ${devices} devices over ${hours} h`);
+  console.log(`   insert: plain ${(count / insertMs.plain * 1000).toFixed(0)}/s, time-series ${(count / insertMs.timeseries * 1000).toFixed(0)}/s`);
+
+  for (const [name, collection] of [['plain', plain], ['time-series', timeseries]]) {
+    const [{ storageStats }] = await collection.aggregate([{ $collStats: { storageStats: {} } }]).toArray();
+    console.log(`   ${name}: ${formatBytes(storageStats.storageSize)} data, ${formatBytes(storageStats.totalIndexSize)} indexes`);
+  }
+
+  const hourAgo = new Date(end.getTime() - 3600000);
+  const queries = {
+    'latest of a device': collection => collection.find({ deviceId: 'bench-7' }).sort({ createdAt: -1 }).limit(1).toArray(),
+    'device history, 1 h': collection => collection.find({ deviceId: 'bench-7', createdAt: { $gte: hourAgo, $lte: end } }).sort({ createdAt: -1 }).toArray(),
+    'device hourly aggregate': collection => collection.aggregate([
+      { $match: { deviceId: 'bench-7', createdAt: { $gte: start, $lte: end } } },
+      {
+        $group: {
+          _id: { $dateToString: { format: '%Y-%m-%d %H:00:00', date: '$createdAt' } },
+          avgTemp: { $avg: '$readings.tempAverage' },
+          avgSoilMoisture: { $avg: '$readings.soilMoisture' },
+          count: { $sum: 1 }
+        }
+      },
+      { $sort: { _id: 1 } }
+    ]).toArray(),
+    'greenhouse history, 1 h': collection => collection.find({ greenhouseId: greenhouseIds[2], createdAt: { $gte: hourAgo, $lte: end } }).toArray()
+  };
+  for (const [label, query] of Object.entries(queries)) {
+    const times = { plain: [], timeseries: [] };
+    for (let run = 0; run < runs; run++) {
+      times.plain.push(await timed(() => query(plain)));
+      times.timeseries.push(await timed(() => query(timeseries)));
+    }
+    console.log(`   ${label}: plain ${median(times.plain).toFixed(1)} ms, time-series ${median(times.timeseries).toFixed(1)} ms`);
+  }
+
+  await plain.drop();
+  await timeseries.drop();
+  await mongoose.connection.close();
+};
+
+main().catch(async (error) => {
+  console.error('❌ Benchmark failed:', error);
+  await mongoose.connection.close();
+  process.exit(1);
+});
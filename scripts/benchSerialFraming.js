@@ -0,0 +1,102 @@
+// Line framing cost of the linux binding: BENCH_LINES (600) Arduino telemetry lines are written to a pty
+// in BENCH_BURST (16) byte bursts paced at BENCH_BAUD (115200), and read back as lines twice:
+//   raw:    the default raw mode, lines split in JS with indexOf like ReadlineParser does
+//   icanon: the tty line discipline assembles lines, each read() returns one
+// Reports read() calls per line and the reading process's CPU time, in total and per line.
+//
+//   node scripts/benchSerialFraming.js
+//   BENCH_LINES=200 BENCH_BURST=64 node scripts/benchSerialFraming.js
+//
+// The device side writes from a child process so its CPU time isn't counted. A run takes about
+// lines * line length * 10 / baud seconds per mode. Linux only.
+const fs = require('fs');
+const { spawn } = require('child_process');
+const { LinuxBinding, openPty } = require('@serialport/bindings-cpp');
+
+const lines = parseInt(process.env.BENCH_LINES) || 600;
+const burst = parseInt(process.env.BENCH_BURST) || 16;
+const baudRate = parseInt(process.env.BENCH_BAUD) || 115200;
+
+// what the sketch sends the ESP32 every loop
+const LINE = 'T1:25.0,H1:60.0,T2:28.0,H2:70.0,Soil:45,Light:80,Tank:75,pH:6.8,WaterPump:ON,WaterMode:AUTO,Fan:OFF,FanMode:AUTO,Fertilizer:OFF,RFID:NoCard\n';
+
+// Device side, run in the child: writes the lines to fd 3 a burst at a time, as fast as the baud rate
+// would carry them (10 bits a byte)
+const runDevice = () => {
+  const data = Buffer.from(LINE.repeat(lines));
+  const burstMs = (burst * 10 * 1000) / baudRate;
+  const started = Date.now();
+  let offset = 0;
+  const tick = () => {
+    const due = Math.min(data.length, Math.floor((Date.now() - started) / burstMs + 1) * burst);
+    while (offset < due) {
+      try {
+        offset += fs.writeSync(3, data, offset, Math.min(burst, due - offset));
+      } catch (error) {
+        if (error.code !== 'EAGAIN') {
+          throw error;
+        }
+        break;
+      }
+    }
+    if (offset < data.length) {
+      setTimeout(tick, Math.max(1, burstMs));
+    }
+  };
+  tick();
+};
+
+const measure = async (mode) => {
+  const pty = openPty();
+  const port = await LinuxBinding.open({ path: pty.path, baudRate, icanon: mode === 'icanon' });
+  const buffer = Buffer.allocUnsafe(65536);
+  let pending = '';
+  let received = 0;
+  let reads = 0;
+  const device = spawn(process.execPath, [__filename, 'device'], {
+    stdio: ['ignore', 'inherit', 'inherit', pty.masterFd],
+    env: { ...process.env, BENCH_LINES: String(lines), BENCH_BURST: String(burst), BENCH_BAUD: String(baudRate) }
+  });
+  const cpu = process.cpuUsage();
+  const started = Date.now();
+  try {
+    while (received < lines) {
+      const { bytesRead } = await port.read(buffer, 0, buffer.length);
+      reads++;
+      if (mode === 'icanon') {
+        received++;
+        continue;
+      }
+      pending += buffer.toString('latin1', 0, bytesRead);
+      let newline;
+      while ((newline = pending.indexOf('\n')) !== -1) {
+        pending = pending.slice(newline + 1);
+        received++;
+      }
+    }
+  } finally {
+    device.kill();
+    await port.close();
+    fs.closeSync(pty.masterFd);
+    fs.closeSync(pty.slaveFd);
+  }
+  const { user, system } = process.cpuUsage(cpu);
+  const cpuMs = (user + system) / 1000;
+  console.log(`✅ ${mode}: ${(reads / received).toFixed(2)} reads per line, ${cpuMs.toFixed(0)} ms CPU ` +
+    `(${(cpuMs / received).toFixed(3)} ms per line) in ${((Date.now() - started) / 1000).toFixed(1)}s`);
+};
+
+const run = async () => {
+  console.log(`📊 ${lines} lines of ${LINE.length} bytes in ${burst} byte bursts at ${baudRate} baud`);
+  await measure('raw');
+  await measure('icanon');
+};
+
+if (process.argv[2] === 'device') {
+  runDevice();
+} else {
+  run().catch((error) => {
+    console.error('❌ Benchmark failed:', error);
+    process.exit(1);
+  });
+}
@@ -0,0 +1,56 @@
+// Open latency of the linux binding: opens and closes BENCH_OPENS ptys (100 by default) one after the
+// other, at a standard rate (115200) and a custom one (250000), reports the p50 and p90 of each.
+//
+//   node scripts/benchSerialOpen.js
+//   BENCH_OPENS=1000 BENCH_ROUNDS=5 node scripts/benchSerialOpen.js
+//
+// Times are from open() to the port being returned, so they include the threadpool round trip, close
+// is not timed. Each of BENCH_ROUNDS (3) rounds opens fresh ptys, the spread between rounds is the
+// noise to compare changes against. ptys make termios ioctls nearly free, real UARTs spend more in
+// the driver's set_termios. Linux only.
+const fs = require('fs');
+const { LinuxBinding, openPty } = require('@serialport/bindings-cpp');
+
+const opens = parseInt(process.env.BENCH_OPENS) || 100;
+const rounds = parseInt(process.env.BENCH_ROUNDS) || 3;
+const baudRates = [115200, 250000];
+
+const percentile = (sorted, p) => sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+const measure = async (baudRate) => {
+  const ptys = Array.from({ length: opens }, () => openPty());
+  const times = [];
+  try {
+    for (const pty of ptys) {
+      const started = process.hrtime.bigint();
+      const port = await LinuxBinding.open({ path: pty.path, baudRate });
+      times.push(Number(process.hrtime.bigint() - started) / 1000);
+      await port.close();
+    }
+  } finally {
+    ptys.forEach((pty) => {
+      fs.closeSync(pty.masterFd);
+      fs.closeSync(pty.slaveFd);
+    });
+  }
+  return times.sort((a, b) => a - b);
+};
+
+const run = async () => {
+  console.log(`📊 ${opens} pty opens per round, ${rounds} rounds`);
+  // warms up the threadpool and the addon
+  await measure(115200);
+  for (const baudRate of baudRates) {
+    const results = [];
+    for (let i = 0; i < rounds; i++) {
+      const times = await measure(baudRate);
+      results.push(`p50 ${percentile(times, 0.5).toFixed(1)}us p90 ${percentile(times, 0.9).toFixed(1)}us`);
+    }
+    console.log(`✅ ${baudRate} baud: ${results.join(', ')}`);
+  }
+};
+
+run().catch((error) => {
+  console.error('❌ Benchmark failed:', error);
+  process.exit(1);
+});
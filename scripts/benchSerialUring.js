@@ -0,0 +1,137 @@
+// io_uring against poll reads on the linux binding: BENCH_PORTS ptys (32) each get BENCH_RATE (100)
+// 52-byte sensor lines a second for BENCH_SECONDS (5), and the ports echo every line back. Runs once
+// with the default poll path and once with `ioUring`, reports the node CPU time per line and the
+// p50/p99 latency from the device's write to the line being read.
+//
+//   node scripts/benchSerialUring.js
+//   BENCH_PORTS=4 BENCH_RATE=1000 node scripts/benchSerialUring.js
+//   taskset -c 0 node scripts/benchSerialUring.js   # everything on one core
+//
+// The device side runs in a child process so its CPU time isn't counted, each line carries its write
+// time (CLOCK_MONOTONIC, shared by both processes). Linux only, the io_uring run is skipped when
+// hasIoUring is false.
+const fs = require('fs');
+const { spawn } = require('child_process');
+const { LinuxBinding, openPty, hasIoUring } = require('@serialport/bindings-cpp');
+
+const ports = parseInt(process.env.BENCH_PORTS) || 32;
+const rate = parseInt(process.env.BENCH_RATE) || 100;
+const seconds = parseFloat(process.env.BENCH_SECONDS) || 5;
+const LINE_LENGTH = 52;
+
+const percentile = (sorted, p) => sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+// Device side, run in the child: writes a line to each of the ports' masters (fds 3 and up) `rate`
+// times a second and drains what the ports echo back
+const runDevice = () => {
+  const fds = Array.from({ length: ports }, (_, i) => 3 + i);
+  const drain = Buffer.allocUnsafe(65536);
+  const started = Date.now();
+  let sent = 0;
+  const tick = () => {
+    const due = Math.floor(((Date.now() - started) * rate) / 1000) + 1;
+    for (; sent < due; sent++) {
+      // the write time, padded so every line has the same length
+      const line = `${process.hrtime.bigint()},T1:25.0,H1:60.0,Soil:45`.padEnd(LINE_LENGTH - 1, ',') + '\n';
+      fds.forEach((fd) => {
+        try {
+          fs.writeSync(fd, line);
+        } catch (error) {
+          if (error.code !== 'EAGAIN') {
+            throw error;
+          }
+        }
+      });
+    }
+    fds.forEach((fd) => {
+      try {
+        while (fs.readSync(fd, drain, 0, drain.length, null) > 0);
+      } catch (error) {
+        if (error.code !== 'EAGAIN') {
+          throw error;
+        }
+      }
+    });
+    setTimeout(tick, Math.max(1, 1000 / rate));
+  };
+  tick();
+};
+
+// Reads lines off a port and writes each chunk back, until the port is closed
+const echoPort = async (port, onLine) => {
+  const buffer = Buffer.allocUnsafe(65536);
+  let pending = '';
+  for (;;) {
+    const { bytesRead } = await port.read(buffer, 0, buffer.length);
+    const chunk = Buffer.from(buffer.subarray(0, bytesRead));
+    pending += chunk.toString('latin1');
+    let newline;
+    while ((newline = pending.indexOf('\n')) !== -1) {
+      onLine(pending.slice(0, newline));
+      pending = pending.slice(newline + 1);
+    }
+    await port.write(chunk);
+  }
+};
+
+const measure = async (mode) => {
+  const ptys = Array.from({ length: ports }, () => openPty());
+  const opened = await Promise.all(ptys.map(pty => LinuxBinding.open({
+    path: pty.path,
+    baudRate: 115200,
+    ioUring: mode === 'io_uring'
+  })));
+  const latencies = [];
+  let lines = 0;
+  const onLine = (line) => {
+    const now = process.hrtime.bigint();
+    lines++;
+    latencies.push(Number(now - BigInt(line.slice(0, line.indexOf(',')))) / 1000);
+  };
+  const echoes = opened.map(port => echoPort(port, onLine).catch(() => {}));
+
+  const device = spawn(process.execPath, [__filename, 'device'], {
+    stdio: ['ignore', 'inherit', 'inherit', ...ptys.map(pty => pty.masterFd)],
+    env: { ...process.env, BENCH_PORTS: String(ports), BENCH_RATE: String(rate) }
+  });
+  // the first second warms up, the rest is measured
+  await new Promise(resolve => setTimeout(resolve, 1000));
+  lines = 0;
+  latencies.length = 0;
+  const cpu = process.cpuUsage();
+  await new Promise(resolve => setTimeout(resolve, seconds * 1000));
+  const { user, system } = process.cpuUsage(cpu);
+  const measured = lines;
+
+  device.kill();
+  // closing cancels the pending reads, which ends the echoes
+  await Promise.all(opened.map(port => port.close()));
+  await Promise.all(echoes);
+  ptys.forEach((pty) => {
+    fs.closeSync(pty.masterFd);
+    fs.closeSync(pty.slaveFd);
+  });
+
+  latencies.sort((a, b) => a - b);
+  console.log(`✅ ${mode}: ${measured} lines, ${((user + system) / measured).toFixed(1)} us CPU per line, ` +
+    `latency p50 ${percentile(latencies, 0.5).toFixed(0)}us p99 ${percentile(latencies, 0.99).toFixed(0)}us`);
+};
+
+const run = async () => {
+  console.log(`📊 ${ports} ports x ${rate} lines/s of ${LINE_LENGTH} bytes for ${seconds}s, echoed back`);
+  await measure('poll');
+  if (hasIoUring) {
+    await measure('io_uring');
+  } else {
+    console.warn('⚠️  io_uring is not available, skipped');
+  }
+};
+
+if (process.argv[2] === 'device') {
+  runDevice();
+} else {
+  run().catch((error) => {
+    console.error('❌ Benchmark failed:', error);
+    process.exit(1);
+  });
+}
@@ -0,0 +1,155 @@
+// Throughput of serial ports owned by worker_threads: BENCH_PORTS ports (4 by default) spread over
+// BENCH_WORKERS workers (one per port by default), reports the aggregate and per worker MB/s.
+//
+//   node scripts/benchSerialWorkers.js
+//   BENCH_WORKERS=1 node scripts/benchSerialWorkers.js   # the same ports on a single thread
+//
+// Each port is a pty whose device side echoes what the port writes, both ends run in the worker that owns
+// the port. Ports write BENCH_CHUNK (4096) bytes at a time for BENCH_SECONDS (5), bytes read back within
+// that window count. Linux only, scaling across workers needs as many cores as workers.
+const os = require('os');
+const fs = require('fs');
+const { Worker, isMainThread, parentPort, workerData } = require('worker_threads');
+const { LinuxBinding, openPty } = require('@serialport/bindings-cpp');
+const { Poller } = require('@serialport/bindings-cpp/dist/poller');
+
+const ports = parseInt(process.env.BENCH_PORTS) || 4;
+const workers = Math.min(parseInt(process.env.BENCH_WORKERS) || ports, ports);
+const seconds = parseFloat(process.env.BENCH_SECONDS) || 5;
+const chunkSize = parseInt(process.env.BENCH_CHUNK) || 4096;
+
+const retryable = (error) => error.code === 'EAGAIN' || error.code === 'EWOULDBLOCK' || error.code === 'EINTR';
+const mbps = (bytes, elapsed) => (bytes / elapsed / 1e6).toFixed(2);
+
+// Device side of a pty: writes back what it reads, reading again once the echo is written. Returns a stop function
+const echo = (pty) => {
+  const poller = new Poller(pty.masterFd);
+  const buffer = Buffer.allocUnsafe(65536);
+  let stopped = false;
+  const write = (data) => {
+    while (data.length > 0) {
+      let written = 0;
+      try {
+        written = fs.writeSync(pty.masterFd, data);
+      } catch (error) {
+        if (!retryable(error)) {
+          return;
+        }
+      }
+      data = data.subarray(written);
+      if (data.length > 0) {
+        poller.once('writable', (err) => !err && !stopped && write(data));
+        return;
+      }
+    }
+    read();
+  };
+  const read = () => poller.once('readable', (err) => {
+    if (err || stopped) {
+      return;
+    }
+    let bytesRead = 0;
+    try {
+      bytesRead = fs.readSync(pty.masterFd, buffer, 0, buffer.length, null);
+    } catch (error) {
+      if (!retryable(error)) {
+        return;
+      }
+    }
+    write(buffer.subarray(0, bytesRead));
+  });
+  read();
+  return () => {
+    stopped = true;
+    poller.stop();
+    poller.destroy();
+  };
+};
+
+const runPort = async (port, deadline) => {
+  const chunk = Buffer.alloc(chunkSize, 'a');
+  let received = 0;
+  const reader = (async () => {
+    const buffer = Buffer.allocUnsafe(65536);
+    for (;;) {
+      const { bytesRead } = await port.read(buffer, 0, buffer.length);
+      if (Date.now() < deadline) {
+        received += bytesRead;
+      }
+    }
+  })().catch(() => {});
+  while (Date.now() < deadline) {
+    await port.write(chunk);
+  }
+  // closing cancels the pending read, which ends the reader
+  await port.close();
+  await reader;
+  return received;
+};
+
+const runWorker = async () => {
+  const ptys = Array.from({ length: workerData.ports }, () => openPty());
+  const stops = ptys.map(echo);
+  const opened = await Promise.all(ptys.map(pty => LinuxBinding.open({ path: pty.path, baudRate: 115200 })));
+  parentPort.postMessage({ ready: true });
+  const { start } = await new Promise(resolve => parentPort.once('message', resolve));
+  const deadline = start + seconds * 1000;
+  const received = await Promise.all(opened.map(port => runPort(port, deadline)));
+  stops.forEach(stop => stop());
+  // the main thread closes the pty fds, a worker only closes fds it opened through fs
+  parentPort.postMessage({ received, fds: ptys.flatMap(pty => [pty.masterFd, pty.slaveFd]) });
+};
+
+const run = async () => {
+  console.log(`📊 ${ports} ports on ${workers} workers, ${os.cpus().length} cores, ${chunkSize} byte writes for ${seconds}s`);
+  const threads = Array.from({ length: workers }, (_, i) => {
+    // ports spread evenly, the first workers take the remainder
+    const owned = Math.floor(ports / workers) + (i < ports % workers ? 1 : 0);
+    const worker = new Worker(__filename, { workerData: { ports: owned } });
+    const messages = [];
+    let waiting = null;
+    const failed = new Promise((resolve, reject) => {
+      worker.on('error', reject);
+      worker.on('exit', code => code !== 0 && reject(new Error(`worker ${i} exited with code ${code}`)));
+    });
+    worker.on('message', (message) => {
+      if (waiting) {
+        waiting(message);
+        waiting = null;
+      } else {
+        messages.push(message);
+      }
+    });
+    const next = () => Promise.race([
+      failed,
+      messages.length > 0 ? messages.shift() : new Promise(resolve => { waiting = resolve; })
+    ]);
+    return { worker, owned, next };
+  });
+
+  await Promise.all(threads.map(thread => thread.next()));
+  const start = Date.now();
+  threads.forEach(thread => thread.worker.postMessage({ start }));
+  const results = await Promise.all(threads.map(thread => thread.next()));
+
+  const total = results.reduce((sum, { received }) => sum + received.reduce((a, b) => a + b, 0), 0);
+  console.log(`✅ ${mbps(total, seconds)} MB/s aggregate, ${mbps(total / ports, seconds)} MB/s per port`);
+  results.forEach(({ received }, i) => {
+    const bytes = received.reduce((a, b) => a + b, 0);
+    console.log(`   worker ${i}: ${threads[i].owned} ports, ${mbps(bytes, seconds)} MB/s`);
+  });
+  await Promise.all(threads.map(thread => thread.worker.terminate()));
+  results.forEach(({ fds }) => fds.forEach(fd => fs.closeSync(fd)));
+};
+
+if (isMainThread) {
+  run().catch((error) => {
+    console.error('❌ Benchmark failed:', error);
+    process.exit(1);
+  });
+} else {
+  runWorker().catch((error) => {
+    console.error('❌ Worker failed:', error);
+    process.exit(1);
+  });
+}
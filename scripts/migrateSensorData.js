@@ -0,0 +1,103 @@
+// Converts readings stored before the slim SensorData schema, while the server keeps running:
+// channel metadata goes to SensorRegistry (once per device), values to `readings`, the rawData copy
+// of the request is dropped. Readings are read and replaced in _id order, MIGRATE_BATCH (1000) at a
+// time with MIGRATE_PAUSE_MS (0) between batches to leave the database room for ingest. Readings
+// that were converted meanwhile are left alone, and the migration can be stopped and run again at
+// any time. The API returns both shapes the same way until it is done.
+//
+// Always works on the plain collection, also with SENSOR_STORAGE=timeseries (time-series collections
+// can't replace documents, scripts/migrateSensorTimeSeries.js converts readings while copying them).
+//
+//   MONGODB_URI=... node scripts/migrateSensorData.js
+//
+// MIGRATE_DRY_RUN=true only reports how much smaller the readings would get. MongoDB reuses the
+// freed space for new readings, run `compact` on the collection to give it back to the OS.
+require('dotenv').config();
+const mongoose = require('mongoose');
+const SensorData = require('../models/SensorData');
+const SensorRegistry = require('../models/SensorRegistry');
+
+const { BSON } = mongoose.mongo;
+const batchSize = parseInt(process.env.MIGRATE_BATCH) || 1000;
+const pauseMs = parseInt(process.env.MIGRATE_PAUSE_MS) || 0;
+const dryRun = process.env.MIGRATE_DRY_RUN === 'true';
+
+const formatBytes = (bytes) => `${(bytes / 1024 / 1024).toFixed(1)} MB`;
+
+const migrate = async () => {
+  if (!process.env.MONGODB_URI) {
+    console.error('❌ MONGODB_URI is required');
+    process.exit(1);
+  }
+  await mongoose.connect(process.env.MONGODB_URI);
+  console.log(`✅ MongoDB Connected: ${mongoose.connection.host}`);
+
+  const plain = mongoose.connection.db.collection(SensorData.collectionNames.collection);
+  const legacyFilter = { readings: { $exists: false } };
+  const remaining = await plain.countDocuments(legacyFilter);
+  console.log(`🔄 ${remaining} readings to convert${dryRun ? ' (dry run)' : ''}`);
+
+  const registered = new Set();
+  let lastId = null;
+  let converted = 0;
+  let bytesBefore = 0;
+  let bytesAfter = 0;
+
+  for (;;) {
+    const filter = lastId ? { ...legacyFilter, _id: { $gt: lastId } } : legacyFilter;
+    const batch = await plain.find(filter).sort({ _id: 1 }).limit(batchSize).toArray();
+    if (batch.length === 0) {
+      break;
+    }
+    lastId = batch[batch.length - 1]._id;
+
+    const readingOps = [];
+    const registryOps = [];
+    batch.forEach((legacy) => {
+      const { slim, channels } = SensorData.fromLegacy(legacy);
+      bytesBefore += BSON.calculateObjectSize(legacy);
+      bytesAfter += BSON.calculateObjectSize(slim);
+      readingOps.push({
+        replaceOne: {
+          // skip readings that were converted since they were read
+          filter: { _id: legacy._id, readings: { $exists: false } },
+          replacement: slim
+        }
+      });
+      // the oldest reading of a device describes it, unless it registered since
+      if (!registered.has(legacy.deviceId)) {
+        registered.add(legacy.deviceId);
+        registryOps.push({
+          updateOne: {
+            filter: { deviceId: legacy.deviceId },
+            update: { $setOnInsert: { deviceId: legacy.deviceId, channels } },
+            upsert: true
+          }
+        });
+      }
+    });
+
+    if (!dryRun) {
+      if (registryOps.length > 0) {
+        await SensorRegistry.bulkWrite(registryOps, { ordered: false });
+      }
+      await plain.bulkWrite(readingOps, { ordered: false });
+    }
+    converted += batch.length;
+    console.log(`📊 ${converted}/${remaining} readings, ${formatBytes(bytesBefore)} -> ${formatBytes(bytesAfter)}`);
+
+    if (pauseMs > 0) {
+      await new Promise(resolve => setTimeout(resolve, pauseMs));
+    }
+  }
+
+  const saved = bytesBefore > 0 ? (1 - bytesAfter / bytesBefore) * 100 : 0;
+  console.log(`✅ ${dryRun ? 'Would convert' : 'Converted'} ${converted} readings for ${registered.size} devices, ${formatBytes(bytesBefore)} -> ${formatBytes(bytesAfter)} (${saved.toFixed(0)}% smaller)`);
+  await mongoose.connection.close();
+};
+
+migrate().catch(async (error) => {
+  console.error('❌ Migration failed:', error);
+  await mongoose.connection.close();
+  process.exit(1);
+});
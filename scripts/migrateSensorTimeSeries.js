@@ -0,0 +1,150 @@
+// Copies readings from the plain SensorData collection into the time-series one used with
+// SENSOR_STORAGE=timeseries, converting readings from before the slim schema on the way. Readings
+// are copied in _id order, MIGRATE_BATCH (1000) at a time with MIGRATE_PAUSE_MS (0) in between, and
+// the last copied _id is kept in the migrations collection so the copy can be stopped and resumed.
+// Readings can reach the plain collection after the copy went past their _id (spill replays, servers
+// that still write there), a second pass over their createdAt copies whatever the first one missed:
+// from MIGRATE_VERIFY_FROM (a date), by default a day before the first run started.
+//
+//   MONGODB_URI=... node scripts/migrateSensorTimeSeries.js
+//
+// 1. Run it while the server still writes to the plain collection.
+// 2. Set SENSOR_STORAGE=timeseries and restart every server.
+// 3. Run it again to copy what was stored in between. Readings that are copied already are skipped.
+// 4. Drop the plain collection once the API serves everything from the new one.
+process.env.SENSOR_STORAGE = 'timeseries';
+require('dotenv').config();
+const mongoose = require('mongoose');
+const SensorData = require('../models/SensorData');
+const SensorRegistry = require('../models/SensorRegistry');
+
+const batchSize = parseInt(process.env.MIGRATE_BATCH) || 1000;
+const pauseMs = parseInt(process.env.MIGRATE_PAUSE_MS) || 0;
+const checkpointId = 'sensordata-timeseries';
+const lateMs = 24 * 60 * 60 * 1000;
+
+const formatBytes = (bytes) => `${(bytes / 1024 / 1024).toFixed(1)} MB`;
+
+const storageStats = async (collection) => {
+  const [stats] = await collection.aggregate([{ $collStats: { storageStats: {} } }]).toArray();
+  return stats.storageStats;
+};
+
+const pause = () => (pauseMs > 0 ? new Promise(resolve => setTimeout(resolve, pauseMs)) : Promise.resolve());
+
+// Converts a batch of plain readings and inserts the ones the time-series collection doesn't have
+// yet, returns how many were copied
+const copyBatch = async (batch, registered) => {
+  const registryOps = [];
+  const readings = batch.map((reading) => {
+    if (reading.readings) {
+      return reading;
+    }
+    const { slim, channels } = SensorData.fromLegacy(reading);
+    if (!registered.has(reading.deviceId)) {
+      registered.add(reading.deviceId);
+      registryOps.push({
+        updateOne: {
+          filter: { deviceId: reading.deviceId },
+          update: { $setOnInsert: { deviceId: reading.deviceId, channels } },
+          upsert: true
+        }
+      });
+    }
+    return slim;
+  }).map(reading => (reading.createdAt ? reading : { ...reading, createdAt: reading._id.getTimestamp() }));
+
+  const stored = await SensorData.storedIds(readings);
+  const fresh = readings.filter(reading => !stored.has(String(reading._id)));
+  if (registryOps.length > 0) {
+    await SensorRegistry.bulkWrite(registryOps, { ordered: false });
+  }
+  if (fresh.length > 0) {
+    await SensorData.collection.insertMany(fresh, { ordered: false });
+  }
+  return fresh.length;
+};
+
+const migrate = async () => {
+  if (!process.env.MONGODB_URI) {
+    console.error('❌ MONGODB_URI is required');
+    process.exit(1);
+  }
+  await mongoose.connect(process.env.MONGODB_URI);
+  console.log(`✅ MongoDB Connected: ${mongoose.connection.host}`);
+
+  // creates the time-series collection and its indexes
+  await SensorData.init();
+  const db = mongoose.connection.db;
+  const target = await db.listCollections({ name: SensorData.collectionNames.timeseries }).next();
+  if (!target || target.type !== 'timeseries') {
+    console.error(`❌ ${SensorData.collectionNames.timeseries} exists and is not a time-series collection`);
+    process.exit(1);
+  }
+
+  const source = db.collection(SensorData.collectionNames.collection);
+  const migrations = db.collection('migrations');
+  const checkpoint = await migrations.findOne({ _id: checkpointId });
+  let lastId = checkpoint ? checkpoint.lastId : null;
+  const startedAt = checkpoint && checkpoint.startedAt ? checkpoint.startedAt : new Date();
+  const remaining = await source.countDocuments(lastId ? { _id: { $gt: lastId } } : {});
+  console.log(`🔄 ${remaining} readings to copy into ${SensorData.collectionNames.timeseries}${lastId ? `, resuming after ${lastId}` : ''}`);
+
+  const registered = new Set();
+  let copied = 0;
+  let skipped = 0;
+  for (;;) {
+    const batch = await source.find(lastId ? { _id: { $gt: lastId } } : {}).sort({ _id: 1 }).limit(batchSize).toArray();
+    if (batch.length === 0) {
+      break;
+    }
+    lastId = batch[batch.length - 1]._id;
+
+    const fresh = await copyBatch(batch, registered);
+    await migrations.updateOne({ _id: checkpointId }, { $set: { lastId, startedAt, updatedAt: new Date() } }, { upsert: true });
+    copied += fresh;
+    skipped += batch.length - fresh;
+    console.log(`📊 ${copied + skipped}/${remaining} readings, ${skipped} copied before`);
+    await pause();
+  }
+
+  // readings stored behind the checkpoint, in createdAt order so storedIds() looks up narrow ranges
+  const verifyFrom = process.env.MIGRATE_VERIFY_FROM
+    ? new Date(process.env.MIGRATE_VERIFY_FROM)
+    : new Date(startedAt.getTime() - lateMs);
+  console.log(`🔄 Checking readings since ${verifyFrom.toISOString()} for ones the copy missed`);
+  const cursor = source.find({ createdAt: { $gte: verifyFrom } }).sort({ createdAt: 1 }).batchSize(batchSize);
+  let checked = 0;
+  let late = 0;
+  let batch = [];
+  const check = async () => {
+    late += await copyBatch(batch, registered);
+    checked += batch.length;
+    batch = [];
+    await pause();
+  };
+  for await (const reading of cursor) {
+    batch.push(reading);
+    if (batch.length === batchSize) {
+      await check();
+    }
+  }
+  if (batch.length > 0) {
+    await check();
+  }
+  console.log(`📊 ${checked} readings checked, ${late} copied late`);
+  copied += late;
+
+  const before = await storageStats(source);
+  const after = await storageStats(SensorData.collection);
+  console.log(`✅ Copied ${copied} readings (${skipped} copied before)`);
+  console.log(`   ${SensorData.collectionNames.collection}: ${before.count} readings, ${formatBytes(before.storageSize)} data, ${formatBytes(before.totalIndexSize)} indexes`);
+  console.log(`   ${SensorData.collectionNames.timeseries}: ${formatBytes(after.storageSize)} data, ${formatBytes(after.totalIndexSize)} indexes`);
+  await mongoose.connection.close();
+};
+
+migrate().catch(async (error) => {
+  console.error('❌ Migration failed:', error);
+  await mongoose.connection.close();
+  process.exit(1);
+});
@@ -0,0 +1,143 @@
+// Recomputes SensorRollup minutes, hours and days from the stored readings, in either storage
+// shape, and replaces the rollups they cover. Run it once to fill the rollups for readings stored
+// before them, or for periods whose incremental updates failed (marked stale, see rollupErrors in the
+// buffer's status). Minute rollups are only rebuilt for the last 30 days, older ones expire.
+//
+//   MONGODB_URI=... node scripts/rebuildSensorRollups.js
+//
+// REBUILD_FROM and REBUILD_TO (dates, default everything) limit the periods, REBUILD_DEVICE one
+// device. Periods that readings are still being stored into are best left to the incremental updates.
+require('dotenv').config();
+const mongoose = require('mongoose');
+const SensorData = require('../models/SensorData');
+const SensorRollup = require('../models/SensorRollup');
+
+const minuteRetentionMs = 30 * 24 * 60 * 60 * 1000;
+
+// Metric values of a reading in either storage shape, until scripts/migrateSensorData.js has run
+const metricValues = {
+  temperature: { $ifNull: ['$readings.tempAverage', '$temperature.average'] },
+  humidity: { $ifNull: ['$readings.humAverage', '$humidity.average'] },
+  soilMoisture: { $ifNull: ['$readings.soilMoisture', '$soilMoisture.value'] },
+  lightIntensity: { $ifNull: ['$readings.lightIntensity', '$lightIntensity.value'] },
+  ph: { $ifNull: ['$readings.ph', '$ph.value'] },
+  waterTankLevel: { $ifNull: ['$readings.waterTankLevel', '$waterTankLevel.value'] }
+};
+
+const rollupPipeline = (match, resolution) => {
+  const group = {
+    _id: {
+      deviceId: '$deviceId',
+      bucket: { $dateTrunc: { date: '$createdAt', unit: resolution } }
+    },
+    greenhouseId: { $first: '$greenhouseId' },
+    count: { $sum: 1 },
+    alertCount: { $sum: '$alertCount' }
+  };
+  const metrics = {};
+  Object.keys(metricValues).forEach(metric => {
+    group[`${metric}Sum`] = { $sum: `$${metric}` };
+    group[`${metric}Count`] = { $sum: { $cond: [{ $isNumber: `$${metric}` }, 1, 0] } };
+    group[`${metric}Min`] = { $min: `$${metric}` };
+    group[`${metric}Max`] = { $max: `$${metric}` };
+    metrics[metric] = {
+      sum: `$${metric}Sum`,
+      count: `$${metric}Count`,
+      min: `$${metric}Min`,
+      max: `$${metric}Max`
+    };
+  });
+
+  return [
+    { $match: match },
+    {
+      $project: {
+        deviceId: 1,
+        greenhouseId: 1,
+        createdAt: 1,
+        alertCount: { $size: { $ifNull: ['$alerts', []] } },
+        ...metricValues
+      }
+    },
+    { $group: group },
+    {
+      $project: {
+        _id: 0,
+        deviceId: '$_id.deviceId',
+        greenhouseId: 1,
+        resolution: { $literal: resolution },
+        bucket: '$_id.bucket',
+        count: 1,
+        alertCount: 1,
+        metrics
+      }
+    },
+    {
+      $merge: {
+        into: SensorRollup.collection.collectionName,
+        on: ['deviceId', 'resolution', 'bucket'],
+        whenMatched: 'replace',
+        whenNotMatched: 'insert'
+      }
+    }
+  ];
+};
+
+const rebuild = async () => {
+  if (!process.env.MONGODB_URI) {
+    console.error('❌ MONGODB_URI is required');
+    process.exit(1);
+  }
+  await mongoose.connect(process.env.MONGODB_URI);
+  console.log(`✅ MongoDB Connected: ${mongoose.connection.host}`);
+  // $merge needs the unique index on deviceId, resolution and bucket
+  await SensorRollup.init();
+
+  const from = process.env.REBUILD_FROM ? new Date(process.env.REBUILD_FROM) : null;
+  const to = process.env.REBUILD_TO ? new Date(process.env.REBUILD_TO) : null;
+  for (const resolution of Object.keys(SensorRollup.periods)) {
+    // whole periods only, a partial one would replace its rollup with part of its readings
+    const period = SensorRollup.periods[resolution];
+    let start = from ? new Date(Math.floor(from.getTime() / period) * period) : null;
+    if (resolution === 'minute') {
+      const oldest = Math.floor((Date.now() - minuteRetentionMs) / period) * period;
+      start = new Date(Math.max(start ? start.getTime() : 0, oldest));
+    }
+    const match = {};
+    if (start || to) {
+      match.createdAt = {};
+      if (start) {
+        match.createdAt.$gte = start;
+      }
+      if (to) {
+        match.createdAt.$lt = new Date(Math.ceil(to.getTime() / period) * period);
+      }
+    }
+    if (process.env.REBUILD_DEVICE) {
+      match.deviceId = process.env.REBUILD_DEVICE;
+    }
+
+    const startedAt = Date.now();
+    // stale rollups of periods without readings aren't replaced by the merge
+    const stale = { resolution, stale: true };
+    if (match.createdAt) {
+      stale.bucket = match.createdAt;
+    }
+    if (match.deviceId) {
+      stale.deviceId = match.deviceId;
+    }
+    await SensorRollup.deleteMany(stale);
+    await SensorData.aggregate(rollupPipeline(match, resolution)).allowDiskUse(true);
+    const rollups = await SensorRollup.countDocuments({ resolution, ...(match.deviceId ? { deviceId: match.deviceId } : {}) });
+    console.log(`📊 ${resolution} rollups rebuilt in ${((Date.now() - startedAt) / 1000).toFixed(1)} s, ${rollups} in total`);
+  }
+
+  console.log('✅ Rollups rebuilt');
+  await mongoose.connection.close();
+};
+
+rebuild().catch(async (error) => {
+  console.error('❌ Rollup rebuild failed:', error);
+  await mongoose.connection.close();
+  process.exit(1);
+});
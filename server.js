@@ -3,6 +3,7 @@ const http = require("http");
 const { Server } = require("socket.io");
 const bodyParser = require("body-parser");
 const cors = require("cors");
+const SerialIngestService = require("./services/serialIngestService");
 
 const app = express();
 const server = http.createServer(app);
@@ -19,14 +20,36 @@ let latestSensorData = {};
 
 // ============ REST ENDPOINTS ============
 
-// Receive sensor data from ESP32
-app.post("/api/sensor-data", (req, res) => {
-latestSensorData = req.body;
+// Ingest pipeline shared by the HTTP endpoint and the serial ingest service
+const ingestSensorData = (data) => {
+latestSensorData = data;
 console.log("📡 Sensor data received:", latestSensorData);
 io.emit("sensorUpdate", latestSensorData); // Broadcast to clients
+};
+
+// Receive sensor data from ESP32
+app.post("/api/sensor-data", (req, res) => {
+ingestSensorData(req.body);
 res.status(200).json({ message: "Data received" });
 });
 
+// Read a USB-attached Arduino directly when SERIAL_INGEST_PORT is set
+const serialIngest = process.env.SERIAL_INGEST_PORT
+? new SerialIngestService(ingestSensorData, {
+path: process.env.SERIAL_INGEST_PORT,
+baudRate: parseInt(process.env.SERIAL_INGEST_BAUD) || 9600,
+deviceId: process.env.SERIAL_INGEST_DEVICE_ID,
+})
+: null;
+
+// Serial ingest connection state and counters
+app.get("/api/serial-ingest/status", (req, res) => {
+if (!serialIngest) {
+return res.json({ enabled: false });
+}
+res.json(serialIngest.getStatus());
+});
+
 // Provide latest sensor data
 app.get("/api/sensor-data", (req, res) => {
 res.json(latestSensorData);
@@ -139,7 +162,11 @@ console.log("❌ Client disconnected:", socket.id);
 const PORT = process.env.PORT || 3000;
 server.listen(PORT, () => {
 console.log(`🚀 Server running on port ${PORT}`);
+if (serialIngest) {
+serialIngest.start();
+}
 console.log(`📋 Available endpoints:`);
+console.log(`   GET  /api/serial-ingest/status - Serial ingest metrics`);
 console.log(`   POST /api/control - Send any command`);
 console.log(`   GET  /api/control/:command - Send command via URL`);
 console.log(`   POST /api/water/auto - Water pump auto mode`);
@@ -74,8 +74,10 @@ class FailsafeService {
     console.log(`⚠️  Device ${device.deviceId} went offline (${offlineMinutes} minutes)`);
     
     // Get latest sensor data to assess situation
-    const latestSensorData = await SensorData.findOne({ deviceId: device.deviceId })
-      .sort({ createdAt: -1 });
+    const latestReading = await SensorData.findOne({ deviceId: device.deviceId })
+      .sort({ createdAt: -1 })
+      .lean();
+    const latestSensorData = latestReading ? SensorData.toApi(latestReading) : null;
     
     // Send real-time notification
     this.io.emit(`greenhouse_${device.greenhouseId}`, {
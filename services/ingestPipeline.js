@@ -0,0 +1,283 @@
+const mongoose = require('mongoose');
+const User = require('../models/User');
+const Greenhouse = require('../models/Greenhouse');
+const DeviceControl = require('../models/DeviceControl');
+const SensorRegistry = require('../models/SensorRegistry');
+
+// Resolves a reading's user and greenhouse from an in-process cache and applies the bookkeeping that
+// follows a reading (greenhouse stats, device status, actuator feedback, the device's SensorRegistry
+// channels when they change) in batches, so ingesting a reading costs the single write that stores it.
+//
+// Cached documents are dropped when the models report a change (see the 'changed' hooks in
+// models/User.js and models/Greenhouse.js) and after `cacheTtlMs` at the latest, which covers
+// writes from other processes. Deferred updates are merged per greenhouse and device and flushed
+// every `flushIntervalMs`, or as soon as `maxBatch` of them are pending.
+class IngestPipeline {
+  constructor(options = {}) {
+    this.cacheTtlMs = options.cacheTtlMs || 60000;
+    this.flushIntervalMs = options.flushIntervalMs || 1000;
+    this.maxBatch = options.maxBatch || 1000;
+
+    // 'user:<id>' / 'greenhouse:<id>' -> { doc, promise, expires }
+    this.cache = new Map();
+    this.greenhouseStats = new Map();
+    this.deviceStatus = new Map();
+    this.controlStates = new Map();
+    // deviceId -> channels as last registered by this process, and the ones to register
+    this.registeredChannels = new Map();
+    this.channelUpdates = new Map();
+    this.pending = 0;
+    this.flushing = null;
+    this.timer = null;
+
+    this.metrics = {
+      readings: 0,
+      cacheHits: 0,
+      cacheMisses: 0,
+      invalidations: 0,
+      flushes: 0,
+      flushedWrites: 0,
+      flushErrors: 0,
+      flushMsMax: 0,
+      lastFlushAt: null,
+      lastError: null
+    };
+
+    this.onUserChanged = (id) => this.invalidate('user', id);
+    this.onGreenhouseChanged = (id) => this.invalidate('greenhouse', id);
+    User.on('changed', this.onUserChanged);
+    Greenhouse.on('changed', this.onGreenhouseChanged);
+  }
+
+  // The user and greenhouse a reading belongs to. The defaults mean the first one, like the legacy
+  // payloads expect. Resolves to null for either when it doesn't exist.
+  async resolve(userId, greenhouseId) {
+    const [user, greenhouse] = await Promise.all([
+      this.lookup('user', userId, () => (userId === 'defaultUserId' ? User.findOne() : User.findById(userId))),
+      this.lookup('greenhouse', greenhouseId, () => (
+        greenhouseId === 'defaultGreenhouseId' ? Greenhouse.findOne() : Greenhouse.findById(greenhouseId)
+      ))
+    ]);
+    return { user, greenhouse };
+  }
+
+  async lookup(kind, id, load) {
+    const key = `${kind}:${id}`;
+    const now = Date.now();
+    const entry = this.cache.get(key);
+    if (entry && entry.expires > now) {
+      this.metrics.cacheHits++;
+      return entry.doc !== undefined ? entry.doc : entry.promise;
+    }
+
+    // Concurrent misses share one query
+    this.metrics.cacheMisses++;
+    const fresh = { doc: undefined, promise: null, expires: now + this.cacheTtlMs };
+    fresh.promise = Promise.resolve(load()).then((doc) => {
+      fresh.doc = doc || null;
+      return fresh.doc;
+    }, (error) => {
+      if (this.cache.get(key) === fresh) {
+        this.cache.delete(key);
+      }
+      throw error;
+    });
+    this.cache.set(key, fresh);
+    return fresh.promise;
+  }
+
+  // Drops cached documents of a kind, all of them when the id is unknown
+  invalidate(kind, id) {
+    const name = id && (typeof id === 'string' || id instanceof mongoose.Types.ObjectId) ? String(id) : null;
+    for (const [key, entry] of this.cache) {
+      if (!key.startsWith(`${kind}:`)) {
+        continue;
+      }
+      // default lookups are cached under their placeholder, match them by the document
+      if (name === null || key === `${kind}:${name}` || (entry.doc && String(entry.doc._id) === name)) {
+        this.cache.delete(key);
+        this.metrics.invalidations++;
+      }
+    }
+  }
+
+  // Queues the updates that follow a stored reading
+  defer({ greenhouseId, deviceId, alerts, actuatorStates, channels, receivedAt = new Date() }) {
+    this.metrics.readings++;
+
+    const statsKey = String(greenhouseId);
+    const stats = this.greenhouseStats.get(statsKey);
+    if (stats) {
+      stats.readings += 1;
+      stats.alerts += alerts;
+      stats.lastDataReceived = receivedAt;
+    } else {
+      this.greenhouseStats.set(statsKey, { greenhouseId, readings: 1, alerts, lastDataReceived: receivedAt });
+      this.pending++;
+    }
+
+    const deviceKey = `${statsKey}:${deviceId}`;
+    if (!this.deviceStatus.has(deviceKey)) {
+      this.pending++;
+    }
+    this.deviceStatus.set(deviceKey, { greenhouseId, deviceId, lastSeen: receivedAt });
+
+    if (actuatorStates) {
+      // only the latest feedback of a device matters
+      if (!this.controlStates.has(deviceId)) {
+        this.pending++;
+      }
+      this.controlStates.set(deviceId, { actuatorStates, receivedAt });
+    }
+
+    if (channels) {
+      const registered = JSON.stringify(channels);
+      if (this.registeredChannels.get(deviceId) !== registered) {
+        this.registeredChannels.set(deviceId, registered);
+        if (!this.channelUpdates.has(deviceId)) {
+          this.pending++;
+        }
+        this.channelUpdates.set(deviceId, channels);
+      }
+    }
+
+    if (this.pending >= this.maxBatch) {
+      this.flush();
+    } else if (!this.timer) {
+      this.timer = setTimeout(() => this.flush(), this.flushIntervalMs);
+      // pending bookkeeping doesn't keep the process alive, close() flushes it
+      this.timer.unref();
+    }
+  }
+
+  // Writes the queued updates, resolves once they are written
+  async flush() {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    }
+    if (this.flushing) {
+      // one flush at a time, whatever was queued meanwhile goes in the next one
+      await this.flushing;
+      if (this.pending > 0) {
+        return this.flush();
+      }
+      return;
+    }
+    if (this.pending === 0) {
+      return;
+    }
+
+    const greenhouseOps = [];
+    for (const stats of this.greenhouseStats.values()) {
+      greenhouseOps.push({
+        updateOne: {
+          filter: { _id: stats.greenhouseId },
+          update: {
+            $inc: { 'stats.totalSensorReadings': stats.readings, 'stats.totalAlerts': stats.alerts },
+            $max: { 'stats.lastDataReceived': stats.lastDataReceived }
+          }
+        }
+      });
+    }
+    for (const device of this.deviceStatus.values()) {
+      // devices that aren't registered with the greenhouse match nothing
+      greenhouseOps.push({
+        updateOne: {
+          filter: { _id: device.greenhouseId, 'devices.deviceId': device.deviceId },
+          update: { $set: { 'devices.$.status': 'active', 'devices.$.lastSeen': device.lastSeen } }
+        }
+      });
+    }
+    const controlOps = [];
+    for (const [deviceId, control] of this.controlStates) {
+      controlOps.push(...controlStateOps(deviceId, control.actuatorStates, control.receivedAt));
+    }
+    const channelUpdates = this.channelUpdates;
+    const registryOps = [...channelUpdates].map(([deviceId, channels]) => ({
+      updateOne: {
+        filter: { deviceId },
+        update: { $set: { channels } },
+        upsert: true
+      }
+    }));
+    this.greenhouseStats = new Map();
+    this.deviceStatus = new Map();
+    this.controlStates = new Map();
+    this.channelUpdates = new Map();
+    this.pending = 0;
+
+    const startedAt = Date.now();
+    this.flushing = Promise.all([
+      greenhouseOps.length > 0 ? Greenhouse.bulkWrite(greenhouseOps, { ordered: false }) : null,
+      controlOps.length > 0 ? DeviceControl.bulkWrite(controlOps, { ordered: false }) : null,
+      registryOps.length > 0 ? SensorRegistry.bulkWrite(registryOps, { ordered: false }) : null
+    ]).then(() => {
+      this.metrics.flushedWrites += greenhouseOps.length + controlOps.length + registryOps.length;
+    }, (error) => {
+      // the readings themselves are stored, only their bookkeeping is lost. Channels are
+      // registered again with the device's next reading.
+      channelUpdates.forEach((channels, deviceId) => this.registeredChannels.delete(deviceId));
+      this.metrics.flushErrors++;
+      this.metrics.lastError = error.message;
+      console.error('❌ Ingest pipeline flush failed:', error.message);
+    }).then(() => {
+      const elapsed = Date.now() - startedAt;
+      this.metrics.flushes++;
+      this.metrics.flushMsMax = Math.max(this.metrics.flushMsMax, elapsed);
+      this.metrics.lastFlushAt = new Date();
+      this.flushing = null;
+    });
+    return this.flushing;
+  }
+
+  getStatus() {
+    const lookups = this.metrics.cacheHits + this.metrics.cacheMisses;
+    return {
+      ...this.metrics,
+      cacheHitRate: lookups > 0 ? this.metrics.cacheHits / lookups : null,
+      cached: this.cache.size,
+      pending: this.pending,
+      flushIntervalMs: this.flushIntervalMs
+    };
+  }
+
+  // Flushes what is queued and stops listening for model changes
+  async close() {
+    User.removeListener('changed', this.onUserChanged);
+    Greenhouse.removeListener('changed', this.onGreenhouseChanged);
+    await this.flush();
+  }
+}
+
+// The ESP32 reports what its relays are doing, record it on relays the device control knows about
+const controlStateOps = (deviceId, actuatorStates, receivedAt) => {
+  const ops = [];
+  const relayUpdate = (relay, state) => {
+    const update = {
+      [`relays.${relay}.state`]: state.status === 'ON',
+      [`relays.${relay}.lastHeartbeat`]: receivedAt
+    };
+    if (relay !== 'fertilizerPump') {
+      update[`relays.${relay}.mode`] = state.mode || 'AUTO';
+    }
+    ops.push({
+      updateOne: {
+        filter: { deviceId, [`relays.${relay}`]: { $exists: true } },
+        update: { $set: update }
+      }
+    });
+  };
+  if (actuatorStates.waterPump) {
+    relayUpdate('waterPump', actuatorStates.waterPump);
+  }
+  if (actuatorStates.ventilationFan) {
+    relayUpdate('ventilationFan', actuatorStates.ventilationFan);
+  }
+  if (actuatorStates.fertilizerPump) {
+    relayUpdate('fertilizerPump', actuatorStates.fertilizerPump);
+  }
+  return ops;
+};
+
+module.exports = IngestPipeline;
@@ -0,0 +1,408 @@
+const fs = require('fs');
+const path = require('path');
+const mongoose = require('mongoose');
+const SensorData = require('../models/SensorData');
+const SensorRollup = require('../models/SensorRollup');
+
+const { EJSON } = mongoose.mongo.BSON;
+const DUPLICATE_KEY = 11000;
+
+// Write-behind buffer for readings: readings from all devices are grouped into one unordered
+// insertMany per batch instead of a save() each, a batch is written once `maxBatch` readings are
+// waiting or `flushIntervalMs` after the first one. insert() resolves when its batch is stored, so a
+// device is still only acknowledged for readings that survive a crash.
+//
+// Memory is bounded: past `maxBuffered` waiting readings insert() throws an error with statusCode 503
+// and `retryAfter` instead of queueing. When a batch can't be written (database down, timeouts) it is
+// appended to the spill file and fsynced, acknowledged, and replayed into the database after the
+// next batch that goes through, or on the next start. Readings keep their _id from the spill, so a
+// batch that reached the database before its error was reported is not stored twice (looked up
+// first with time-series storage, which has no unique _id index). A line torn by a crash during an
+// append is cut off before the next append, lines the replay can't parse are moved to `<spill>.bad`
+// instead of holding up the rest.
+//
+// Readings are added to their SensorRollup minutes, hours and days once they are stored. A spilled
+// batch is rolled up when it is replayed, including readings its failed write stored after all, and
+// the replay keeps its progress in `<spill>.replay.done` so a retried replay doesn't add them twice.
+// Other readings that turn out to be stored already were rolled up before and are skipped. When a
+// rollup update fails its rollups are marked stale (retried after the next batch that goes through),
+// charts group their readings instead.
+class SensorDataBuffer {
+  constructor(options = {}) {
+    this.maxBatch = options.maxBatch || 500;
+    this.flushIntervalMs = options.flushIntervalMs || 50;
+    this.maxBuffered = options.maxBuffered || 10000;
+    this.spillPath = options.spillPath || process.env.SENSOR_SPILL_PATH || 'data/sensor-spill.ndjson';
+    this.maxSpillBytes = options.maxSpillBytes || 256 * 1024 * 1024;
+
+    this.queue = [];
+    this.inFlight = 0;
+    this.timer = null;
+    this.drained = [];
+    // spill appends and the replay's rename take turns
+    this.spillLock = Promise.resolve();
+    this.replaying = false;
+    // whether the end of the spill file is known to be a whole line, checked before the first append
+    this.spillChecked = false;
+    this.rollups = new Set();
+    // readings whose rollups still have to be marked stale
+    this.staleReadings = [];
+    this.markingStale = false;
+    this.spillPending = fs.existsSync(this.spillPath) || fs.existsSync(this.replayPath());
+
+    this.metrics = {
+      batches: 0,
+      inserted: 0,
+      largestBatch: 0,
+      flushMsMax: 0,
+      rejected: 0,
+      failed: 0,
+      spilled: 0,
+      replayed: 0,
+      quarantined: 0,
+      rollupErrors: 0,
+      lastError: null
+    };
+  }
+
+  replayPath() {
+    return `${this.spillPath}.replay`;
+  }
+
+  progressPath() {
+    return `${this.spillPath}.replay.done`;
+  }
+
+  quarantinePath() {
+    return `${this.spillPath}.bad`;
+  }
+
+  // Queues a new SensorData document, resolves once it is stored (or spilled). Throws the document's
+  // ValidationError like save() does.
+  insert(sensorData) {
+    if (this.queue.length + this.inFlight >= this.maxBuffered) {
+      this.metrics.rejected++;
+      return Promise.reject(busy('Sensor data buffer is full, retry later'));
+    }
+
+    // what save() would do, insertMany runs no save middleware
+    sensorData.calculateAverages();
+    const validationError = sensorData.validateSync();
+    if (validationError) {
+      return Promise.reject(validationError);
+    }
+    sensorData.initializeTimestamps();
+
+    return new Promise((resolve, reject) => {
+      this.queue.push({ sensorData, resolve, reject });
+      if (this.queue.length >= this.maxBatch) {
+        this.flush();
+      } else if (!this.timer) {
+        this.timer = setTimeout(() => this.flush(), this.flushIntervalMs);
+      }
+    });
+  }
+
+  // Starts writing everything queued, in batches of `maxBatch` that are written concurrently
+  flush() {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    }
+    while (this.queue.length > 0) {
+      this.write(this.queue.splice(0, this.maxBatch));
+    }
+  }
+
+  async write(batch) {
+    this.inFlight += batch.length;
+    const startedAt = Date.now();
+    const docs = batch.map(entry => entry.sensorData.toBSON());
+    const failed = new Set();
+    const duplicates = new Set();
+    let spill = false;
+
+    try {
+      await SensorData.collection.insertMany(docs, { ordered: false });
+    } catch (error) {
+      const writeErrors = error.writeErrors ? [].concat(error.writeErrors) : null;
+      if (writeErrors) {
+        // the rest of an unordered batch is stored, duplicates are readings stored before
+        writeErrors.forEach(writeError => (writeError.code === DUPLICATE_KEY ? duplicates : failed).add(writeError.index));
+      } else {
+        spill = true;
+      }
+      this.metrics.lastError = error.message;
+      console.error('❌ Sensor data batch insert failed:', error.message);
+    }
+
+    if (spill) {
+      try {
+        await this.spill(batch);
+        this.metrics.spilled += batch.length;
+      } catch (error) {
+        console.error('❌ Sensor data spill failed:', error.message);
+        batch.forEach((entry, index) => failed.add(index));
+      }
+    }
+
+    batch.forEach((entry, index) => {
+      if (failed.has(index)) {
+        entry.reject(busy('Sensor data could not be stored, retry later'));
+      } else {
+        entry.resolve(entry.sensorData);
+      }
+    });
+
+    this.inFlight -= batch.length;
+    this.metrics.batches++;
+    // duplicates were stored by an earlier write
+    this.metrics.inserted += spill ? 0 : batch.length - failed.size - duplicates.size;
+    this.metrics.failed += failed.size;
+    this.metrics.largestBatch = Math.max(this.metrics.largestBatch, batch.length);
+    this.metrics.flushMsMax = Math.max(this.metrics.flushMsMax, Date.now() - startedAt);
+
+    if (!spill) {
+      this.rollUp(docs.filter((doc, index) => !failed.has(index) && !duplicates.has(index)));
+    }
+    if (!spill && this.staleReadings.length > 0) {
+      this.markStale();
+    }
+    if (!spill && this.spillPending && !this.replaying) {
+      this.replay().catch((error) => {
+        this.metrics.lastError = error.message;
+        console.error('❌ Sensor data spill replay failed:', error.message);
+      });
+    }
+    if (this.inFlight === 0 && this.queue.length === 0) {
+      this.drained.splice(0).forEach(resolve => resolve());
+    }
+  }
+
+  // Adds newly stored readings to their rollups, resolves once that is done or has failed. The
+  // rollups of a failed update are marked stale, scripts/rebuildSensorRollups.js recomputes them.
+  rollUp(docs) {
+    if (docs.length === 0) {
+      return Promise.resolve();
+    }
+    const rollup = SensorRollup.applyReadings(docs).catch((error) => {
+      this.metrics.rollupErrors++;
+      this.metrics.lastError = error.message;
+      console.error('❌ Sensor rollup update failed:', error.message);
+      docs.forEach(({ deviceId, greenhouseId, createdAt }) => this.staleReadings.push({ deviceId, greenhouseId, createdAt }));
+      return this.markStale();
+    }).then(() => this.rollups.delete(rollup));
+    this.rollups.add(rollup);
+    return rollup;
+  }
+
+  // Marks the rollups of readings whose update failed, kept for the next try when that fails too
+  async markStale() {
+    if (this.markingStale || this.staleReadings.length === 0) {
+      return;
+    }
+    this.markingStale = true;
+    const readings = this.staleReadings;
+    this.staleReadings = [];
+    try {
+      await SensorRollup.markStale(readings);
+    } catch (error) {
+      this.staleReadings = readings.concat(this.staleReadings);
+      this.metrics.lastError = error.message;
+      console.error('❌ Marking stale sensor rollups failed:', error.message);
+    } finally {
+      this.markingStale = false;
+    }
+  }
+
+  // Appends a batch to the spill file and fsyncs it
+  spill(batch) {
+    const lines = batch.map(entry => EJSON.stringify(entry.sensorData.toBSON(), { relaxed: false })).join('\n') + '\n';
+    const append = this.spillLock.then(async () => {
+      await fs.promises.mkdir(path.dirname(this.spillPath), { recursive: true });
+      if (!this.spillChecked) {
+        // a crash or a failed append left part of a line, the next line would be glued onto it
+        const dropped = await truncateTornLine(this.spillPath);
+        if (dropped > 0) {
+          console.warn(`⚠️  Dropped ${dropped} bytes of a torn line from ${this.spillPath}`);
+        }
+        this.spillChecked = true;
+      }
+      const size = await fs.promises.stat(this.spillPath).then(stats => stats.size, () => 0);
+      if (size + Buffer.byteLength(lines) > this.maxSpillBytes) {
+        throw new Error(`Spill file ${this.spillPath} is full`);
+      }
+      const file = await fs.promises.open(this.spillPath, 'a');
+      try {
+        await file.writeFile(lines);
+        await file.sync();
+      } catch (error) {
+        this.spillChecked = false;
+        throw error;
+      } finally {
+        await file.close();
+      }
+      this.spillPending = true;
+    });
+    this.spillLock = append.catch(() => {});
+    return append;
+  }
+
+  // Inserts spilled readings, a replay that fails is retried from the start after the next batch
+  async replay() {
+    this.replaying = true;
+    try {
+      const replayPath = this.replayPath();
+      const rename = this.spillLock.then(() => {
+        // a replay file is left over from a replay that failed, finish it first
+        if (!fs.existsSync(replayPath) && fs.existsSync(this.spillPath)) {
+          fs.rmSync(this.progressPath(), { force: true });
+          fs.renameSync(this.spillPath, replayPath);
+        }
+      });
+      this.spillLock = rename.catch(() => {});
+      await rename;
+      if (!fs.existsSync(replayPath)) {
+        this.spillPending = false;
+        return;
+      }
+
+      const content = await fs.promises.readFile(replayPath, 'utf8');
+      // a crash during an append leaves a partial last line, that batch was never acknowledged
+      const lines = content.slice(0, content.lastIndexOf('\n') + 1).split('\n').filter(line => line.length > 0);
+      const spilled = [];
+      const unparseable = [];
+      lines.forEach((line) => {
+        try {
+          // plain numbers like toBSON() gives (and SensorRollup adds up), ObjectIds and Dates are kept
+          spilled.push(EJSON.parse(line, { relaxed: true }));
+        } catch (error) {
+          unparseable.push(line);
+        }
+      });
+      if (unparseable.length > 0) {
+        await this.quarantine(unparseable, spilled);
+      }
+
+      // batches a replay that failed part way got through, they are stored and rolled up
+      const done = parseInt(await fs.promises.readFile(this.progressPath(), 'utf8').catch(() => '0')) || 0;
+      console.log(`🔄 Replaying ${spilled.length - done} spilled sensor readings`);
+      for (let i = done; i < spilled.length; i += this.maxBatch) {
+        const docs = spilled.slice(i, i + this.maxBatch);
+        let fresh = docs;
+        if (SensorData.storage === 'timeseries') {
+          const stored = await SensorData.storedIds(docs);
+          fresh = docs.filter(doc => !stored.has(String(doc._id)));
+        }
+        const duplicates = new Set();
+        if (fresh.length > 0) {
+          try {
+            await SensorData.collection.insertMany(fresh, { ordered: false });
+          } catch (error) {
+            const writeErrors = error.writeErrors ? [].concat(error.writeErrors) : null;
+            if (!writeErrors || writeErrors.some(writeError => writeError.code !== DUPLICATE_KEY)) {
+              throw error;
+            }
+            writeErrors.forEach(writeError => duplicates.add(writeError.index));
+          }
+        }
+        // none of them were rolled up when they were spilled, stored before or not
+        await this.rollUp(docs);
+        await fs.promises.writeFile(this.progressPath(), String(i + docs.length));
+        this.metrics.replayed += fresh.length - duplicates.size;
+      }
+      await fs.promises.unlink(replayPath);
+      await fs.promises.rm(this.progressPath(), { force: true });
+      this.spillPending = fs.existsSync(this.spillPath);
+      console.log(`✅ Replayed ${spilled.length} spilled sensor readings`);
+    } finally {
+      this.replaying = false;
+    }
+  }
+
+  // Moves lines the replay can't parse to the quarantine file for a look by hand, and rewrites the
+  // replay file without them so a retried replay doesn't move them again
+  async quarantine(unparseable, spilled) {
+    const file = await fs.promises.open(this.quarantinePath(), 'a');
+    try {
+      await file.writeFile(unparseable.join('\n') + '\n');
+      await file.sync();
+    } finally {
+      await file.close();
+    }
+    const replayPath = this.replayPath();
+    const rewritten = `${replayPath}.tmp`;
+    await fs.promises.writeFile(rewritten, spilled.map(doc => EJSON.stringify(doc, { relaxed: false }) + '\n').join(''));
+    const handle = await fs.promises.open(rewritten, 'r');
+    await handle.sync();
+    await handle.close();
+    await fs.promises.rename(rewritten, replayPath);
+    this.metrics.quarantined += unparseable.length;
+    console.warn(`⚠️  Moved ${unparseable.length} unparseable spilled readings to ${this.quarantinePath()}`);
+  }
+
+  getStatus() {
+    return {
+      ...this.metrics,
+      buffered: this.queue.length,
+      inFlight: this.inFlight,
+      maxBuffered: this.maxBuffered,
+      spillPending: this.spillPending,
+      staleReadings: this.staleReadings.length
+    };
+  }
+
+  // Writes everything queued, resolves once no batch or rollup update is in flight
+  async close() {
+    this.flush();
+    if (this.inFlight > 0) {
+      await new Promise(resolve => this.drained.push(resolve));
+    }
+    await Promise.all([...this.rollups]);
+  }
+}
+
+// Cuts a file back to its last newline, returns the number of bytes dropped
+const truncateTornLine = async (filePath) => {
+  let file;
+  try {
+    file = await fs.promises.open(filePath, 'r+');
+  } catch (error) {
+    if (error.code === 'ENOENT') {
+      return 0;
+    }
+    throw error;
+  }
+  try {
+    const { size } = await file.stat();
+    const chunk = Buffer.alloc(64 * 1024);
+    let end = size;
+    while (end > 0) {
+      const start = Math.max(0, end - chunk.length);
+      const { bytesRead } = await file.read(chunk, 0, end - start, start);
+      const newline = chunk.subarray(0, bytesRead).lastIndexOf(0x0a);
+      if (newline !== -1) {
+        end = start + newline + 1;
+        break;
+      }
+      end = start;
+    }
+    if (end < size) {
+      await file.truncate(end);
+      await file.sync();
+    }
+    return size - end;
+  } finally {
+    await file.close();
+  }
+};
+
+// Error the HTTP endpoint answers with 503 and Retry-After
+const busy = (message) => {
+  const error = new Error(message);
+  error.statusCode = 503;
+  error.retryAfter = 1;
+  return error;
+};
+
+module.exports = SensorDataBuffer;
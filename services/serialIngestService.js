@@ -0,0 +1,258 @@
+const { SerialPort, ReadlineParser } = require('serialport');
+
+// Arduino espSerial line, the same one the ESP32 parses before posting it:
+// T1:25.0,H1:60.0,T2:28.0,H2:70.0,Soil:45,Light:80,Tank:75,pH:6.8,WaterPump:ON,WaterMode:AUTO,Fan:OFF,FanMode:AUTO,Fertilizer:OFF,RFID:NoCard
+const NUMERIC_FIELDS = {
+  T1: 'outsideTemp',
+  T2: 'greenhouseTemp',
+  H1: 'outsideHumidity',
+  H2: 'greenhouseHumidity',
+  Soil: 'soilMoisture',
+  Light: 'lightLevel',
+  Tank: 'waterTank',
+  pH: 'phLevel'
+};
+
+const MIN_RETRY_DELAY = 1000;
+const MAX_RETRY_DELAY = 30000;
+
+// Turns one line into the payload the ESP32 would have posted, null when it isn't a reading. Over
+// USB the Arduino echoes the packet as "Sent: T1:...", so anything before T1: is skipped.
+const parseSensorLine = (line, deviceId) => {
+  const start = line.indexOf('T1:');
+  if (start === -1) {
+    return null;
+  }
+
+  const fields = {};
+  for (const pair of line.slice(start).split(',')) {
+    const separator = pair.indexOf(':');
+    if (separator > 0) {
+      fields[pair.slice(0, separator).trim()] = pair.slice(separator + 1).trim();
+    }
+  }
+
+  const sensors = {};
+  for (const [key, name] of Object.entries(NUMERIC_FIELDS)) {
+    const value = parseFloat(fields[key]);
+    sensors[name] = Number.isFinite(value) ? value : null;
+  }
+  if (sensors.outsideTemp === null && sensors.soilMoisture === null) {
+    throw new Error(`Unparseable sensor line: ${line}`);
+  }
+
+  return {
+    deviceId,
+    timestamp: Date.now(),
+    sensors,
+    actuators: {
+      waterPump: { status: fields.WaterPump, mode: fields.WaterMode },
+      ventilationFan: { status: fields.Fan, mode: fields.FanMode },
+      fertilizerPump: { status: fields.Fertilizer }
+    },
+    rfid: fields.RFID || 'NoCard',
+    source: 'serial'
+  };
+};
+
+// Reads a USB-attached Arduino directly and feeds each reading to `ingest`, the same pipeline the
+// HTTP endpoint uses. The port is reopened with backoff when it fails, and readings that arrive while
+// the previous one is still being ingested replace each other rather than queueing.
+class SerialIngestService {
+  constructor(ingest, options = {}) {
+    this.ingest = ingest;
+    this.path = options.path;
+    this.baudRate = options.baudRate || 9600;
+    this.deviceId = options.deviceId || `serial:${options.path}`;
+    this.port = null;
+    this.stopped = true;
+    this.retryDelay = MIN_RETRY_DELAY;
+    this.retryTimer = null;
+    // set once the first open succeeded, later successful opens count as reconnects
+    this.wasConnected = false;
+    this.busy = false;
+    this.pending = null;
+
+    this.metrics = {
+      connected: false,
+      lines: 0,
+      samples: 0,
+      ignoredLines: 0,
+      parseErrors: 0,
+      ingestErrors: 0,
+      replaced: 0,
+      reconnects: 0,
+      lastSampleAt: null,
+      lastError: null,
+      ingestMsTotal: 0,
+      ingestMsMax: 0
+    };
+  }
+
+  start() {
+    if (!this.stopped) {
+      return;
+    }
+    this.stopped = false;
+    console.log(`🔌 Serial ingest starting on ${this.path} @ ${this.baudRate} baud`);
+    this.open();
+  }
+
+  open() {
+    this.retryTimer = null;
+    // reconnect lets the linux binding follow the board when it re-enumerates, icanon has the kernel
+    // hand over whole lines; other platforms ignore both
+    const port = new SerialPort({
+      path: this.path,
+      baudRate: this.baudRate,
+      autoOpen: false,
+      reconnect: true,
+      icanon: true
+    });
+    this.port = port;
+
+    port.open((error) => {
+      if (error) {
+        this.recordError(error);
+        console.error(`❌ Serial ingest cannot open ${this.path}:`, error.message);
+        this.scheduleReopen();
+        return;
+      }
+      if (this.stopped) {
+        port.close(() => {});
+        return;
+      }
+      console.log(`✅ Serial ingest connected to ${this.path}`);
+      this.metrics.connected = true;
+      if (this.wasConnected) {
+        this.metrics.reconnects++;
+      }
+      this.wasConnected = true;
+      this.retryDelay = MIN_RETRY_DELAY;
+
+      // the reconnecting binding reports the device going away and coming back
+      if (port.port && typeof port.port.on === 'function') {
+        port.port.on('disconnect', (err) => {
+          this.metrics.connected = false;
+          this.recordError(err);
+          console.warn(`⚠️  Serial ingest lost ${this.path}, waiting for it to return`);
+        });
+        port.port.on('reconnect', ({ path }) => {
+          this.metrics.connected = true;
+          this.metrics.reconnects++;
+          console.log(`🔄 Serial ingest reconnected on ${path}`);
+        });
+      }
+    });
+
+    port.pipe(new ReadlineParser({ delimiter: '\n' })).on('data', (line) => this.onLine(line));
+
+    port.on('error', (error) => {
+      this.recordError(error);
+      console.error('❌ Serial ingest port error:', error.message);
+    });
+
+    port.on('close', () => {
+      this.metrics.connected = false;
+      if (this.port === port) {
+        this.port = null;
+      }
+      if (!this.stopped) {
+        console.warn(`⚠️  Serial ingest port ${this.path} closed, reopening`);
+        this.scheduleReopen();
+      }
+    });
+  }
+
+  scheduleReopen() {
+    if (this.stopped || this.retryTimer) {
+      return;
+    }
+    const delay = this.retryDelay;
+    this.retryDelay = Math.min(this.retryDelay * 2, MAX_RETRY_DELAY);
+    this.retryTimer = setTimeout(() => this.open(), delay);
+  }
+
+  onLine(line) {
+    this.metrics.lines++;
+    let payload;
+    try {
+      payload = parseSensorLine(line.replace(/\r$/, ''), this.deviceId);
+    } catch (error) {
+      this.metrics.parseErrors++;
+      this.recordError(error);
+      return;
+    }
+    if (!payload) {
+      // command echoes and debug prints
+      this.metrics.ignoredLines++;
+      return;
+    }
+
+    if (this.busy) {
+      if (this.pending) {
+        this.metrics.replaced++;
+      }
+      this.pending = payload;
+      return;
+    }
+    this.process(payload);
+  }
+
+  async process(payload) {
+    this.busy = true;
+    while (payload) {
+      const started = Date.now();
+      try {
+        await this.ingest(payload);
+        const elapsed = Date.now() - started;
+        this.metrics.samples++;
+        this.metrics.lastSampleAt = new Date();
+        this.metrics.ingestMsTotal += elapsed;
+        this.metrics.ingestMsMax = Math.max(this.metrics.ingestMsMax, elapsed);
+      } catch (error) {
+        this.metrics.ingestErrors++;
+        this.recordError(error);
+        console.error('❌ Serial ingest error:', error.message);
+      }
+      payload = this.pending;
+      this.pending = null;
+    }
+    this.busy = false;
+  }
+
+  recordError(error) {
+    this.metrics.lastError = {
+      message: error ? error.message : 'Unknown error',
+      at: new Date()
+    };
+  }
+
+  getStatus() {
+    const { ingestMsTotal, ...metrics } = this.metrics;
+    return {
+      enabled: !this.stopped,
+      path: this.path,
+      baudRate: this.baudRate,
+      deviceId: this.deviceId,
+      ...metrics,
+      ingestMsAverage: metrics.samples > 0 ? ingestMsTotal / metrics.samples : 0
+    };
+  }
+
+  stop() {
+    this.stopped = true;
+    if (this.retryTimer) {
+      clearTimeout(this.retryTimer);
+      this.retryTimer = null;
+    }
+    if (this.port && this.port.isOpen) {
+      this.port.close(() => {});
+    }
+    this.port = null;
+  }
+}
+
+SerialIngestService.parseSensorLine = parseSensorLine;
+
+module.exports = SerialIngestService;
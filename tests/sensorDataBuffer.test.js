@@ -0,0 +1,162 @@
+// SensorDataBuffer against a mocked collection and a temp spill dir: failed batches are spilled and
+// acknowledged, replayed into the database later, and a crash part way through either leaves nothing
+// stored twice or lost.
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const mongoose = require('mongoose');
+const SensorData = require('../models/SensorData');
+const SensorRollup = require('../models/SensorRollup');
+const SensorDataBuffer = require('../services/sensorDataBuffer');
+
+const { EJSON } = mongoose.mongo.BSON;
+
+const reading = (deviceId = 'device-1') => new SensorData({
+  deviceId,
+  userId: new mongoose.Types.ObjectId(),
+  greenhouseId: new mongoose.Types.ObjectId(),
+  readings: {
+    temp1: 21,
+    temp2: 24,
+    hum1: 50,
+    hum2: 60,
+    soilMoisture: 40,
+    lightIntensity: 70,
+    ph: 6.5,
+    waterTankLevel: 80
+  }
+});
+
+// A spill file line as spill() writes it
+const spillLine = (sensorData) => {
+  sensorData.calculateAverages();
+  sensorData.initializeTimestamps();
+  return EJSON.stringify(sensorData.toBSON(), { relaxed: false }) + '\n';
+};
+
+// What an unordered insertMany throws when some of its documents were not stored
+const writeError = (indexes, code) => Object.assign(new Error('write errors'), {
+  writeErrors: indexes.map(index => ({ index, code }))
+});
+
+describe('SensorDataBuffer', () => {
+  let dir;
+  let spillPath;
+  let insertMany;
+  let applyReadings;
+
+  beforeEach(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sensor-spill-'));
+    spillPath = path.join(dir, 'spill.ndjson');
+    insertMany = jest.spyOn(SensorData.collection, 'insertMany').mockResolvedValue({});
+    applyReadings = jest.spyOn(SensorRollup, 'applyReadings').mockResolvedValue();
+    jest.spyOn(SensorRollup, 'markStale').mockResolvedValue();
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    jest.restoreAllMocks();
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  const storedIds = () => insertMany.mock.calls.flatMap(([docs]) => docs.map(doc => String(doc._id)));
+
+  test('spills a batch the database rejects and replays it after the next batch', async () => {
+    const buffer = new SensorDataBuffer({ spillPath, flushIntervalMs: 1 });
+    insertMany.mockRejectedValueOnce(new Error('connection refused'));
+
+    const spilled = [reading(), reading()];
+    await Promise.all(spilled.map(sensorData => buffer.insert(sensorData)));
+    expect(fs.readFileSync(spillPath, 'utf8').trim().split('\n')).toHaveLength(2);
+    expect(buffer.getStatus()).toMatchObject({ spilled: 2, inserted: 0, spillPending: true });
+    expect(applyReadings).not.toHaveBeenCalled();
+
+    const next = reading();
+    await buffer.insert(next);
+    await buffer.close();
+    await waitFor(() => !buffer.replaying && !fs.existsSync(buffer.replayPath()));
+
+    // the rejected write, the next batch, then the replay
+    const ids = sensorDataList => sensorDataList.map(sensorData => String(sensorData._id));
+    expect(insertMany.mock.calls.map(([docs]) => docs.map(doc => String(doc._id)))).toEqual([ids(spilled), ids([next]), ids(spilled)]);
+    expect(buffer.getStatus()).toMatchObject({ inserted: 1, replayed: 2, spillPending: false });
+    expect(fs.existsSync(spillPath)).toBe(false);
+    // the replay rolls up the spilled readings, the direct insert its own
+    expect(applyReadings.mock.calls.flatMap(([docs]) => docs)).toHaveLength(3);
+  });
+
+  test('resumes a replay that crashed part way after the batches it finished', async () => {
+    const readings = [reading(), reading(), reading(), reading(), reading()];
+    // a replay of batches of 2 crashed after storing and rolling up the first batch
+    fs.writeFileSync(`${spillPath}.replay`, readings.map(spillLine).join(''));
+    fs.writeFileSync(`${spillPath}.replay.done`, '2');
+
+    const buffer = new SensorDataBuffer({ spillPath, maxBatch: 2 });
+    expect(buffer.getStatus().spillPending).toBe(true);
+    await buffer.replay();
+
+    const rest = readings.slice(2).map(sensorData => String(sensorData._id));
+    expect(storedIds()).toEqual(rest);
+    expect(applyReadings.mock.calls.flatMap(([docs]) => docs.map(doc => String(doc._id)))).toEqual(rest);
+    expect(buffer.getStatus()).toMatchObject({ replayed: 3, spillPending: false });
+    expect(fs.existsSync(`${spillPath}.replay`)).toBe(false);
+    expect(fs.existsSync(`${spillPath}.replay.done`)).toBe(false);
+  });
+
+  test('counts readings the failed write stored after all as replayed only once', async () => {
+    const readings = [reading(), reading(), reading()];
+    fs.writeFileSync(spillPath, readings.map(spillLine).join(''));
+    insertMany.mockRejectedValueOnce(writeError([0], 11000));
+
+    const buffer = new SensorDataBuffer({ spillPath });
+    await buffer.replay();
+
+    expect(buffer.getStatus().replayed).toBe(2);
+    // none of them were rolled up when they were spilled
+    expect(applyReadings.mock.calls.flatMap(([docs]) => docs)).toHaveLength(3);
+  });
+
+  test('ignores a torn last line on replay and cuts it off before the next append', async () => {
+    const whole = reading();
+    const torn = spillLine(reading());
+    fs.writeFileSync(spillPath, spillLine(whole) + torn.slice(0, torn.length / 2));
+
+    const buffer = new SensorDataBuffer({ spillPath, flushIntervalMs: 1 });
+    insertMany.mockRejectedValueOnce(new Error('connection refused'));
+    const appended = reading();
+    await buffer.insert(appended);
+
+    const lines = fs.readFileSync(spillPath, 'utf8').split('\n');
+    expect(lines).toHaveLength(3);
+    expect(lines[2]).toBe('');
+    expect(lines.slice(0, 2).map(line => String(EJSON.parse(line)._id))).toEqual([String(whole._id), String(appended._id)]);
+
+    // a torn line the append never got to is left out of the replay, it was never acknowledged
+    fs.appendFileSync(spillPath, torn.slice(0, 10));
+    insertMany.mockClear();
+    await buffer.replay();
+    expect(storedIds()).toEqual([String(whole._id), String(appended._id)]);
+    expect(buffer.getStatus().quarantined).toBe(0);
+  });
+
+  test('does not count duplicates and failed readings as inserted', async () => {
+    const buffer = new SensorDataBuffer({ spillPath, flushIntervalMs: 1 });
+    insertMany.mockRejectedValueOnce(writeError([1], 11000));
+    await Promise.all([reading(), reading(), reading()].map(sensorData => buffer.insert(sensorData)));
+    expect(buffer.getStatus()).toMatchObject({ inserted: 2, failed: 0 });
+
+    insertMany.mockRejectedValueOnce(writeError([0], 121));
+    const results = await Promise.allSettled([reading(), reading()].map(sensorData => buffer.insert(sensorData)));
+    expect(results.map(result => result.status)).toEqual(['rejected', 'fulfilled']);
+    expect(buffer.getStatus()).toMatchObject({ inserted: 3, failed: 1 });
+  });
+});
+
+// Waits for work the buffer started without handing back a promise
+const waitFor = async (condition) => {
+  for (let i = 0; i < 100 && !condition(); i++) {
+    await new Promise(resolve => setTimeout(resolve, 10));
+  }
+};
@@ -0,0 +1,50 @@
+// Read timing travels with each read result: two reads in flight at once each get the stamps of their
+// own data, on the plain fs.read path and on the coalescing reader.
+const fs = require('fs');
+const { LinuxBinding, openPty } = require('@serialport/bindings-cpp');
+
+const describeLinux = process.platform === 'linux' ? describe : describe.skip;
+
+describeLinux('LinuxBinding.read timing', () => {
+  let ptys;
+
+  beforeEach(() => {
+    ptys = [openPty(), openPty()];
+  });
+
+  afterEach(() => {
+    ptys.forEach((pty) => {
+      fs.closeSync(pty.masterFd);
+      fs.closeSync(pty.slaveFd);
+    });
+  });
+
+  test.each([
+    { name: 'plain', options: {} },
+    { name: 'coalesce', options: { coalesce: { maxDelayMicros: 0 } } }
+  ])('stamps each read on the $name path', async ({ options }) => {
+    const ports = await Promise.all(ptys.map(pty => LinuxBinding.open({ path: pty.path, baudRate: 9600, ...options })));
+    try {
+      const reads = ports.map(port => port.read(Buffer.alloc(64), 0, 64));
+      const before = Number(process.hrtime.bigint());
+      fs.writeSync(ptys[0].masterFd, 'first\n');
+      const first = await reads[0];
+      const between = Number(process.hrtime.bigint());
+      await new Promise(resolve => setTimeout(resolve, 20));
+      fs.writeSync(ptys[1].masterFd, 'second\n');
+      const second = await reads[1];
+
+      expect(first.buffer.subarray(0, first.bytesRead).toString()).toBe('first\n');
+      expect(second.buffer.subarray(0, second.bytesRead).toString()).toBe('second\n');
+      for (const result of [first, second]) {
+        expect(result.wakeAt).toBeLessThanOrEqual(result.readAt);
+      }
+      // the slower read didn't overwrite the first one's stamps
+      expect(first.readAt).toBeGreaterThanOrEqual(before);
+      expect(first.readAt).toBeLessThanOrEqual(between);
+      expect(second.readAt).toBeGreaterThan(between);
+    } finally {
+      await Promise.all(ports.map(port => port.close()));
+    }
+  });
+});
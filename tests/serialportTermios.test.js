@@ -0,0 +1,45 @@
+// Opening a pty with each framing option: only a baud rate the driver didn't apply may fail an open,
+// the other flags are best effort like they were before the single termios pass.
+const fs = require('fs');
+const { LinuxBinding, openPty } = require('@serialport/bindings-cpp');
+
+const describeLinux = process.platform === 'linux' ? describe : describe.skip;
+
+describeLinux('LinuxBinding.open termios', () => {
+  let pty;
+
+  beforeEach(() => {
+    pty = openPty();
+  });
+
+  afterEach(() => {
+    fs.closeSync(pty.masterFd);
+    fs.closeSync(pty.slaveFd);
+  });
+
+  test.each([
+    { parity: 'even' },
+    { parity: 'odd' },
+    { dataBits: 7 },
+    { dataBits: 5, stopBits: 2 },
+    { rtscts: true },
+    { baudRate: 250000 }
+  ])('opens with %o', async (options) => {
+    const port = await LinuxBinding.open({ path: pty.path, baudRate: 9600, ...options });
+    try {
+      expect(await port.getBaudRate()).toEqual({ baudRate: options.baudRate || 9600 });
+    } finally {
+      await port.close();
+    }
+  });
+
+  test('update() changes the baud rate of a port opened with parity', async () => {
+    const port = await LinuxBinding.open({ path: pty.path, baudRate: 9600, parity: 'even', dataBits: 7 });
+    try {
+      await port.update({ baudRate: 57600 });
+      expect(await port.getBaudRate()).toEqual({ baudRate: 57600 });
+    } finally {
+      await port.close();
+    }
+  });
+});